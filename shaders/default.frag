@@ -4,17 +4,48 @@ in vec3 currentPos;
 in vec3 normal;
 in vec3 colour;
 in vec2 texCoord;
+flat in int materialIndex;
 
 out vec4 FragColour;
 
-uniform sampler2D diffuse0;
-uniform sampler2D specular0;
-uniform vec4 lightColour;
-uniform vec3 lightPos;
-uniform vec3 camPos;
+// Every texture in the scene, as layers of a few arrays, see MaterialLibrary
+uniform sampler2DArray textureArrays[4];
+// Shared by every draw in a frame, see FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 camMatrix;
+    vec4 camPos;
+    vec4 lightColour;
+    vec4 lightPos;
+};
+
+// For each material, the array and layer of its diffuse and specular textures, see MaterialLibrary
+layout (std140) uniform MaterialData {
+    ivec4 materials[256];
+};
+
+// GLSL 3.30 can only index sampler arrays with constants, so the array is picked by branching
+vec4 SampleLayer(int array, int layer) {
+    vec3 coords = vec3(texCoord, float(layer));
+    if (array == 0) return texture(textureArrays[0], coords);
+    if (array == 1) return texture(textureArrays[1], coords);
+    if (array == 2) return texture(textureArrays[2], coords);
+    if (array == 3) return texture(textureArrays[3], coords);
+    // No texture, so plain white
+    return vec4(1.0);
+}
+
+vec4 Diffuse() {
+    ivec4 material = materials[materialIndex];
+    return SampleLayer(material.x, material.y);
+}
+
+float Specular() {
+    ivec4 material = materials[materialIndex];
+    return SampleLayer(material.z, material.w).r;
+}
 
 vec4 PointLight() {
-    vec3 lightVector = lightPos - currentPos;
+    vec3 lightVector = lightPos.xyz - currentPos;
     float dist = length(lightVector);
     float a = 0.05;
     float b = 0.01;
@@ -26,12 +57,12 @@ vec4 PointLight() {
     vec3 lightDirection = normalize(lightVector);
     float diffuse = max(dot(unitNormal, lightDirection), 0.0);
     float specularLight = 0.5;
-    vec3 viewDirection = normalize(camPos - currentPos);
+    vec3 viewDirection = normalize(camPos.xyz - currentPos);
     vec3 reflectDirection = reflect(-lightDirection, unitNormal);
     float specularAmount = pow(max(dot(viewDirection, reflectDirection), 0.0), 32.0);
     float specular = specularAmount*specularLight;
 
-    return vec4(colour, 1.0)*lightColour*((intensity*diffuse + ambient)*texture(diffuse0, texCoord) + intensity*specular*texture(specular0, texCoord).r);
+    return vec4(colour, 1.0)*lightColour*((intensity*diffuse + ambient)*Diffuse() + intensity*specular*Specular());
 }
 
 vec4 DirectionalLight() {
@@ -41,16 +72,16 @@ vec4 DirectionalLight() {
     vec3 lightDirection = normalize(vec3(1.0, 1.0, 0.0));
     float diffuse = max(dot(unitNormal, lightDirection), 0.0);
     float specularLight = 0.5;
-    vec3 viewDirection = normalize(camPos - currentPos);
+    vec3 viewDirection = normalize(camPos.xyz - currentPos);
     vec3 reflectDirection = reflect(-lightDirection, unitNormal);
     float specularAmount = pow(max(dot(viewDirection, reflectDirection), 0.0), 32.0);
     float specular = specularAmount*specularLight;
 
-    return vec4(colour, 1.0)*lightColour*((diffuse + ambient)*texture(diffuse0, texCoord) + specular*texture(specular0, texCoord).r);
+    return vec4(colour, 1.0)*lightColour*((diffuse + ambient)*Diffuse() + specular*Specular());
 }
 
 vec4 SpotLight() {
-    vec3 lightVector = lightPos - currentPos;
+    vec3 lightVector = lightPos.xyz - currentPos;
 
     // cos(angle)s for two cones that create a soft spotlight
     float outerCone = 0.90;
@@ -62,7 +93,7 @@ vec4 SpotLight() {
     vec3 lightDirection = normalize(lightVector);
     float diffuse = max(dot(unitNormal, lightDirection), 0.0);
     float specularLight = 0.5;
-    vec3 viewDirection = normalize(camPos - currentPos);
+    vec3 viewDirection = normalize(camPos.xyz - currentPos);
     vec3 reflectDirection = reflect(-lightDirection, unitNormal);
     float specularAmount = pow(max(dot(viewDirection, reflectDirection), 0.0), 32.0);
     float specular = specularAmount*specularLight;
@@ -70,7 +101,7 @@ vec4 SpotLight() {
     float angle = dot(vec3(0.0, -1.0, 0.0), -lightDirection);
     float intensity = clamp((angle - outerCone)/(innerCone - outerCone), 0.0, 1.0);
 
-    return vec4(colour, 1.0)*lightColour*((intensity*diffuse + ambient)*texture(diffuse0, texCoord) + intensity*specular*texture(specular0, texCoord).r);
+    return vec4(colour, 1.0)*lightColour*((intensity*diffuse + ambient)*Diffuse() + intensity*specular*Specular());
 }
 
 void main() {
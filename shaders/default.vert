@@ -9,18 +9,28 @@ out vec3 currentPos;
 out vec3 normal;
 out vec3 colour;
 out vec2 texCoord;
+flat out int materialIndex;
 
-uniform mat4 camMatrix;
-uniform mat4 model;
-uniform mat4 translation;
-uniform mat4 rotation;
-uniform mat4 scale;
+// Shared by every draw in a frame, see FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 camMatrix;
+    vec4 camPos;
+    vec4 lightColour;
+    vec4 lightPos;
+};
+
+// Set per object, see ObjectUniformRing
+layout (std140) uniform ObjectData {
+    mat4 model;
+    int material;
+};
 
 void main() {
-   currentPos = vec3(model*translation*rotation*scale*vec4(aPos, 1.0));
+   currentPos = vec3(model*vec4(aPos, 1.0));
    normal = aNormal;
    colour = aColour;
    texCoord = mat2(1.0, 0.0, 0.0, -1.0)*aTexture;
+   materialIndex = material;
 
    gl_Position = camMatrix*vec4(currentPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aColour;
+layout (location = 3) in vec2 aTexture;
+
+// Per-instance attributes
+layout (location = 4) in vec3 aInstancePosition;
+layout (location = 5) in float aInstanceRadius;
+layout (location = 6) in vec3 aInstanceColour;
+
+// Outputs that go to the fragment shader
+out vec3 currentPos;
+out vec3 normal;
+out vec3 colour;
+out vec2 texCoord;
+flat out int materialIndex;
+
+// Shared by every draw in a frame, see FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 camMatrix;
+    vec4 camPos;
+    vec4 lightColour;
+    vec4 lightPos;
+};
+
+void main() {
+   // Instances are unit spheres, so a uniform scale and a translation are their whole transform
+   currentPos = aInstancePosition + aInstanceRadius*aPos;
+   normal = aNormal;
+   colour = aInstanceColour;
+   texCoord = mat2(1.0, 0.0, 0.0, -1.0)*aTexture;
+   // Bodies are coloured by their instances alone, so use the plain material
+   materialIndex = 0;
+
+   gl_Position = camMatrix*vec4(currentPos, 1.0);
+}
@@ -2,8 +2,18 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 camMatrix;
+// Shared by every draw in a frame, see FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 camMatrix;
+    vec4 camPos;
+    vec4 lightColour;
+    vec4 lightPos;
+};
+
+layout (std140) uniform ObjectData {
+    mat4 model;
+    int material;
+};
 
 void main() {
     gl_Position = camMatrix*model*vec4(aPos, 1.0f);
@@ -0,0 +1,8 @@
+#version 330 core
+
+out vec4 FragColour;
+
+void main() {
+    // The same colour as the asteroids drawn as spheres
+    FragColour = vec4(0.6f, 0.58f, 0.55f, 1.0f);
+}
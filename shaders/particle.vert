@@ -0,0 +1,25 @@
+#version 330 core
+
+// Each component is its own array in the buffer, see ParticleCloud
+layout (location = 0) in float aPreviousX;
+layout (location = 1) in float aPreviousY;
+layout (location = 2) in float aPreviousZ;
+layout (location = 3) in float aX;
+layout (location = 4) in float aY;
+layout (location = 5) in float aZ;
+
+// Shared by every draw in a frame, see FrameUniformBuffer
+layout (std140) uniform FrameData {
+    mat4 camMatrix;
+    vec4 camPos;
+    vec4 lightColour;
+    vec4 lightPos;
+};
+
+// How far between the previous and current positions to draw
+uniform float interpolation;
+
+void main() {
+    vec3 position = mix(vec3(aPreviousX, aPreviousY, aPreviousZ), vec3(aX, aY, aZ), interpolation);
+    gl_Position = camMatrix*vec4(position, 1.0);
+}
@@ -1,5 +1,7 @@
 #include <Camera/Camera.hpp>
 
+#include <algorithm>
+
 Camera::Camera(int width, int height, glm::vec3 position) {
     this->width = width;
     this->height = height;
@@ -7,8 +9,7 @@ Camera::Camera(int width, int height, glm::vec3 position) {
 }
 
 void Camera::UpdateMatrix(float FOVdeg, float nearPlane, float farPlane) {
-    glm::mat4 view = glm::mat4(1.0f);
-    glm::mat4 projection = glm::mat4(1.0f);
+    projection = glm::mat4(1.0f);
 
     view = glm::lookAt(position, position + orientation, up);
 
@@ -42,6 +43,29 @@ void Camera::UpdateMatrix(float FOVdeg, float nearPlane, float farPlane) {
     cameraMatrix = projection*view;
 }
 
+/**
+ * @brief Estimates how large a sphere appears on screen.
+ *
+ * Uses the sphere's depth from the camera matrix, so it is only valid after UpdateMatrix. The
+ * estimate ignores the slight stretching of spheres towards the edge of the view.
+ *
+ * @param centre the centre of the sphere, in world space.
+ * @param radius the radius of the sphere.
+ * @return the radius of the sphere on screen, in pixels; 0 if it is entirely behind the camera.
+ */
+float Camera::ProjectedRadius(glm::vec3 centre, float radius) const {
+    // The clip space w of a point is its depth in front of the camera
+    float depth = (cameraMatrix*glm::vec4(centre, 1.0f)).w;
+    if (depth + radius <= 0.0f) {
+        return 0.0f;
+    }
+    if (depth <= radius) {
+        // The camera is inside or touching the sphere, so it fills the view
+        return (float)std::max(width, height);
+    }
+    return radius*projection[1][1]*0.5f*height/depth;
+}
+
 /**
  * @brief Sends the camera's transformation matrix to a shader.
  * 
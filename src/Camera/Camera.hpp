@@ -20,6 +20,8 @@ class Camera {
         glm::vec3 orientation = glm::vec3(0.0f, 0.0f, -1.0f);
         glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
         glm::mat4 cameraMatrix = glm::mat4(1.0f);
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::mat4 projection = glm::mat4(1.0f);
         int width, height;
         float speed = 0.1f;
         float sensitivity = 100.0f;
@@ -29,4 +31,5 @@ class Camera {
         void UpdateMatrix(float FOVdeg, float nearPlane, float farPlane);
         void SendMatrixToShader(unsigned int shaderID, const char* uniform);
         void HandleInputs(GLFWwindow* window, float deltaTime);
+        float ProjectedRadius(glm::vec3 centre, float radius) const;
 };
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <Distributed/Decomposition.hpp>
+
+#include <algorithm>
+
+/**
+ * @brief Builds the decomposition from samples of every process's work.
+ *
+ * @param samples the samples, which must be the same on every process.
+ * @param rankCount the number of processes to split space between.
+ */
+void Decomposition::Build(std::vector<DecompositionSample> samples, int rankCount) {
+    nodes.clear();
+    nodes.reserve(2*rankCount);
+    split(samples, 0, samples.size(), 0, std::max(rankCount, 1));
+}
+
+/**
+ * @brief Splits a run of samples between a run of processes, recursively.
+ *
+ * @return the index of the node covering them.
+ */
+int Decomposition::split(std::vector<DecompositionSample>& samples, size_t begin, size_t end, int firstRank, int rankCount) {
+    int nodeIndex = (int)nodes.size();
+    nodes.push_back(Node{firstRank, 0, 0.0, {-1, -1}});
+    if (rankCount == 1) {
+        return nodeIndex;
+    }
+
+    int lowRankCount = rankCount/2;
+    size_t cut = begin;
+    int axis = 0;
+    double position = 0.0;
+    if (end > begin) {
+        glm::dvec3 minimum = samples[begin].position;
+        glm::dvec3 maximum = samples[begin].position;
+        double totalWeight = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            minimum = glm::min(minimum, samples[i].position);
+            maximum = glm::max(maximum, samples[i].position);
+            totalWeight += samples[i].weight;
+        }
+        glm::dvec3 extent = maximum - minimum;
+        axis = extent.y > extent.x ? (extent.z > extent.y ? 2 : 1) : (extent.z > extent.x ? 2 : 0);
+
+        std::sort(samples.begin() + begin, samples.begin() + end, [axis](const DecompositionSample& first, const DecompositionSample& second) {
+            return first.position[axis] < second.position[axis];
+        });
+        // Cut where the low half has its share of the weight, halfway between the samples either side
+        double lowWeight = totalWeight*lowRankCount/rankCount;
+        double weight = 0.0;
+        while (cut < end && weight + samples[cut].weight <= lowWeight) {
+            weight += samples[cut++].weight;
+        }
+        if (cut == begin) {
+            position = samples[begin].position[axis];
+        }
+        else if (cut == end) {
+            position = samples[end - 1].position[axis];
+        }
+        else {
+            position = 0.5*(samples[cut - 1].position[axis] + samples[cut].position[axis]);
+        }
+    }
+
+    nodes[nodeIndex].rank = -1;
+    nodes[nodeIndex].axis = axis;
+    nodes[nodeIndex].position = position;
+    int low = split(samples, begin, cut, firstRank, lowRankCount);
+    int high = split(samples, cut, end, firstRank + lowRankCount, rankCount - lowRankCount);
+    nodes[nodeIndex].children[0] = low;
+    nodes[nodeIndex].children[1] = high;
+    return nodeIndex;
+}
+
+/**
+ * @brief Finds the process whose region holds a point.
+ *
+ * @param position the point.
+ * @return the rank of the process; 0 if the decomposition hasn't been built.
+ */
+int Decomposition::RankOf(glm::dvec3 position) const {
+    if (nodes.empty()) {
+        return 0;
+    }
+    int nodeIndex = 0;
+    while (nodes[nodeIndex].rank < 0) {
+        const Node& node = nodes[nodeIndex];
+        nodeIndex = node.children[position[node.axis] < node.position ? 0 : 1];
+    }
+    return nodes[nodeIndex].rank;
+}
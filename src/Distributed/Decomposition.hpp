@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief A point standing in for some of the work of a simulation, for balancing it across processes.
+ */
+struct DecompositionSample {
+    glm::dvec3 position;
+    double weight;
+};
+
+/**
+ * @brief Splits space between processes by orthogonal recursive bisection.
+ *
+ * The processes are halved, and space is cut across the longest side of the samples' bounds so that
+ * each half gets its share of the samples' weight; then each half is split again the same way, until
+ * every process has a region of its own. Odd numbers of processes are split as evenly as they go, so
+ * any count works. Built from a small weighted sample of every process's bodies, the same on every
+ * process, so they all agree on where every body belongs without any further communication.
+ */
+class Decomposition {
+    private:
+        struct Node {
+            // Leaves hold the process they belong to; other nodes the cut and their two children
+            int rank;
+            int axis;
+            double position;
+            int children[2];
+        };
+
+        std::vector<Node> nodes;
+
+        int split(std::vector<DecompositionSample>& samples, size_t begin, size_t end, int firstRank, int rankCount);
+
+    public:
+        void Build(std::vector<DecompositionSample> samples, int rankCount);
+        int RankOf(glm::dvec3 position) const;
+};
@@ -0,0 +1,307 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <mpi.h>
+
+#include <Distributed/DistributedWorld.hpp>
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/PhysicsWorld/PhysicsWorld.hpp>
+#include <Physics/Scenario/Scenario.hpp>
+#include <Physics/Trajectory/TrajectoryWriter.hpp>
+
+struct DistributedOptions {
+    std::string scenario = "belt";
+    int asteroidCount = 100000;
+    long long steps = -1;
+    double duration = -1.0;
+    double timestep = 1.0/240.0;
+    long long snapshotInterval = 0;
+    std::string outputPath;
+    TrajectoryCompression compression = TRAJECTORY_FLOAT64;
+    unsigned int threadCount = 1;
+    double openingAngle = 0.5;
+    unsigned int rebalanceInterval = 16;
+    bool isComparing = false;
+    // Largest difference --compare accepts, as a fraction of the system's radius
+    double tolerance = 1e-6;
+};
+
+static void printUsage() {
+    std::cout <<
+        "Usage: mpirun -np <processes> SolarSystemDistributed [options]\n"
+        "Runs the gravity simulation split across MPI processes, with no window.\n"
+        "\n"
+        "  --scenario <solar|belt>      system to simulate (default belt)\n"
+        "  --asteroids <n>              asteroids in the belt (default 100000)\n"
+        "  --steps <n>                  number of steps to run\n"
+        "  --time <t>                   simulated time to run for, instead of --steps\n"
+        "  --dt <t>                     step size (default 1/240)\n"
+        "  --threads <n>                worker threads per process, 0 for one per hardware thread (default 1)\n"
+        "  --theta <angle>              Barnes-Hut opening angle (default 0.5)\n"
+        "  --rebalance-every <n>        steps between rebalances of the processes' regions (default 16)\n"
+        "  --output <file>              trajectory file to record to (default: no recording)\n"
+        "  --snapshot-every <n>         record a frame every n steps (default: first and last only)\n"
+        "  --compression <float64|float32|delta16>  how to store recorded frames (default float64)\n"
+        "  --compare                    afterwards, rerun in a single threaded process and report the difference\n"
+        "  --tolerance <x>              fail --compare if positions differ by more than this fraction of the system's radius (default 1e-6)\n";
+}
+
+/**
+ * @brief Parses the command line into a set of options.
+ *
+ * @throws std::runtime_error if an option is unknown or is missing its value.
+ */
+static DistributedOptions parseArguments(int argc, char** argv) {
+    DistributedOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--compare") {
+            options.isComparing = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("Missing value for option '" + argument + "'");
+        }
+        std::string value = argv[++i];
+
+        if (argument == "--scenario") {
+            options.scenario = value;
+        } else if (argument == "--asteroids") {
+            options.asteroidCount = std::stoi(value);
+        } else if (argument == "--steps") {
+            options.steps = std::stoll(value);
+        } else if (argument == "--time") {
+            options.duration = std::stod(value);
+        } else if (argument == "--dt") {
+            options.timestep = std::stod(value);
+        } else if (argument == "--threads") {
+            options.threadCount = (unsigned int)std::stoul(value);
+        } else if (argument == "--theta") {
+            options.openingAngle = std::stod(value);
+        } else if (argument == "--rebalance-every") {
+            options.rebalanceInterval = (unsigned int)std::stoul(value);
+        } else if (argument == "--output") {
+            options.outputPath = value;
+        } else if (argument == "--snapshot-every") {
+            options.snapshotInterval = std::stoll(value);
+        } else if (argument == "--compression") {
+            options.compression = TrajectoryCompressionFromString(value);
+        } else if (argument == "--tolerance") {
+            options.tolerance = std::stod(value);
+        } else {
+            throw std::runtime_error("Unknown option '" + argument + "'");
+        }
+    }
+
+    if (options.scenario != "solar" && options.scenario != "belt") {
+        throw std::runtime_error("Only the solar and belt scenarios can be distributed");
+    }
+    if (options.steps < 0 && options.duration < 0.0) {
+        throw std::runtime_error("One of --steps or --time is required");
+    }
+    if (options.timestep <= 0.0) {
+        throw std::runtime_error("--dt must be positive");
+    }
+    return options;
+}
+
+/**
+ * @brief Waits for every process to arrive without spinning, so a waiting process leaves its core free.
+ */
+static void waitQuietly(MPI_Comm communicator) {
+    MPI_Request request;
+    MPI_Ibarrier(communicator, &request);
+    int isDone = 0;
+    while (!isDone) {
+        MPI_Test(&request, &isDone, MPI_STATUS_IGNORE);
+        if (!isDone) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
+
+/**
+ * @brief Runs the same simulation in this process alone, on every hardware thread, and reports how far
+ * it ends up from the distributed run and how long it took.
+ *
+ * @return whether the largest difference in position is within the tolerance.
+ */
+static bool compare(const DistributedOptions& options, const BodyStore& distributed, long long totalSteps, double distributedSeconds) {
+    JobSystem jobSystem(0);
+    PhysicsWorld world;
+    world.SetJobSystem(&jobSystem);
+    SetUpScenario(options.scenario, world, options.asteroidCount);
+    world.SetIntegrator(LEAPFROG);
+    world.gravity.mode = BARNES_HUT;
+    world.gravity.openingAngle = options.openingAngle;
+    world.Initialise();
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (long long step = 1; step <= totalSteps; step++) {
+        world.Step(options.timestep);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    double largestDifference = 0.0, largestRadius = 0.0;
+    for (unsigned int i = 0; i < world.bodies.Size(); i++) {
+        largestDifference = std::max(largestDifference, glm::length(world.bodies.Position(i) - distributed.Position(i)));
+        largestRadius = std::max(largestRadius, glm::length(world.bodies.Position(i)));
+    }
+    std::cout << "Single process on " << jobSystem.ThreadCount() << " threads: " << std::fixed << std::setprecision(1)
+              << totalSteps/seconds << " steps/s against " << totalSteps/distributedSeconds << " distributed" << std::defaultfloat
+              << " | largest difference in position " << largestDifference << " (" << largestDifference/largestRadius
+              << " of the system's radius)" << std::endl;
+    if (!(largestDifference <= options.tolerance*largestRadius)) {
+        std::cout << "Difference exceeds the tolerance of " << options.tolerance << " of the system's radius" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Runs the distributed simulation for the requested number of steps, writing snapshots along the way.
+ *
+ * @return false if the run was compared against a single process and differed by more than the
+ * tolerance, on every process.
+ */
+static bool run(const DistributedOptions& options) {
+    JobSystem jobSystem(options.threadCount);
+    DistributedWorld world;
+    world.SetJobSystem(&jobSystem);
+    world.gravity.openingAngle = options.openingAngle;
+    world.rebalanceInterval = std::max(options.rebalanceInterval, 1u);
+    bool isRoot = world.Rank() == 0;
+
+    {
+        // Every process builds the same scenario from the same seed and keeps its share
+        PhysicsWorld scenario;
+        SetUpScenario(options.scenario, scenario, options.asteroidCount);
+        world.Distribute(scenario.bodies);
+    }
+    world.Initialise();
+
+    long long totalSteps = options.steps >= 0 ? options.steps : (long long)std::ceil(options.duration/options.timestep - 1e-9);
+    BodyStore allBodies;
+    std::unique_ptr<TrajectoryWriter> trajectory;
+    if (!options.outputPath.empty()) {
+        world.Gather(allBodies);
+        if (isRoot) {
+            std::filesystem::path outputPath(options.outputPath);
+            if (outputPath.has_parent_path()) {
+                std::filesystem::create_directories(outputPath.parent_path());
+            }
+            trajectory.reset(new TrajectoryWriter(options.outputPath, allBodies, options.compression));
+            trajectory->WriteFrame(allBodies, 0, world.time);
+        }
+    }
+
+    uint64_t bodyCount = world.GlobalSize();
+    if (isRoot) {
+        std::cout << "Simulating " << bodyCount << " bodies for " << totalSteps << " steps on " << world.RankCount()
+                  << " processes of " << jobSystem.WorkerCount() << " worker threads (" << SimdLevelToString(world.gravity.GetSimdLevel())
+                  << ", Barnes-Hut, leapfrog)" << std::endl;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto lastReport = startTime;
+    for (long long step = 1; step <= totalSteps; step++) {
+        world.Step(options.timestep);
+
+        bool isLastStep = step == totalSteps;
+        if (!options.outputPath.empty() && (isLastStep || (options.snapshotInterval > 0 && step % options.snapshotInterval == 0))) {
+            world.Gather(allBodies);
+            if (isRoot) {
+                trajectory->WriteFrame(allBodies, step, world.time);
+            }
+        }
+
+        // Every process must take part in the report, so the root's clock decides for all of them
+        auto now = std::chrono::steady_clock::now();
+        int isReporting = isLastStep || std::chrono::duration<double>(now - lastReport).count() >= 5.0;
+        MPI_Bcast(&isReporting, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (isReporting) {
+            uint64_t localImported = world.ImportedCount(), imported = 0;
+            MPI_Reduce(&localImported, &imported, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+            double imbalance = world.LoadImbalance();
+            if (isRoot) {
+                double elapsed = std::chrono::duration<double>(now - startTime).count();
+                std::cout << "Step " << step << "/" << totalSteps << " | t = " << world.time << " | " << std::fixed << std::setprecision(1)
+                          << step/elapsed << " steps/s" << std::setprecision(2) << " | load imbalance " << imbalance << std::defaultfloat
+                          << " | " << imported/world.RankCount() << " sources imported per process" << std::endl;
+            }
+            lastReport = now;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (trajectory) {
+        trajectory->Close();
+        std::cout << "Recorded " << trajectory->FramesQueued() << " frames to " << options.outputPath << std::endl;
+    }
+    int isPassing = 1;
+    if (options.isComparing) {
+        world.Gather(allBodies);
+        if (isRoot) {
+            isPassing = compare(options, allBodies, totalSteps, seconds);
+        }
+        waitQuietly(MPI_COMM_WORLD);
+        MPI_Bcast(&isPassing, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+    return isPassing != 0;
+}
+
+/**
+ * @brief Entry point of the distributed simulation; run one copy per process with mpirun.
+ *
+ * @return int Exit status of the program.
+ */
+int main(int argc, char** argv) {
+    int threadSupport;
+    // Only the main thread of each process talks to MPI; the job system's workers never do
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Every process parses the same arguments, so only the first needs to say anything
+    DistributedOptions options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            if (std::string(argv[i]) == "--help" || std::string(argv[i]) == "-h") {
+                if (rank == 0) {
+                    printUsage();
+                }
+                MPI_Finalize();
+                return EXIT_SUCCESS;
+            }
+        }
+        options = parseArguments(argc, argv);
+    }
+    catch(const std::exception& e) {
+        if (rank == 0) {
+            std::cerr << e.what() << '\n';
+        }
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    bool isPassing = true;
+    try {
+        isPassing = run(options);
+    }
+    catch(const std::exception& e) {
+        // The other processes may be waiting on this one, so take them all down
+        std::cerr << "Process " << rank << ": " << e.what() << '\n';
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    MPI_Finalize();
+    return isPassing ? EXIT_SUCCESS : EXIT_FAILURE;
+}
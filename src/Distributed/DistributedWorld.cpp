@@ -0,0 +1,342 @@
+#include <Distributed/DistributedWorld.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+// A body as sent between processes: its id, position, velocity, acceleration, mass and radius
+static const int PACKED_BODY_SIZE = 12;
+// An exported source: position and mass
+static const int PACKED_SOURCE_SIZE = 4;
+static const int PACKED_SAMPLE_SIZE = 4;
+static const size_t STEP_GRAIN_SIZE = 4096;
+
+using Clock = std::chrono::steady_clock;
+
+static void packBody(const BodyStore& bodies, size_t index, uint64_t id, double* packed) {
+    std::memcpy(&packed[0], &id, sizeof(id));
+    packed[1] = bodies.x[index];
+    packed[2] = bodies.y[index];
+    packed[3] = bodies.z[index];
+    packed[4] = bodies.vx[index];
+    packed[5] = bodies.vy[index];
+    packed[6] = bodies.vz[index];
+    packed[7] = bodies.ax[index];
+    packed[8] = bodies.ay[index];
+    packed[9] = bodies.az[index];
+    packed[10] = bodies.mass[index];
+    packed[11] = bodies.radius[index];
+}
+
+static uint64_t unpackBody(const double* packed, BodyStore& bodies) {
+    uint64_t id;
+    std::memcpy(&id, &packed[0], sizeof(id));
+    Body body(glm::dvec3(packed[1], packed[2], packed[3]), glm::dvec3(packed[4], packed[5], packed[6]), packed[10], packed[11]);
+    body.acceleration = glm::dvec3(packed[7], packed[8], packed[9]);
+    bodies.Add(body);
+    return id;
+}
+
+/**
+ * @brief Works out where each process's data starts in a buffer of the given counts.
+ *
+ * @return the total count.
+ */
+static int offsetsOf(const std::vector<int>& counts, std::vector<int>& offsets) {
+    offsets.resize(counts.size());
+    int total = 0;
+    for (size_t r = 0; r < counts.size(); r++) {
+        offsets[r] = total;
+        total += counts[r];
+    }
+    return total;
+}
+
+/**
+ * @brief Sends every process its part of a buffer and receives what every process sends back.
+ *
+ * @param sendBuffer the data to send, grouped by destination.
+ * @param sendCounts the number of values for each process.
+ * @param receiveBuffer receives the data from every process, grouped by source.
+ */
+static void exchange(MPI_Comm communicator, const std::vector<double>& sendBuffer, const std::vector<int>& sendCounts,
+                     std::vector<double>& receiveBuffer) {
+    std::vector<int> receiveCounts(sendCounts.size());
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, receiveCounts.data(), 1, MPI_INT, communicator);
+    std::vector<int> sendOffsets, receiveOffsets;
+    offsetsOf(sendCounts, sendOffsets);
+    receiveBuffer.resize(offsetsOf(receiveCounts, receiveOffsets));
+    MPI_Alltoallv(sendBuffer.data(), sendCounts.data(), sendOffsets.data(), MPI_DOUBLE,
+                  receiveBuffer.data(), receiveCounts.data(), receiveOffsets.data(), MPI_DOUBLE, communicator);
+}
+
+/**
+ * @brief Joins the given communicator. Every process in it must create its world together.
+ *
+ * @param communicator the processes to split the simulation between.
+ */
+DistributedWorld::DistributedWorld(MPI_Comm communicator) : communicator(communicator) {
+    MPI_Comm_rank(communicator, &rank);
+    MPI_Comm_size(communicator, &rankCount);
+    // The trees sent between processes are only as accurate as Barnes-Hut, so there is no exact mode
+    gravity.mode = BARNES_HUT;
+}
+
+/**
+ * @brief Sets the job system this process's share of the work runs on.
+ *
+ * @param jobSystem the job system, or nullptr to run everything on the calling thread.
+ */
+void DistributedWorld::SetJobSystem(JobSystem* jobSystem) {
+    this->jobSystem = jobSystem;
+    gravity.SetJobSystem(jobSystem);
+}
+
+void DistributedWorld::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (jobSystem == nullptr) {
+        body(0, count);
+    }
+    else {
+        jobSystem->ParallelFor(0, count, grainSize, body);
+    }
+}
+
+/**
+ * @brief Takes this process's share of a full set of bodies. Every process must pass the same bodies.
+ *
+ * The share is only a starting point; Initialise divides the bodies up properly.
+ *
+ * @param allBodies every body in the simulation.
+ */
+void DistributedWorld::Distribute(const BodyStore& allBodies) {
+    bodies.Clear();
+    ids.clear();
+    bodies.Reserve(allBodies.Size()/rankCount + 1);
+    for (size_t i = rank; i < allBodies.Size(); i += rankCount) {
+        bodies.Add(allBodies.Get(i));
+        ids.push_back(i);
+    }
+}
+
+/**
+ * @brief Divides the bodies between the processes and computes their initial accelerations.
+ */
+void DistributedWorld::Initialise() {
+    Rebalance();
+    computeAccelerations();
+}
+
+/**
+ * @brief Advances every process's bodies by one kick-drift-kick leapfrog step.
+ *
+ * Every rebalanceInterval steps the division of space is rebalanced between the drift and the force
+ * pass, so the bodies arrive at their new process with their positions up to date.
+ *
+ * @param deltaTime the step size, in simulation time.
+ */
+void DistributedWorld::Step(double deltaTime) {
+    kick(0.5*deltaTime);
+    drift(deltaTime);
+    time += deltaTime;
+    if (++stepsSinceBalance >= rebalanceInterval) {
+        Rebalance();
+    }
+    computeAccelerations();
+    kick(0.5*deltaTime);
+}
+
+void DistributedWorld::kick(double deltaTime) {
+    parallelFor(bodies.Size(), STEP_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            bodies.vx[i] += bodies.ax[i]*deltaTime;
+            bodies.vy[i] += bodies.ay[i]*deltaTime;
+            bodies.vz[i] += bodies.az[i]*deltaTime;
+        }
+    });
+}
+
+void DistributedWorld::drift(double deltaTime) {
+    parallelFor(bodies.Size(), STEP_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            bodies.x[i] += bodies.vx[i]*deltaTime;
+            bodies.y[i] += bodies.vy[i]*deltaTime;
+            bodies.z[i] += bodies.vz[i]*deltaTime;
+        }
+    });
+}
+
+/**
+ * @brief Redivides space between the processes, and sends every body to the process that now owns it.
+ *
+ * Each process contributes up to samplesPerRank of its bodies as samples, sharing out between them
+ * the time its last force pass took, or its body count before the first pass. Every process gathers
+ * all the samples and builds the same decomposition from them.
+ */
+void DistributedWorld::Rebalance() {
+    stepsSinceBalance = 0;
+
+    size_t stride = std::max<size_t>(1, (bodies.Size() + samplesPerRank - 1)/samplesPerRank);
+    size_t sampleCount = (bodies.Size() + stride - 1)/stride;
+    double work = forceTime > 0.0 ? forceTime : (double)bodies.Size();
+    std::vector<double> localSamples;
+    localSamples.reserve(sampleCount*PACKED_SAMPLE_SIZE);
+    for (size_t i = 0; i < bodies.Size(); i += stride) {
+        localSamples.insert(localSamples.end(), {bodies.x[i], bodies.y[i], bodies.z[i], work/sampleCount});
+    }
+
+    int localCount = (int)localSamples.size();
+    std::vector<int> counts(rankCount), offsets;
+    MPI_Allgather(&localCount, 1, MPI_INT, counts.data(), 1, MPI_INT, communicator);
+    std::vector<double> allSamples(offsetsOf(counts, offsets));
+    MPI_Allgatherv(localSamples.data(), localCount, MPI_DOUBLE, allSamples.data(), counts.data(), offsets.data(), MPI_DOUBLE, communicator);
+
+    std::vector<DecompositionSample> samples(allSamples.size()/PACKED_SAMPLE_SIZE);
+    for (size_t s = 0; s < samples.size(); s++) {
+        const double* sample = &allSamples[s*PACKED_SAMPLE_SIZE];
+        samples[s] = DecompositionSample{glm::dvec3(sample[0], sample[1], sample[2]), sample[3]};
+    }
+    decomposition.Build(std::move(samples), rankCount);
+
+    // Migrate every body to its new owner, which is often this process again
+    std::vector<int> destinations(bodies.Size());
+    std::vector<int> sendCounts(rankCount, 0);
+    for (size_t i = 0; i < bodies.Size(); i++) {
+        destinations[i] = decomposition.RankOf(bodies.Position(i));
+        sendCounts[destinations[i]] += PACKED_BODY_SIZE;
+    }
+    std::vector<int> sendOffsets;
+    std::vector<double> sendBuffer(offsetsOf(sendCounts, sendOffsets));
+    for (size_t i = 0; i < bodies.Size(); i++) {
+        packBody(bodies, i, ids[i], &sendBuffer[sendOffsets[destinations[i]]]);
+        sendOffsets[destinations[i]] += PACKED_BODY_SIZE;
+    }
+
+    std::vector<double> receiveBuffer;
+    exchange(communicator, sendBuffer, sendCounts, receiveBuffer);
+    size_t receivedCount = receiveBuffer.size()/PACKED_BODY_SIZE;
+    bodies.Clear();
+    bodies.Reserve(receivedCount);
+    ids.resize(receivedCount);
+    for (size_t i = 0; i < receivedCount; i++) {
+        ids[i] = unpackBody(&receiveBuffer[i*PACKED_BODY_SIZE], bodies);
+    }
+}
+
+/**
+ * @brief Computes the accelerations of this process's bodies, trading locally essential trees with
+ * every other process.
+ */
+void DistributedWorld::computeAccelerations() {
+    const double infinity = std::numeric_limits<double>::infinity();
+    double box[6] = {infinity, infinity, infinity, -infinity, -infinity, -infinity};
+    for (size_t i = 0; i < bodies.Size(); i++) {
+        box[0] = std::min(box[0], bodies.x[i]);
+        box[1] = std::min(box[1], bodies.y[i]);
+        box[2] = std::min(box[2], bodies.z[i]);
+        box[3] = std::max(box[3], bodies.x[i]);
+        box[4] = std::max(box[4], bodies.y[i]);
+        box[5] = std::max(box[5], bodies.z[i]);
+    }
+    std::vector<double> boxes(6*rankCount);
+    MPI_Allgather(box, 6, MPI_DOUBLE, boxes.data(), 6, MPI_DOUBLE, communicator);
+
+    Clock::time_point exportStart = Clock::now();
+    localTree.Build(bodies, jobSystem);
+    std::vector<int> sendCounts(rankCount, 0);
+    std::vector<double> sendBuffer;
+    for (int r = 0; r < rankCount; r++) {
+        const double* other = &boxes[6*r];
+        // Processes with no bodies need nothing
+        if (r == rank || other[0] > other[3]) {
+            continue;
+        }
+        localTree.ExportEssential(bodies, glm::dvec3(other[0], other[1], other[2]), glm::dvec3(other[3], other[4], other[5]),
+                                  gravity.openingAngle, exported);
+        for (size_t k = 0; k < exported.count; k++) {
+            sendBuffer.insert(sendBuffer.end(), {exported.x[k], exported.y[k], exported.z[k], exported.mass[k]});
+        }
+        sendCounts[r] = (int)(exported.count*PACKED_SOURCE_SIZE);
+    }
+    double work = std::chrono::duration<double>(Clock::now() - exportStart).count();
+
+    std::vector<double> receiveBuffer;
+    exchange(communicator, sendBuffer, sendCounts, receiveBuffer);
+
+    Clock::time_point forceStart = Clock::now();
+    importedCount = receiveBuffer.size()/PACKED_SOURCE_SIZE;
+    imported.Clear();
+    for (size_t k = 0; k < importedCount; k++) {
+        const double* source = &receiveBuffer[k*PACKED_SOURCE_SIZE];
+        imported.Add(source[0], source[1], source[2], source[3]);
+    }
+    imported.Pad();
+    gravity.ComputeAccelerations(bodies, imported);
+    forceTime = work + std::chrono::duration<double>(Clock::now() - forceStart).count();
+}
+
+/**
+ * @brief Collects every body onto one process, in their original order.
+ *
+ * Every process must call this together.
+ *
+ * @param allBodies on the root process, receives every body; untouched elsewhere.
+ * @param root the process to collect onto.
+ */
+void DistributedWorld::Gather(BodyStore& allBodies, int root) const {
+    std::vector<double> packed(bodies.Size()*PACKED_BODY_SIZE);
+    for (size_t i = 0; i < bodies.Size(); i++) {
+        packBody(bodies, i, ids[i], &packed[i*PACKED_BODY_SIZE]);
+    }
+    int localCount = (int)packed.size();
+    std::vector<int> counts(rankCount), offsets;
+    MPI_Gather(&localCount, 1, MPI_INT, counts.data(), 1, MPI_INT, root, communicator);
+    std::vector<double> gathered;
+    if (rank == root) {
+        gathered.resize(offsetsOf(counts, offsets));
+    }
+    MPI_Gatherv(packed.data(), localCount, MPI_DOUBLE, gathered.data(), counts.data(), offsets.data(), MPI_DOUBLE, root, communicator);
+    if (rank != root) {
+        return;
+    }
+
+    size_t count = gathered.size()/PACKED_BODY_SIZE;
+    BodyStore unordered;
+    unordered.Reserve(count);
+    std::vector<uint64_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = unpackBody(&gathered[i*PACKED_BODY_SIZE], unordered);
+    }
+    std::vector<size_t> sorted(count);
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(), [&](size_t first, size_t second) { return order[first] < order[second]; });
+    allBodies.Clear();
+    allBodies.Reserve(count);
+    for (size_t i : sorted) {
+        allBodies.Add(unordered.Get(i));
+    }
+}
+
+/**
+ * @brief Counts the bodies on every process. Every process must call this together.
+ */
+uint64_t DistributedWorld::GlobalSize() const {
+    uint64_t localSize = bodies.Size();
+    uint64_t globalSize = 0;
+    MPI_Allreduce(&localSize, &globalSize, 1, MPI_UINT64_T, MPI_SUM, communicator);
+    return globalSize;
+}
+
+/**
+ * @brief Measures how unevenly the last force pass was spread, as the slowest process's time over the
+ * mean. Every process must call this together.
+ *
+ * @return 1 for perfect balance, rankCount at worst.
+ */
+double DistributedWorld::LoadImbalance() const {
+    double slowest = 0.0, total = 0.0;
+    MPI_Allreduce(&forceTime, &slowest, 1, MPI_DOUBLE, MPI_MAX, communicator);
+    MPI_Allreduce(&forceTime, &total, 1, MPI_DOUBLE, MPI_SUM, communicator);
+    return total > 0.0 ? slowest*rankCount/total : 1.0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <mpi.h>
+
+#include <Distributed/Decomposition.hpp>
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Gravity/Gravity.hpp>
+#include <Physics/Gravity/Octree.hpp>
+
+/**
+ * @brief The bodies of a simulation split across MPI processes, each stepping its own share.
+ *
+ * Space is divided between the processes by orthogonal recursive bisection, weighted by how long each
+ * process's force pass takes, and bodies migrate to the process that owns their region whenever the
+ * division is rebalanced. Between rebalances bodies may wander out of their region; that only costs
+ * balance, never accuracy.
+ *
+ * For each force pass every process builds an octree over its own bodies and sends each other process
+ * its locally essential tree: the nodes that every point in that process's bounding box would accept
+ * whole, and the bodies of the leaves it would open. Each process then computes the forces on its own
+ * bodies with the ordinary Gravity over its own tree, and sums what it was sent directly on top, so the
+ * imported nodes are never grouped again. Within each process the force pass runs on the job system
+ * as usual.
+ *
+ * Bodies are stepped with kick-drift-kick leapfrog. Collisions, rails and test particles are not
+ * distributed.
+ */
+class DistributedWorld {
+    private:
+        MPI_Comm communicator;
+        int rank = 0;
+        int rankCount = 1;
+        JobSystem* jobSystem = nullptr;
+
+        // The global index of each of this process's bodies
+        std::vector<uint64_t> ids;
+        Decomposition decomposition;
+        Octree localTree;
+        InteractionList exported;
+        // The sources the other processes sent, for the force pass
+        InteractionList imported;
+        // Seconds of work in this process's last force pass, not counting waiting on other processes
+        double forceTime = 0.0;
+        size_t importedCount = 0;
+        unsigned int stepsSinceBalance = 0;
+
+        void computeAccelerations();
+        void kick(double deltaTime);
+        void drift(double deltaTime);
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    public:
+        // Only this process's share of the bodies
+        BodyStore bodies;
+        Gravity gravity;
+        double time = 0.0;
+        // Steps between rebalances of the division of space
+        unsigned int rebalanceInterval = 16;
+        // Bodies each process contributes to the samples the division is built from
+        size_t samplesPerRank = 1024;
+
+        explicit DistributedWorld(MPI_Comm communicator = MPI_COMM_WORLD);
+
+        void SetJobSystem(JobSystem* jobSystem);
+        void Distribute(const BodyStore& allBodies);
+        void Initialise();
+        void Step(double deltaTime);
+        void Rebalance();
+        void Gather(BodyStore& allBodies, int root = 0) const;
+
+        int Rank() const { return rank; }
+        int RankCount() const { return rankCount; }
+        uint64_t GlobalSize() const;
+        size_t ImportedCount() const { return importedCount; }
+        double LoadImbalance() const;
+};
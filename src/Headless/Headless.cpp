@@ -0,0 +1,272 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/Ephemeris/Ephemeris.hpp>
+#include <Physics/Ephemeris/EphemerisWriter.hpp>
+#include <Physics/PhysicsWorld/PhysicsWorld.hpp>
+#include <Physics/Scenario/Scenario.hpp>
+#include <Physics/Trajectory/TrajectoryWriter.hpp>
+
+struct HeadlessOptions {
+    std::string scenario = "solar";
+    int asteroidCount = 1000;
+    long long steps = -1;
+    double duration = -1.0;
+    double timestep = 1.0/240.0;
+    long long snapshotInterval = 0;
+    std::string outputPath = "trajectory.traj";
+    TrajectoryCompression compression = TRAJECTORY_FLOAT64;
+    unsigned int threadCount = 0;
+    GravityMode mode = AUTOMATIC;
+    double openingAngle = 0.5;
+    std::string simd;
+    std::string integrator;
+    CollisionResponse collisions = IGNORE_COLLISIONS;
+    std::string ephemerisPath;
+    std::string recordEphemerisPath;
+    std::string importTablePath;
+    unsigned int ephemerisBodyCount = 7;
+    double ephemerisInterval = 0.25;
+};
+
+static void printUsage() {
+    std::cout <<
+        "Usage: SolarSystemHeadless [options]\n"
+        "Runs the gravity simulation with no window, GL context or assets.\n"
+        "\n"
+        "  --scenario <solar|belt|debris|rails>  system to simulate (default solar)\n"
+        "  --asteroids <n>              asteroids in the belt or rails scenario, or test particles in the debris field (default 1000)\n"
+        "  --steps <n>                  number of steps to run\n"
+        "  --time <t>                   simulated time to run for, instead of --steps\n"
+        "  --dt <t>                     step size (default 1/240)\n"
+        "  --snapshot-every <n>         record a frame every n steps (default: first and last only)\n"
+        "  --output <file>              trajectory file to record to (default trajectory.traj)\n"
+        "  --compression <float64|float32|delta16>  how to store recorded frames (default float64)\n"
+        "  --threads <n>                worker threads, 0 for one per hardware thread (default 0)\n"
+        "  --mode <auto|direct|barnes-hut>  force calculation (default auto)\n"
+        "  --theta <angle>              Barnes-Hut opening angle (default 0.5)\n"
+        "  --simd <scalar|sse2|avx2|avx512> force a SIMD level (default: best available)\n"
+        "  --integrator <leapfrog|yoshida4|block>  integration scheme (default: chosen by the scenario)\n"
+        "  --collisions <none|merge|bounce>  what bodies that touch do (default none)\n"
+        "  --ephemeris <file>           drive the bodies in an ephemeris file from it instead of integrating them\n"
+        "  --record-ephemeris <file>    fit an ephemeris to the first --ephemeris-bodies bodies while running\n"
+        "  --import-ephemeris <table>   fit the ephemeris given by --record-ephemeris to a text table, then exit\n"
+        "  --ephemeris-bodies <n>       bodies to record in the ephemeris (default 7, the star and planets)\n"
+        "  --ephemeris-interval <t>     time covered by each set of Chebyshev coefficients (default 0.25)\n";
+}
+
+/**
+ * @brief Parses the command line into a set of options.
+ *
+ * @throws std::runtime_error if an option is unknown or is missing its value.
+ */
+static HeadlessOptions parseArguments(int argc, char** argv) {
+    HeadlessOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--help" || argument == "-h") {
+            printUsage();
+            std::exit(EXIT_SUCCESS);
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("Missing value for option '" + argument + "'");
+        }
+        std::string value = argv[++i];
+
+        if (argument == "--scenario") {
+            options.scenario = value;
+        } else if (argument == "--asteroids") {
+            options.asteroidCount = std::stoi(value);
+        } else if (argument == "--steps") {
+            options.steps = std::stoll(value);
+        } else if (argument == "--time") {
+            options.duration = std::stod(value);
+        } else if (argument == "--dt") {
+            options.timestep = std::stod(value);
+        } else if (argument == "--snapshot-every") {
+            options.snapshotInterval = std::stoll(value);
+        } else if (argument == "--output") {
+            options.outputPath = value;
+        } else if (argument == "--compression") {
+            options.compression = TrajectoryCompressionFromString(value);
+        } else if (argument == "--threads") {
+            options.threadCount = (unsigned int)std::stoul(value);
+        } else if (argument == "--theta") {
+            options.openingAngle = std::stod(value);
+        } else if (argument == "--simd") {
+            options.simd = value;
+        } else if (argument == "--integrator") {
+            options.integrator = value;
+        } else if (argument == "--collisions") {
+            if (value == "none") {
+                options.collisions = IGNORE_COLLISIONS;
+            } else if (value == "merge") {
+                options.collisions = MERGE;
+            } else if (value == "bounce") {
+                options.collisions = BOUNCE;
+            } else {
+                throw std::runtime_error("Unknown collision response '" + value + "'");
+            }
+        } else if (argument == "--ephemeris") {
+            options.ephemerisPath = value;
+        } else if (argument == "--record-ephemeris") {
+            options.recordEphemerisPath = value;
+        } else if (argument == "--import-ephemeris") {
+            options.importTablePath = value;
+        } else if (argument == "--ephemeris-bodies") {
+            options.ephemerisBodyCount = (unsigned int)std::stoul(value);
+        } else if (argument == "--ephemeris-interval") {
+            options.ephemerisInterval = std::stod(value);
+        } else if (argument == "--mode") {
+            if (value == "auto") {
+                options.mode = AUTOMATIC;
+            } else if (value == "direct") {
+                options.mode = DIRECT_SUM;
+            } else if (value == "barnes-hut") {
+                options.mode = BARNES_HUT;
+            } else {
+                throw std::runtime_error("Unknown gravity mode '" + value + "'");
+            }
+        } else {
+            throw std::runtime_error("Unknown option '" + argument + "'");
+        }
+    }
+
+    if (!options.importTablePath.empty()) {
+        if (options.recordEphemerisPath.empty()) {
+            throw std::runtime_error("--import-ephemeris needs --record-ephemeris to say where to write it");
+        }
+        return options;
+    }
+    if (options.steps < 0 && options.duration < 0.0) {
+        throw std::runtime_error("One of --steps or --time is required");
+    }
+    if (options.timestep <= 0.0) {
+        throw std::runtime_error("--dt must be positive");
+    }
+    return options;
+}
+
+static SimdLevel parseSimdLevel(const std::string& name) {
+    if (name == "scalar") return SCALAR;
+    if (name == "sse2")   return SSE2;
+    if (name == "avx2")   return AVX2;
+    if (name == "avx512") return AVX512;
+    throw std::runtime_error("Unknown SIMD level '" + name + "'");
+}
+
+/**
+ * @brief Runs the simulation for the requested number of steps, writing snapshots along the way.
+ */
+static void run(const HeadlessOptions& options) {
+    if (!options.importTablePath.empty()) {
+        ImportEphemerisTable(options.importTablePath, options.recordEphemerisPath, options.ephemerisInterval);
+        std::cout << "Fitted " << options.importTablePath << " to " << options.recordEphemerisPath << std::endl;
+        return;
+    }
+
+    JobSystem jobSystem(options.threadCount);
+    PhysicsWorld world;
+    world.SetJobSystem(&jobSystem);
+    world.gravity.mode = options.mode;
+    world.gravity.openingAngle = options.openingAngle;
+    world.collisions.response = options.collisions;
+    if (!options.simd.empty()) {
+        world.gravity.SetSimdLevel(parseSimdLevel(options.simd));
+        world.rails.SetSimdLevel(world.gravity.GetSimdLevel());
+    }
+
+    SetUpScenario(options.scenario, world, options.asteroidCount);
+    if (!options.integrator.empty()) {
+        world.SetIntegrator(IntegratorTypeFromString(options.integrator));
+    }
+    std::unique_ptr<Ephemeris> ephemeris;
+    if (!options.ephemerisPath.empty()) {
+        ephemeris.reset(new Ephemeris(options.ephemerisPath));
+        world.SetEphemeris(ephemeris.get());
+    }
+    world.Initialise();
+
+    std::unique_ptr<EphemerisWriter> ephemerisWriter;
+    if (!options.recordEphemerisPath.empty()) {
+        std::vector<unsigned int> indices;
+        for (unsigned int i = 0; i < options.ephemerisBodyCount && i < world.bodies.Size(); i++) {
+            indices.push_back(i);
+        }
+        ephemerisWriter.reset(new EphemerisWriter(options.recordEphemerisPath, world.bodies, indices, world.time, options.ephemerisInterval));
+        // Every step is sampled, so the positions alone pin the fit down
+        ephemerisWriter->velocityWeight = 0.0;
+        ephemerisWriter->AddSample(world.time, world.bodies);
+    }
+
+    long long totalSteps = options.steps >= 0 ? options.steps : (long long)std::ceil(options.duration/options.timestep - 1e-9);
+    std::filesystem::path outputPath(options.outputPath);
+    if (outputPath.has_parent_path()) {
+        std::filesystem::create_directories(outputPath.parent_path());
+    }
+    // Merging changes masses and radii, so they have to be recorded with every frame
+    TrajectoryWriter trajectory(options.outputPath, world.bodies, options.compression,
+                                options.collisions == MERGE ? TRAJECTORY_FRAME_BODIES : 0);
+
+    std::cout << "Simulating " << world.bodies.Size() << " bodies and " << world.particles.Size() << " test particles for " << totalSteps << " steps on "
+              << jobSystem.ThreadCount() << " threads (" << SimdLevelToString(world.gravity.GetSimdLevel()) << ", "
+              << (world.gravity.ResolveMode(world.bodies.Size()) == BARNES_HUT ? "Barnes-Hut" : "direct sum") << ", "
+              << world.GetIntegrator().GetName() << ")" << std::endl;
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto lastReport = startTime;
+    trajectory.WriteFrame(world.bodies, 0, world.time);
+    for (long long step = 1; step <= totalSteps; step++) {
+        world.Step(options.timestep);
+        if (ephemerisWriter) {
+            ephemerisWriter->AddSample(world.time, world.bodies);
+        }
+
+        bool isLastStep = step == totalSteps;
+        if (isLastStep || (options.snapshotInterval > 0 && step % options.snapshotInterval == 0)) {
+            trajectory.WriteFrame(world.bodies, step, world.time);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (isLastStep || std::chrono::duration<double>(now - lastReport).count() >= 5.0) {
+            double elapsed = std::chrono::duration<double>(now - startTime).count();
+            std::cout << "Step " << step << "/" << totalSteps << " | t = " << world.time
+                      << " | " << std::fixed << std::setprecision(1) << step/elapsed << " steps/s" << std::defaultfloat << std::endl;
+            lastReport = now;
+        }
+    }
+
+    trajectory.Close();
+    std::cout << "Recorded " << trajectory.FramesQueued() << " frames to " << options.outputPath << std::endl;
+    if (ephemerisWriter) {
+        ephemerisWriter->Close();
+        std::cout << "Fitted " << ephemerisWriter->IntervalsWritten() << " ephemeris intervals to " << options.recordEphemerisPath << std::endl;
+    }
+}
+
+/**
+ * @brief Entry point of the headless simulation.
+ *
+ * @return int Exit status of the program.
+ */
+int main(int argc, char** argv) {
+    try {
+        run(parseArguments(argc, argv));
+    }
+    catch(const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+#include <JobSystem/JobSystem.hpp>
+
+#include <algorithm>
+
+// The job system the current thread is a worker of, and its queue index in that system
+static thread_local JobSystem* currentJobSystem = nullptr;
+static thread_local unsigned int currentQueueIndex = 0;
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param workerCount the number of worker threads to start. 0 picks one per hardware thread, less
+ * one for the thread that submits work, which also runs jobs while it waits for them.
+ */
+JobSystem::JobSystem(unsigned int workerCount) {
+    if (workerCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    for (unsigned int i = 0; i < workerCount + 1; i++) {
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, i + 1));
+    }
+}
+
+/**
+ * @brief Stops and joins the worker threads.
+ *
+ * Jobs that are still queued are discarded, so anything that matters must be waited on first.
+ */
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isRunning = false;
+    }
+    sleepCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Main loop of a worker thread: run jobs, stealing when out of work, and sleep when idle.
+ *
+ * @param queueIndex the index of the worker's own queue.
+ */
+void JobSystem::workerLoop(unsigned int queueIndex) {
+    currentJobSystem = this;
+    currentQueueIndex = queueIndex;
+
+    while (isRunning) {
+        if (tryRunJob(queueIndex)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [this]() { return !isRunning || queuedJobs > 0; });
+    }
+}
+
+/**
+ * @brief Pushes a job onto the calling thread's queue and wakes a sleeping worker.
+ */
+void JobSystem::push(Job job) {
+    unsigned int queueIndex = currentJobSystem == this ? currentQueueIndex : 0;
+    {
+        // Count the job before it becomes visible, so a thief can never take the count below zero.
+        // Taking the lock stops the notification slipping in between a worker's check and its wait.
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->jobs.push_back(std::move(job));
+    }
+    sleepCondition.notify_one();
+}
+
+/**
+ * @brief Takes the most recently pushed job from a thread's own queue.
+ */
+bool JobSystem::popJob(unsigned int queueIndex, Job& job) {
+    WorkQueue& queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) {
+        return false;
+    }
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+/**
+ * @brief Takes the oldest job from some other thread's queue.
+ *
+ * Victims are visited round-robin starting after the thief, so thieves spread out over the queues.
+ */
+bool JobSystem::stealJob(unsigned int thiefIndex, Job& job) {
+    unsigned int queueCount = (unsigned int)queues.size();
+    for (unsigned int offset = 1; offset < queueCount; offset++) {
+        WorkQueue& queue = *queues[(thiefIndex + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Runs one job from the given queue, or stolen from another queue if it is empty.
+ *
+ * @param queueIndex the queue of the calling thread.
+ * @return true if a job was run.
+ */
+bool JobSystem::tryRunJob(unsigned int queueIndex) {
+    Job job;
+    if (!popJob(queueIndex, job) && !stealJob(queueIndex, job)) {
+        return false;
+    }
+    queuedJobs--;
+
+    job.function();
+    if (job.remaining != nullptr) {
+        job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return true;
+}
+
+/**
+ * @brief Queues a job without any way to wait for it.
+ *
+ * @param job the function to run on a worker thread.
+ */
+void JobSystem::Submit(std::function<void()> job) {
+    push(Job{std::move(job), nullptr});
+}
+
+/**
+ * @brief Queues a job that decrements a counter once it has finished.
+ *
+ * The counter must already include this job, and must outlive it.
+ *
+ * @param job the function to run on a worker thread.
+ * @param remaining the counter to decrement when the job completes.
+ */
+void JobSystem::Submit(std::function<void()> job, std::atomic<size_t>& remaining) {
+    push(Job{std::move(job), &remaining});
+}
+
+/**
+ * @brief Waits until a counter reaches zero, running queued jobs in the meantime.
+ *
+ * @param remaining the counter to wait on.
+ */
+void JobSystem::Wait(std::atomic<size_t>& remaining) {
+    unsigned int queueIndex = currentJobSystem == this ? currentQueueIndex : 0;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!tryRunJob(queueIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**
+ * @brief Runs a function over a range, split into chunks spread across every thread.
+ *
+ * The calling thread runs chunks too, and returns once every chunk is done.
+ *
+ * @param begin the start of the range.
+ * @param end one past the end of the range.
+ * @param grainSize the smallest chunk worth giving to a thread.
+ * @param body the function to run, taking the start and end of a chunk.
+ */
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (end <= begin) {
+        return;
+    }
+    size_t count = end - begin;
+    // A few chunks per thread lets stealing even out chunks that take different amounts of time
+    size_t chunkCount = std::min(std::max<size_t>(count/std::max<size_t>(grainSize, 1), 1), (size_t)ThreadCount()*4);
+    if (chunkCount == 1) {
+        body(begin, end);
+        return;
+    }
+
+    size_t chunkSize = (count + chunkCount - 1)/chunkCount;
+    std::atomic<size_t> remaining(0);
+    for (size_t chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize) {
+        size_t chunkEnd = std::min(chunkBegin + chunkSize, end);
+        remaining++;
+        Submit([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }, remaining);
+    }
+
+    body(begin, std::min(begin + chunkSize, end));
+    Wait(remaining);
+}
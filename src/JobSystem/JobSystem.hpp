@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Pool of worker threads that share work through per-thread work-stealing deques.
+ *
+ * Every worker owns a deque: it pushes and pops jobs at the back, while idle threads steal from the
+ * front of other threads' deques. Threads that aren't workers (e.g. the main thread) submit into a
+ * shared deque. A thread waiting on jobs runs other jobs while it waits, so jobs can safely
+ * spawn and wait on further jobs.
+ */
+class JobSystem {
+    private:
+        struct Job {
+            std::function<void()> function;
+            std::atomic<size_t>* remaining;
+        };
+
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        std::vector<std::thread> workers;
+        // Queue 0 is shared by every non-worker thread, queue i + 1 belongs to worker i
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::atomic<size_t> queuedJobs{0};
+        std::atomic<bool> isRunning{true};
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+
+        void workerLoop(unsigned int workerIndex);
+        void push(Job job);
+        bool tryRunJob(unsigned int queueIndex);
+        bool popJob(unsigned int queueIndex, Job& job);
+        bool stealJob(unsigned int thiefIndex, Job& job);
+
+    public:
+        explicit JobSystem(unsigned int workerCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        unsigned int WorkerCount() const { return (unsigned int)workers.size(); }
+        unsigned int ThreadCount() const { return (unsigned int)workers.size() + 1; }
+
+        void Submit(std::function<void()> job);
+        void Submit(std::function<void()> job, std::atomic<size_t>& remaining);
+        void Wait(std::atomic<size_t>& remaining);
+        void ParallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief State of a single gravitating body.
+ *
+ * Positions, velocities and masses are kept in double precision, as single precision
+ * loses too much accuracy over long orbital integrations.
+ */
+struct Body {
+    glm::dvec3 position;
+    glm::dvec3 velocity;
+    glm::dvec3 acceleration;
+    double mass;
+    double radius;
+
+    Body(glm::dvec3 position, glm::dvec3 velocity, double mass, double radius) {
+        this->position = position;
+        this->velocity = velocity;
+        this->acceleration = glm::dvec3(0.0);
+        this->mass = mass;
+        this->radius = radius;
+    }
+};
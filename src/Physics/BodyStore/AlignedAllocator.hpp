@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
+
+/**
+ * @brief Standard library allocator that returns memory aligned to the given boundary.
+ *
+ * Used for the structure-of-arrays body data so SIMD kernels can stream it with aligned loads and
+ * so no array ever straddles a cache line at its start.
+ */
+template <typename T, std::size_t Alignment>
+class AlignedAllocator {
+    public:
+        typedef T value_type;
+
+        template <typename U>
+        struct rebind {
+            typedef AlignedAllocator<U, Alignment> other;
+        };
+
+        AlignedAllocator() {}
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+        T* allocate(std::size_t count) {
+            if (count == 0) {
+                return nullptr;
+            }
+            std::size_t bytes = ((count*sizeof(T) + Alignment - 1)/Alignment)*Alignment;
+#ifdef _WIN32
+            void* memory = _aligned_malloc(bytes, Alignment);
+#else
+            void* memory = std::aligned_alloc(Alignment, bytes);
+#endif
+            if (memory == nullptr) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(memory);
+        }
+
+        void deallocate(T* memory, std::size_t) {
+#ifdef _WIN32
+            _aligned_free(memory);
+#else
+            std::free(memory);
+#endif
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+        template <typename U>
+        bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// 64 bytes covers both AVX-512 register width and a cache line
+const std::size_t SIMD_ALIGNMENT = 64;
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, SIMD_ALIGNMENT>>;
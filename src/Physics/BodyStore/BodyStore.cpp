@@ -0,0 +1,102 @@
+#include <Physics/BodyStore/BodyStore.hpp>
+
+/**
+ * @brief Rounds a body count up to the next multiple of BODY_STORE_PADDING.
+ */
+static std::size_t paddedCount(std::size_t count) {
+    return ((count + BODY_STORE_PADDING - 1)/BODY_STORE_PADDING)*BODY_STORE_PADDING;
+}
+
+/**
+ * @brief Resizes every component array, filling any new entries with zeros.
+ *
+ * @param size the new size of the arrays, including padding.
+ */
+void BodyStore::resizeArrays(std::size_t size) {
+    x.resize(size, 0.0);
+    y.resize(size, 0.0);
+    z.resize(size, 0.0);
+    vx.resize(size, 0.0);
+    vy.resize(size, 0.0);
+    vz.resize(size, 0.0);
+    ax.resize(size, 0.0);
+    ay.resize(size, 0.0);
+    az.resize(size, 0.0);
+    mass.resize(size, 0.0);
+    radius.resize(size, 0.0);
+}
+
+/**
+ * @brief Reserves space for the given number of bodies so adding them doesn't reallocate.
+ *
+ * @param capacity the number of bodies to reserve space for.
+ */
+void BodyStore::Reserve(std::size_t capacity) {
+    std::size_t size = paddedCount(capacity);
+    x.reserve(size);
+    y.reserve(size);
+    z.reserve(size);
+    vx.reserve(size);
+    vy.reserve(size);
+    vz.reserve(size);
+    ax.reserve(size);
+    ay.reserve(size);
+    az.reserve(size);
+    mass.reserve(size);
+    radius.reserve(size);
+}
+
+/**
+ * @brief Removes every body from the store.
+ */
+void BodyStore::Clear() {
+    count = 0;
+    resizeArrays(0);
+}
+
+/**
+ * @brief Appends a body to the end of the store.
+ *
+ * The slot the body is written to was previously padding, so it is already zeroed.
+ *
+ * @param body the body to add.
+ */
+void BodyStore::Add(const Body& body) {
+    std::size_t index = count++;
+    if (count > x.size()) {
+        resizeArrays(paddedCount(count));
+    }
+    Set(index, body);
+}
+
+/**
+ * @brief Gathers the components of a body into a single Body.
+ *
+ * @param index the index of the body.
+ * @return a copy of the body's state.
+ */
+Body BodyStore::Get(std::size_t index) const {
+    Body body(Position(index), Velocity(index), mass[index], radius[index]);
+    body.acceleration = Acceleration(index);
+    return body;
+}
+
+/**
+ * @brief Scatters the state of a Body into the component arrays.
+ *
+ * @param index the index of the body to overwrite.
+ * @param body the new state of the body.
+ */
+void BodyStore::Set(std::size_t index, const Body& body) {
+    x[index] = body.position.x;
+    y[index] = body.position.y;
+    z[index] = body.position.z;
+    vx[index] = body.velocity.x;
+    vy[index] = body.velocity.y;
+    vz[index] = body.velocity.z;
+    ax[index] = body.acceleration.x;
+    ay[index] = body.acceleration.y;
+    az[index] = body.acceleration.z;
+    mass[index] = body.mass;
+    radius[index] = body.radius;
+}
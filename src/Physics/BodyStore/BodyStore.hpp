@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Physics/Body/Body.hpp>
+#include <Physics/BodyStore/AlignedAllocator.hpp>
+
+// Arrays are padded to a multiple of this many entries so SIMD kernels never need a remainder loop
+const std::size_t BODY_STORE_PADDING = 8;
+
+/**
+ * @brief Structure-of-arrays storage for the state of every body in the simulation.
+ *
+ * Each component lives in its own contiguous, SIMD-aligned array. The arrays are padded past
+ * Size() up to PaddedSize() with massless bodies at the origin, which contribute nothing to any
+ * force sum, so kernels can run over whole SIMD blocks.
+ */
+class BodyStore {
+    private:
+        std::size_t count = 0;
+
+        void resizeArrays(std::size_t size);
+
+    public:
+        AlignedVector<double> x, y, z;
+        AlignedVector<double> vx, vy, vz;
+        AlignedVector<double> ax, ay, az;
+        AlignedVector<double> mass;
+        AlignedVector<double> radius;
+
+        std::size_t Size() const { return count; }
+        std::size_t PaddedSize() const { return x.size(); }
+        bool Empty() const { return count == 0; }
+
+        void Reserve(std::size_t capacity);
+        void Clear();
+        void Add(const Body& body);
+        Body Get(std::size_t index) const;
+        void Set(std::size_t index, const Body& body);
+
+        glm::dvec3 Position(std::size_t index) const { return glm::dvec3(x[index], y[index], z[index]); }
+        glm::dvec3 Velocity(std::size_t index) const { return glm::dvec3(vx[index], vy[index], vz[index]); }
+        glm::dvec3 Acceleration(std::size_t index) const { return glm::dvec3(ax[index], ay[index], az[index]); }
+};
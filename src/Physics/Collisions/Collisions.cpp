@@ -0,0 +1,414 @@
+#include <Physics/Collisions/Collisions.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+// Smallest number of bodies worth handing to another thread when hashing or finding pairs
+static const size_t HASH_GRAIN_SIZE = 4096;
+static const size_t CONTACT_GRAIN_SIZE = 1024;
+static const size_t LARGE_BODY_GRAIN_SIZE = 16;
+static const uint32_t NOT_HASHED = ~0u;
+
+/**
+ * @brief Records where every body is at the start of a step, for the swept tests at the end of it.
+ *
+ * @param bodies the bodies about to be stepped.
+ */
+void Collisions::BeginStep(const BodyStore& bodies) {
+    startX.assign(bodies.x.begin(), bodies.x.begin() + bodies.Size());
+    startY.assign(bodies.y.begin(), bodies.y.begin() + bodies.Size());
+    startZ.assign(bodies.z.begin(), bodies.z.begin() + bodies.Size());
+}
+
+/**
+ * @brief Finds every contact during the step just taken and resolves it according to the response.
+ *
+ * Bodies that changed in a merge or bounce keep the accelerations they had, which for a merge is the
+ * mass-weighted average of the pair's, so integrators can carry on without another force calculation.
+ *
+ * @param bodies the bodies, at the end of the step. BeginStep must have been called before the step.
+ * @param deltaTime the length of the step.
+ * @return the number of contacts resolved.
+ */
+size_t Collisions::Resolve(BodyStore& bodies, double deltaTime) {
+    if (response == IGNORE_COLLISIONS || bodies.Size() < 2) {
+        return 0;
+    }
+    if (startX.size() != bodies.Size()) {
+        // Nothing was recorded for this step, so treat the bodies as having been still
+        BeginStep(bodies);
+    }
+
+    buildHash(bodies);
+    findContacts(bodies);
+    std::sort(contacts.begin(), contacts.end(), [](const Contact& first, const Contact& second) {
+        if (first.time != second.time) return first.time < second.time;
+        if (first.a != second.a) return first.a < second.a;
+        return first.b < second.b;
+    });
+
+    // Each body takes part in at most its first contact; any later ones are found again next step
+    isResolved.assign(bodies.Size(), 0);
+    size_t resolvedCount = 0;
+    for (const auto& contact : contacts) {
+        if (isResolved[contact.a] || isResolved[contact.b]) {
+            continue;
+        }
+        isResolved[contact.a] = isResolved[contact.b] = 1;
+        if (response == MERGE) {
+            merge(bodies, contact.a, contact.b);
+        }
+        else {
+            bounce(bodies, contact.a, contact.b, contact.time, deltaTime);
+        }
+        resolvedCount++;
+    }
+    return resolvedCount;
+}
+
+/**
+ * @brief Runs a loop over [0, count) on the job system, or on this thread if there isn't one.
+ */
+void Collisions::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (jobSystem == nullptr) {
+        body(0, count);
+    }
+    else {
+        jobSystem->ParallelFor(0, count, grainSize, body);
+    }
+}
+
+/**
+ * @brief Hashes a cell's coordinates to a bucket of the table.
+ */
+size_t Collisions::cellHash(int64_t x, int64_t y, int64_t z) const {
+    uint64_t hash = (uint64_t)x*0x9E3779B97F4A7C15ull ^ (uint64_t)y*0xC2B2AE3D27D4EB4Full ^ (uint64_t)z*0x165667B19E3779F9ull;
+    hash ^= hash >> 29;
+    return (size_t)hash & tableMask;
+}
+
+/**
+ * @brief Sorts the bodies into the spatial hash.
+ *
+ * The cell size is picked from the swept diameters, so almost every body fits in one cell, and the
+ * rest go on the list of large bodies. Bucket sizes are counted and the bodies scattered into place
+ * in parallel, with atomic counters, so the order within a bucket varies from run to run; contacts
+ * are sorted before they are resolved, so the results don't.
+ */
+void Collisions::buildHash(const BodyStore& bodies) {
+    size_t count = bodies.Size();
+    sweptRadii.resize(count);
+    parallelFor(count, HASH_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            double dx = bodies.x[i] - startX[i], dy = bodies.y[i] - startY[i], dz = bodies.z[i] - startZ[i];
+            sweptRadii[i] = bodies.radius[i] > 0.0 ? bodies.radius[i] + 0.5*std::sqrt(dx*dx + dy*dy + dz*dz) : 0.0;
+        }
+    });
+
+    std::vector<double> diameters;
+    diameters.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        if (sweptRadii[i] > 0.0) {
+            diameters.push_back(2.0*sweptRadii[i]);
+        }
+    }
+    if (diameters.empty()) {
+        cellSize = 1.0;
+    }
+    else {
+        size_t quantile = std::min((size_t)(cellSizeQuantile*(double)diameters.size()), diameters.size() - 1);
+        std::nth_element(diameters.begin(), diameters.begin() + quantile, diameters.end());
+        cellSize = std::max(diameters[quantile], 1e-9);
+    }
+
+    size_t tableSize = 1;
+    while (tableSize < 2*count) {
+        tableSize *= 2;
+    }
+    tableMask = tableSize - 1;
+    if (cellCountsCapacity < tableSize) {
+        cellCounts.reset(new std::atomic<uint32_t>[tableSize]);
+        cellCountsCapacity = tableSize;
+    }
+    parallelFor(tableSize, HASH_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t h = begin; h < end; h++) {
+            cellCounts[h].store(0, std::memory_order_relaxed);
+        }
+    });
+
+    // Ordinary bodies are hashed by the cell holding the middle of their sweep
+    bodyCells.resize(count);
+    parallelFor(count, HASH_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (sweptRadii[i] == 0.0 || 2.0*sweptRadii[i] > cellSize) {
+                bodyCells[i] = NOT_HASHED;
+                continue;
+            }
+            int64_t cellX = (int64_t)std::floor(0.5*(startX[i] + bodies.x[i])/cellSize);
+            int64_t cellY = (int64_t)std::floor(0.5*(startY[i] + bodies.y[i])/cellSize);
+            int64_t cellZ = (int64_t)std::floor(0.5*(startZ[i] + bodies.z[i])/cellSize);
+            bodyCells[i] = (uint32_t)cellHash(cellX, cellY, cellZ);
+            cellCounts[bodyCells[i]].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    cellStart.resize(tableSize + 1);
+    uint32_t offset = 0;
+    for (size_t h = 0; h < tableSize; h++) {
+        cellStart[h] = offset;
+        offset += cellCounts[h].load(std::memory_order_relaxed);
+        cellCounts[h].store(cellStart[h], std::memory_order_relaxed);
+    }
+    cellStart[tableSize] = offset;
+
+    cellBodies.resize(offset);
+    parallelFor(count, HASH_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (bodyCells[i] != NOT_HASHED) {
+                cellBodies[cellCounts[bodyCells[i]].fetch_add(1, std::memory_order_relaxed)] = (uint32_t)i;
+            }
+        }
+    });
+
+    // Large bodies are kept in order of the low x edge of their sweeps, to be swept and pruned
+    largeBodies.clear();
+    for (unsigned int i = 0; i < count; i++) {
+        if (bodyCells[i] == NOT_HASHED && sweptRadii[i] > 0.0) {
+            largeBodies.push_back(i);
+        }
+    }
+    auto lowX = [&](unsigned int i) { return 0.5*(startX[i] + bodies.x[i]) - sweptRadii[i]; };
+    std::sort(largeBodies.begin(), largeBodies.end(), [&](unsigned int first, unsigned int second) {
+        return lowX(first) < lowX(second);
+    });
+}
+
+/**
+ * @brief Finds every pair of bodies that touch during the step.
+ *
+ * Two ordinary bodies that touch have swept centres less than a cell apart, so each only needs testing
+ * against the 27 cells around its own, and each pair is tested from its lower index. Large bodies test
+ * every bucket their swept bounds cover, or every ordinary body if that would be fewer, and are swept
+ * and pruned along x against each other.
+ */
+void Collisions::findContacts(const BodyStore& bodies) {
+    contacts.clear();
+    std::mutex contactsMutex;
+    auto addContacts = [&](const std::vector<Contact>& found) {
+        if (!found.empty()) {
+            std::lock_guard<std::mutex> lock(contactsMutex);
+            contacts.insert(contacts.end(), found.begin(), found.end());
+        }
+    };
+
+    parallelFor(bodies.Size(), CONTACT_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        std::vector<Contact> found;
+        size_t buckets[27];
+        for (size_t i = begin; i < end; i++) {
+            if (bodyCells[i] == NOT_HASHED) {
+                continue;
+            }
+            int64_t cellX = (int64_t)std::floor(0.5*(startX[i] + bodies.x[i])/cellSize);
+            int64_t cellY = (int64_t)std::floor(0.5*(startY[i] + bodies.y[i])/cellSize);
+            int64_t cellZ = (int64_t)std::floor(0.5*(startZ[i] + bodies.z[i])/cellSize);
+
+            // Neighbouring cells can share a bucket, which must only be searched once
+            int bucketCount = 0;
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dz = -1; dz <= 1; dz++) {
+                        size_t bucket = cellHash(cellX + dx, cellY + dy, cellZ + dz);
+                        if (std::find(buckets, buckets + bucketCount, bucket) == buckets + bucketCount) {
+                            buckets[bucketCount++] = bucket;
+                        }
+                    }
+                }
+            }
+
+            for (int k = 0; k < bucketCount; k++) {
+                for (uint32_t slot = cellStart[buckets[k]]; slot < cellStart[buckets[k] + 1]; slot++) {
+                    unsigned int j = cellBodies[slot];
+                    double time;
+                    if (j > i && sweptContact(bodies, (unsigned int)i, j, time)) {
+                        found.push_back({(unsigned int)i, j, time});
+                    }
+                }
+            }
+        }
+        addContacts(found);
+    });
+
+    parallelFor(largeBodies.size(), LARGE_BODY_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        std::vector<Contact> found;
+        std::vector<size_t> buckets;
+        auto test = [&](unsigned int a, unsigned int b) {
+            double time;
+            if (sweptContact(bodies, std::min(a, b), std::max(a, b), time)) {
+                found.push_back({std::min(a, b), std::max(a, b), time});
+            }
+        };
+
+        for (size_t l = begin; l < end; l++) {
+            unsigned int i = largeBodies[l];
+            double highX = 0.5*(startX[i] + bodies.x[i]) + sweptRadii[i];
+            for (size_t m = l + 1; m < largeBodies.size(); m++) {
+                unsigned int j = largeBodies[m];
+                if (0.5*(startX[j] + bodies.x[j]) - sweptRadii[j] > highX) {
+                    break;
+                }
+                test(i, j);
+            }
+
+            // Any ordinary body that could touch this one has its swept centre within half a cell of its bounds
+            double reach = sweptRadii[i] + 0.5*cellSize;
+            double centre[3] = {0.5*(startX[i] + bodies.x[i]), 0.5*(startY[i] + bodies.y[i]), 0.5*(startZ[i] + bodies.z[i])};
+            int64_t low[3], high[3];
+            double cells = 1.0;
+            for (int axis = 0; axis < 3; axis++) {
+                low[axis] = (int64_t)std::floor((centre[axis] - reach)/cellSize);
+                high[axis] = (int64_t)std::floor((centre[axis] + reach)/cellSize);
+                cells *= (double)(high[axis] - low[axis] + 1);
+            }
+
+            if (cells >= (double)cellBodies.size()) {
+                for (uint32_t j : cellBodies) {
+                    test(i, j);
+                }
+                continue;
+            }
+            buckets.clear();
+            for (int64_t cellX = low[0]; cellX <= high[0]; cellX++) {
+                for (int64_t cellY = low[1]; cellY <= high[1]; cellY++) {
+                    for (int64_t cellZ = low[2]; cellZ <= high[2]; cellZ++) {
+                        buckets.push_back(cellHash(cellX, cellY, cellZ));
+                    }
+                }
+            }
+            std::sort(buckets.begin(), buckets.end());
+            buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+            for (size_t bucket : buckets) {
+                for (uint32_t slot = cellStart[bucket]; slot < cellStart[bucket + 1]; slot++) {
+                    test(i, cellBodies[slot]);
+                }
+            }
+        }
+        addContacts(found);
+    });
+}
+
+/**
+ * @brief Tests whether two spheres moving in straight lines over the step touch.
+ *
+ * @param bodies the bodies, at the end of the step.
+ * @param a, b the two bodies.
+ * @param time receives the fraction of the step at which they first touch; 0 if they started touching.
+ * @return whether they touch at any point during the step.
+ */
+bool Collisions::sweptContact(const BodyStore& bodies, unsigned int a, unsigned int b, double& time) const {
+    // Separation at the start, and how it changes over the step
+    double sx = startX[b] - startX[a], sy = startY[b] - startY[a], sz = startZ[b] - startZ[a];
+    double dx = (bodies.x[b] - startX[b]) - (bodies.x[a] - startX[a]);
+    double dy = (bodies.y[b] - startY[b]) - (bodies.y[a] - startY[a]);
+    double dz = (bodies.z[b] - startZ[b]) - (bodies.z[a] - startZ[a]);
+    double contactDistance = bodies.radius[a] + bodies.radius[b];
+
+    double c = sx*sx + sy*sy + sz*sz - contactDistance*contactDistance;
+    if (c <= 0.0) {
+        time = 0.0;
+        return true;
+    }
+    // Solve |s + t*d| = contactDistance for the first t in [0, 1]
+    double a2 = dx*dx + dy*dy + dz*dz;
+    double b2 = sx*dx + sy*dy + sz*dz;
+    if (a2 == 0.0 || b2 >= 0.0) {
+        return false;
+    }
+    double discriminant = b2*b2 - a2*c;
+    if (discriminant < 0.0) {
+        return false;
+    }
+    time = (-b2 - std::sqrt(discriminant))/a2;
+    return time <= 1.0;
+}
+
+/**
+ * @brief Merges two bodies into the heavier of them, conserving mass and momentum.
+ *
+ * The merged body sits at the pair's centre of mass with the volume of both. The lighter body is left
+ * where the merged one is, with no mass and no radius.
+ */
+void Collisions::merge(BodyStore& bodies, unsigned int a, unsigned int b) {
+    double totalMass = bodies.mass[a] + bodies.mass[b];
+    if (totalMass <= 0.0) {
+        return;
+    }
+    unsigned int survivor = bodies.mass[b] > bodies.mass[a] ? b : a;
+    unsigned int remnant = survivor == a ? b : a;
+    double weightA = bodies.mass[a]/totalMass;
+    double weightB = bodies.mass[b]/totalMass;
+
+    Body merged = bodies.Get(survivor);
+    merged.position = weightA*bodies.Position(a) + weightB*bodies.Position(b);
+    merged.velocity = weightA*bodies.Velocity(a) + weightB*bodies.Velocity(b);
+    merged.acceleration = weightA*bodies.Acceleration(a) + weightB*bodies.Acceleration(b);
+    merged.mass = totalMass;
+    merged.radius = std::cbrt(std::pow(bodies.radius[a], 3.0) + std::pow(bodies.radius[b], 3.0));
+    bodies.Set(survivor, merged);
+
+    merged.mass = 0.0;
+    merged.radius = 0.0;
+    bodies.Set(remnant, merged);
+}
+
+/**
+ * @brief Bounces two bodies off each other, conserving momentum.
+ *
+ * The bodies are wound back to where they touched, their velocities along the line between them are
+ * exchanged (scaled by the restitution), and they carry on for the rest of the step. Bodies that
+ * started the step overlapping are also pushed apart until they only just touch.
+ */
+void Collisions::bounce(BodyStore& bodies, unsigned int a, unsigned int b, double time, double deltaTime) {
+    double massA = bodies.mass[a], massB = bodies.mass[b];
+    double totalMass = massA + massB;
+    if (totalMass <= 0.0) {
+        return;
+    }
+
+    glm::dvec3 startA(startX[a], startY[a], startZ[a]);
+    glm::dvec3 startB(startX[b], startY[b], startZ[b]);
+    glm::dvec3 contactA = startA + time*(bodies.Position(a) - startA);
+    glm::dvec3 contactB = startB + time*(bodies.Position(b) - startB);
+    glm::dvec3 normal = contactB - contactA;
+    double distance = glm::length(normal);
+    if (distance == 0.0) {
+        return;
+    }
+    normal /= distance;
+
+    glm::dvec3 velocityA = bodies.Velocity(a);
+    glm::dvec3 velocityB = bodies.Velocity(b);
+    double approachSpeed = glm::dot(velocityB - velocityA, normal);
+    if (approachSpeed >= 0.0) {
+        // Already moving apart
+        return;
+    }
+    velocityA += (1.0 + restitution)*approachSpeed*(massB/totalMass)*normal;
+    velocityB -= (1.0 + restitution)*approachSpeed*(massA/totalMass)*normal;
+
+    glm::dvec3 positionA = contactA + (1.0 - time)*deltaTime*velocityA;
+    glm::dvec3 positionB = contactB + (1.0 - time)*deltaTime*velocityB;
+    glm::dvec3 separation = positionB - positionA;
+    double separationLength = glm::length(separation);
+    double overlap = bodies.radius[a] + bodies.radius[b] - separationLength;
+    if (overlap > 0.0 && separationLength > 0.0) {
+        separation /= separationLength;
+        positionA -= overlap*(massB/totalMass)*separation;
+        positionB += overlap*(massA/totalMass)*separation;
+    }
+
+    bodies.x[a] = positionA.x; bodies.y[a] = positionA.y; bodies.z[a] = positionA.z;
+    bodies.x[b] = positionB.x; bodies.y[b] = positionB.y; bodies.z[b] = positionB.z;
+    bodies.vx[a] = velocityA.x; bodies.vy[a] = velocityA.y; bodies.vz[a] = velocityA.z;
+    bodies.vx[b] = velocityB.x; bodies.vy[b] = velocityB.y; bodies.vz[b] = velocityB.z;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+
+enum CollisionResponse {
+    IGNORE_COLLISIONS,
+    MERGE,
+    BOUNCE
+};
+
+/**
+ * @brief Finds bodies whose spheres touch during a step and merges or bounces them.
+ *
+ * Each body is swept in a straight line from where it started the step to where it ended, so fast
+ * bodies can't pass through each other between steps. Candidate pairs come from a uniform spatial
+ * hash rebuilt every step: ordinary bodies go in the cell holding their centre and are tested against
+ * the 27 cells around it, while the few bodies too large for a cell look up every cell their swept
+ * bounds cover instead, and find each other by sweep and prune. Hashing and pair finding run on the
+ * job system; the contacts found are then resolved in order of time of impact, each body in at most
+ * one contact per step.
+ *
+ * Merges conserve mass and momentum. A merged body keeps the index of the heavier of the two, and the
+ * other is left behind as a massless body of zero radius, so that body indices stay valid for
+ * everything that refers to them (trajectories, the renderer, planet terrain). Bodies of zero radius
+ * never collide.
+ */
+class Collisions {
+    private:
+        struct Contact {
+            unsigned int a, b;
+            // Fraction of the step at which the spheres first touch
+            double time;
+        };
+
+        JobSystem* jobSystem = nullptr;
+        AlignedVector<double> startX, startY, startZ;
+
+        // Spatial hash over the ordinary bodies: cellStart[h] to cellStart[h + 1] index into cellBodies
+        double cellSize = 1.0;
+        size_t tableMask = 0;
+        std::vector<uint32_t> bodyCells;
+        std::vector<double> sweptRadii;
+        std::unique_ptr<std::atomic<uint32_t>[]> cellCounts;
+        size_t cellCountsCapacity = 0;
+        std::vector<uint32_t> cellStart;
+        std::vector<uint32_t> cellBodies;
+        std::vector<unsigned int> largeBodies;
+
+        std::vector<Contact> contacts;
+        std::vector<char> isResolved;
+
+        void buildHash(const BodyStore& bodies);
+        void findContacts(const BodyStore& bodies);
+        bool sweptContact(const BodyStore& bodies, unsigned int a, unsigned int b, double& time) const;
+        void merge(BodyStore& bodies, unsigned int a, unsigned int b);
+        void bounce(BodyStore& bodies, unsigned int a, unsigned int b, double time, double deltaTime);
+        size_t cellHash(int64_t x, int64_t y, int64_t z) const;
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    public:
+        CollisionResponse response = IGNORE_COLLISIONS;
+        // For BOUNCE, the fraction of the approach speed kept after a bounce; 1 is perfectly elastic
+        double restitution = 1.0;
+        // Cells are the size of this fraction of bodies' swept diameters; larger bodies are looked up
+        // separately
+        double cellSizeQuantile = 0.9;
+
+        void BeginStep(const BodyStore& bodies);
+        size_t Resolve(BodyStore& bodies, double deltaTime);
+
+        void SetJobSystem(JobSystem* jobSystem) { this->jobSystem = jobSystem; }
+};
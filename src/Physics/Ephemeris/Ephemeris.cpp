@@ -0,0 +1,173 @@
+#include <Physics/Ephemeris/Ephemeris.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief Evaluates the Chebyshev polynomials, and their first and second derivatives, at a point.
+ *
+ * @param scaledTime the point, in [-1, 1].
+ * @param count the number of polynomials to evaluate.
+ * @param values, slopes, curvatures receive count values each.
+ */
+static void chebyshevBasis(double scaledTime, size_t count, double* values, double* slopes, double* curvatures) {
+    values[0] = 1.0;
+    slopes[0] = 0.0;
+    curvatures[0] = 0.0;
+    if (count > 1) {
+        values[1] = scaledTime;
+        slopes[1] = 1.0;
+        curvatures[1] = 0.0;
+    }
+    for (size_t k = 2; k < count; k++) {
+        values[k] = 2.0*scaledTime*values[k - 1] - values[k - 2];
+        slopes[k] = 2.0*values[k - 1] + 2.0*scaledTime*slopes[k - 1] - slopes[k - 2];
+        curvatures[k] = 4.0*slopes[k - 1] + 2.0*scaledTime*curvatures[k - 1] - curvatures[k - 2];
+    }
+}
+
+/**
+ * @brief Maps an ephemeris file and checks its header.
+ *
+ * @param path the path of the ephemeris file.
+ * @throws std::runtime_error if the file can't be mapped, isn't an ephemeris this version can read, or is
+ * shorter than its header says.
+ */
+Ephemeris::Ephemeris(const std::string& path) : file(path) {
+    if (file.Size() < sizeof(EphemerisHeader)) {
+        throw std::runtime_error("'" + path + "' is too small to be an ephemeris file");
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, EPHEMERIS_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("'" + path + "' is not an ephemeris file");
+    }
+    if (header.version != EPHEMERIS_VERSION) {
+        throw std::runtime_error("'" + path + "' is ephemeris version " + std::to_string(header.version) +
+                                 ", expected " + std::to_string(EPHEMERIS_VERSION));
+    }
+    // A body count too large for the file would overflow the layout's offsets, so it is checked first
+    if (header.coefficientCount == 0 || header.coefficientCount > EPHEMERIS_MAX_COEFFICIENTS || header.bodyCount == 0 ||
+        header.bodyCount > file.Size()/sizeof(double) || !(header.intervalLength > 0.0)) {
+        throw std::runtime_error("'" + path + "' has a corrupt header");
+    }
+
+    layout = EphemerisLayout(header.bodyCount, header.coefficientCount);
+    if (layout.recordsOffset != header.recordsOffset || layout.BodiesOffset() != header.bodiesOffset) {
+        throw std::runtime_error("'" + path + "' has a corrupt header");
+    }
+    if (header.recordsOffset > file.Size()) {
+        throw std::runtime_error("'" + path + "' is truncated before the end of its body data");
+    }
+    // The header's count is only written on close, so the intervals are counted from the file size,
+    // which only ever covers whole records. A closed file with fewer intervals than its header lists was
+    // cut short.
+    intervalCount = layout.IntervalsInFile(file.Size());
+    if (header.intervalCount > intervalCount) {
+        throw std::runtime_error("'" + path + "' is truncated: its header lists " + std::to_string(header.intervalCount) +
+                                 " intervals, but only " + std::to_string(intervalCount) + " are in the file");
+    }
+}
+
+const uint64_t* Ephemeris::BodyIndices() const {
+    return (const uint64_t*)(file.Data() + layout.BodiesOffset());
+}
+
+const double* Ephemeris::Masses() const {
+    return (const double*)(file.Data() + layout.MassesOffset());
+}
+
+const double* Ephemeris::Radii() const {
+    return (const double*)(file.Data() + layout.RadiiOffset());
+}
+
+/**
+ * @brief Finds the interval holding a time, and where in it the time falls.
+ *
+ * @param time the simulation time.
+ * @param scaledTime receives the time scaled to [-1, 1] across the interval.
+ * @return the index of the interval.
+ * @throws std::out_of_range if the ephemeris doesn't cover the time.
+ */
+size_t Ephemeris::findInterval(double time, double& scaledTime) const {
+    if (!Covers(time)) {
+        throw std::out_of_range("Time " + std::to_string(time) + " is outside the ephemeris");
+    }
+    double position = (time - header.startTime)/header.intervalLength;
+    // The very end of the range belongs to the last interval
+    size_t interval = std::min((size_t)position, intervalCount - 1);
+    scaledTime = 2.0*(position - interval) - 1.0;
+    return interval;
+}
+
+const double* Ephemeris::series(size_t interval, size_t body, int axis) const {
+    return (const double*)(file.Data() + layout.RecordOffset(interval) + layout.SeriesOffset(body, axis));
+}
+
+/**
+ * @brief Evaluates the position and velocity of one body.
+ *
+ * @param body the body's index within the ephemeris, not the simulation.
+ * @param time the simulation time to evaluate at.
+ * @param position, velocity receive the body's state.
+ * @throws std::out_of_range if the ephemeris doesn't cover the time.
+ */
+void Ephemeris::Evaluate(size_t body, double time, glm::dvec3& position, glm::dvec3& velocity) const {
+    double values[EPHEMERIS_MAX_COEFFICIENTS], slopes[EPHEMERIS_MAX_COEFFICIENTS], curvatures[EPHEMERIS_MAX_COEFFICIENTS];
+    double scaledTime;
+    size_t interval = findInterval(time, scaledTime);
+    size_t count = layout.coefficientCount;
+    chebyshevBasis(scaledTime, count, values, slopes, curvatures);
+
+    double timeScale = 2.0/header.intervalLength;
+    for (int axis = 0; axis < 3; axis++) {
+        const double* coefficients = series(interval, body, axis);
+        double value = 0.0, slope = 0.0;
+        for (size_t k = 0; k < count; k++) {
+            value += coefficients[k]*values[k];
+            slope += coefficients[k]*slopes[k];
+        }
+        position[axis] = value;
+        velocity[axis] = slope*timeScale;
+    }
+}
+
+/**
+ * @brief Sets the position, velocity and acceleration of every body the ephemeris drives.
+ *
+ * The polynomials are evaluated once and shared by every body, so this costs a few multiply-adds per
+ * coordinate.
+ *
+ * @param time the simulation time to evaluate at.
+ * @param bodies the simulation's bodies; must hold every body the ephemeris refers to.
+ * @throws std::out_of_range if the ephemeris doesn't cover the time.
+ */
+void Ephemeris::Evaluate(double time, BodyStore& bodies) const {
+    double values[EPHEMERIS_MAX_COEFFICIENTS], slopes[EPHEMERIS_MAX_COEFFICIENTS], curvatures[EPHEMERIS_MAX_COEFFICIENTS];
+    double scaledTime;
+    size_t interval = findInterval(time, scaledTime);
+    size_t count = layout.coefficientCount;
+    chebyshevBasis(scaledTime, count, values, slopes, curvatures);
+
+    double timeScale = 2.0/header.intervalLength;
+    const uint64_t* indices = BodyIndices();
+    AlignedVector<double>* positions[3] = {&bodies.x, &bodies.y, &bodies.z};
+    AlignedVector<double>* velocities[3] = {&bodies.vx, &bodies.vy, &bodies.vz};
+    AlignedVector<double>* accelerations[3] = {&bodies.ax, &bodies.ay, &bodies.az};
+    for (size_t body = 0; body < layout.bodyCount; body++) {
+        size_t index = indices[body];
+        for (int axis = 0; axis < 3; axis++) {
+            const double* coefficients = series(interval, body, axis);
+            double value = 0.0, slope = 0.0, curvature = 0.0;
+            for (size_t k = 0; k < count; k++) {
+                value += coefficients[k]*values[k];
+                slope += coefficients[k]*slopes[k];
+                curvature += coefficients[k]*curvatures[k];
+            }
+            (*positions[axis])[index] = value;
+            (*velocities[axis])[index] = slope*timeScale;
+            (*accelerations[axis])[index] = curvature*timeScale*timeScale;
+        }
+    }
+}
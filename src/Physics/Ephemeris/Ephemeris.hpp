@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Ephemeris/EphemerisFormat.hpp>
+#include <Utilities/MappedFile.hpp>
+
+/**
+ * @brief Positions, velocities and accelerations of a few bodies at any time, from a memory-mapped
+ * ephemeris file.
+ *
+ * Any time within the file's range is looked up in O(1): the interval holding it is found by
+ * division, and one short Chebyshev series is summed per coordinate. Velocities and accelerations come
+ * from differentiating the same series. Only the records that are evaluated are paged in from disk,
+ * and nothing is ever written, so any number of threads may evaluate at once.
+ */
+class Ephemeris {
+    private:
+        MappedFile file;
+        EphemerisHeader header;
+        EphemerisLayout layout;
+        size_t intervalCount = 0;
+
+        size_t findInterval(double time, double& scaledTime) const;
+        const double* series(size_t interval, size_t body, int axis) const;
+
+    public:
+        explicit Ephemeris(const std::string& path);
+
+        size_t BodyCount() const { return layout.bodyCount; }
+        size_t IntervalCount() const { return intervalCount; }
+        size_t CoefficientCount() const { return layout.coefficientCount; }
+        double StartTime() const { return header.startTime; }
+        double EndTime() const { return header.startTime + intervalCount*header.intervalLength; }
+        double IntervalLength() const { return header.intervalLength; }
+        bool Covers(double time) const { return intervalCount > 0 && time >= StartTime() && time <= EndTime(); }
+
+        // The index of each body in the simulation it drives
+        const uint64_t* BodyIndices() const;
+        const double* Masses() const;
+        const double* Radii() const;
+
+        void Evaluate(size_t body, double time, glm::dvec3& position, glm::dvec3& velocity) const;
+        void Evaluate(double time, BodyStore& bodies) const;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Ephemeris files hold piecewise Chebyshev fits to the paths of a few bodies, in the manner of the JPL
+ * DE files.
+ *
+ * The time covered is cut into equal intervals, and within each one every coordinate of every body is
+ * a Chebyshev series in the time scaled to [-1, 1]. The file starts with an EphemerisHeader, followed by
+ * the simulation index, mass and radius of each body, followed by one record per interval. A record
+ * holds coefficientCount coefficients for x, y and z of each body in turn, padded to
+ * EPHEMERIS_ALIGNMENT. Records are a fixed size, so the record for any time is found with one division,
+ * and a mapped file can be evaluated directly with no parsing.
+ *
+ * All values are little-endian.
+ */
+
+static const char EPHEMERIS_MAGIC[8] = {'S', 'O', 'L', 'E', 'P', 'H', 'E', 'M'};
+static const uint32_t EPHEMERIS_VERSION = 1;
+static const size_t EPHEMERIS_ALIGNMENT = 64;
+// Chebyshev series longer than this lose more to rounding than they gain in accuracy
+static const uint32_t EPHEMERIS_MAX_COEFFICIENTS = 32;
+
+struct EphemerisHeader {
+    char magic[8];
+    uint32_t version;
+    // Coefficients in each coordinate's series, one more than the degree of the polynomial
+    uint32_t coefficientCount;
+    uint64_t bodyCount;
+    // Intervals completely written; only filled in when the writer is closed
+    uint64_t intervalCount;
+    double startTime;
+    double intervalLength;
+    // Offset of the body index array, which is followed by the mass and radius arrays
+    uint64_t bodiesOffset;
+    uint64_t recordsOffset;
+};
+static_assert(sizeof(EphemerisHeader) == 64, "Ephemeris header layout must not change");
+
+/**
+ * @brief Works out where everything lives in an ephemeris file from its header.
+ */
+class EphemerisLayout {
+    private:
+        static size_t align(size_t size) { return (size + EPHEMERIS_ALIGNMENT - 1)/EPHEMERIS_ALIGNMENT*EPHEMERIS_ALIGNMENT; }
+
+    public:
+        size_t bodyCount = 0;
+        size_t coefficientCount = 0;
+        size_t recordsOffset = 0;
+
+        EphemerisLayout() = default;
+        EphemerisLayout(size_t bodyCount, size_t coefficientCount) :
+            bodyCount(bodyCount), coefficientCount(coefficientCount),
+            recordsOffset(align(sizeof(EphemerisHeader)) + 3*align(bodyCount*sizeof(double))) {}
+
+        size_t BodiesOffset() const { return align(sizeof(EphemerisHeader)); }
+        size_t MassesOffset() const { return BodiesOffset() + align(bodyCount*sizeof(double)); }
+        size_t RadiiOffset() const { return MassesOffset() + align(bodyCount*sizeof(double)); }
+
+        size_t RecordSize() const { return align(bodyCount*3*coefficientCount*sizeof(double)); }
+        size_t RecordOffset(size_t interval) const { return recordsOffset + interval*RecordSize(); }
+
+        // Offset within a record of the series for one coordinate (0 to 2 for x to z) of one body
+        size_t SeriesOffset(size_t body, int axis) const { return (body*3 + axis)*coefficientCount*sizeof(double); }
+
+        // Number of whole records that fit in a file of the given size
+        size_t IntervalsInFile(size_t fileSize) const {
+            return fileSize < recordsOffset ? 0 : (fileSize - recordsOffset)/RecordSize();
+        }
+};
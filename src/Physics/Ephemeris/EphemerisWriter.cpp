@@ -0,0 +1,389 @@
+#include <Physics/Ephemeris/EphemerisWriter.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+ * @brief Creates the ephemeris file and writes its header and body data.
+ *
+ * @param path the path of the file to create; an existing file is overwritten.
+ * @param bodyIndices the simulation index of each body to fit.
+ * @param masses, radii the mass and radius of each body.
+ * @param startTime the start of the first interval.
+ * @param intervalLength the length of time covered by each interval.
+ * @param coefficientCount the number of coefficients in each series, one more than its degree.
+ * @throws std::runtime_error if the file can't be created or the settings make no sense.
+ */
+EphemerisWriter::EphemerisWriter(const std::string& path, const std::vector<unsigned int>& bodyIndices, const std::vector<double>& masses,
+                                 const std::vector<double>& radii, double startTime, double intervalLength, uint32_t coefficientCount) :
+    file(path, std::ios::binary | std::ios::trunc), bodyIndices(bodyIndices) {
+    if (!file.good()) {
+        throw std::runtime_error("Could not create ephemeris file '" + path + "'");
+    }
+    if (bodyIndices.empty() || masses.size() != bodyIndices.size() || radii.size() != bodyIndices.size()) {
+        throw std::runtime_error("An ephemeris needs a mass and radius for each of at least one body");
+    }
+    if (!(intervalLength > 0.0)) {
+        throw std::runtime_error("Ephemeris interval length must be positive");
+    }
+    if (coefficientCount < 2 || coefficientCount > EPHEMERIS_MAX_COEFFICIENTS) {
+        throw std::runtime_error("Ephemeris series need between 2 and " + std::to_string(EPHEMERIS_MAX_COEFFICIENTS) + " coefficients");
+    }
+
+    layout = EphemerisLayout(bodyIndices.size(), coefficientCount);
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, EPHEMERIS_MAGIC, sizeof(header.magic));
+    header.version = EPHEMERIS_VERSION;
+    header.coefficientCount = coefficientCount;
+    header.bodyCount = bodyIndices.size();
+    header.startTime = startTime;
+    header.intervalLength = intervalLength;
+    header.bodiesOffset = layout.BodiesOffset();
+    header.recordsOffset = layout.recordsOffset;
+
+    // Everything up to the first record is written in one go, zero padded between sections
+    std::vector<uint8_t> preamble(layout.recordsOffset, 0);
+    std::memcpy(preamble.data(), &header, sizeof(header));
+    for (size_t i = 0; i < bodyIndices.size(); i++) {
+        uint64_t index = bodyIndices[i];
+        std::memcpy(preamble.data() + layout.BodiesOffset() + i*sizeof(uint64_t), &index, sizeof(index));
+    }
+    std::memcpy(preamble.data() + layout.MassesOffset(), masses.data(), masses.size()*sizeof(double));
+    std::memcpy(preamble.data() + layout.RadiiOffset(), radii.data(), radii.size()*sizeof(double));
+    file.write((const char*)preamble.data(), preamble.size());
+
+    record.resize(layout.RecordSize()/sizeof(double));
+}
+
+/**
+ * @brief Picks out one property of some of the bodies.
+ *
+ * @throws std::runtime_error if a body doesn't exist.
+ */
+static std::vector<double> gatherBodies(const BodyStore& bodies, const std::vector<unsigned int>& indices, const AlignedVector<double>& values) {
+    std::vector<double> gathered;
+    for (unsigned int index : indices) {
+        if (index >= bodies.Size()) {
+            throw std::runtime_error("Body " + std::to_string(index) + " doesn't exist");
+        }
+        gathered.push_back(values[index]);
+    }
+    return gathered;
+}
+
+/**
+ * @brief Creates an ephemeris file for some of a simulation's bodies, taking their masses and radii
+ * from the simulation.
+ *
+ * @param path the path of the file to create; an existing file is overwritten.
+ * @param bodies the simulation's bodies.
+ * @param bodyIndices the bodies to fit.
+ * @param startTime the start of the first interval.
+ * @param intervalLength the length of time covered by each interval.
+ * @param coefficientCount the number of coefficients in each series, one more than its degree.
+ * @throws std::runtime_error if the file can't be created, a body doesn't exist or the settings make no sense.
+ */
+EphemerisWriter::EphemerisWriter(const std::string& path, const BodyStore& bodies, const std::vector<unsigned int>& bodyIndices,
+                                 double startTime, double intervalLength, uint32_t coefficientCount) :
+    EphemerisWriter(path, bodyIndices, gatherBodies(bodies, bodyIndices, bodies.mass), gatherBodies(bodies, bodyIndices, bodies.radius),
+                    startTime, intervalLength, coefficientCount) {}
+
+EphemerisWriter::~EphemerisWriter() {
+    try {
+        Close();
+    }
+    catch (...) {
+        // Nothing sensible to do with an error while being destroyed
+    }
+}
+
+/**
+ * @brief Adds the state of every body at one time.
+ *
+ * @param time the time of the sample; must be later than the previous sample.
+ * @param positions, velocities the state of each body, in the order the bodies were given.
+ * @throws std::runtime_error if the samples are out of order, too sparse to fit, or can't be written.
+ */
+void EphemerisWriter::AddSample(double time, const glm::dvec3* positions, const glm::dvec3* velocities) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Ephemeris writer is closed");
+    }
+    if (!sampleTimes.empty() && time <= sampleTimes.back()) {
+        throw std::runtime_error("Ephemeris samples must be in increasing time order");
+    }
+    size_t bodyCount = layout.bodyCount;
+    if (time < header.startTime) {
+        // Only the last sample before the start is needed, to anchor the first interval
+        sampleTimes.clear();
+        samplePositions.clear();
+        sampleVelocities.clear();
+    }
+    sampleTimes.push_back(time);
+    samplePositions.insert(samplePositions.end(), positions, positions + bodyCount);
+    sampleVelocities.insert(sampleVelocities.end(), velocities, velocities + bodyCount);
+
+    while (time >= header.startTime + (intervalsWritten + 1)*header.intervalLength) {
+        fitInterval();
+        intervalsWritten++;
+
+        // Keep the last sample before the new interval starts, so the fits overlap
+        double intervalStart = header.startTime + intervalsWritten*header.intervalLength;
+        size_t firstKept = 0;
+        while (firstKept + 1 < sampleTimes.size() && sampleTimes[firstKept + 1] < intervalStart) {
+            firstKept++;
+        }
+        sampleTimes.erase(sampleTimes.begin(), sampleTimes.begin() + firstKept);
+        samplePositions.erase(samplePositions.begin(), samplePositions.begin() + firstKept*bodyCount);
+        sampleVelocities.erase(sampleVelocities.begin(), sampleVelocities.begin() + firstKept*bodyCount);
+    }
+}
+
+/**
+ * @brief Adds the state of the fitted bodies from a simulation.
+ *
+ * @param time the simulation time; must be later than the previous sample.
+ * @param bodies the simulation's bodies.
+ * @throws std::runtime_error if the samples are out of order, too sparse to fit, or can't be written.
+ */
+void EphemerisWriter::AddSample(double time, const BodyStore& bodies) {
+    std::vector<glm::dvec3> positions, velocities;
+    positions.reserve(bodyIndices.size());
+    velocities.reserve(bodyIndices.size());
+    for (unsigned int index : bodyIndices) {
+        positions.push_back(bodies.Position(index));
+        velocities.push_back(bodies.Velocity(index));
+    }
+    AddSample(time, positions.data(), velocities.data());
+}
+
+/**
+ * @brief Fits every series of the current interval to the samples, and writes them out.
+ *
+ * Every series shares the same sample times, so the normal equations are built and factored once and
+ * then solved for each coordinate of each body. Velocity rows are scaled by half the interval length,
+ * which puts them in the same units as the positions, and then by the velocity weight.
+ */
+void EphemerisWriter::fitInterval() {
+    size_t count = layout.coefficientCount;
+    size_t bodyCount = layout.bodyCount;
+    double intervalStart = header.startTime + intervalsWritten*header.intervalLength;
+    double halfLength = 0.5*header.intervalLength;
+
+    size_t insideCount = 0;
+    for (double time : sampleTimes) {
+        insideCount += time >= intervalStart && time <= intervalStart + header.intervalLength;
+    }
+    if (insideCount < (velocityWeight > 0.0 ? count/2 + 1 : count)) {
+        throw std::runtime_error("Too few samples in ephemeris interval " + std::to_string(intervalsWritten) +
+                                 "; sample more often or use longer intervals");
+    }
+
+    // The value and slope of each polynomial at each sample
+    std::vector<double> values(sampleTimes.size()*count), slopes(sampleTimes.size()*count);
+    for (size_t s = 0; s < sampleTimes.size(); s++) {
+        double scaledTime = (sampleTimes[s] - intervalStart)/halfLength - 1.0;
+        double* value = &values[s*count];
+        double* slope = &slopes[s*count];
+        value[0] = 1.0;
+        value[1] = scaledTime;
+        slope[0] = 0.0;
+        slope[1] = 1.0;
+        for (size_t k = 2; k < count; k++) {
+            value[k] = 2.0*scaledTime*value[k - 1] - value[k - 2];
+            slope[k] = 2.0*value[k - 1] + 2.0*scaledTime*slope[k - 1] - slope[k - 2];
+        }
+    }
+
+    // Cholesky factorisation of the normal equations, lower triangle only
+    double slopeWeight = velocityWeight*velocityWeight;
+    std::vector<double> factor(count*count, 0.0);
+    for (size_t s = 0; s < sampleTimes.size(); s++) {
+        for (size_t i = 0; i < count; i++) {
+            for (size_t j = 0; j <= i; j++) {
+                factor[i*count + j] += values[s*count + i]*values[s*count + j] + slopeWeight*slopes[s*count + i]*slopes[s*count + j];
+            }
+        }
+    }
+    for (size_t j = 0; j < count; j++) {
+        double diagonal = factor[j*count + j];
+        for (size_t k = 0; k < j; k++) {
+            diagonal -= factor[j*count + k]*factor[j*count + k];
+        }
+        if (!(diagonal > 0.0)) {
+            throw std::runtime_error("Ephemeris interval " + std::to_string(intervalsWritten) + " can't be fitted to its samples");
+        }
+        factor[j*count + j] = std::sqrt(diagonal);
+        for (size_t i = j + 1; i < count; i++) {
+            double sum = factor[i*count + j];
+            for (size_t k = 0; k < j; k++) {
+                sum -= factor[i*count + k]*factor[j*count + k];
+            }
+            factor[i*count + j] = sum/factor[j*count + j];
+        }
+    }
+
+    std::vector<double> solution(count);
+    for (size_t body = 0; body < bodyCount; body++) {
+        for (int axis = 0; axis < 3; axis++) {
+            for (size_t k = 0; k < count; k++) {
+                double sum = 0.0;
+                for (size_t s = 0; s < sampleTimes.size(); s++) {
+                    sum += values[s*count + k]*samplePositions[s*bodyCount + body][axis] +
+                           slopeWeight*slopes[s*count + k]*sampleVelocities[s*bodyCount + body][axis]*halfLength;
+                }
+                solution[k] = sum;
+            }
+            // Forward then back substitution
+            for (size_t i = 0; i < count; i++) {
+                for (size_t k = 0; k < i; k++) {
+                    solution[i] -= factor[i*count + k]*solution[k];
+                }
+                solution[i] /= factor[i*count + i];
+            }
+            for (size_t i = count; i-- > 0;) {
+                for (size_t k = i + 1; k < count; k++) {
+                    solution[i] -= factor[k*count + i]*solution[k];
+                }
+                solution[i] /= factor[i*count + i];
+            }
+            std::memcpy(&record[layout.SeriesOffset(body, axis)/sizeof(double)], solution.data(), count*sizeof(double));
+        }
+    }
+
+    file.write((const char*)record.data(), layout.RecordSize());
+    if (!file.good()) {
+        throw std::runtime_error("Could not write to ephemeris file");
+    }
+}
+
+/**
+ * @brief Fills in the final interval count and closes the file.
+ *
+ * Samples past the end of the last whole interval are dropped. Safe to call more than once.
+ *
+ * @throws std::runtime_error if the file can't be finished.
+ */
+void EphemerisWriter::Close() {
+    if (!file.is_open()) {
+        return;
+    }
+    header.intervalCount = intervalsWritten;
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    file.flush();
+    bool isGood = file.good();
+    file.close();
+    if (!isGood) {
+        throw std::runtime_error("Could not finish writing ephemeris file");
+    }
+}
+
+/**
+ * @brief Fits an ephemeris to a text table of states, such as one exported from another ephemeris.
+ *
+ * The table first declares each body on a line of its own as `body <index> <mass> <radius>`, where
+ * the index is the body's index in the simulation. Each following line is a sample of one body,
+ * `<time> <index> <x> <y> <z> <vx> <vy> <vz>`, and every body must be sampled at every time, in
+ * increasing time order. Anything after a '#' is a comment. The ephemeris starts at the first time in
+ * the table.
+ *
+ * @param tablePath the path of the table to read.
+ * @param ephemerisPath the path of the ephemeris file to write.
+ * @param intervalLength the length of time covered by each interval.
+ * @param coefficientCount the number of coefficients in each series, one more than its degree.
+ * @throws std::runtime_error if the table can't be read or is malformed, or the ephemeris can't be written.
+ */
+void ImportEphemerisTable(const std::string& tablePath, const std::string& ephemerisPath, double intervalLength, uint32_t coefficientCount) {
+    std::ifstream table(tablePath);
+    if (!table.good()) {
+        throw std::runtime_error("Could not open ephemeris table '" + tablePath + "'");
+    }
+
+    std::vector<unsigned int> indices;
+    std::vector<double> masses, radii;
+    std::unordered_map<unsigned int, size_t> slots;
+    std::unique_ptr<EphemerisWriter> writer;
+    double sampleTime = 0.0;
+    std::vector<glm::dvec3> positions, velocities;
+    size_t filledCount = 0;
+    std::vector<char> isFilled;
+
+    auto addSample = [&]() {
+        if (filledCount != indices.size()) {
+            throw std::runtime_error("Not every body is sampled at time " + std::to_string(sampleTime) + " in '" + tablePath + "'");
+        }
+        writer->AddSample(sampleTime, positions.data(), velocities.data());
+        std::fill(isFilled.begin(), isFilled.end(), 0);
+        filledCount = 0;
+    };
+
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(table, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first)) {
+            continue;
+        }
+        std::string location = "line " + std::to_string(lineNumber) + " of '" + tablePath + "'";
+
+        if (first == "body") {
+            unsigned int index;
+            double mass, radius;
+            if (writer || !(fields >> index >> mass >> radius) || slots.count(index) > 0) {
+                throw std::runtime_error("Bad body declaration on " + location);
+            }
+            slots[index] = indices.size();
+            indices.push_back(index);
+            masses.push_back(mass);
+            radii.push_back(radius);
+            continue;
+        }
+
+        double time;
+        unsigned int index;
+        glm::dvec3 position, velocity;
+        try {
+            time = std::stod(first);
+        }
+        catch (const std::exception&) {
+            throw std::runtime_error("Bad sample on " + location);
+        }
+        if (!(fields >> index >> position.x >> position.y >> position.z >> velocity.x >> velocity.y >> velocity.z)) {
+            throw std::runtime_error("Bad sample on " + location);
+        }
+        auto slot = slots.find(index);
+        if (slot == slots.end()) {
+            throw std::runtime_error("Undeclared body " + std::to_string(index) + " on " + location);
+        }
+
+        if (!writer) {
+            writer.reset(new EphemerisWriter(ephemerisPath, indices, masses, radii, time, intervalLength, coefficientCount));
+            positions.resize(indices.size());
+            velocities.resize(indices.size());
+            isFilled.assign(indices.size(), 0);
+            sampleTime = time;
+        }
+        else if (time != sampleTime) {
+            addSample();
+            sampleTime = time;
+        }
+        if (isFilled[slot->second]) {
+            throw std::runtime_error("Body " + std::to_string(index) + " sampled twice on " + location);
+        }
+        positions[slot->second] = position;
+        velocities[slot->second] = velocity;
+        isFilled[slot->second] = 1;
+        filledCount++;
+    }
+
+    if (!writer) {
+        throw std::runtime_error("'" + tablePath + "' has no samples");
+    }
+    addSample();
+    writer->Close();
+}
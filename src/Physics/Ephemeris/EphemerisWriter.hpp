@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Ephemeris/EphemerisFormat.hpp>
+
+/**
+ * @brief Fits Chebyshev series to the paths of a few bodies and writes them to an ephemeris file.
+ *
+ * Samples of the bodies' positions and velocities are fed in time order, from a running simulation
+ * or an imported table. As soon as the samples pass the end of an interval, each coordinate of each
+ * body is fitted by least squares to both the positions and the velocities in it, and the interval is
+ * written out. The samples either side of an interval are included in its fit, so neighbouring
+ * intervals meet smoothly. Samples should be a good deal closer together than the interval length; at
+ * least coefficientCount/2 + 1 must fall in every interval, or coefficientCount when velocities are
+ * ignored.
+ */
+class EphemerisWriter {
+    private:
+        std::ofstream file;
+        EphemerisHeader header;
+        EphemerisLayout layout;
+        std::vector<unsigned int> bodyIndices;
+        uint64_t intervalsWritten = 0;
+
+        // Samples not yet fitted, each with bodyCount positions and velocities
+        std::vector<double> sampleTimes;
+        std::vector<glm::dvec3> samplePositions, sampleVelocities;
+        std::vector<double> record;
+
+        void fitInterval();
+
+    public:
+        static const uint32_t DEFAULT_COEFFICIENT_COUNT = 14;
+
+        // How much the fit trusts the sampled velocities against the positions. An integrator's velocities
+        // only match the slope of its positions to the order of the scheme, so runs sampled every step
+        // fit best to their positions alone, with 0; sparse tables need the velocities too
+        double velocityWeight = 1.0;
+
+        EphemerisWriter(const std::string& path, const std::vector<unsigned int>& bodyIndices, const std::vector<double>& masses,
+                        const std::vector<double>& radii, double startTime, double intervalLength,
+                        uint32_t coefficientCount = DEFAULT_COEFFICIENT_COUNT);
+        EphemerisWriter(const std::string& path, const BodyStore& bodies, const std::vector<unsigned int>& bodyIndices,
+                        double startTime, double intervalLength, uint32_t coefficientCount = DEFAULT_COEFFICIENT_COUNT);
+        ~EphemerisWriter();
+        EphemerisWriter(const EphemerisWriter&) = delete;
+        EphemerisWriter& operator=(const EphemerisWriter&) = delete;
+
+        void AddSample(double time, const glm::dvec3* positions, const glm::dvec3* velocities);
+        void AddSample(double time, const BodyStore& bodies);
+        void Close();
+
+        uint64_t IntervalsWritten() const { return intervalsWritten; }
+};
+
+void ImportEphemerisTable(const std::string& tablePath, const std::string& ephemerisPath, double intervalLength,
+                          uint32_t coefficientCount = EphemerisWriter::DEFAULT_COEFFICIENT_COUNT);
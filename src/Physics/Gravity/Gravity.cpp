@@ -0,0 +1,310 @@
+#include <Physics/Gravity/Gravity.hpp>
+
+#include <cmath>
+
+// Smallest number of bodies worth handing to another thread for each kind of work
+static const size_t DIRECT_SUM_GRAIN_SIZE = 64;
+static const size_t BARNES_HUT_GRAIN_SIZE = 256;
+// Particles only sum over the massive bodies, so each is cheap and many are handed over at once
+static const size_t PARTICLE_GRAIN_SIZE = 1024;
+
+Gravity::Gravity() {
+    SetSimdLevel(DetectSimdLevel());
+}
+
+/**
+ * @brief Selects the SIMD kernel used for force accumulation.
+ *
+ * Every level produces identical results, so this only affects speed. It is mostly useful for
+ * benchmarking, or for forcing the scalar path when debugging.
+ *
+ * @param level the SIMD level to use.
+ */
+void Gravity::SetSimdLevel(SimdLevel level) {
+    simdLevel = level;
+    kernel = GetGravityKernel(level);
+}
+
+/**
+ * @brief Works out which force calculation to use for a system of the given size.
+ *
+ * @param bodyCount the number of bodies in the system.
+ * @return DIRECT_SUM or BARNES_HUT.
+ */
+GravityMode Gravity::ResolveMode(size_t bodyCount) const {
+    if (mode != AUTOMATIC) {
+        return mode;
+    }
+    return bodyCount > directSumLimit ? BARNES_HUT : DIRECT_SUM;
+}
+
+/**
+ * @brief Computes the gravitational acceleration on every body.
+ *
+ * Overwrites each body's acceleration using either the exact O(N^2) direct sum or the
+ * O(N log N) Barnes-Hut approximation, depending on the mode. If active bodies have been set, only
+ * their accelerations are updated, though every body still acts as a source.
+ *
+ * @param bodies the bodies to compute accelerations for.
+ */
+void Gravity::ComputeAccelerations(BodyStore& bodies) {
+    if (activeBodies != nullptr) {
+        computeAccelerations(bodies, activeBodies->data(), activeBodies->size());
+        return;
+    }
+    computeAccelerations(bodies, nullptr, bodies.Size());
+}
+
+/**
+ * @brief Computes the gravitational acceleration on a subset of the bodies.
+ *
+ * Every body still acts as a source; only the listed bodies have their accelerations updated.
+ * Used by integrators that don't step every body at once.
+ *
+ * @param bodies the bodies to compute accelerations for.
+ * @param targets the indices of the bodies to update.
+ */
+void Gravity::ComputeAccelerations(BodyStore& bodies, const std::vector<unsigned int>& targets) {
+    computeAccelerations(bodies, targets.data(), targets.size());
+}
+
+/**
+ * @brief Computes the gravitational acceleration on every body, from the other bodies and from sources
+ * kept outside the store.
+ *
+ * The bodies act on each other as in ComputeAccelerations. The external sources are then summed
+ * directly onto every body, never put in the tree, so sources that already stand for whole groups of
+ * bodies, such as another process's locally essential tree, aren't grouped together a second time.
+ * Active bodies are respected as in ComputeAccelerations.
+ *
+ * @param bodies the bodies to compute accelerations for.
+ * @param externalSources the other sources, padded.
+ */
+void Gravity::ComputeAccelerations(BodyStore& bodies, const InteractionList& externalSources) {
+    const unsigned int* targets = activeBodies != nullptr ? activeBodies->data() : nullptr;
+    size_t targetCount = activeBodies != nullptr ? activeBodies->size() : bodies.Size();
+    computeAccelerations(bodies, targets, targetCount);
+    if (externalSources.count == 0) {
+        return;
+    }
+
+    const double softeningSquared = softening*softening;
+    parallelFor(targetCount, DIRECT_SUM_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        double acceleration[3];
+        for (size_t t = begin; t < end; t++) {
+            size_t i = targets != nullptr ? targets[t] : t;
+            kernel(externalSources.x.data(), externalSources.y.data(), externalSources.z.data(), externalSources.mass.data(),
+                   externalSources.count, bodies.x[i], bodies.y[i], bodies.z[i], softeningSquared, acceleration);
+            bodies.ax[i] += gravitationalConstant*acceleration[0];
+            bodies.ay[i] += gravitationalConstant*acceleration[1];
+            bodies.az[i] += gravitationalConstant*acceleration[2];
+        }
+    });
+}
+
+/**
+ * @brief Computes the gravitational acceleration on every test particle.
+ *
+ * Only the bodies act as sources, so this costs O(bodies x particles) rather than growing with the
+ * square of the particle count. The mode is chosen by the number of bodies, as for the bodies themselves.
+ *
+ * @param bodies the massive bodies pulling on the particles.
+ * @param particles the particles to compute accelerations for.
+ */
+void Gravity::ComputeParticleAccelerations(const BodyStore& bodies, ParticleStore& particles) {
+    if (particles.Empty()) {
+        return;
+    }
+    if (ResolveMode(bodies.Size()) == BARNES_HUT) {
+        computeParticlesBarnesHut(bodies, particles);
+    }
+    else {
+        computeParticlesDirectSum(bodies, particles);
+    }
+}
+
+/**
+ * @brief Computes the acceleration and its rate of change, the jerk, on a subset of the bodies.
+ *
+ * Always an exact direct sum, whatever the mode, as integrators that need the jerk rely on it being
+ * consistent with the acceleration from one evaluation to the next. Every body acts as a source, at
+ * the position and velocity it has in the store.
+ *
+ * @param bodies the bodies to compute accelerations for.
+ * @param targets the indices of the bodies to update.
+ * @param jerkX, jerkY, jerkZ receive the jerks, indexed by body like the accelerations.
+ */
+void Gravity::ComputeAccelerationsAndJerks(BodyStore& bodies, const std::vector<unsigned int>& targets,
+                                           double* jerkX, double* jerkY, double* jerkZ) {
+    const double softeningSquared = softening*softening;
+    const size_t count = bodies.Size();
+    parallelFor(targets.size(), DIRECT_SUM_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            unsigned int i = targets[t];
+            double ax = 0.0, ay = 0.0, az = 0.0;
+            double jx = 0.0, jy = 0.0, jz = 0.0;
+            for (size_t j = 0; j < count; j++) {
+                double dx = bodies.x[j] - bodies.x[i];
+                double dy = bodies.y[j] - bodies.y[i];
+                double dz = bodies.z[j] - bodies.z[i];
+                double dvx = bodies.vx[j] - bodies.vx[i];
+                double dvy = bodies.vy[j] - bodies.vy[i];
+                double dvz = bodies.vz[j] - bodies.vz[i];
+                double distanceSquared = dx*dx + dy*dy + dz*dz + softeningSquared;
+                if (j == i || distanceSquared == 0.0) {
+                    continue;
+                }
+                double inverseDistance = 1.0/std::sqrt(distanceSquared);
+                double factor = bodies.mass[j]*inverseDistance*inverseDistance*inverseDistance;
+                double approach = 3.0*(dx*dvx + dy*dvy + dz*dvz)/distanceSquared;
+                ax += factor*dx;
+                ay += factor*dy;
+                az += factor*dz;
+                jx += factor*(dvx - approach*dx);
+                jy += factor*(dvy - approach*dy);
+                jz += factor*(dvz - approach*dz);
+            }
+            bodies.ax[i] = gravitationalConstant*ax;
+            bodies.ay[i] = gravitationalConstant*ay;
+            bodies.az[i] = gravitationalConstant*az;
+            jerkX[i] = gravitationalConstant*jx;
+            jerkY[i] = gravitationalConstant*jy;
+            jerkZ[i] = gravitationalConstant*jz;
+        }
+    });
+}
+
+/**
+ * @brief Dispatches to the force calculation for the current mode.
+ *
+ * @param bodies the bodies to compute accelerations for.
+ * @param targets the indices of the bodies to update, or nullptr for every body.
+ * @param targetCount the number of bodies to update.
+ */
+void Gravity::computeAccelerations(BodyStore& bodies, const unsigned int* targets, size_t targetCount) {
+    if (ResolveMode(bodies.Size()) == BARNES_HUT) {
+        computeBarnesHut(bodies, targets, targetCount);
+    }
+    else {
+        computeDirectSum(bodies, targets, targetCount);
+    }
+}
+
+/**
+ * @brief Runs a loop over [0, count) on the job system, or on this thread if there isn't one.
+ *
+ * @param count the number of iterations.
+ * @param grainSize the smallest number of iterations worth handing to another thread.
+ * @param body the loop body, taking the start and end of a chunk.
+ */
+void Gravity::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (jobSystem == nullptr) {
+        body(0, count);
+    }
+    else {
+        jobSystem->ParallelFor(0, count, grainSize, body);
+    }
+}
+
+/**
+ * @brief Computes accelerations exactly by summing over every pair of bodies.
+ *
+ * Each body's sum runs over the whole padded store with the SIMD kernel. A body's interaction
+ * with itself contributes nothing, as its separation is zero.
+ *
+ * @param bodies the bodies to compute accelerations for.
+ * @param targets the indices of the bodies to update, or nullptr for every body.
+ * @param targetCount the number of bodies to update.
+ */
+void Gravity::computeDirectSum(BodyStore& bodies, const unsigned int* targets, size_t targetCount) {
+    const double softeningSquared = softening*softening;
+    parallelFor(targetCount, DIRECT_SUM_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        double acceleration[3];
+        for (size_t t = begin; t < end; t++) {
+            size_t i = targets != nullptr ? targets[t] : t;
+            kernel(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), bodies.PaddedSize(),
+                   bodies.x[i], bodies.y[i], bodies.z[i], softeningSquared, acceleration);
+            bodies.ax[i] = gravitationalConstant*acceleration[0];
+            bodies.ay[i] = gravitationalConstant*acceleration[1];
+            bodies.az[i] = gravitationalConstant*acceleration[2];
+        }
+    });
+}
+
+/**
+ * @brief Computes approximate accelerations using a Barnes-Hut octree.
+ *
+ * The tree is rebuilt every call, as bodies move between octants from step to step. Each body's
+ * interaction list is gathered from the tree and then summed with the same SIMD kernel as the
+ * direct sum.
+ *
+ * @param bodies the bodies to compute accelerations for.
+ * @param targets the indices of the bodies to update, or nullptr for every body.
+ * @param targetCount the number of bodies to update.
+ */
+void Gravity::computeBarnesHut(BodyStore& bodies, const unsigned int* targets, size_t targetCount) {
+    const double softeningSquared = softening*softening;
+    octree.Build(bodies, jobSystem);
+    parallelFor(targetCount, BARNES_HUT_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        // Each thread keeps its own list, so it is only allocated once rather than once per chunk
+        static thread_local InteractionList interactions;
+        double acceleration[3];
+        for (size_t t = begin; t < end; t++) {
+            size_t i = targets != nullptr ? targets[t] : t;
+            octree.GatherInteractions(bodies, bodies.Position(i), openingAngle, interactions);
+            kernel(interactions.x.data(), interactions.y.data(), interactions.z.data(), interactions.mass.data(), interactions.count,
+                   bodies.x[i], bodies.y[i], bodies.z[i], softeningSquared, acceleration);
+            bodies.ax[i] = gravitationalConstant*acceleration[0];
+            bodies.ay[i] = gravitationalConstant*acceleration[1];
+            bodies.az[i] = gravitationalConstant*acceleration[2];
+        }
+    });
+}
+
+/**
+ * @brief Computes particle accelerations exactly by summing over every body.
+ *
+ * With only a handful of bodies, their padded arrays fit in a block or two of the SIMD kernel and stay
+ * in cache for the whole pass, so the cost is dominated by streaming the particles through.
+ *
+ * @param bodies the massive bodies pulling on the particles.
+ * @param particles the particles to compute accelerations for.
+ */
+void Gravity::computeParticlesDirectSum(const BodyStore& bodies, ParticleStore& particles) {
+    const double softeningSquared = softening*softening;
+    parallelFor(particles.Size(), PARTICLE_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        double acceleration[3];
+        for (size_t i = begin; i < end; i++) {
+            kernel(bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.mass.data(), bodies.PaddedSize(),
+                   particles.x[i], particles.y[i], particles.z[i], softeningSquared, acceleration);
+            particles.ax[i] = gravitationalConstant*acceleration[0];
+            particles.ay[i] = gravitationalConstant*acceleration[1];
+            particles.az[i] = gravitationalConstant*acceleration[2];
+        }
+    });
+}
+
+/**
+ * @brief Computes approximate particle accelerations using a Barnes-Hut octree of the bodies.
+ *
+ * The tree is rebuilt from the bodies, which is cheap next to walking it once per particle.
+ *
+ * @param bodies the massive bodies pulling on the particles.
+ * @param particles the particles to compute accelerations for.
+ */
+void Gravity::computeParticlesBarnesHut(const BodyStore& bodies, ParticleStore& particles) {
+    const double softeningSquared = softening*softening;
+    octree.Build(bodies, jobSystem);
+    parallelFor(particles.Size(), BARNES_HUT_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        static thread_local InteractionList interactions;
+        double acceleration[3];
+        for (size_t i = begin; i < end; i++) {
+            octree.GatherInteractions(bodies, particles.Position(i), openingAngle, interactions);
+            kernel(interactions.x.data(), interactions.y.data(), interactions.z.data(), interactions.mass.data(), interactions.count,
+                   particles.x[i], particles.y[i], particles.z[i], softeningSquared, acceleration);
+            particles.ax[i] = gravitationalConstant*acceleration[0];
+            particles.ay[i] = gravitationalConstant*acceleration[1];
+            particles.az[i] = gravitationalConstant*acceleration[2];
+        }
+    });
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Gravity/GravityKernels.hpp>
+#include <Physics/Gravity/Octree.hpp>
+#include <Physics/ParticleStore/ParticleStore.hpp>
+
+enum GravityMode {
+    DIRECT_SUM,
+    BARNES_HUT,
+    AUTOMATIC
+};
+
+class Gravity {
+    private:
+        Octree octree;
+        SimdLevel simdLevel;
+        GravityKernel kernel;
+        JobSystem* jobSystem = nullptr;
+        const std::vector<unsigned int>* activeBodies = nullptr;
+
+        void computeAccelerations(BodyStore& bodies, const unsigned int* targets, size_t targetCount);
+        void computeDirectSum(BodyStore& bodies, const unsigned int* targets, size_t targetCount);
+        void computeBarnesHut(BodyStore& bodies, const unsigned int* targets, size_t targetCount);
+        void computeParticlesDirectSum(const BodyStore& bodies, ParticleStore& particles);
+        void computeParticlesBarnesHut(const BodyStore& bodies, ParticleStore& particles);
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    public:
+        GravityMode mode = AUTOMATIC;
+        double gravitationalConstant = 1.0;
+        double softening = 0.01;
+        double openingAngle = 0.5;
+        // In AUTOMATIC mode, systems with more bodies than this use Barnes-Hut
+        size_t directSumLimit = 2048;
+
+        Gravity();
+
+        void ComputeAccelerations(BodyStore& bodies);
+        void ComputeAccelerations(BodyStore& bodies, const std::vector<unsigned int>& targets);
+        void ComputeAccelerations(BodyStore& bodies, const InteractionList& externalSources);
+        void ComputeParticleAccelerations(const BodyStore& bodies, ParticleStore& particles);
+        void ComputeAccelerationsAndJerks(BodyStore& bodies, const std::vector<unsigned int>& targets,
+                                          double* jerkX, double* jerkY, double* jerkZ);
+        GravityMode ResolveMode(size_t bodyCount) const;
+
+        void SetSimdLevel(SimdLevel level);
+        SimdLevel GetSimdLevel() const { return simdLevel; }
+        void SetJobSystem(JobSystem* jobSystem) { this->jobSystem = jobSystem; }
+        // Limits the full computation to the listed bodies, such as those not on rails; nullptr for all
+        void SetActiveBodies(const std::vector<unsigned int>* activeBodies) { this->activeBodies = activeBodies; }
+};
@@ -0,0 +1,206 @@
+#include <Physics/Gravity/GravityKernels.hpp>
+
+#include <cmath>
+
+// NOTE: this file must be compiled without floating point contraction (-ffp-contract=off), otherwise
+// the compiler may fuse multiplies and adds differently in each kernel and they will stop agreeing
+// bit for bit. See CMakeLists.txt.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define GRAVITY_KERNELS_X86
+    #include <immintrin.h>
+#endif
+
+/**
+ * @brief Portable reference kernel, also used on machines without any supported SIMD extension.
+ */
+static void gravityKernelScalar(const double* x, const double* y, const double* z, const double* mass, std::size_t count,
+                                double px, double py, double pz, double softeningSquared, double* acceleration) {
+    double sumX[8] = {0.0}, sumY[8] = {0.0}, sumZ[8] = {0.0};
+
+    for (std::size_t j = 0; j < count; j += 8) {
+        for (int lane = 0; lane < 8; lane++) {
+            double dx = x[j + lane] - px;
+            double dy = y[j + lane] - py;
+            double dz = z[j + lane] - pz;
+            double distanceSquared = dx*dx + dy*dy + dz*dz + softeningSquared;
+            double distance = std::sqrt(distanceSquared);
+            double scale = distanceSquared > 0.0 ? mass[j + lane]/(distanceSquared*distance) : 0.0;
+            sumX[lane] += scale*dx;
+            sumY[lane] += scale*dy;
+            sumZ[lane] += scale*dz;
+        }
+    }
+
+    // Reduce lanes (i, i + 4), then (i, i + 2), then (0, 1), matching the SIMD kernels
+    double* sums[3] = {sumX, sumY, sumZ};
+    for (int axis = 0; axis < 3; axis++) {
+        double* s = sums[axis];
+        double half[4] = {s[0] + s[4], s[1] + s[5], s[2] + s[6], s[3] + s[7]};
+        double quarter[2] = {half[0] + half[2], half[1] + half[3]};
+        acceleration[axis] = quarter[0] + quarter[1];
+    }
+}
+
+#ifdef GRAVITY_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void gravityKernelSSE2(const double* x, const double* y, const double* z, const double* mass, std::size_t count,
+                              double px, double py, double pz, double softeningSquared, double* acceleration) {
+    const __m128d pointX = _mm_set1_pd(px);
+    const __m128d pointY = _mm_set1_pd(py);
+    const __m128d pointZ = _mm_set1_pd(pz);
+    const __m128d softening = _mm_set1_pd(softeningSquared);
+    const __m128d zero = _mm_setzero_pd();
+
+    // Four registers of two lanes make up the eight accumulation lanes
+    __m128d sumX[4], sumY[4], sumZ[4];
+    for (int r = 0; r < 4; r++) {
+        sumX[r] = zero;
+        sumY[r] = zero;
+        sumZ[r] = zero;
+    }
+
+    for (std::size_t j = 0; j < count; j += 8) {
+        for (int r = 0; r < 4; r++) {
+            std::size_t k = j + 2*r;
+            __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + k), pointX);
+            __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + k), pointY);
+            __m128d dz = _mm_sub_pd(_mm_loadu_pd(z + k), pointZ);
+            __m128d distanceSquared = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz)), softening);
+            __m128d distance = _mm_sqrt_pd(distanceSquared);
+            __m128d scale = _mm_div_pd(_mm_loadu_pd(mass + k), _mm_mul_pd(distanceSquared, distance));
+            scale = _mm_and_pd(scale, _mm_cmpgt_pd(distanceSquared, zero));
+            sumX[r] = _mm_add_pd(sumX[r], _mm_mul_pd(scale, dx));
+            sumY[r] = _mm_add_pd(sumY[r], _mm_mul_pd(scale, dy));
+            sumZ[r] = _mm_add_pd(sumZ[r], _mm_mul_pd(scale, dz));
+        }
+    }
+
+    __m128d* sums[3] = {sumX, sumY, sumZ};
+    for (int axis = 0; axis < 3; axis++) {
+        __m128d* s = sums[axis];
+        __m128d quarter = _mm_add_pd(_mm_add_pd(s[0], s[2]), _mm_add_pd(s[1], s[3]));
+        acceleration[axis] = _mm_cvtsd_f64(quarter) + _mm_cvtsd_f64(_mm_unpackhi_pd(quarter, quarter));
+    }
+}
+
+__attribute__((target("avx2")))
+static void gravityKernelAVX2(const double* x, const double* y, const double* z, const double* mass, std::size_t count,
+                              double px, double py, double pz, double softeningSquared, double* acceleration) {
+    const __m256d pointX = _mm256_set1_pd(px);
+    const __m256d pointY = _mm256_set1_pd(py);
+    const __m256d pointZ = _mm256_set1_pd(pz);
+    const __m256d softening = _mm256_set1_pd(softeningSquared);
+    const __m256d zero = _mm256_setzero_pd();
+
+    // Two registers of four lanes make up the eight accumulation lanes
+    __m256d sumX[2] = {zero, zero}, sumY[2] = {zero, zero}, sumZ[2] = {zero, zero};
+
+    for (std::size_t j = 0; j < count; j += 8) {
+        for (int r = 0; r < 2; r++) {
+            std::size_t k = j + 4*r;
+            __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + k), pointX);
+            __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + k), pointY);
+            __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + k), pointZ);
+            __m256d distanceSquared = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz)), softening);
+            __m256d distance = _mm256_sqrt_pd(distanceSquared);
+            __m256d scale = _mm256_div_pd(_mm256_loadu_pd(mass + k), _mm256_mul_pd(distanceSquared, distance));
+            scale = _mm256_and_pd(scale, _mm256_cmp_pd(distanceSquared, zero, _CMP_GT_OQ));
+            sumX[r] = _mm256_add_pd(sumX[r], _mm256_mul_pd(scale, dx));
+            sumY[r] = _mm256_add_pd(sumY[r], _mm256_mul_pd(scale, dy));
+            sumZ[r] = _mm256_add_pd(sumZ[r], _mm256_mul_pd(scale, dz));
+        }
+    }
+
+    __m256d* sums[3] = {sumX, sumY, sumZ};
+    for (int axis = 0; axis < 3; axis++) {
+        __m256d half = _mm256_add_pd(sums[axis][0], sums[axis][1]);
+        __m128d quarter = _mm_add_pd(_mm256_castpd256_pd128(half), _mm256_extractf128_pd(half, 1));
+        acceleration[axis] = _mm_cvtsd_f64(quarter) + _mm_cvtsd_f64(_mm_unpackhi_pd(quarter, quarter));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void gravityKernelAVX512(const double* x, const double* y, const double* z, const double* mass, std::size_t count,
+                                double px, double py, double pz, double softeningSquared, double* acceleration) {
+    const __m512d pointX = _mm512_set1_pd(px);
+    const __m512d pointY = _mm512_set1_pd(py);
+    const __m512d pointZ = _mm512_set1_pd(pz);
+    const __m512d softening = _mm512_set1_pd(softeningSquared);
+    const __m512d zero = _mm512_setzero_pd();
+
+    __m512d sumX = zero, sumY = zero, sumZ = zero;
+
+    for (std::size_t j = 0; j < count; j += 8) {
+        __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(x + j), pointX);
+        __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(y + j), pointY);
+        __m512d dz = _mm512_sub_pd(_mm512_loadu_pd(z + j), pointZ);
+        __m512d distanceSquared = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)), _mm512_mul_pd(dz, dz)), softening);
+        __m512d distance = _mm512_sqrt_pd(distanceSquared);
+        __mmask8 positive = _mm512_cmp_pd_mask(distanceSquared, zero, _CMP_GT_OQ);
+        __m512d scale = _mm512_maskz_div_pd(positive, _mm512_loadu_pd(mass + j), _mm512_mul_pd(distanceSquared, distance));
+        sumX = _mm512_add_pd(sumX, _mm512_mul_pd(scale, dx));
+        sumY = _mm512_add_pd(sumY, _mm512_mul_pd(scale, dy));
+        sumZ = _mm512_add_pd(sumZ, _mm512_mul_pd(scale, dz));
+    }
+
+    __m512d sums[3] = {sumX, sumY, sumZ};
+    for (int axis = 0; axis < 3; axis++) {
+        __m256d half = _mm256_add_pd(_mm512_castpd512_pd256(sums[axis]), _mm512_extractf64x4_pd(sums[axis], 1));
+        __m128d quarter = _mm_add_pd(_mm256_castpd256_pd128(half), _mm256_extractf128_pd(half, 1));
+        acceleration[axis] = _mm_cvtsd_f64(quarter) + _mm_cvtsd_f64(_mm_unpackhi_pd(quarter, quarter));
+    }
+}
+
+#endif
+
+/**
+ * @brief Finds the widest SIMD extension supported by both the CPU and the OS.
+ *
+ * @return the best available SimdLevel.
+ */
+SimdLevel DetectSimdLevel() {
+#ifdef GRAVITY_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SSE2;
+    }
+#endif
+    return SCALAR;
+}
+
+/**
+ * @brief Gets the gravity kernel for a SIMD level.
+ *
+ * Levels that weren't compiled in on this platform fall back to the scalar kernel.
+ *
+ * @param level the SIMD level to get the kernel for.
+ * @return the kernel.
+ */
+GravityKernel GetGravityKernel(SimdLevel level) {
+#ifdef GRAVITY_KERNELS_X86
+    switch (level) {
+        case AVX512: return gravityKernelAVX512;
+        case AVX2:   return gravityKernelAVX2;
+        case SSE2:   return gravityKernelSSE2;
+        default:     break;
+    }
+#endif
+    return gravityKernelScalar;
+}
+
+const char* SimdLevelToString(SimdLevel level) {
+    switch (level) {
+        case AVX512: return "AVX-512";
+        case AVX2:   return "AVX2";
+        case SSE2:   return "SSE2";
+        default:     return "scalar";
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+enum SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief Accumulates the softened gravitational acceleration from a block of sources at one point.
+ *
+ * Every kernel splits the sources across eight accumulation lanes and reduces them in the same
+ * fixed order, and none of them use fused multiply-adds, so all SIMD levels return bit-identical
+ * results. The source count must be a multiple of 8; pad with zero-mass sources.
+ *
+ * @param x, y, z the source positions.
+ * @param mass the source masses.
+ * @param count the number of sources, a multiple of 8.
+ * @param px, py, pz the point to evaluate the acceleration at.
+ * @param softeningSquared the square of the Plummer softening length.
+ * @param acceleration receives the acceleration (without G) as x, y, z.
+ */
+typedef void (*GravityKernel)(const double* x, const double* y, const double* z, const double* mass, std::size_t count,
+                              double px, double py, double pz, double softeningSquared, double* acceleration);
+
+SimdLevel DetectSimdLevel();
+GravityKernel GetGravityKernel(SimdLevel level);
+const char* SimdLevelToString(SimdLevel level);
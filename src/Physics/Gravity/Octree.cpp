@@ -0,0 +1,356 @@
+#include <Physics/Gravity/Octree.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Builds the octree from scratch over the given bodies.
+ *
+ * The root node is a cube enclosing every body. Nodes are split into octants until they hold
+ * at most leafCapacity bodies, or until maxDepth is reached (which only happens for bodies that
+ * are almost on top of each other).
+ *
+ * With a job system, the top of the tree is split breadth-first until there are a few subtrees
+ * per thread, the subtrees are built in parallel into their own node arrays, and those are then
+ * spliced back into the main array.
+ *
+ * @param bodies the bodies to build the tree over.
+ * @param jobSystem the job system to build subtrees on, or nullptr to build on this thread.
+ */
+void Octree::Build(const BodyStore& bodies, JobSystem* jobSystem) {
+    nodes.clear();
+    bodyIndices.resize(bodies.Size());
+    scratchIndices.resize(bodies.Size());
+    if (bodies.Empty()) {
+        return;
+    }
+
+    glm::dvec3 minimum = bodies.Position(0);
+    glm::dvec3 maximum = bodies.Position(0);
+    for (unsigned int i = 0; i < bodies.Size(); i++) {
+        bodyIndices[i] = i;
+        minimum = glm::min(minimum, bodies.Position(i));
+        maximum = glm::max(maximum, bodies.Position(i));
+    }
+
+    glm::dvec3 extent = maximum - minimum;
+    Node root;
+    root.centre = 0.5*(minimum + maximum);
+    // Pad slightly so that bodies on the boundary fall strictly inside the root cube
+    root.halfWidth = 0.5*std::max(extent.x, std::max(extent.y, extent.z))*1.0001 + 1e-12;
+    root.firstChild = -1;
+    root.childCount = 0;
+    root.firstBody = 0;
+    root.bodyCount = (int)bodies.Size();
+    nodes.reserve(2*bodies.Size()/leafCapacity + 1);
+    nodes.push_back(root);
+
+    if (jobSystem == nullptr || jobSystem->ThreadCount() == 1) {
+        buildSubtree(nodes, 0, bodies, 0);
+        return;
+    }
+
+    // Split breadth-first until there are enough subtrees to keep every thread busy. Children are
+    // always appended after their parent, so the top of the tree is in order of increasing depth.
+    std::vector<int> depths(1, 0);
+    size_t targetSubtrees = 8*(size_t)jobSystem->ThreadCount();
+    size_t next = 0;
+    while (next < nodes.size() && nodes.size() - next < targetSubtrees) {
+        int nodeIndex = (int)next++;
+        if (splitNode(nodes, nodeIndex, bodies, depths[nodeIndex])) {
+            depths.resize(nodes.size(), depths[nodeIndex] + 1);
+        }
+    }
+    int topCount = (int)nodes.size();
+    std::vector<int> subtrees;
+    for (int i = (int)next; i < topCount; i++) {
+        subtrees.push_back(i);
+    }
+
+    std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+    jobSystem->ParallelFor(0, subtrees.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+            subtreeNodes[s].push_back(nodes[subtrees[s]]);
+            buildSubtree(subtreeNodes[s], 0, bodies, depths[subtrees[s]]);
+        }
+    });
+
+    // Splice each subtree in: its root replaces the frontier node, the rest go on the end
+    for (size_t s = 0; s < subtrees.size(); s++) {
+        const std::vector<Node>& local = subtreeNodes[s];
+        int offset = (int)nodes.size() - 1;
+        nodes[subtrees[s]] = local[0];
+        if (local[0].childCount > 0) {
+            nodes[subtrees[s]].firstChild += offset;
+        }
+        for (size_t i = 1; i < local.size(); i++) {
+            Node node = local[i];
+            if (node.childCount > 0) {
+                node.firstChild += offset;
+            }
+            nodes.push_back(node);
+        }
+    }
+
+    // Finally, fill in the masses of the top of the tree from the bottom up
+    for (int i = (int)next - 1; i >= 0; i--) {
+        if (nodes[i].childCount > 0) {
+            computeMass(nodes, i);
+        }
+    }
+}
+
+/**
+ * @brief Sorts a node's bodies into octants and creates its non-empty children.
+ *
+ * Nodes that are small enough, or deep enough, become leaves instead and get their mass computed.
+ * The children are appended to the end of the node array without being built themselves.
+ *
+ * @param tree the node array the node lives in.
+ * @param nodeIndex the index of the node to split.
+ * @param bodies the bodies the tree is being built over.
+ * @param depth the depth of the node in the tree.
+ * @return true if the node was split, false if it became a leaf.
+ */
+bool Octree::splitNode(std::vector<Node>& tree, int nodeIndex, const BodyStore& bodies, int depth) {
+    int firstBody = tree[nodeIndex].firstBody;
+    int bodyCount = tree[nodeIndex].bodyCount;
+
+    if (bodyCount <= leafCapacity || depth >= maxDepth) {
+        double mass = 0.0;
+        glm::dvec3 weightedPosition(0.0);
+        for (int i = firstBody; i < firstBody + bodyCount; i++) {
+            int body = bodyIndices[i];
+            mass += bodies.mass[body];
+            weightedPosition += bodies.mass[body]*bodies.Position(body);
+        }
+        tree[nodeIndex].mass = mass;
+        tree[nodeIndex].centreOfMass = mass > 0.0 ? weightedPosition/mass : tree[nodeIndex].centre;
+        return false;
+    }
+
+    // Sort the node's bodies into octants with a counting sort
+    glm::dvec3 centre = tree[nodeIndex].centre;
+    int octantCounts[8] = {0};
+    for (int i = firstBody; i < firstBody + bodyCount; i++) {
+        glm::dvec3 p = bodies.Position(bodyIndices[i]);
+        int octant = (p.x > centre.x) | ((p.y > centre.y) << 1) | ((p.z > centre.z) << 2);
+        octantCounts[octant]++;
+    }
+    int octantStarts[8];
+    int start = firstBody;
+    for (int o = 0; o < 8; o++) {
+        octantStarts[o] = start;
+        start += octantCounts[o];
+    }
+    int octantCursor[8];
+    std::copy(octantStarts, octantStarts + 8, octantCursor);
+    for (int i = firstBody; i < firstBody + bodyCount; i++) {
+        glm::dvec3 p = bodies.Position(bodyIndices[i]);
+        int octant = (p.x > centre.x) | ((p.y > centre.y) << 1) | ((p.z > centre.z) << 2);
+        scratchIndices[octantCursor[octant]++] = bodyIndices[i];
+    }
+    std::copy(scratchIndices.begin() + firstBody, scratchIndices.begin() + firstBody + bodyCount, bodyIndices.begin() + firstBody);
+
+    // Create the non-empty children contiguously
+    double childHalfWidth = 0.5*tree[nodeIndex].halfWidth;
+    int firstChild = (int)tree.size();
+    int childCount = 0;
+    for (int o = 0; o < 8; o++) {
+        if (octantCounts[o] == 0) {
+            continue;
+        }
+        Node child;
+        child.centre = centre + glm::dvec3((o & 1) ? childHalfWidth : -childHalfWidth,
+                                           (o & 2) ? childHalfWidth : -childHalfWidth,
+                                           (o & 4) ? childHalfWidth : -childHalfWidth);
+        child.halfWidth = childHalfWidth;
+        child.firstChild = -1;
+        child.childCount = 0;
+        child.firstBody = octantStarts[o];
+        child.bodyCount = octantCounts[o];
+        tree.push_back(child);
+        childCount++;
+    }
+    tree[nodeIndex].firstChild = firstChild;
+    tree[nodeIndex].childCount = childCount;
+    return true;
+}
+
+/**
+ * @brief Recursively builds the subtree under a node, including its mass and centre of mass.
+ *
+ * Note that tree may be reallocated by the recursive calls, so tree are always accessed by index.
+ * Subtrees only ever touch their own range of the body index arrays, so different subtrees can be
+ * built concurrently into different node arrays.
+ *
+ * @param tree the node array the subtree is built in.
+ * @param nodeIndex the index of the subtree's root.
+ * @param bodies the bodies the tree is being built over.
+ * @param depth the depth of the subtree's root in the whole tree.
+ */
+void Octree::buildSubtree(std::vector<Node>& tree, int nodeIndex, const BodyStore& bodies, int depth) {
+    if (!splitNode(tree, nodeIndex, bodies, depth)) {
+        return;
+    }
+    int firstChild = tree[nodeIndex].firstChild;
+    for (int c = firstChild; c < firstChild + tree[nodeIndex].childCount; c++) {
+        buildSubtree(tree, c, bodies, depth + 1);
+    }
+    computeMass(tree, nodeIndex);
+}
+
+/**
+ * @brief Sums the mass and centre of mass of a node from its children.
+ */
+void Octree::computeMass(std::vector<Node>& tree, int nodeIndex) {
+    double mass = 0.0;
+    glm::dvec3 weightedPosition(0.0);
+    int firstChild = tree[nodeIndex].firstChild;
+    for (int c = firstChild; c < firstChild + tree[nodeIndex].childCount; c++) {
+        mass += tree[c].mass;
+        weightedPosition += tree[c].mass*tree[c].centreOfMass;
+    }
+    tree[nodeIndex].mass = mass;
+    tree[nodeIndex].centreOfMass = mass > 0.0 ? weightedPosition/mass : tree[nodeIndex].centre;
+}
+
+/**
+ * @brief Walks the tree and gathers every source that acts on a point.
+ *
+ * A node is approximated by its centre of mass when its width, as seen from the point, subtends
+ * less than the opening angle, i.e. when width/distance < openingAngle. Nodes containing the point
+ * are always opened, so a body never attracts itself through a monopole. A body's own entry in an
+ * opened leaf contributes nothing, since its separation is zero.
+ *
+ * @param bodies the bodies the tree was built over.
+ * @param position the point to gather interactions for.
+ * @param openingAngle the Barnes-Hut opening angle; 0 degenerates to a direct sum.
+ * @param interactions receives the sources, padded ready for a GravityKernel.
+ */
+void Octree::GatherInteractions(const BodyStore& bodies, glm::dvec3 position, double openingAngle, InteractionList& interactions) const {
+    interactions.Clear();
+    if (nodes.empty()) {
+        interactions.Pad();
+        return;
+    }
+
+    const double openingAngleSquared = openingAngle*openingAngle;
+
+    // Each level pushes at most 8 children, so this cannot overflow for trees up to maxDepth
+    int stack[8*64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        if (node.childCount == 0) {
+            for (int i = node.firstBody; i < node.firstBody + node.bodyCount; i++) {
+                int other = bodyIndices[i];
+                interactions.Add(bodies.x[other], bodies.y[other], bodies.z[other], bodies.mass[other]);
+            }
+            continue;
+        }
+
+        glm::dvec3 offset = glm::abs(position - node.centre);
+        bool containsPoint = offset.x <= node.halfWidth && offset.y <= node.halfWidth && offset.z <= node.halfWidth;
+        glm::dvec3 separation = node.centreOfMass - position;
+        double distanceSquared = glm::dot(separation, separation);
+        double width = 2.0*node.halfWidth;
+
+        if (!containsPoint && width*width < openingAngleSquared*distanceSquared) {
+            interactions.Add(node.centreOfMass.x, node.centreOfMass.y, node.centreOfMass.z, node.mass);
+        }
+        else {
+            for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+                stack[stackSize++] = c;
+            }
+        }
+    }
+
+    interactions.Pad();
+}
+
+/**
+ * @brief Gathers the sources that any point in a box needs from this tree: its locally essential tree.
+ *
+ * A node is sent whole, as its centre of mass, when every point in the box would accept it by the
+ * same criterion GatherInteractions uses; otherwise it is opened, and opened leaves send their bodies.
+ * Every exported source is therefore one that each target in the box would accept from this tree as it
+ * stands, so summing them directly gives forces at least as accurate as a traversal here. They must not
+ * be built into another tree, where nodes of them would be accepted as a whole and the already grouped
+ * mass grouped again. Used to send other processes what their bodies need.
+ *
+ * @param bodies the bodies the tree was built over.
+ * @param boxMinimum, boxMaximum the corners of the box holding the targets.
+ * @param openingAngle the Barnes-Hut opening angle.
+ * @param exported receives the sources.
+ */
+void Octree::ExportEssential(const BodyStore& bodies, glm::dvec3 boxMinimum, glm::dvec3 boxMaximum, double openingAngle,
+                             InteractionList& exported) const {
+    exported.Clear();
+    if (nodes.empty()) {
+        return;
+    }
+
+    const double openingAngleSquared = openingAngle*openingAngle;
+    int stack[8*64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        if (node.childCount == 0) {
+            for (int i = node.firstBody; i < node.firstBody + node.bodyCount; i++) {
+                int other = bodyIndices[i];
+                exported.Add(bodies.x[other], bodies.y[other], bodies.z[other], bodies.mass[other]);
+            }
+            continue;
+        }
+
+        // The nearest points of the box to the node's cube and to its centre of mass
+        glm::dvec3 offset = glm::abs(glm::min(glm::max(node.centre, boxMinimum), boxMaximum) - node.centre);
+        bool overlapsBox = offset.x <= node.halfWidth && offset.y <= node.halfWidth && offset.z <= node.halfWidth;
+        glm::dvec3 separation = node.centreOfMass - glm::min(glm::max(node.centreOfMass, boxMinimum), boxMaximum);
+        double distanceSquared = glm::dot(separation, separation);
+        double width = 2.0*node.halfWidth;
+
+        if (!overlapsBox && width*width < openingAngleSquared*distanceSquared) {
+            exported.Add(node.centreOfMass.x, node.centreOfMass.y, node.centreOfMass.z, node.mass);
+        }
+        else {
+            for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+                stack[stackSize++] = c;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Appends a source to the list, growing the arrays if needed.
+ */
+void InteractionList::Add(double sourceX, double sourceY, double sourceZ, double sourceMass) {
+    if (count == x.size()) {
+        std::size_t size = std::max<std::size_t>(64, 2*x.size());
+        x.resize(size);
+        y.resize(size);
+        z.resize(size);
+        mass.resize(size);
+    }
+    x[count] = sourceX;
+    y[count] = sourceY;
+    z[count] = sourceZ;
+    mass[count] = sourceMass;
+    count++;
+}
+
+/**
+ * @brief Pads the list with massless sources up to a multiple of BODY_STORE_PADDING.
+ */
+void InteractionList::Pad() {
+    while (count % BODY_STORE_PADDING != 0) {
+        Add(0.0, 0.0, 0.0, 0.0);
+    }
+}
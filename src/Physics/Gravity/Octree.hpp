@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+
+/**
+ * @brief Sources a body interacts with, gathered from the tree in kernel-ready SoA form.
+ *
+ * Holds both the individual bodies of opened leaves and the centres of mass of accepted nodes.
+ */
+struct InteractionList {
+    AlignedVector<double> x, y, z, mass;
+    std::size_t count = 0;
+
+    void Clear() { count = 0; }
+    void Add(double sourceX, double sourceY, double sourceZ, double sourceMass);
+    void Pad();
+};
+
+/**
+ * @brief Barnes-Hut octree over a set of bodies.
+ *
+ * Nodes are stored in a flat array, with the (non-empty) children of a node stored contiguously.
+ * Every node covers a contiguous range of the reordered body index array, so a leaf's bodies can be
+ * iterated without following any further pointers.
+ */
+class Octree {
+    private:
+        struct Node {
+            glm::dvec3 centre;
+            double halfWidth;
+            glm::dvec3 centreOfMass;
+            double mass;
+            int firstChild;
+            int childCount;
+            int firstBody;
+            int bodyCount;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<int> bodyIndices;
+        std::vector<int> scratchIndices;
+
+        bool splitNode(std::vector<Node>& tree, int nodeIndex, const BodyStore& bodies, int depth);
+        void buildSubtree(std::vector<Node>& tree, int nodeIndex, const BodyStore& bodies, int depth);
+        void computeMass(std::vector<Node>& tree, int nodeIndex);
+
+    public:
+        int leafCapacity = 8;
+        int maxDepth = 32;
+
+        void Build(const BodyStore& bodies, JobSystem* jobSystem = nullptr);
+        void GatherInteractions(const BodyStore& bodies, glm::dvec3 position, double openingAngle, InteractionList& interactions) const;
+        void ExportEssential(const BodyStore& bodies, glm::dvec3 boxMinimum, glm::dvec3 boxMaximum, double openingAngle,
+                             InteractionList& exported) const;
+        int NodeCount() const { return (int)nodes.size(); }
+};
@@ -0,0 +1,230 @@
+#include <Physics/Integrator/BlockTimestep.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Estimates the first step a body should take, from its acceleration and jerk alone.
+ *
+ * For an orbit |a|/|da/dt| is a fixed fraction of the period; during an encounter the jerk spikes and
+ * the step shrinks with it.
+ *
+ * @param bodies the bodies being integrated, with their accelerations up to date.
+ * @param i the body to estimate the step for.
+ * @return the ideal step length.
+ */
+double BlockTimestep::initialTimestep(const BodyStore& bodies, unsigned int i) const {
+    double accelerationSquared = bodies.ax[i]*bodies.ax[i] + bodies.ay[i]*bodies.ay[i] + bodies.az[i]*bodies.az[i];
+    double jerkSquared = jerkX[i]*jerkX[i] + jerkY[i]*jerkY[i] + jerkZ[i]*jerkZ[i];
+    if (jerkSquared == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return startingAccuracy*std::sqrt(accelerationSquared/jerkSquared);
+}
+
+/**
+ * @brief Finds the coarsest level whose step is no longer than the given step.
+ */
+int BlockTimestep::levelForTimestep(double timestep, double deltaTime) const {
+    if (!(timestep < deltaTime)) {
+        return 0;
+    }
+    if (timestep <= 0.0) {
+        return maxLevel;
+    }
+    int level = (int)std::ceil(std::log2(deltaTime/timestep));
+    return std::min(std::max(level, 0), maxLevel);
+}
+
+/**
+ * @brief Picks up the bodies' state at the start of a step.
+ *
+ * Bodies are normally just where the last step left them. Any that have been moved, kicked or added
+ * since, such as by collisions or by being put back on rails, have their jerks recomputed and start
+ * again on a level chosen from scratch.
+ */
+void BlockTimestep::synchronise(BodyStore& bodies, Gravity& gravity, double deltaTime) {
+    size_t count = bodies.Size();
+    active.clear();
+    if (levels.size() != count) {
+        levels.resize(count);
+        startTicks.resize(count);
+        for (AlignedVector<double>* array : {&startX, &startY, &startZ, &startVx, &startVy, &startVz, &startAx, &startAy, &startAz,
+                                             &jerkX, &jerkY, &jerkZ, &endJerkX, &endJerkY, &endJerkZ}) {
+            array->resize(count);
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            active.push_back(i);
+        }
+    }
+    else {
+        for (unsigned int i = 0; i < count; i++) {
+            if (bodies.x[i] != startX[i] || bodies.y[i] != startY[i] || bodies.z[i] != startZ[i] ||
+                bodies.vx[i] != startVx[i] || bodies.vy[i] != startVy[i] || bodies.vz[i] != startVz[i] ||
+                bodies.ax[i] != startAx[i] || bodies.ay[i] != startAy[i] || bodies.az[i] != startAz[i]) {
+                active.push_back(i);
+            }
+        }
+    }
+
+    if (!active.empty()) {
+        gravity.ComputeAccelerationsAndJerks(bodies, active, jerkX.data(), jerkY.data(), jerkZ.data());
+    }
+    for (unsigned int i : active) {
+        startX[i] = bodies.x[i];
+        startY[i] = bodies.y[i];
+        startZ[i] = bodies.z[i];
+        startVx[i] = bodies.vx[i];
+        startVy[i] = bodies.vy[i];
+        startVz[i] = bodies.vz[i];
+        startAx[i] = bodies.ax[i];
+        startAy[i] = bodies.ay[i];
+        startAz[i] = bodies.az[i];
+        levels[i] = levelForTimestep(initialTimestep(bodies, i), deltaTime);
+    }
+    std::fill(startTicks.begin(), startTicks.end(), 0);
+}
+
+/**
+ * @brief Moves every body to a tick along the Taylor series from the start of its current step.
+ */
+void BlockTimestep::predict(BodyStore& bodies, long long tick, double tickTime) {
+    parallelFor(bodies.Size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            double dt = (double)(tick - startTicks[i])*tickTime;
+            bodies.x[i] = startX[i] + dt*(startVx[i] + dt*(0.5*startAx[i] + dt*jerkX[i]/6.0));
+            bodies.y[i] = startY[i] + dt*(startVy[i] + dt*(0.5*startAy[i] + dt*jerkY[i]/6.0));
+            bodies.z[i] = startZ[i] + dt*(startVz[i] + dt*(0.5*startAz[i] + dt*jerkZ[i]/6.0));
+            bodies.vx[i] = startVx[i] + dt*(startAx[i] + 0.5*dt*jerkX[i]);
+            bodies.vy[i] = startVy[i] + dt*(startAy[i] + 0.5*dt*jerkY[i]);
+            bodies.vz[i] = startVz[i] + dt*(startAz[i] + 0.5*dt*jerkZ[i]);
+        }
+    });
+}
+
+/**
+ * @brief Corrects a body at the end of its step, and starts its next step there.
+ *
+ * The acceleration and jerk at both ends of the step fix a cubic for the acceleration over it, which
+ * is integrated to get the corrected velocity and position. Its second and third derivatives feed
+ * Aarseth's criterion for the next step:
+ *
+ *     dt = sqrt(accuracy*(|a||a''| + |a'|^2)/(|a'||a'''| + |a''|^2))
+ *
+ * @param bodies the bodies being integrated, with the body's new acceleration in place.
+ * @param i the body to correct.
+ * @param timestep the length of the step just taken.
+ * @return the ideal length of the body's next step.
+ */
+double BlockTimestep::correct(BodyStore& bodies, unsigned int i, double timestep) {
+    const double h = timestep;
+    const double startA[3] = {startAx[i], startAy[i], startAz[i]};
+    const double endA[3] = {bodies.ax[i], bodies.ay[i], bodies.az[i]};
+    const double startJ[3] = {jerkX[i], jerkY[i], jerkZ[i]};
+    const double endJ[3] = {endJerkX[i], endJerkY[i], endJerkZ[i]};
+    const double startV[3] = {startVx[i], startVy[i], startVz[i]};
+    const double startP[3] = {startX[i], startY[i], startZ[i]};
+
+    double v[3], p[3];
+    double accelerationSquared = 0.0, jerkSquared = 0.0, snapSquared = 0.0, crackleSquared = 0.0;
+    for (int k = 0; k < 3; k++) {
+        v[k] = startV[k] + 0.5*h*(startA[k] + endA[k]) + h*h/12.0*(startJ[k] - endJ[k]);
+        p[k] = startP[k] + 0.5*h*(startV[k] + v[k]) + h*h/12.0*(startA[k] - endA[k]);
+
+        double crackle = (12.0*(startA[k] - endA[k]) + 6.0*h*(startJ[k] + endJ[k]))/(h*h*h);
+        double snap = (-6.0*(startA[k] - endA[k]) - h*(4.0*startJ[k] + 2.0*endJ[k]))/(h*h) + h*crackle;
+        accelerationSquared += endA[k]*endA[k];
+        jerkSquared += endJ[k]*endJ[k];
+        snapSquared += snap*snap;
+        crackleSquared += crackle*crackle;
+    }
+
+    bodies.x[i] = startX[i] = p[0];
+    bodies.y[i] = startY[i] = p[1];
+    bodies.z[i] = startZ[i] = p[2];
+    bodies.vx[i] = startVx[i] = v[0];
+    bodies.vy[i] = startVy[i] = v[1];
+    bodies.vz[i] = startVz[i] = v[2];
+    startAx[i] = endA[0];
+    startAy[i] = endA[1];
+    startAz[i] = endA[2];
+    jerkX[i] = endJ[0];
+    jerkY[i] = endJ[1];
+    jerkZ[i] = endJ[2];
+
+    double numerator = std::sqrt(accelerationSquared*snapSquared) + jerkSquared;
+    double denominator = std::sqrt(jerkSquared*crackleSquared) + snapSquared;
+    if (denominator == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::sqrt(accuracy*numerator/denominator);
+}
+
+/**
+ * @brief Advances every body by deltaTime, each in as many substeps as its level demands.
+ *
+ * Time is counted in ticks of the smallest possible step, deltaTime/2^maxLevel. Each pass moves to
+ * the next tick on which some body's step ends, predicts every body there, and corrects the bodies
+ * whose step ends with fresh forces, before they pick a new level. A body can always move to a finer
+ * level, but only moves up one coarser level at a time, and only when the current tick lines up with
+ * that level's steps, so the bins stay nested.
+ *
+ * Test particles take a single kick-drift-kick step of deltaTime, with their forces computed once the
+ * bodies are back in sync at the end. Their orbits are gentle by nature, and stepping them through
+ * every tick would cost a particle force pass per tick.
+ *
+ * @param bodies the bodies to advance.
+ * @param particles the test particles to advance alongside them.
+ * @param gravity the gravity model to compute accelerations with.
+ * @param deltaTime the step size; the largest step any body takes.
+ */
+void BlockTimestep::Step(BodyStore& bodies, ParticleStore& particles, Gravity& gravity, double deltaTime) {
+    size_t count = bodies.Size();
+    synchronise(bodies, gravity, deltaTime);
+
+    const long long totalTicks = 1LL << maxLevel;
+    const double tickTime = deltaTime/(double)totalTicks;
+    auto levelTimestep = [&](int level) { return deltaTime/(double)(1LL << level); };
+    auto levelTicks = [&](int level) { return 1LL << (maxLevel - level); };
+
+    kick(particles, 0.5*deltaTime);
+
+    int deepestLevel = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        deepestLevel = std::max(deepestLevel, levels[i]);
+    }
+
+    long long tick = 0;
+    while (tick < totalTicks) {
+        long long stride = levelTicks(deepestLevel);
+        tick = (tick/stride + 1)*stride;
+
+        active.clear();
+        for (unsigned int i = 0; i < count; i++) {
+            if (tick - startTicks[i] == levelTicks(levels[i])) {
+                active.push_back(i);
+            }
+        }
+        predict(bodies, tick, tickTime);
+        gravity.ComputeAccelerationsAndJerks(bodies, active, endJerkX.data(), endJerkY.data(), endJerkZ.data());
+
+        for (unsigned int i : active) {
+            int level = levelForTimestep(correct(bodies, i, levelTimestep(levels[i])), deltaTime);
+            if (level < levels[i]) {
+                // Only step up to a coarser level once this tick lines up with it
+                level = tick % levelTicks(levels[i] - 1) == 0 ? levels[i] - 1 : levels[i];
+            }
+            levels[i] = level;
+            startTicks[i] = tick;
+        }
+        deepestLevel = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            deepestLevel = std::max(deepestLevel, levels[i]);
+        }
+    }
+
+    drift(particles, deltaTime);
+    gravity.ComputeParticleAccelerations(bodies, particles);
+    kick(particles, 0.5*deltaTime);
+}
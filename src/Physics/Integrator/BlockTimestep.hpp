@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include <Physics/Integrator/Integrator.hpp>
+
+/**
+ * @brief Adaptive fourth order Hermite integrator where each body steps at its own rate.
+ *
+ * Bodies are sorted into power-of-two timestep bins: a body on level k steps with dt/2^k, so a close
+ * encounter only shrinks the steps of the bodies involved rather than the whole system. At each time
+ * some body's step ends, every body is predicted there from its last acceleration and jerk, and only
+ * the bodies whose step ends get new forces and a Hermite correction (Makino and Aarseth, 1992). All
+ * bodies are back in sync at the end of each call to Step.
+ *
+ * Each body's next step comes from Aarseth's criterion, using the higher derivatives of its
+ * acceleration that the corrector recovers for free. The error falls off as the fourth power of the
+ * step, so accuracy costs far fewer steps than with leapfrog. The scheme isn't symplectic, though, so
+ * energy errors slowly accumulate rather than staying bounded.
+ *
+ * Forces and jerks are always summed directly, so this suits systems of up to a few thousand bodies.
+ */
+class BlockTimestep : public Integrator {
+    private:
+        std::vector<int> levels;
+        // Tick each body's current step started on
+        std::vector<long long> startTicks;
+        std::vector<unsigned int> active;
+        // Each body's corrected state at the start of its current step
+        AlignedVector<double> startX, startY, startZ;
+        AlignedVector<double> startVx, startVy, startVz;
+        AlignedVector<double> startAx, startAy, startAz;
+        AlignedVector<double> jerkX, jerkY, jerkZ;
+        // Jerks at the end of the current step, for the bodies being corrected
+        AlignedVector<double> endJerkX, endJerkY, endJerkZ;
+
+        double initialTimestep(const BodyStore& bodies, unsigned int i) const;
+        int levelForTimestep(double timestep, double deltaTime) const;
+        void synchronise(BodyStore& bodies, Gravity& gravity, double deltaTime);
+        void predict(BodyStore& bodies, long long tick, double tickTime);
+        double correct(BodyStore& bodies, unsigned int i, double timestep);
+
+    public:
+        // Scales every step; the error of each step falls off as its fourth power
+        double accuracy = 0.01;
+        // Scales the first step a body takes, before its higher derivatives are known
+        double startingAccuracy = 0.01;
+        // The smallest step is deltaTime/2^maxLevel
+        int maxLevel = 16;
+
+        void Step(BodyStore& bodies, ParticleStore& particles, Gravity& gravity, double deltaTime) override;
+        const char* GetName() const override { return "block"; }
+
+        int GetLevel(unsigned int index) const { return levels[index]; }
+};
@@ -0,0 +1,114 @@
+#include <Physics/Integrator/Integrator.hpp>
+
+#include <stdexcept>
+
+#include <Physics/Integrator/BlockTimestep.hpp>
+#include <Physics/Integrator/Leapfrog.hpp>
+#include <Physics/Integrator/Yoshida4.hpp>
+
+// Smallest number of bodies worth handing to another thread when kicking or drifting
+static const size_t INTEGRATION_GRAIN_SIZE = 8192;
+
+/**
+ * @brief Creates an integrator of the given type.
+ *
+ * @param type the integration scheme to use.
+ * @return the new integrator.
+ */
+std::unique_ptr<Integrator> CreateIntegrator(IntegratorType type) {
+    switch (type) {
+        case YOSHIDA4:       return std::unique_ptr<Integrator>(new Yoshida4());
+        case BLOCK_TIMESTEP: return std::unique_ptr<Integrator>(new BlockTimestep());
+        default:             return std::unique_ptr<Integrator>(new Leapfrog());
+    }
+}
+
+/**
+ * @brief Parses the name of an integrator, as used on the command line.
+ *
+ * @param name one of "leapfrog", "yoshida4" or "block".
+ * @return the matching integrator type.
+ * @throws std::runtime_error if the name isn't recognised.
+ */
+IntegratorType IntegratorTypeFromString(const std::string& name) {
+    if (name == "leapfrog") return LEAPFROG;
+    if (name == "yoshida4") return YOSHIDA4;
+    if (name == "block")    return BLOCK_TIMESTEP;
+    throw std::runtime_error("Unknown integrator '" + name + "'");
+}
+
+/**
+ * @brief Runs a loop over [0, count) on the job system, or on this thread if there isn't one.
+ */
+void Integrator::parallelFor(size_t count, const std::function<void(size_t, size_t)>& body) {
+    if (jobSystem == nullptr) {
+        body(0, count);
+    }
+    else {
+        jobSystem->ParallelFor(0, count, INTEGRATION_GRAIN_SIZE, body);
+    }
+}
+
+/**
+ * @brief Updates every body's velocity from its current acceleration.
+ *
+ * @param bodies the bodies to kick.
+ * @param deltaTime the length of the kick.
+ */
+void Integrator::kick(BodyStore& bodies, double deltaTime) {
+    parallelFor(bodies.Size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            bodies.vx[i] += deltaTime*bodies.ax[i];
+            bodies.vy[i] += deltaTime*bodies.ay[i];
+            bodies.vz[i] += deltaTime*bodies.az[i];
+        }
+    });
+}
+
+/**
+ * @brief Moves every body along its current velocity.
+ *
+ * @param bodies the bodies to drift.
+ * @param deltaTime the length of the drift.
+ */
+void Integrator::drift(BodyStore& bodies, double deltaTime) {
+    parallelFor(bodies.Size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            bodies.x[i] += deltaTime*bodies.vx[i];
+            bodies.y[i] += deltaTime*bodies.vy[i];
+            bodies.z[i] += deltaTime*bodies.vz[i];
+        }
+    });
+}
+
+/**
+ * @brief Updates every particle's velocity from its current acceleration.
+ *
+ * @param particles the particles to kick.
+ * @param deltaTime the length of the kick.
+ */
+void Integrator::kick(ParticleStore& particles, double deltaTime) {
+    parallelFor(particles.Size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            particles.vx[i] += deltaTime*particles.ax[i];
+            particles.vy[i] += deltaTime*particles.ay[i];
+            particles.vz[i] += deltaTime*particles.az[i];
+        }
+    });
+}
+
+/**
+ * @brief Moves every particle along its current velocity.
+ *
+ * @param particles the particles to drift.
+ * @param deltaTime the length of the drift.
+ */
+void Integrator::drift(ParticleStore& particles, double deltaTime) {
+    parallelFor(particles.Size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            particles.x[i] += deltaTime*particles.vx[i];
+            particles.y[i] += deltaTime*particles.vy[i];
+            particles.z[i] += deltaTime*particles.vz[i];
+        }
+    });
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Gravity/Gravity.hpp>
+#include <Physics/ParticleStore/ParticleStore.hpp>
+
+enum IntegratorType {
+    LEAPFROG,
+    YOSHIDA4,
+    BLOCK_TIMESTEP
+};
+
+/**
+ * @brief Advances a set of bodies through time under gravity.
+ *
+ * Every integrator relies on the bodies' accelerations being up to date with their positions when
+ * Step is called, and leaves them up to date when it returns. The same goes for the test particles,
+ * which are advanced alongside the bodies but pulled only by them.
+ */
+class Integrator {
+    protected:
+        JobSystem* jobSystem = nullptr;
+
+        void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body);
+        void kick(BodyStore& bodies, double deltaTime);
+        void drift(BodyStore& bodies, double deltaTime);
+        void kick(ParticleStore& particles, double deltaTime);
+        void drift(ParticleStore& particles, double deltaTime);
+
+    public:
+        virtual ~Integrator() {}
+
+        virtual void Step(BodyStore& bodies, ParticleStore& particles, Gravity& gravity, double deltaTime) = 0;
+        virtual const char* GetName() const = 0;
+
+        void SetJobSystem(JobSystem* jobSystem) { this->jobSystem = jobSystem; }
+};
+
+std::unique_ptr<Integrator> CreateIntegrator(IntegratorType type);
+IntegratorType IntegratorTypeFromString(const std::string& name);
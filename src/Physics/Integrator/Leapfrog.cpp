@@ -0,0 +1,20 @@
+#include <Physics/Integrator/Leapfrog.hpp>
+
+/**
+ * @brief Advances the bodies by one kick-drift-kick step.
+ *
+ * @param bodies the bodies to advance.
+ * @param particles the test particles to advance alongside them.
+ * @param gravity the gravity model to compute accelerations with.
+ * @param deltaTime the step size.
+ */
+void Leapfrog::Step(BodyStore& bodies, ParticleStore& particles, Gravity& gravity, double deltaTime) {
+    kick(bodies, 0.5*deltaTime);
+    kick(particles, 0.5*deltaTime);
+    drift(bodies, deltaTime);
+    drift(particles, deltaTime);
+    gravity.ComputeAccelerations(bodies);
+    gravity.ComputeParticleAccelerations(bodies, particles);
+    kick(bodies, 0.5*deltaTime);
+    kick(particles, 0.5*deltaTime);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Physics/Integrator/Integrator.hpp>
+
+/**
+ * @brief Second order symplectic kick-drift-kick leapfrog (velocity Verlet).
+ *
+ * One force evaluation per step. Energy errors stay bounded rather than drifting, which makes it a
+ * good default for long runs at a fixed step.
+ */
+class Leapfrog : public Integrator {
+    public:
+        void Step(BodyStore& bodies, ParticleStore& particles, Gravity& gravity, double deltaTime) override;
+        const char* GetName() const override { return "leapfrog"; }
+};
@@ -0,0 +1,33 @@
+#include <Physics/Integrator/Yoshida4.hpp>
+
+#include <cmath>
+
+/**
+ * @brief Advances the bodies by one fourth order step.
+ *
+ * The step is the "triple jump" composition of kick-drift-kick leapfrog steps of lengths
+ * w1*dt, w0*dt and w1*dt, where w0 is negative. Adjacent half kicks share a force evaluation.
+ *
+ * @param bodies the bodies to advance.
+ * @param particles the test particles to advance alongside them.
+ * @param gravity the gravity model to compute accelerations with.
+ * @param deltaTime the step size.
+ */
+void Yoshida4::Step(BodyStore& bodies, ParticleStore& particles, Gravity& gravity, double deltaTime) {
+    const double cubeRootTwo = std::cbrt(2.0);
+    const double w1 = 1.0/(2.0 - cubeRootTwo);
+    const double w0 = -cubeRootTwo*w1;
+    const double weights[3] = {w1, w0, w1};
+
+    kick(bodies, 0.5*w1*deltaTime);
+    kick(particles, 0.5*w1*deltaTime);
+    for (int i = 0; i < 3; i++) {
+        drift(bodies, weights[i]*deltaTime);
+        drift(particles, weights[i]*deltaTime);
+        gravity.ComputeAccelerations(bodies);
+        gravity.ComputeParticleAccelerations(bodies, particles);
+        double nextWeight = i < 2 ? weights[i + 1] : 0.0;
+        kick(bodies, 0.5*(weights[i] + nextWeight)*deltaTime);
+        kick(particles, 0.5*(weights[i] + nextWeight)*deltaTime);
+    }
+}
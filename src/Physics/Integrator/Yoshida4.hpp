@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Physics/Integrator/Integrator.hpp>
+
+/**
+ * @brief Fourth order symplectic integrator built from three leapfrog substeps (Yoshida, 1990).
+ *
+ * Costs three force evaluations per step, but the error falls off as the fourth power of the step
+ * size, so for a given accuracy it can take far larger steps than plain leapfrog.
+ */
+class Yoshida4 : public Integrator {
+    public:
+        void Step(BodyStore& bodies, ParticleStore& particles, Gravity& gravity, double deltaTime) override;
+        const char* GetName() const override { return "yoshida4"; }
+};
@@ -0,0 +1,53 @@
+#include <Physics/ParticleStore/ParticleStore.hpp>
+
+/**
+ * @brief Reserves space for the given number of particles so adding them doesn't reallocate.
+ *
+ * @param capacity the number of particles to reserve space for.
+ */
+void ParticleStore::Reserve(std::size_t capacity) {
+    x.reserve(capacity);
+    y.reserve(capacity);
+    z.reserve(capacity);
+    vx.reserve(capacity);
+    vy.reserve(capacity);
+    vz.reserve(capacity);
+    ax.reserve(capacity);
+    ay.reserve(capacity);
+    az.reserve(capacity);
+}
+
+/**
+ * @brief Removes every particle from the store.
+ */
+void ParticleStore::Clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    vx.clear();
+    vy.clear();
+    vz.clear();
+    ax.clear();
+    ay.clear();
+    az.clear();
+}
+
+/**
+ * @brief Appends a particle to the end of the store.
+ *
+ * Its acceleration starts at zero, until the next force calculation fills it in.
+ *
+ * @param position the particle's position.
+ * @param velocity the particle's velocity.
+ */
+void ParticleStore::Add(glm::dvec3 position, glm::dvec3 velocity) {
+    x.push_back(position.x);
+    y.push_back(position.y);
+    z.push_back(position.z);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    vz.push_back(velocity.z);
+    ax.push_back(0.0);
+    ay.push_back(0.0);
+    az.push_back(0.0);
+}
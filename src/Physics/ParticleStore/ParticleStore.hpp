@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include <Physics/BodyStore/AlignedAllocator.hpp>
+
+/**
+ * @brief Structure-of-arrays storage for massless test particles.
+ *
+ * Particles feel the gravity of the bodies in a BodyStore but exert none of their own, so they carry
+ * no mass, and nothing is ever summed over them; they only need a position, velocity and acceleration.
+ * Each component lives in its own contiguous, SIMD-aligned array, with no padding.
+ */
+class ParticleStore {
+    public:
+        AlignedVector<double> x, y, z;
+        AlignedVector<double> vx, vy, vz;
+        AlignedVector<double> ax, ay, az;
+
+        std::size_t Size() const { return x.size(); }
+        bool Empty() const { return x.empty(); }
+
+        void Reserve(std::size_t capacity);
+        void Clear();
+        void Add(glm::dvec3 position, glm::dvec3 velocity);
+
+        glm::dvec3 Position(std::size_t index) const { return glm::dvec3(x[index], y[index], z[index]); }
+        glm::dvec3 Velocity(std::size_t index) const { return glm::dvec3(vx[index], vy[index], vz[index]); }
+        glm::dvec3 Acceleration(std::size_t index) const { return glm::dvec3(ax[index], ay[index], az[index]); }
+};
@@ -0,0 +1,155 @@
+#include <Physics/PhysicsThread/PhysicsThread.hpp>
+
+#include <algorithm>
+
+/**
+ * @brief Works out how far between the previous and current positions to draw the bodies.
+ *
+ * Rendering runs one step behind the physics: the previous state is shown when the snapshot is
+ * published, blending into the current state by the time the next step is due.
+ *
+ * @param now the time the frame is being drawn.
+ * @return the interpolation factor, between 0 (previous) and 1 (current).
+ */
+float PhysicsSnapshot::InterpolationFactor(std::chrono::steady_clock::time_point now) const {
+    if (stepWallTime <= 0.0) {
+        return 1.0f;
+    }
+    double elapsed = std::chrono::duration<double>(now - publishTime).count();
+    return (float)std::min(std::max(elapsed/stepWallTime, 0.0), 1.0);
+}
+
+PhysicsThread::~PhysicsThread() {
+    Stop();
+}
+
+/**
+ * @brief Publishes the initial state and starts stepping the world on a new thread.
+ */
+void PhysicsThread::Start() {
+    if (isRunning) {
+        return;
+    }
+    capturePrevious(snapshots.WriteBuffer());
+    publish(snapshots.WriteBuffer());
+
+    isRunning = true;
+    thread = std::thread(&PhysicsThread::loop, this);
+}
+
+/**
+ * @brief Stops the physics thread, waiting for the current step to finish.
+ */
+void PhysicsThread::Stop() {
+    isRunning = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Main loop of the physics thread.
+ *
+ * Uses a fixed-timestep accumulator: wall-clock time (scaled by timeScale) is added every pass and
+ * consumed in whole steps. Only the positions before the final step of a batch are recorded, since
+ * that is all the renderer needs to interpolate.
+ */
+void PhysicsThread::loop() {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point previousTime = Clock::now();
+    double accumulator = 0.0;
+
+    while (isRunning) {
+        Clock::time_point currentTime = Clock::now();
+        double frameTime = std::chrono::duration<double>(currentTime - previousTime).count();
+        previousTime = currentTime;
+        if (!isPaused) {
+            accumulator += frameTime*timeScale;
+        }
+
+        int steps = 0;
+        while (accumulator >= fixedTimestep && steps < maxStepsPerUpdate) {
+            bool isLastStep = accumulator < 2.0*fixedTimestep || steps == maxStepsPerUpdate - 1;
+            if (isLastStep) {
+                capturePrevious(snapshots.WriteBuffer());
+            }
+            world.Step(fixedTimestep);
+            accumulator -= fixedTimestep;
+            steps++;
+        }
+        if (steps == maxStepsPerUpdate) {
+            // Too slow to keep up: let the simulation run slower than real time instead of spiralling
+            accumulator = std::min(accumulator, fixedTimestep);
+        }
+
+        if (steps > 0) {
+            publish(snapshots.WriteBuffer());
+        }
+        else {
+            // Nothing to do until the next step is due
+            double scale = std::max((double)timeScale, 1e-6);
+            double wait = isPaused ? 0.01 : (fixedTimestep - accumulator)/scale;
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::min(wait, 0.01)));
+        }
+    }
+}
+
+/**
+ * @brief Converts one component of the positions to floats.
+ */
+static void copyComponent(const AlignedVector<double>& source, size_t count, std::vector<float>& destination) {
+    destination.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        destination[i] = (float)source[i];
+    }
+}
+
+/**
+ * @brief Records the current positions as the snapshot's previous positions.
+ */
+void PhysicsThread::capturePrevious(PhysicsSnapshot& snapshot) {
+    const BodyStore& bodies = world.bodies;
+    size_t count = bodies.Size();
+    snapshot.previousX.resize(count);
+    snapshot.previousY.resize(count);
+    snapshot.previousZ.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        snapshot.previousX[i] = (float)bodies.x[i];
+        snapshot.previousY[i] = (float)bodies.y[i];
+        snapshot.previousZ[i] = (float)bodies.z[i];
+    }
+    snapshot.previousTime = world.time;
+
+    const ParticleStore& particles = world.particles;
+    copyComponent(particles.x, particles.Size(), snapshot.previousParticleX);
+    copyComponent(particles.y, particles.Size(), snapshot.previousParticleY);
+    copyComponent(particles.z, particles.Size(), snapshot.previousParticleZ);
+}
+
+/**
+ * @brief Fills in the rest of the snapshot from the current state and hands it to the renderer.
+ */
+void PhysicsThread::publish(PhysicsSnapshot& snapshot) {
+    const BodyStore& bodies = world.bodies;
+    size_t count = bodies.Size();
+    snapshot.x.resize(count);
+    snapshot.y.resize(count);
+    snapshot.z.resize(count);
+    snapshot.radius.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        snapshot.x[i] = (float)bodies.x[i];
+        snapshot.y[i] = (float)bodies.y[i];
+        snapshot.z[i] = (float)bodies.z[i];
+        snapshot.radius[i] = (float)bodies.radius[i];
+    }
+
+    const ParticleStore& particles = world.particles;
+    copyComponent(particles.x, particles.Size(), snapshot.particleX);
+    copyComponent(particles.y, particles.Size(), snapshot.particleY);
+    copyComponent(particles.z, particles.Size(), snapshot.particleZ);
+    snapshot.time = world.time;
+    snapshot.publishTime = std::chrono::steady_clock::now();
+    snapshot.stepWallTime = fixedTimestep/std::max((double)timeScale, 1e-6);
+
+    snapshots.Publish();
+}
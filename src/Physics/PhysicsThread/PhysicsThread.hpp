@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Physics/PhysicsWorld/PhysicsWorld.hpp>
+#include <Utilities/TripleBuffer.hpp>
+
+/**
+ * @brief The positions of every body and test particle at the end of a step, plus where they were one
+ * step before.
+ *
+ * Holding both lets the renderer interpolate between the last two states without keeping any
+ * history of its own.
+ */
+struct PhysicsSnapshot {
+    std::vector<float> x, y, z;
+    std::vector<float> previousX, previousY, previousZ;
+    std::vector<float> radius;
+    std::vector<float> particleX, particleY, particleZ;
+    std::vector<float> previousParticleX, previousParticleY, previousParticleZ;
+    // Simulation time of the current and previous states
+    double time = 0.0;
+    double previousTime = 0.0;
+    // Wall-clock time the step finished, and how much wall-clock time one step represents
+    std::chrono::steady_clock::time_point publishTime;
+    double stepWallTime = 0.0;
+
+    size_t Size() const { return x.size(); }
+    size_t ParticleCount() const { return particleX.size(); }
+    float InterpolationFactor(std::chrono::steady_clock::time_point now) const;
+};
+
+/**
+ * @brief Runs a PhysicsWorld on its own thread at a fixed timestep.
+ *
+ * Real time is accumulated and consumed in fixed steps, so the integration doesn't depend on the
+ * frame rate. After each batch of steps the state is published through a triple buffer, so neither
+ * a slow frame nor a slow step ever makes the other side wait.
+ */
+class PhysicsThread {
+    private:
+        PhysicsWorld& world;
+        std::thread thread;
+        std::atomic<bool> isRunning{false};
+        TripleBuffer<PhysicsSnapshot> snapshots;
+
+        void loop();
+        void capturePrevious(PhysicsSnapshot& snapshot);
+        void publish(PhysicsSnapshot& snapshot);
+
+    public:
+        double fixedTimestep = 1.0/240.0;
+        // If the physics falls further behind than this many steps, the backlog is dropped
+        int maxStepsPerUpdate = 16;
+        std::atomic<double> timeScale{1.0};
+        std::atomic<bool> isPaused{false};
+
+        explicit PhysicsThread(PhysicsWorld& world) : world(world) {}
+        ~PhysicsThread();
+
+        PhysicsThread(const PhysicsThread&) = delete;
+        PhysicsThread& operator=(const PhysicsThread&) = delete;
+
+        void Start();
+        void Stop();
+        bool AcquireSnapshot() { return snapshots.Acquire(); }
+        const PhysicsSnapshot& Snapshot() const { return snapshots.ReadBuffer(); }
+};
@@ -0,0 +1,228 @@
+#include <Physics/PhysicsWorld/PhysicsWorld.hpp>
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Sets the job system the physics runs on.
+ *
+ * @param jobSystem the job system, or nullptr to run everything on the calling thread.
+ */
+void PhysicsWorld::SetJobSystem(JobSystem* jobSystem) {
+    this->jobSystem = jobSystem;
+    gravity.SetJobSystem(jobSystem);
+    collisions.SetJobSystem(jobSystem);
+    rails.SetJobSystem(jobSystem);
+    integrator->SetJobSystem(jobSystem);
+}
+
+/**
+ * @brief Switches the scheme used to advance the bodies.
+ *
+ * Safe to call between steps, since every integrator keeps the accelerations in sync with the positions.
+ *
+ * @param type the integrator to use from the next step on.
+ */
+void PhysicsWorld::SetIntegrator(IntegratorType type) {
+    integrator = CreateIntegrator(type);
+    integrator->SetJobSystem(jobSystem);
+}
+
+/**
+ * @brief Drives some of the bodies from an ephemeris instead of integrating them.
+ *
+ * The driven bodies still pull on everything else, but have no forces computed for themselves, and
+ * are placed by the ephemeris at the end of every step. Once the simulation runs past the end of the
+ * ephemeris they are integrated like any other body. Call before Initialise; the ephemeris must outlive
+ * the world, or be replaced first.
+ *
+ * @param ephemeris the ephemeris, or nullptr to integrate every body.
+ */
+void PhysicsWorld::SetEphemeris(const Ephemeris* ephemeris) {
+    this->ephemeris = ephemeris;
+    drivenBodies.clear();
+    if (ephemeris != nullptr) {
+        const uint64_t* indices = ephemeris->BodyIndices();
+        drivenBodies.assign(indices, indices + ephemeris->BodyCount());
+    }
+}
+
+/**
+ * @brief Points gravity at the bodies that need their forces computed, which is all of them unless
+ * some are on rails or driven by the ephemeris.
+ */
+void PhysicsWorld::updateActiveBodies() {
+    if (drivenBodies.empty()) {
+        gravity.SetActiveBodies(rails.Empty() ? nullptr : &rails.FreeBodies());
+        return;
+    }
+    activeBodies.clear();
+    if (rails.Empty()) {
+        for (unsigned int i = 0; i < bodies.Size(); i++) {
+            if (!isDriven[i]) {
+                activeBodies.push_back(i);
+            }
+        }
+    }
+    else {
+        for (unsigned int i : rails.FreeBodies()) {
+            if (!isDriven[i]) {
+                activeBodies.push_back(i);
+            }
+        }
+    }
+    gravity.SetActiveBodies(&activeBodies);
+}
+
+/**
+ * @brief Places the driven bodies for the current time, or hands them back to the integrator once the
+ * ephemeris has run out.
+ */
+void PhysicsWorld::driveBodies() {
+    if (ephemeris == nullptr) {
+        return;
+    }
+    if (ephemeris->Covers(time)) {
+        ephemeris->Evaluate(time, bodies);
+        return;
+    }
+    std::vector<unsigned int> released;
+    released.swap(drivenBodies);
+    ephemeris = nullptr;
+    updateActiveBodies();
+    gravity.ComputeAccelerations(bodies, released);
+}
+
+/**
+ * @brief Prepares the world for stepping once its bodies and particles have been set up.
+ *
+ * Places the bodies driven by the ephemeris and puts bodies on rails as their motions ask, then
+ * computes the initial accelerations, which the first step relies on.
+ *
+ * @throws std::runtime_error if the ephemeris doesn't fit the bodies or doesn't cover the current time.
+ */
+void PhysicsWorld::Initialise() {
+    isDriven.assign(bodies.Size(), 0);
+    for (unsigned int i : drivenBodies) {
+        if (i >= bodies.Size() || rails.GetMotion(i) != N_BODY) {
+            throw std::runtime_error("Body " + std::to_string(i) + " can't be driven by the ephemeris");
+        }
+        isDriven[i] = 1;
+    }
+    if (ephemeris != nullptr) {
+        if (!ephemeris->Covers(time)) {
+            throw std::runtime_error("The ephemeris doesn't cover time " + std::to_string(time));
+        }
+        ephemeris->Evaluate(time, bodies);
+    }
+
+    rails.Initialise(bodies, time, gravity.gravitationalConstant);
+    updateActiveBodies();
+    gravity.ComputeAccelerations(bodies);
+    rails.Evaluate(bodies, time);
+    gravity.ComputeParticleAccelerations(bodies, particles);
+}
+
+/**
+ * @brief Advances the world by one step, then resolves any collisions between bodies during it.
+ *
+ * Bodies driven by the ephemeris are placed, and bodies on rails put back on their orbits, at the end
+ * of the step, before collisions are looked for.
+ *
+ * @param deltaTime the step size, in simulation time.
+ */
+void PhysicsWorld::Step(double deltaTime) {
+    bool isColliding = collisions.response != IGNORE_COLLISIONS;
+    if (isColliding) {
+        collisions.BeginStep(bodies);
+    }
+    integrator->Step(bodies, particles, gravity, deltaTime);
+    time += deltaTime;
+
+    driveBodies();
+    const std::vector<unsigned int>& freed = rails.Update(bodies, time, gravity.gravitationalConstant);
+    updateActiveBodies();
+    if (!freed.empty()) {
+        gravity.ComputeAccelerations(bodies, freed);
+    }
+    if (isColliding && collisions.Resolve(bodies, deltaTime) > 0 && !rails.Empty()) {
+        const std::vector<unsigned int>& detached = rails.Anchor(bodies, time, gravity.gravitationalConstant);
+        updateActiveBodies();
+        if (!detached.empty()) {
+            gravity.ComputeAccelerations(bodies, detached);
+        }
+    }
+}
+
+/**
+ * @brief Moves the world straight to another time, without stepping.
+ *
+ * Only possible when there are no particles and every body is on rails or driven by the ephemeris,
+ * but for at most one root when there is no ephemeris. Driven bodies are placed by the ephemeris and
+ * everything else on its orbit. A root, the heaviest body, is placed where it keeps the centre of
+ * mass of the whole system drifting at its current velocity. The jump costs O(N) however far it goes.
+ *
+ * @param time the simulation time to move to.
+ * @throws std::runtime_error if any particles or bodies can't be placed, or the ephemeris doesn't cover the time.
+ */
+void PhysicsWorld::JumpTo(double time) {
+    if (!particles.Empty()) {
+        throw std::runtime_error("Can't jump in time with test particles, which aren't on rails");
+    }
+    std::vector<unsigned int> roots;
+    for (unsigned int i = 0; i < bodies.Size(); i++) {
+        if (!rails.IsOnRails(i) && (ephemeris == nullptr || !isDriven[i])) {
+            roots.push_back(i);
+        }
+    }
+    if (ephemeris != nullptr) {
+        if (!roots.empty()) {
+            throw std::runtime_error("Can't jump in time unless every body is on rails or driven by the ephemeris");
+        }
+        if (!ephemeris->Covers(time)) {
+            throw std::runtime_error("The ephemeris doesn't cover time " + std::to_string(time));
+        }
+        this->time = time;
+        ephemeris->Evaluate(time, bodies);
+        rails.Evaluate(bodies, time);
+        return;
+    }
+    if (roots.size() != 1) {
+        throw std::runtime_error("Can't jump in time unless every body but one is on rails");
+    }
+
+    double totalMass = 0.0;
+    glm::dvec3 centre(0.0), momentum(0.0);
+    for (unsigned int i = 0; i < bodies.Size(); i++) {
+        totalMass += bodies.mass[i];
+        centre += bodies.mass[i]*bodies.Position(i);
+        momentum += bodies.mass[i]*bodies.Velocity(i);
+    }
+    glm::dvec3 velocity = momentum/totalMass;
+    centre = centre/totalMass + velocity*(time - this->time);
+
+    // Lay the hierarchy out around the root at the origin, then move it so the centre of mass lands in place
+    unsigned int root = roots[0];
+    bodies.x[root] = bodies.y[root] = bodies.z[root] = 0.0;
+    bodies.vx[root] = bodies.vy[root] = bodies.vz[root] = 0.0;
+    rails.Evaluate(bodies, time);
+    glm::dvec3 offset(0.0), offsetVelocity(0.0);
+    for (unsigned int i = 0; i < bodies.Size(); i++) {
+        offset += bodies.mass[i]*bodies.Position(i);
+        offsetVelocity += bodies.mass[i]*bodies.Velocity(i);
+    }
+    offset = centre - offset/totalMass;
+    offsetVelocity = velocity - offsetVelocity/totalMass;
+    for (unsigned int i = 0; i < bodies.Size(); i++) {
+        bodies.x[i] += offset.x;
+        bodies.y[i] += offset.y;
+        bodies.z[i] += offset.z;
+        bodies.vx[i] += offsetVelocity.x;
+        bodies.vy[i] += offsetVelocity.y;
+        bodies.vz[i] += offsetVelocity.z;
+    }
+
+    this->time = time;
+    gravity.ComputeAccelerations(bodies, roots);
+    rails.Evaluate(bodies, time);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Collisions/Collisions.hpp>
+#include <Physics/Ephemeris/Ephemeris.hpp>
+#include <Physics/Gravity/Gravity.hpp>
+#include <Physics/Integrator/Integrator.hpp>
+#include <Physics/ParticleStore/ParticleStore.hpp>
+#include <Physics/Rails/KeplerRails.hpp>
+
+/**
+ * @brief Everything needed to advance the simulated system, independent of any rendering.
+ *
+ * Owned by whichever thread runs the physics; nothing else may touch it while that thread runs.
+ */
+class PhysicsWorld {
+    private:
+        JobSystem* jobSystem = nullptr;
+        std::unique_ptr<Integrator> integrator = CreateIntegrator(LEAPFROG);
+        // Bodies placed by the ephemeris rather than integrated
+        const Ephemeris* ephemeris = nullptr;
+        std::vector<unsigned int> drivenBodies;
+        std::vector<char> isDriven;
+        std::vector<unsigned int> activeBodies;
+
+        void updateActiveBodies();
+        void driveBodies();
+
+    public:
+        BodyStore bodies;
+        // Massless test particles, such as belt asteroids, which are pulled by the bodies but not the other way round
+        ParticleStore particles;
+        Gravity gravity;
+        Collisions collisions;
+        // Bodies moved along Kepler orbits instead of being integrated
+        KeplerRails rails;
+        double time = 0.0;
+
+        void SetJobSystem(JobSystem* jobSystem);
+        void SetIntegrator(IntegratorType type);
+        void SetEphemeris(const Ephemeris* ephemeris);
+        const Integrator& GetIntegrator() const { return *integrator; }
+        void Initialise();
+        void Step(double deltaTime);
+        void JumpTo(double time);
+};
@@ -0,0 +1,763 @@
+#include <Physics/Rails/KeplerKernels.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// NOTE: like GravityKernels.cpp, this file must be compiled without floating point contraction
+// (-ffp-contract=off), otherwise the kernels will stop agreeing bit for bit. See CMakeLists.txt.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define KEPLER_KERNELS_X86
+    #include <immintrin.h>
+#endif
+
+/*
+ * Every kernel solves Kepler's equation in universal variables with the Laguerre-Conway iteration,
+ * which converges from a rough first guess for every kind of orbit. Bodies are solved in blocks, and
+ * each iteration is applied to the whole block before the next, so the arithmetic runs across bodies
+ * and the block stops once every body in it has converged. Nothing branches on a single body: the
+ * first guesses for ellipses, parabolae and hyperbolae are all worked out and the right one picked,
+ * and the Stumpff functions are summed as a series after quartering their argument as many times as
+ * each body needs, then doubled back up, with bodies that are done masked out.
+ */
+
+// Bodies are solved in blocks of this many
+static const std::size_t KEPLER_BLOCK_SIZE = 64;
+static const int KEPLER_MAX_ITERATIONS = 30;
+// Largest step, relative to the universal anomaly, at which a block counts as converged
+static const double KEPLER_TOLERANCE = 1e-14;
+// Orbits with a reciprocal semi-major axis smaller than this get the parabolic first guess
+static const double KEPLER_PARABOLIC_LIMIT = 1e-12;
+static const double TWO_PI = 2.0*M_PI;
+
+// The Stumpff series are summed once the argument has been quartered to below this. A wide range with
+// a long series means fewer doublings, each of which loses a little precision on hyperbolae.
+static const double STUMPFF_SERIES_LIMIT = 4.0;
+// Enough for any argument whose functions don't overflow
+static const int STUMPFF_MAX_QUARTERINGS = 16;
+static const int STUMPFF_TERMS = 13;
+// C(z) is the sum of (-z)^k/(2k + 2)!, and S(z) the sum of (-z)^k/(2k + 3)!
+static const double STUMPFF_C[STUMPFF_TERMS] = {
+    1.0/2.0, -1.0/24.0, 1.0/720.0, -1.0/40320.0, 1.0/3628800.0, -1.0/479001600.0, 1.0/87178291200.0,
+    -1.0/20922789888000.0, 1.0/6402373705728000.0, -1.0/2432902008176640000.0, 1.0/1124000727777607680000.0,
+    -1.0/620448401733239439360000.0, 1.0/403291461126605635584000000.0
+};
+static const double STUMPFF_S[STUMPFF_TERMS] = {
+    1.0/6.0, -1.0/120.0, 1.0/5040.0, -1.0/362880.0, 1.0/39916800.0, -1.0/6227020800.0, 1.0/1307674368000.0,
+    -1.0/355687428096000.0, 1.0/121645100408832000.0, -1.0/51090942171709440000.0, 1.0/25852016738884976640000.0,
+    -1.0/15511210043330985984000000.0, 1.0/10888869450418352160768000000.0
+};
+
+// The logarithm for the hyperbolic first guess is log((1 + s)/(1 - s)) = 2(s + s^3/3 + s^5/5 + ...)
+static const int LOG_TERMS = 6;
+static const double LOG_SERIES[LOG_TERMS] = {1.0, 1.0/3.0, 1.0/5.0, 1.0/7.0, 1.0/9.0, 1.0/11.0};
+// The exponent bits are slotted into the mantissa of 2^52, which is then subtracted along with the bias
+static const uint64_t EXPONENT_AS_MANTISSA = 0x4330000000000000ull;
+static const double EXPONENT_OFFSET = 4503599627370496.0 + 1023.0;
+static const uint64_t MANTISSA_BITS = 0x000FFFFFFFFFFFFFull;
+static const uint64_t ONE_BITS = 0x3FF0000000000000ull;
+
+/**
+ * @brief Approximates the natural logarithm of a positive number, closely enough for a first guess.
+ */
+static inline double logScalar(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint64_t exponentBits = (bits >> 52) | EXPONENT_AS_MANTISSA;
+    uint64_t mantissaBits = (bits & MANTISSA_BITS) | ONE_BITS;
+    double exponent, mantissa;
+    std::memcpy(&exponent, &exponentBits, sizeof(exponent));
+    std::memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+    exponent = exponent - EXPONENT_OFFSET;
+
+    // The series converges fastest with the mantissa between sqrt(1/2) and sqrt(2)
+    bool isLarge = mantissa > M_SQRT2;
+    mantissa = isLarge ? mantissa*0.5 : mantissa;
+    exponent = isLarge ? exponent + 1.0 : exponent;
+    double s = (mantissa - 1.0)/(mantissa + 1.0);
+    double sSquared = s*s;
+    double series = LOG_SERIES[LOG_TERMS - 1];
+    for (int k = LOG_TERMS - 2; k >= 0; k--) {
+        series = series*sSquared + LOG_SERIES[k];
+    }
+    double half = s*series;
+    return exponent*M_LN2 + (half + half);
+}
+
+/**
+ * @brief Evaluates the Stumpff functions C(z) and S(z).
+ *
+ * With c0 to c3 the Stumpff functions of z, those of 4z are c0' = 2c0^2 - 1, c1' = c0 c1,
+ * c2' = c1^2/2 and c3' = (c2 + c0 c3)/4, which hold for any sign of z.
+ */
+static inline void stumpffScalar(double z, double& c, double& s) {
+    double reduced = z;
+    int quarterings = 0;
+    while (quarterings < STUMPFF_MAX_QUARTERINGS && std::fabs(reduced) >= STUMPFF_SERIES_LIMIT) {
+        reduced = reduced*0.25;
+        quarterings++;
+    }
+
+    c = STUMPFF_C[STUMPFF_TERMS - 1];
+    s = STUMPFF_S[STUMPFF_TERMS - 1];
+    for (int k = STUMPFF_TERMS - 2; k >= 0; k--) {
+        c = c*reduced + STUMPFF_C[k];
+        s = s*reduced + STUMPFF_S[k];
+    }
+    double c0 = 1.0 - reduced*c;
+    double c1 = 1.0 - reduced*s;
+
+    for (int k = 0; k < quarterings; k++) {
+        s = (c + c0*s)*0.25;
+        c = c1*c1*0.5;
+        c1 = c0*c1;
+        c0 = 2.0*c0*c0 - 1.0;
+    }
+}
+
+/**
+ * @brief Portable reference kernel, also used on machines without any supported SIMD extension.
+ */
+static void keplerKernelScalar(const double* x, const double* y, const double* z, const double* vx, const double* vy, const double* vz,
+                               const double* gravitationalParameter, const double* deltaTime, std::size_t count,
+                               double* outX, double* outY, double* outZ, double* outVx, double* outVy, double* outVz) {
+    double radius[KEPLER_BLOCK_SIZE], sigma[KEPLER_BLOCK_SIZE], alpha[KEPLER_BLOCK_SIZE], eccentric[KEPLER_BLOCK_SIZE];
+    double rootMu[KEPLER_BLOCK_SIZE], time[KEPLER_BLOCK_SIZE], chi[KEPLER_BLOCK_SIZE];
+
+    for (std::size_t start = 0; start < count; start += KEPLER_BLOCK_SIZE) {
+        std::size_t blockCount = std::min(KEPLER_BLOCK_SIZE, count - start);
+
+        for (std::size_t k = 0; k < blockCount; k++) {
+            std::size_t i = start + k;
+            double mu = gravitationalParameter[i];
+            radius[k] = std::sqrt(x[i]*x[i] + y[i]*y[i] + z[i]*z[i]);
+            rootMu[k] = std::sqrt(mu);
+            sigma[k] = (x[i]*vx[i] + y[i]*vy[i] + z[i]*vz[i])/rootMu[k];
+            // alpha is the reciprocal of the semi-major axis: positive for ellipses, negative for hyperbolae
+            alpha[k] = 2.0/radius[k] - (vx[i]*vx[i] + vy[i]*vy[i] + vz[i]*vz[i])/mu;
+            eccentric[k] = 1.0 - alpha[k]*radius[k];
+
+            // Ellipses are first wound back by whole periods, so far jumps lose no accuracy
+            double t = deltaTime[i];
+            double period = TWO_PI/(rootMu[k]*alpha[k]*std::sqrt(alpha[k]));
+            double wound = t - std::trunc(t/period)*period;
+            double ellipseGuess = rootMu[k]*alpha[k]*wound;
+
+            double semiMajorAxis = 1.0/alpha[k];
+            double direction = t < 0.0 ? -1.0 : 1.0;
+            double argument = -2.0*mu*alpha[k]*t/(sigma[k]*rootMu[k] + direction*std::sqrt(-mu*semiMajorAxis)*eccentric[k]);
+            double hyperbolaGuess = direction*std::sqrt(-semiMajorAxis)*logScalar(argument);
+            double parabolaGuess = rootMu[k]*t/radius[k];
+
+            bool isEllipse = alpha[k] > KEPLER_PARABOLIC_LIMIT;
+            bool isHyperbola = alpha[k] < -KEPLER_PARABOLIC_LIMIT && argument > 0.0;
+            time[k] = isEllipse ? wound : t;
+            chi[k] = isEllipse ? ellipseGuess : (isHyperbola ? hyperbolaGuess : parabolaGuess);
+        }
+
+        for (int iteration = 0; iteration < KEPLER_MAX_ITERATIONS; iteration++) {
+            double largestError = 0.0;
+            for (std::size_t k = 0; k < blockCount; k++) {
+                double chiSquared = chi[k]*chi[k];
+                double zeta = alpha[k]*chiSquared;
+                double c, s;
+                stumpffScalar(zeta, c, s);
+                double value = sigma[k]*chiSquared*c + eccentric[k]*chiSquared*chi[k]*s + radius[k]*chi[k] - rootMu[k]*time[k];
+                double slope = sigma[k]*chi[k]*(1.0 - zeta*s) + eccentric[k]*chiSquared*c + radius[k];
+                double curvature = sigma[k]*(1.0 - zeta*c) + eccentric[k]*chi[k]*(1.0 - zeta*s);
+                double root = std::sqrt(std::fabs(16.0*slope*slope - 20.0*value*curvature));
+                double step = 5.0*value/(slope + (slope < 0.0 ? -root : root));
+                chi[k] = chi[k] - step;
+                largestError = std::max(largestError, std::fabs(step)/std::max(1.0, std::fabs(chi[k])));
+            }
+            if (largestError < KEPLER_TOLERANCE) {
+                break;
+            }
+        }
+
+        for (std::size_t k = 0; k < blockCount; k++) {
+            std::size_t i = start + k;
+            double chiSquared = chi[k]*chi[k];
+            double zeta = alpha[k]*chiSquared;
+            double c, s;
+            stumpffScalar(zeta, c, s);
+            double f = 1.0 - chiSquared*c/radius[k];
+            double g = time[k] - chiSquared*chi[k]*s/rootMu[k];
+            double newX = f*x[i] + g*vx[i];
+            double newY = f*y[i] + g*vy[i];
+            double newZ = f*z[i] + g*vz[i];
+            double newRadius = std::sqrt(newX*newX + newY*newY + newZ*newZ);
+            double fDot = rootMu[k]*chi[k]*(zeta*s - 1.0)/(newRadius*radius[k]);
+            double gDot = 1.0 - chiSquared*c/newRadius;
+            outX[i] = newX;
+            outY[i] = newY;
+            outZ[i] = newZ;
+            outVx[i] = fDot*x[i] + gDot*vx[i];
+            outVy[i] = fDot*y[i] + gDot*vy[i];
+            outVz[i] = fDot*z[i] + gDot*vz[i];
+        }
+    }
+}
+
+#ifdef KEPLER_KERNELS_X86
+
+__attribute__((target("sse2")))
+static inline __m128d blendSSE2(__m128d mask, __m128d ifTrue, __m128d ifFalse) {
+    return _mm_or_pd(_mm_and_pd(mask, ifTrue), _mm_andnot_pd(mask, ifFalse));
+}
+
+// SSE2 has no rounding instruction, so adding and taking away 2^52 rounds, and the result is stepped towards zero
+__attribute__((target("sse2")))
+static inline __m128d truncateSSE2(__m128d value) {
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    const __m128d twoToThe52 = _mm_set1_pd(4503599627370496.0);
+    __m128d magnitude = _mm_andnot_pd(signBit, value);
+    __m128d rounded = _mm_sub_pd(_mm_add_pd(magnitude, twoToThe52), twoToThe52);
+    rounded = _mm_sub_pd(rounded, _mm_and_pd(_mm_cmpgt_pd(rounded, magnitude), _mm_set1_pd(1.0)));
+    // Anything this large is a whole number already
+    rounded = blendSSE2(_mm_cmpge_pd(magnitude, twoToThe52), magnitude, rounded);
+    return _mm_or_pd(rounded, _mm_and_pd(value, signBit));
+}
+
+__attribute__((target("sse2")))
+static inline __m128d logSSE2(__m128d value) {
+    const __m128d one = _mm_set1_pd(1.0);
+    __m128i bits = _mm_castpd_si128(value);
+    __m128d exponent = _mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(bits, 52), _mm_set1_epi64x((long long)EXPONENT_AS_MANTISSA)));
+    __m128d mantissa = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x((long long)MANTISSA_BITS)), _mm_set1_epi64x((long long)ONE_BITS)));
+    exponent = _mm_sub_pd(exponent, _mm_set1_pd(EXPONENT_OFFSET));
+
+    __m128d isLarge = _mm_cmpgt_pd(mantissa, _mm_set1_pd(M_SQRT2));
+    mantissa = blendSSE2(isLarge, _mm_mul_pd(mantissa, _mm_set1_pd(0.5)), mantissa);
+    exponent = blendSSE2(isLarge, _mm_add_pd(exponent, one), exponent);
+    __m128d s = _mm_div_pd(_mm_sub_pd(mantissa, one), _mm_add_pd(mantissa, one));
+    __m128d sSquared = _mm_mul_pd(s, s);
+    __m128d series = _mm_set1_pd(LOG_SERIES[LOG_TERMS - 1]);
+    for (int k = LOG_TERMS - 2; k >= 0; k--) {
+        series = _mm_add_pd(_mm_mul_pd(series, sSquared), _mm_set1_pd(LOG_SERIES[k]));
+    }
+    __m128d half = _mm_mul_pd(s, series);
+    return _mm_add_pd(_mm_mul_pd(exponent, _mm_set1_pd(M_LN2)), _mm_add_pd(half, half));
+}
+
+__attribute__((target("sse2")))
+static inline void stumpffSSE2(__m128d z, __m128d& c, __m128d& s) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d quarter = _mm_set1_pd(0.25);
+    const __m128d limit = _mm_set1_pd(STUMPFF_SERIES_LIMIT);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+
+    // Only stops early once no lane needs quartering any more
+    __m128d reduced = z;
+    __m128d quarterings = _mm_setzero_pd();
+    int rounds = 0;
+    for (; rounds < STUMPFF_MAX_QUARTERINGS; rounds++) {
+        __m128d isLarge = _mm_cmpge_pd(_mm_andnot_pd(signBit, reduced), limit);
+        if (_mm_movemask_pd(isLarge) == 0) {
+            break;
+        }
+        reduced = blendSSE2(isLarge, _mm_mul_pd(reduced, quarter), reduced);
+        quarterings = _mm_add_pd(quarterings, _mm_and_pd(isLarge, one));
+    }
+
+    c = _mm_set1_pd(STUMPFF_C[STUMPFF_TERMS - 1]);
+    s = _mm_set1_pd(STUMPFF_S[STUMPFF_TERMS - 1]);
+    for (int k = STUMPFF_TERMS - 2; k >= 0; k--) {
+        c = _mm_add_pd(_mm_mul_pd(c, reduced), _mm_set1_pd(STUMPFF_C[k]));
+        s = _mm_add_pd(_mm_mul_pd(s, reduced), _mm_set1_pd(STUMPFF_S[k]));
+    }
+    __m128d c0 = _mm_sub_pd(one, _mm_mul_pd(reduced, c));
+    __m128d c1 = _mm_sub_pd(one, _mm_mul_pd(reduced, s));
+
+    for (int round = 0; round < rounds; round++) {
+        __m128d isDoubling = _mm_cmpgt_pd(quarterings, _mm_set1_pd((double)round));
+        __m128d doubledS = _mm_mul_pd(_mm_add_pd(c, _mm_mul_pd(c0, s)), quarter);
+        __m128d doubledC = _mm_mul_pd(_mm_mul_pd(c1, c1), _mm_set1_pd(0.5));
+        __m128d doubledC1 = _mm_mul_pd(c0, c1);
+        __m128d doubledC0 = _mm_sub_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(2.0), c0), c0), one);
+        s = blendSSE2(isDoubling, doubledS, s);
+        c = blendSSE2(isDoubling, doubledC, c);
+        c1 = blendSSE2(isDoubling, doubledC1, c1);
+        c0 = blendSSE2(isDoubling, doubledC0, c0);
+    }
+}
+
+__attribute__((target("sse2")))
+static void keplerKernelSSE2(const double* x, const double* y, const double* z, const double* vx, const double* vy, const double* vz,
+                             const double* gravitationalParameter, const double* deltaTime, std::size_t count,
+                             double* outX, double* outY, double* outZ, double* outVx, double* outVy, double* outVz) {
+    alignas(64) double radius[KEPLER_BLOCK_SIZE], sigma[KEPLER_BLOCK_SIZE], alpha[KEPLER_BLOCK_SIZE], eccentric[KEPLER_BLOCK_SIZE];
+    alignas(64) double rootMu[KEPLER_BLOCK_SIZE], time[KEPLER_BLOCK_SIZE], chi[KEPLER_BLOCK_SIZE];
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+
+    for (std::size_t start = 0; start < count; start += KEPLER_BLOCK_SIZE) {
+        std::size_t blockCount = std::min(KEPLER_BLOCK_SIZE, count - start);
+
+        for (std::size_t k = 0; k < blockCount; k += 2) {
+            std::size_t i = start + k;
+            __m128d px = _mm_loadu_pd(x + i), py = _mm_loadu_pd(y + i), pz = _mm_loadu_pd(z + i);
+            __m128d pvx = _mm_loadu_pd(vx + i), pvy = _mm_loadu_pd(vy + i), pvz = _mm_loadu_pd(vz + i);
+            __m128d mu = _mm_loadu_pd(gravitationalParameter + i);
+            __m128d r = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(px, px), _mm_mul_pd(py, py)), _mm_mul_pd(pz, pz)));
+            __m128d rm = _mm_sqrt_pd(mu);
+            __m128d sg = _mm_div_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(px, pvx), _mm_mul_pd(py, pvy)), _mm_mul_pd(pz, pvz)), rm);
+            __m128d speedSquared = _mm_add_pd(_mm_add_pd(_mm_mul_pd(pvx, pvx), _mm_mul_pd(pvy, pvy)), _mm_mul_pd(pvz, pvz));
+            __m128d a = _mm_sub_pd(_mm_div_pd(_mm_set1_pd(2.0), r), _mm_div_pd(speedSquared, mu));
+            __m128d e = _mm_sub_pd(one, _mm_mul_pd(a, r));
+
+            __m128d t = _mm_loadu_pd(deltaTime + i);
+            __m128d period = _mm_div_pd(_mm_set1_pd(TWO_PI), _mm_mul_pd(_mm_mul_pd(rm, a), _mm_sqrt_pd(a)));
+            __m128d wound = _mm_sub_pd(t, _mm_mul_pd(truncateSSE2(_mm_div_pd(t, period)), period));
+            __m128d ellipseGuess = _mm_mul_pd(_mm_mul_pd(rm, a), wound);
+
+            __m128d semiMajorAxis = _mm_div_pd(one, a);
+            __m128d direction = blendSSE2(_mm_cmplt_pd(t, zero), _mm_set1_pd(-1.0), one);
+            __m128d denominator = _mm_add_pd(_mm_mul_pd(sg, rm),
+                                             _mm_mul_pd(_mm_mul_pd(direction, _mm_sqrt_pd(_mm_mul_pd(_mm_xor_pd(mu, signBit), semiMajorAxis))), e));
+            __m128d argument = _mm_div_pd(_mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(-2.0), mu), a), t), denominator);
+            __m128d hyperbolaGuess = _mm_mul_pd(_mm_mul_pd(direction, _mm_sqrt_pd(_mm_xor_pd(semiMajorAxis, signBit))), logSSE2(argument));
+            __m128d parabolaGuess = _mm_div_pd(_mm_mul_pd(rm, t), r);
+
+            __m128d isEllipse = _mm_cmpgt_pd(a, _mm_set1_pd(KEPLER_PARABOLIC_LIMIT));
+            __m128d isHyperbola = _mm_and_pd(_mm_cmplt_pd(a, _mm_set1_pd(-KEPLER_PARABOLIC_LIMIT)), _mm_cmpgt_pd(argument, zero));
+            _mm_store_pd(radius + k, r);
+            _mm_store_pd(rootMu + k, rm);
+            _mm_store_pd(sigma + k, sg);
+            _mm_store_pd(alpha + k, a);
+            _mm_store_pd(eccentric + k, e);
+            _mm_store_pd(time + k, blendSSE2(isEllipse, wound, t));
+            _mm_store_pd(chi + k, blendSSE2(isEllipse, ellipseGuess, blendSSE2(isHyperbola, hyperbolaGuess, parabolaGuess)));
+        }
+
+        for (int iteration = 0; iteration < KEPLER_MAX_ITERATIONS; iteration++) {
+            __m128d largestError = zero;
+            for (std::size_t k = 0; k < blockCount; k += 2) {
+                __m128d ch = _mm_load_pd(chi + k);
+                __m128d r = _mm_load_pd(radius + k), rm = _mm_load_pd(rootMu + k), sg = _mm_load_pd(sigma + k);
+                __m128d a = _mm_load_pd(alpha + k), e = _mm_load_pd(eccentric + k), t = _mm_load_pd(time + k);
+                __m128d chiSquared = _mm_mul_pd(ch, ch);
+                __m128d zeta = _mm_mul_pd(a, chiSquared);
+                __m128d c, s;
+                stumpffSSE2(zeta, c, s);
+                __m128d oneMinusZetaS = _mm_sub_pd(one, _mm_mul_pd(zeta, s));
+                __m128d value = _mm_sub_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(sg, chiSquared), c), _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(e, chiSquared), ch), s)),
+                                                      _mm_mul_pd(r, ch)), _mm_mul_pd(rm, t));
+                __m128d slope = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(sg, ch), oneMinusZetaS), _mm_mul_pd(_mm_mul_pd(e, chiSquared), c)), r);
+                __m128d curvature = _mm_add_pd(_mm_mul_pd(sg, _mm_sub_pd(one, _mm_mul_pd(zeta, c))), _mm_mul_pd(_mm_mul_pd(e, ch), oneMinusZetaS));
+                __m128d root = _mm_sqrt_pd(_mm_andnot_pd(signBit, _mm_sub_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(16.0), slope), slope),
+                                                                             _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(20.0), value), curvature))));
+                root = _mm_xor_pd(root, _mm_and_pd(_mm_cmplt_pd(slope, zero), signBit));
+                __m128d step = _mm_div_pd(_mm_mul_pd(_mm_set1_pd(5.0), value), _mm_add_pd(slope, root));
+                ch = _mm_sub_pd(ch, step);
+                _mm_store_pd(chi + k, ch);
+                __m128d error = _mm_div_pd(_mm_andnot_pd(signBit, step), _mm_max_pd(_mm_andnot_pd(signBit, ch), one));
+                largestError = _mm_max_pd(error, largestError);
+            }
+            if (_mm_cvtsd_f64(_mm_max_sd(largestError, _mm_unpackhi_pd(largestError, largestError))) < KEPLER_TOLERANCE) {
+                break;
+            }
+        }
+
+        for (std::size_t k = 0; k < blockCount; k += 2) {
+            std::size_t i = start + k;
+            __m128d px = _mm_loadu_pd(x + i), py = _mm_loadu_pd(y + i), pz = _mm_loadu_pd(z + i);
+            __m128d pvx = _mm_loadu_pd(vx + i), pvy = _mm_loadu_pd(vy + i), pvz = _mm_loadu_pd(vz + i);
+            __m128d ch = _mm_load_pd(chi + k), r = _mm_load_pd(radius + k), rm = _mm_load_pd(rootMu + k);
+            __m128d chiSquared = _mm_mul_pd(ch, ch);
+            __m128d zeta = _mm_mul_pd(_mm_load_pd(alpha + k), chiSquared);
+            __m128d c, s;
+            stumpffSSE2(zeta, c, s);
+            __m128d f = _mm_sub_pd(one, _mm_div_pd(_mm_mul_pd(chiSquared, c), r));
+            __m128d g = _mm_sub_pd(_mm_load_pd(time + k), _mm_div_pd(_mm_mul_pd(_mm_mul_pd(chiSquared, ch), s), rm));
+            __m128d newX = _mm_add_pd(_mm_mul_pd(f, px), _mm_mul_pd(g, pvx));
+            __m128d newY = _mm_add_pd(_mm_mul_pd(f, py), _mm_mul_pd(g, pvy));
+            __m128d newZ = _mm_add_pd(_mm_mul_pd(f, pz), _mm_mul_pd(g, pvz));
+            __m128d newRadius = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(newX, newX), _mm_mul_pd(newY, newY)), _mm_mul_pd(newZ, newZ)));
+            __m128d fDot = _mm_div_pd(_mm_mul_pd(_mm_mul_pd(rm, ch), _mm_sub_pd(_mm_mul_pd(zeta, s), one)), _mm_mul_pd(newRadius, r));
+            __m128d gDot = _mm_sub_pd(one, _mm_div_pd(_mm_mul_pd(chiSquared, c), newRadius));
+            _mm_storeu_pd(outX + i, newX);
+            _mm_storeu_pd(outY + i, newY);
+            _mm_storeu_pd(outZ + i, newZ);
+            _mm_storeu_pd(outVx + i, _mm_add_pd(_mm_mul_pd(fDot, px), _mm_mul_pd(gDot, pvx)));
+            _mm_storeu_pd(outVy + i, _mm_add_pd(_mm_mul_pd(fDot, py), _mm_mul_pd(gDot, pvy)));
+            _mm_storeu_pd(outVz + i, _mm_add_pd(_mm_mul_pd(fDot, pz), _mm_mul_pd(gDot, pvz)));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256d logAVX2(__m256d value) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256i bits = _mm256_castpd_si256(value);
+    __m256d exponent = _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x((long long)EXPONENT_AS_MANTISSA)));
+    __m256d mantissa = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x((long long)MANTISSA_BITS)),
+                                                           _mm256_set1_epi64x((long long)ONE_BITS)));
+    exponent = _mm256_sub_pd(exponent, _mm256_set1_pd(EXPONENT_OFFSET));
+
+    __m256d isLarge = _mm256_cmp_pd(mantissa, _mm256_set1_pd(M_SQRT2), _CMP_GT_OQ);
+    mantissa = _mm256_blendv_pd(mantissa, _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), isLarge);
+    exponent = _mm256_blendv_pd(exponent, _mm256_add_pd(exponent, one), isLarge);
+    __m256d s = _mm256_div_pd(_mm256_sub_pd(mantissa, one), _mm256_add_pd(mantissa, one));
+    __m256d sSquared = _mm256_mul_pd(s, s);
+    __m256d series = _mm256_set1_pd(LOG_SERIES[LOG_TERMS - 1]);
+    for (int k = LOG_TERMS - 2; k >= 0; k--) {
+        series = _mm256_add_pd(_mm256_mul_pd(series, sSquared), _mm256_set1_pd(LOG_SERIES[k]));
+    }
+    __m256d half = _mm256_mul_pd(s, series);
+    return _mm256_add_pd(_mm256_mul_pd(exponent, _mm256_set1_pd(M_LN2)), _mm256_add_pd(half, half));
+}
+
+__attribute__((target("avx2")))
+static inline void stumpffAVX2(__m256d z, __m256d& c, __m256d& s) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d limit = _mm256_set1_pd(STUMPFF_SERIES_LIMIT);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+
+    // Only stops early once no lane needs quartering any more
+    __m256d reduced = z;
+    __m256d quarterings = _mm256_setzero_pd();
+    int rounds = 0;
+    for (; rounds < STUMPFF_MAX_QUARTERINGS; rounds++) {
+        __m256d isLarge = _mm256_cmp_pd(_mm256_andnot_pd(signBit, reduced), limit, _CMP_GE_OQ);
+        if (_mm256_movemask_pd(isLarge) == 0) {
+            break;
+        }
+        reduced = _mm256_blendv_pd(reduced, _mm256_mul_pd(reduced, quarter), isLarge);
+        quarterings = _mm256_add_pd(quarterings, _mm256_and_pd(isLarge, one));
+    }
+
+    c = _mm256_set1_pd(STUMPFF_C[STUMPFF_TERMS - 1]);
+    s = _mm256_set1_pd(STUMPFF_S[STUMPFF_TERMS - 1]);
+    for (int k = STUMPFF_TERMS - 2; k >= 0; k--) {
+        c = _mm256_add_pd(_mm256_mul_pd(c, reduced), _mm256_set1_pd(STUMPFF_C[k]));
+        s = _mm256_add_pd(_mm256_mul_pd(s, reduced), _mm256_set1_pd(STUMPFF_S[k]));
+    }
+    __m256d c0 = _mm256_sub_pd(one, _mm256_mul_pd(reduced, c));
+    __m256d c1 = _mm256_sub_pd(one, _mm256_mul_pd(reduced, s));
+
+    for (int round = 0; round < rounds; round++) {
+        __m256d isDoubling = _mm256_cmp_pd(quarterings, _mm256_set1_pd((double)round), _CMP_GT_OQ);
+        __m256d doubledS = _mm256_mul_pd(_mm256_add_pd(c, _mm256_mul_pd(c0, s)), quarter);
+        __m256d doubledC = _mm256_mul_pd(_mm256_mul_pd(c1, c1), _mm256_set1_pd(0.5));
+        __m256d doubledC1 = _mm256_mul_pd(c0, c1);
+        __m256d doubledC0 = _mm256_sub_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), c0), c0), one);
+        s = _mm256_blendv_pd(s, doubledS, isDoubling);
+        c = _mm256_blendv_pd(c, doubledC, isDoubling);
+        c1 = _mm256_blendv_pd(c1, doubledC1, isDoubling);
+        c0 = _mm256_blendv_pd(c0, doubledC0, isDoubling);
+    }
+}
+
+__attribute__((target("avx2")))
+static void keplerKernelAVX2(const double* x, const double* y, const double* z, const double* vx, const double* vy, const double* vz,
+                             const double* gravitationalParameter, const double* deltaTime, std::size_t count,
+                             double* outX, double* outY, double* outZ, double* outVx, double* outVy, double* outVz) {
+    alignas(64) double radius[KEPLER_BLOCK_SIZE], sigma[KEPLER_BLOCK_SIZE], alpha[KEPLER_BLOCK_SIZE], eccentric[KEPLER_BLOCK_SIZE];
+    alignas(64) double rootMu[KEPLER_BLOCK_SIZE], time[KEPLER_BLOCK_SIZE], chi[KEPLER_BLOCK_SIZE];
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+
+    for (std::size_t start = 0; start < count; start += KEPLER_BLOCK_SIZE) {
+        std::size_t blockCount = std::min(KEPLER_BLOCK_SIZE, count - start);
+
+        for (std::size_t k = 0; k < blockCount; k += 4) {
+            std::size_t i = start + k;
+            __m256d px = _mm256_loadu_pd(x + i), py = _mm256_loadu_pd(y + i), pz = _mm256_loadu_pd(z + i);
+            __m256d pvx = _mm256_loadu_pd(vx + i), pvy = _mm256_loadu_pd(vy + i), pvz = _mm256_loadu_pd(vz + i);
+            __m256d mu = _mm256_loadu_pd(gravitationalParameter + i);
+            __m256d r = _mm256_sqrt_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(px, px), _mm256_mul_pd(py, py)), _mm256_mul_pd(pz, pz)));
+            __m256d rm = _mm256_sqrt_pd(mu);
+            __m256d sg = _mm256_div_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(px, pvx), _mm256_mul_pd(py, pvy)), _mm256_mul_pd(pz, pvz)), rm);
+            __m256d speedSquared = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(pvx, pvx), _mm256_mul_pd(pvy, pvy)), _mm256_mul_pd(pvz, pvz));
+            __m256d a = _mm256_sub_pd(_mm256_div_pd(_mm256_set1_pd(2.0), r), _mm256_div_pd(speedSquared, mu));
+            __m256d e = _mm256_sub_pd(one, _mm256_mul_pd(a, r));
+
+            __m256d t = _mm256_loadu_pd(deltaTime + i);
+            __m256d period = _mm256_div_pd(_mm256_set1_pd(TWO_PI), _mm256_mul_pd(_mm256_mul_pd(rm, a), _mm256_sqrt_pd(a)));
+            __m256d turns = _mm256_round_pd(_mm256_div_pd(t, period), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            __m256d wound = _mm256_sub_pd(t, _mm256_mul_pd(turns, period));
+            __m256d ellipseGuess = _mm256_mul_pd(_mm256_mul_pd(rm, a), wound);
+
+            __m256d semiMajorAxis = _mm256_div_pd(one, a);
+            __m256d direction = _mm256_blendv_pd(one, _mm256_set1_pd(-1.0), _mm256_cmp_pd(t, zero, _CMP_LT_OQ));
+            __m256d denominator = _mm256_add_pd(_mm256_mul_pd(sg, rm),
+                                                _mm256_mul_pd(_mm256_mul_pd(direction, _mm256_sqrt_pd(_mm256_mul_pd(_mm256_xor_pd(mu, signBit), semiMajorAxis))), e));
+            __m256d argument = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(-2.0), mu), a), t), denominator);
+            __m256d hyperbolaGuess = _mm256_mul_pd(_mm256_mul_pd(direction, _mm256_sqrt_pd(_mm256_xor_pd(semiMajorAxis, signBit))), logAVX2(argument));
+            __m256d parabolaGuess = _mm256_div_pd(_mm256_mul_pd(rm, t), r);
+
+            __m256d isEllipse = _mm256_cmp_pd(a, _mm256_set1_pd(KEPLER_PARABOLIC_LIMIT), _CMP_GT_OQ);
+            __m256d isHyperbola = _mm256_and_pd(_mm256_cmp_pd(a, _mm256_set1_pd(-KEPLER_PARABOLIC_LIMIT), _CMP_LT_OQ),
+                                                _mm256_cmp_pd(argument, zero, _CMP_GT_OQ));
+            _mm256_store_pd(radius + k, r);
+            _mm256_store_pd(rootMu + k, rm);
+            _mm256_store_pd(sigma + k, sg);
+            _mm256_store_pd(alpha + k, a);
+            _mm256_store_pd(eccentric + k, e);
+            _mm256_store_pd(time + k, _mm256_blendv_pd(t, wound, isEllipse));
+            _mm256_store_pd(chi + k, _mm256_blendv_pd(_mm256_blendv_pd(parabolaGuess, hyperbolaGuess, isHyperbola), ellipseGuess, isEllipse));
+        }
+
+        for (int iteration = 0; iteration < KEPLER_MAX_ITERATIONS; iteration++) {
+            __m256d largestError = zero;
+            for (std::size_t k = 0; k < blockCount; k += 4) {
+                __m256d ch = _mm256_load_pd(chi + k);
+                __m256d r = _mm256_load_pd(radius + k), rm = _mm256_load_pd(rootMu + k), sg = _mm256_load_pd(sigma + k);
+                __m256d a = _mm256_load_pd(alpha + k), e = _mm256_load_pd(eccentric + k), t = _mm256_load_pd(time + k);
+                __m256d chiSquared = _mm256_mul_pd(ch, ch);
+                __m256d zeta = _mm256_mul_pd(a, chiSquared);
+                __m256d c, s;
+                stumpffAVX2(zeta, c, s);
+                __m256d oneMinusZetaS = _mm256_sub_pd(one, _mm256_mul_pd(zeta, s));
+                __m256d value = _mm256_sub_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(sg, chiSquared), c),
+                                                                          _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(e, chiSquared), ch), s)),
+                                                            _mm256_mul_pd(r, ch)), _mm256_mul_pd(rm, t));
+                __m256d slope = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(sg, ch), oneMinusZetaS), _mm256_mul_pd(_mm256_mul_pd(e, chiSquared), c)), r);
+                __m256d curvature = _mm256_add_pd(_mm256_mul_pd(sg, _mm256_sub_pd(one, _mm256_mul_pd(zeta, c))), _mm256_mul_pd(_mm256_mul_pd(e, ch), oneMinusZetaS));
+                __m256d root = _mm256_sqrt_pd(_mm256_andnot_pd(signBit, _mm256_sub_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(16.0), slope), slope),
+                                                                                      _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(20.0), value), curvature))));
+                root = _mm256_xor_pd(root, _mm256_and_pd(_mm256_cmp_pd(slope, zero, _CMP_LT_OQ), signBit));
+                __m256d step = _mm256_div_pd(_mm256_mul_pd(_mm256_set1_pd(5.0), value), _mm256_add_pd(slope, root));
+                ch = _mm256_sub_pd(ch, step);
+                _mm256_store_pd(chi + k, ch);
+                __m256d error = _mm256_div_pd(_mm256_andnot_pd(signBit, step), _mm256_max_pd(_mm256_andnot_pd(signBit, ch), one));
+                largestError = _mm256_max_pd(error, largestError);
+            }
+            __m128d half = _mm_max_pd(_mm256_castpd256_pd128(largestError), _mm256_extractf128_pd(largestError, 1));
+            if (_mm_cvtsd_f64(_mm_max_sd(half, _mm_unpackhi_pd(half, half))) < KEPLER_TOLERANCE) {
+                break;
+            }
+        }
+
+        for (std::size_t k = 0; k < blockCount; k += 4) {
+            std::size_t i = start + k;
+            __m256d px = _mm256_loadu_pd(x + i), py = _mm256_loadu_pd(y + i), pz = _mm256_loadu_pd(z + i);
+            __m256d pvx = _mm256_loadu_pd(vx + i), pvy = _mm256_loadu_pd(vy + i), pvz = _mm256_loadu_pd(vz + i);
+            __m256d ch = _mm256_load_pd(chi + k), r = _mm256_load_pd(radius + k), rm = _mm256_load_pd(rootMu + k);
+            __m256d chiSquared = _mm256_mul_pd(ch, ch);
+            __m256d zeta = _mm256_mul_pd(_mm256_load_pd(alpha + k), chiSquared);
+            __m256d c, s;
+            stumpffAVX2(zeta, c, s);
+            __m256d f = _mm256_sub_pd(one, _mm256_div_pd(_mm256_mul_pd(chiSquared, c), r));
+            __m256d g = _mm256_sub_pd(_mm256_load_pd(time + k), _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(chiSquared, ch), s), rm));
+            __m256d newX = _mm256_add_pd(_mm256_mul_pd(f, px), _mm256_mul_pd(g, pvx));
+            __m256d newY = _mm256_add_pd(_mm256_mul_pd(f, py), _mm256_mul_pd(g, pvy));
+            __m256d newZ = _mm256_add_pd(_mm256_mul_pd(f, pz), _mm256_mul_pd(g, pvz));
+            __m256d newRadius = _mm256_sqrt_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(newX, newX), _mm256_mul_pd(newY, newY)), _mm256_mul_pd(newZ, newZ)));
+            __m256d fDot = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(rm, ch), _mm256_sub_pd(_mm256_mul_pd(zeta, s), one)), _mm256_mul_pd(newRadius, r));
+            __m256d gDot = _mm256_sub_pd(one, _mm256_div_pd(_mm256_mul_pd(chiSquared, c), newRadius));
+            _mm256_storeu_pd(outX + i, newX);
+            _mm256_storeu_pd(outY + i, newY);
+            _mm256_storeu_pd(outZ + i, newZ);
+            _mm256_storeu_pd(outVx + i, _mm256_add_pd(_mm256_mul_pd(fDot, px), _mm256_mul_pd(gDot, pvx)));
+            _mm256_storeu_pd(outVy + i, _mm256_add_pd(_mm256_mul_pd(fDot, py), _mm256_mul_pd(gDot, pvy)));
+            _mm256_storeu_pd(outVz + i, _mm256_add_pd(_mm256_mul_pd(fDot, pz), _mm256_mul_pd(gDot, pvz)));
+        }
+    }
+}
+
+// AVX-512F has no floating point xor, so signs are flipped on the integer side
+__attribute__((target("avx512f")))
+static inline __m512d flipSignAVX512(__m512d value, __mmask8 mask) {
+    __m512i bits = _mm512_castpd_si512(value);
+    return _mm512_castsi512_pd(_mm512_mask_xor_epi64(bits, mask, bits, _mm512_set1_epi64((long long)0x8000000000000000ull)));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d logAVX512(__m512d value) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512i bits = _mm512_castpd_si512(value);
+    __m512d exponent = _mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, 52), _mm512_set1_epi64((long long)EXPONENT_AS_MANTISSA)));
+    __m512d mantissa = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64((long long)MANTISSA_BITS)),
+                                                           _mm512_set1_epi64((long long)ONE_BITS)));
+    exponent = _mm512_sub_pd(exponent, _mm512_set1_pd(EXPONENT_OFFSET));
+
+    __mmask8 isLarge = _mm512_cmp_pd_mask(mantissa, _mm512_set1_pd(M_SQRT2), _CMP_GT_OQ);
+    mantissa = _mm512_mask_mul_pd(mantissa, isLarge, mantissa, _mm512_set1_pd(0.5));
+    exponent = _mm512_mask_add_pd(exponent, isLarge, exponent, one);
+    __m512d s = _mm512_div_pd(_mm512_sub_pd(mantissa, one), _mm512_add_pd(mantissa, one));
+    __m512d sSquared = _mm512_mul_pd(s, s);
+    __m512d series = _mm512_set1_pd(LOG_SERIES[LOG_TERMS - 1]);
+    for (int k = LOG_TERMS - 2; k >= 0; k--) {
+        series = _mm512_add_pd(_mm512_mul_pd(series, sSquared), _mm512_set1_pd(LOG_SERIES[k]));
+    }
+    __m512d half = _mm512_mul_pd(s, series);
+    return _mm512_add_pd(_mm512_mul_pd(exponent, _mm512_set1_pd(M_LN2)), _mm512_add_pd(half, half));
+}
+
+__attribute__((target("avx512f")))
+static inline void stumpffAVX512(__m512d z, __m512d& c, __m512d& s) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d quarter = _mm512_set1_pd(0.25);
+    const __m512d limit = _mm512_set1_pd(STUMPFF_SERIES_LIMIT);
+
+    // Only stops early once no lane needs quartering any more
+    __m512d reduced = z;
+    __m512d quarterings = _mm512_setzero_pd();
+    int rounds = 0;
+    for (; rounds < STUMPFF_MAX_QUARTERINGS; rounds++) {
+        __mmask8 isLarge = _mm512_cmp_pd_mask(_mm512_abs_pd(reduced), limit, _CMP_GE_OQ);
+        if (isLarge == 0) {
+            break;
+        }
+        reduced = _mm512_mask_mul_pd(reduced, isLarge, reduced, quarter);
+        quarterings = _mm512_mask_add_pd(quarterings, isLarge, quarterings, one);
+    }
+
+    c = _mm512_set1_pd(STUMPFF_C[STUMPFF_TERMS - 1]);
+    s = _mm512_set1_pd(STUMPFF_S[STUMPFF_TERMS - 1]);
+    for (int k = STUMPFF_TERMS - 2; k >= 0; k--) {
+        c = _mm512_add_pd(_mm512_mul_pd(c, reduced), _mm512_set1_pd(STUMPFF_C[k]));
+        s = _mm512_add_pd(_mm512_mul_pd(s, reduced), _mm512_set1_pd(STUMPFF_S[k]));
+    }
+    __m512d c0 = _mm512_sub_pd(one, _mm512_mul_pd(reduced, c));
+    __m512d c1 = _mm512_sub_pd(one, _mm512_mul_pd(reduced, s));
+
+    for (int round = 0; round < rounds; round++) {
+        __mmask8 isDoubling = _mm512_cmp_pd_mask(quarterings, _mm512_set1_pd((double)round), _CMP_GT_OQ);
+        __m512d doubledS = _mm512_mul_pd(_mm512_add_pd(c, _mm512_mul_pd(c0, s)), quarter);
+        __m512d doubledC = _mm512_mul_pd(_mm512_mul_pd(c1, c1), _mm512_set1_pd(0.5));
+        __m512d doubledC1 = _mm512_mul_pd(c0, c1);
+        __m512d doubledC0 = _mm512_sub_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(2.0), c0), c0), one);
+        s = _mm512_mask_blend_pd(isDoubling, s, doubledS);
+        c = _mm512_mask_blend_pd(isDoubling, c, doubledC);
+        c1 = _mm512_mask_blend_pd(isDoubling, c1, doubledC1);
+        c0 = _mm512_mask_blend_pd(isDoubling, c0, doubledC0);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void keplerKernelAVX512(const double* x, const double* y, const double* z, const double* vx, const double* vy, const double* vz,
+                               const double* gravitationalParameter, const double* deltaTime, std::size_t count,
+                               double* outX, double* outY, double* outZ, double* outVx, double* outVy, double* outVz) {
+    alignas(64) double radius[KEPLER_BLOCK_SIZE], sigma[KEPLER_BLOCK_SIZE], alpha[KEPLER_BLOCK_SIZE], eccentric[KEPLER_BLOCK_SIZE];
+    alignas(64) double rootMu[KEPLER_BLOCK_SIZE], time[KEPLER_BLOCK_SIZE], chi[KEPLER_BLOCK_SIZE];
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d one = _mm512_set1_pd(1.0);
+
+    for (std::size_t start = 0; start < count; start += KEPLER_BLOCK_SIZE) {
+        std::size_t blockCount = std::min(KEPLER_BLOCK_SIZE, count - start);
+
+        for (std::size_t k = 0; k < blockCount; k += 8) {
+            std::size_t i = start + k;
+            __m512d px = _mm512_loadu_pd(x + i), py = _mm512_loadu_pd(y + i), pz = _mm512_loadu_pd(z + i);
+            __m512d pvx = _mm512_loadu_pd(vx + i), pvy = _mm512_loadu_pd(vy + i), pvz = _mm512_loadu_pd(vz + i);
+            __m512d mu = _mm512_loadu_pd(gravitationalParameter + i);
+            __m512d r = _mm512_sqrt_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(px, px), _mm512_mul_pd(py, py)), _mm512_mul_pd(pz, pz)));
+            __m512d rm = _mm512_sqrt_pd(mu);
+            __m512d sg = _mm512_div_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(px, pvx), _mm512_mul_pd(py, pvy)), _mm512_mul_pd(pz, pvz)), rm);
+            __m512d speedSquared = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(pvx, pvx), _mm512_mul_pd(pvy, pvy)), _mm512_mul_pd(pvz, pvz));
+            __m512d a = _mm512_sub_pd(_mm512_div_pd(_mm512_set1_pd(2.0), r), _mm512_div_pd(speedSquared, mu));
+            __m512d e = _mm512_sub_pd(one, _mm512_mul_pd(a, r));
+
+            __m512d t = _mm512_loadu_pd(deltaTime + i);
+            __m512d period = _mm512_div_pd(_mm512_set1_pd(TWO_PI), _mm512_mul_pd(_mm512_mul_pd(rm, a), _mm512_sqrt_pd(a)));
+            __m512d turns = _mm512_roundscale_pd(_mm512_div_pd(t, period), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            __m512d wound = _mm512_sub_pd(t, _mm512_mul_pd(turns, period));
+            __m512d ellipseGuess = _mm512_mul_pd(_mm512_mul_pd(rm, a), wound);
+
+            __m512d semiMajorAxis = _mm512_div_pd(one, a);
+            __mmask8 isBackwards = _mm512_cmp_pd_mask(t, zero, _CMP_LT_OQ);
+            __m512d direction = _mm512_mask_blend_pd(isBackwards, one, _mm512_set1_pd(-1.0));
+            __m512d denominator = _mm512_add_pd(_mm512_mul_pd(sg, rm),
+                                                _mm512_mul_pd(_mm512_mul_pd(direction, _mm512_sqrt_pd(_mm512_mul_pd(flipSignAVX512(mu, 0xFF), semiMajorAxis))), e));
+            __m512d argument = _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(-2.0), mu), a), t), denominator);
+            __m512d hyperbolaGuess = _mm512_mul_pd(_mm512_mul_pd(direction, _mm512_sqrt_pd(flipSignAVX512(semiMajorAxis, 0xFF))), logAVX512(argument));
+            __m512d parabolaGuess = _mm512_div_pd(_mm512_mul_pd(rm, t), r);
+
+            __mmask8 isEllipse = _mm512_cmp_pd_mask(a, _mm512_set1_pd(KEPLER_PARABOLIC_LIMIT), _CMP_GT_OQ);
+            __mmask8 isHyperbola = _mm512_cmp_pd_mask(a, _mm512_set1_pd(-KEPLER_PARABOLIC_LIMIT), _CMP_LT_OQ) &
+                                   _mm512_cmp_pd_mask(argument, zero, _CMP_GT_OQ);
+            _mm512_store_pd(radius + k, r);
+            _mm512_store_pd(rootMu + k, rm);
+            _mm512_store_pd(sigma + k, sg);
+            _mm512_store_pd(alpha + k, a);
+            _mm512_store_pd(eccentric + k, e);
+            _mm512_store_pd(time + k, _mm512_mask_blend_pd(isEllipse, t, wound));
+            _mm512_store_pd(chi + k, _mm512_mask_blend_pd(isEllipse, _mm512_mask_blend_pd(isHyperbola, parabolaGuess, hyperbolaGuess), ellipseGuess));
+        }
+
+        for (int iteration = 0; iteration < KEPLER_MAX_ITERATIONS; iteration++) {
+            __m512d largestError = zero;
+            for (std::size_t k = 0; k < blockCount; k += 8) {
+                __m512d ch = _mm512_load_pd(chi + k);
+                __m512d r = _mm512_load_pd(radius + k), rm = _mm512_load_pd(rootMu + k), sg = _mm512_load_pd(sigma + k);
+                __m512d a = _mm512_load_pd(alpha + k), e = _mm512_load_pd(eccentric + k), t = _mm512_load_pd(time + k);
+                __m512d chiSquared = _mm512_mul_pd(ch, ch);
+                __m512d zeta = _mm512_mul_pd(a, chiSquared);
+                __m512d c, s;
+                stumpffAVX512(zeta, c, s);
+                __m512d oneMinusZetaS = _mm512_sub_pd(one, _mm512_mul_pd(zeta, s));
+                __m512d value = _mm512_sub_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(sg, chiSquared), c),
+                                                                          _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(e, chiSquared), ch), s)),
+                                                            _mm512_mul_pd(r, ch)), _mm512_mul_pd(rm, t));
+                __m512d slope = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(sg, ch), oneMinusZetaS), _mm512_mul_pd(_mm512_mul_pd(e, chiSquared), c)), r);
+                __m512d curvature = _mm512_add_pd(_mm512_mul_pd(sg, _mm512_sub_pd(one, _mm512_mul_pd(zeta, c))), _mm512_mul_pd(_mm512_mul_pd(e, ch), oneMinusZetaS));
+                __m512d root = _mm512_sqrt_pd(_mm512_abs_pd(_mm512_sub_pd(_mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(16.0), slope), slope),
+                                                                          _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(20.0), value), curvature))));
+                root = flipSignAVX512(root, _mm512_cmp_pd_mask(slope, zero, _CMP_LT_OQ));
+                __m512d step = _mm512_div_pd(_mm512_mul_pd(_mm512_set1_pd(5.0), value), _mm512_add_pd(slope, root));
+                ch = _mm512_sub_pd(ch, step);
+                _mm512_store_pd(chi + k, ch);
+                __m512d error = _mm512_div_pd(_mm512_abs_pd(step), _mm512_max_pd(_mm512_abs_pd(ch), one));
+                largestError = _mm512_max_pd(error, largestError);
+            }
+            if (_mm512_reduce_max_pd(largestError) < KEPLER_TOLERANCE) {
+                break;
+            }
+        }
+
+        for (std::size_t k = 0; k < blockCount; k += 8) {
+            std::size_t i = start + k;
+            __m512d px = _mm512_loadu_pd(x + i), py = _mm512_loadu_pd(y + i), pz = _mm512_loadu_pd(z + i);
+            __m512d pvx = _mm512_loadu_pd(vx + i), pvy = _mm512_loadu_pd(vy + i), pvz = _mm512_loadu_pd(vz + i);
+            __m512d ch = _mm512_load_pd(chi + k), r = _mm512_load_pd(radius + k), rm = _mm512_load_pd(rootMu + k);
+            __m512d chiSquared = _mm512_mul_pd(ch, ch);
+            __m512d zeta = _mm512_mul_pd(_mm512_load_pd(alpha + k), chiSquared);
+            __m512d c, s;
+            stumpffAVX512(zeta, c, s);
+            __m512d f = _mm512_sub_pd(one, _mm512_div_pd(_mm512_mul_pd(chiSquared, c), r));
+            __m512d g = _mm512_sub_pd(_mm512_load_pd(time + k), _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(chiSquared, ch), s), rm));
+            __m512d newX = _mm512_add_pd(_mm512_mul_pd(f, px), _mm512_mul_pd(g, pvx));
+            __m512d newY = _mm512_add_pd(_mm512_mul_pd(f, py), _mm512_mul_pd(g, pvy));
+            __m512d newZ = _mm512_add_pd(_mm512_mul_pd(f, pz), _mm512_mul_pd(g, pvz));
+            __m512d newRadius = _mm512_sqrt_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(newX, newX), _mm512_mul_pd(newY, newY)), _mm512_mul_pd(newZ, newZ)));
+            __m512d fDot = _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(rm, ch), _mm512_sub_pd(_mm512_mul_pd(zeta, s), one)), _mm512_mul_pd(newRadius, r));
+            __m512d gDot = _mm512_sub_pd(one, _mm512_div_pd(_mm512_mul_pd(chiSquared, c), newRadius));
+            _mm512_storeu_pd(outX + i, newX);
+            _mm512_storeu_pd(outY + i, newY);
+            _mm512_storeu_pd(outZ + i, newZ);
+            _mm512_storeu_pd(outVx + i, _mm512_add_pd(_mm512_mul_pd(fDot, px), _mm512_mul_pd(gDot, pvx)));
+            _mm512_storeu_pd(outVy + i, _mm512_add_pd(_mm512_mul_pd(fDot, py), _mm512_mul_pd(gDot, pvy)));
+            _mm512_storeu_pd(outVz + i, _mm512_add_pd(_mm512_mul_pd(fDot, pz), _mm512_mul_pd(gDot, pvz)));
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief Gets the Kepler kernel for a SIMD level.
+ *
+ * Levels that weren't compiled in on this platform fall back to the scalar kernel.
+ *
+ * @param level the SIMD level to get the kernel for.
+ * @return the kernel.
+ */
+KeplerKernel GetKeplerKernel(SimdLevel level) {
+#ifdef KEPLER_KERNELS_X86
+    switch (level) {
+        case AVX512: return keplerKernelAVX512;
+        case AVX2:   return keplerKernelAVX2;
+        case SSE2:   return keplerKernelSSE2;
+        default:     break;
+    }
+#endif
+    return keplerKernelScalar;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Physics/Gravity/GravityKernels.hpp>
+
+/**
+ * @brief Moves a batch of bodies along their Kepler orbits.
+ *
+ * Every kernel does the same arithmetic in the same order, with no fused multiply-adds, so all SIMD
+ * levels return bit-identical results, as the gravity kernels do. The count must be a multiple of 8;
+ * pad with bodies on any orbit and no time to move them, such as a circular orbit of unit radius with
+ * a unit gravitational parameter.
+ *
+ * @param x, y, z, vx, vy, vz the state of each body relative to its parent at its epoch.
+ * @param gravitationalParameter G times the combined mass of each body and its parent.
+ * @param deltaTime the time since each body's epoch.
+ * @param count the number of bodies, a multiple of 8.
+ * @param outX, outY, outZ, outVx, outVy, outVz receive the state of each body relative to its parent.
+ */
+typedef void (*KeplerKernel)(const double* x, const double* y, const double* z, const double* vx, const double* vy, const double* vz,
+                             const double* gravitationalParameter, const double* deltaTime, std::size_t count,
+                             double* outX, double* outY, double* outZ, double* outVx, double* outVy, double* outVz);
+
+KeplerKernel GetKeplerKernel(SimdLevel level);
@@ -0,0 +1,346 @@
+#include <Physics/Rails/KeplerRails.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Bodies are gathered into contiguous arrays in blocks of this many, a multiple of the kernels' 8 lanes
+static const size_t KEPLER_BLOCK_SIZE = 64;
+// Smallest number of bodies worth handing to another thread
+static const size_t KEPLER_GRAIN_SIZE = 1024;
+
+KeplerRails::KeplerRails() {
+    SetSimdLevel(DetectSimdLevel());
+}
+
+/**
+ * @brief Selects the SIMD kernel used to move bodies along their orbits.
+ *
+ * Every level produces identical results, so this only affects speed.
+ *
+ * @param level the SIMD level to use.
+ */
+void KeplerRails::SetSimdLevel(SimdLevel level) {
+    simdLevel = level;
+    kernel = GetKeplerKernel(level);
+}
+
+void KeplerRails::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (jobSystem == nullptr) {
+        body(0, count);
+    }
+    else {
+        jobSystem->ParallelFor(0, count, grainSize, body);
+    }
+}
+
+void KeplerRails::resize(size_t count) {
+    if (motions.size() >= count) {
+        return;
+    }
+    motions.resize(count, N_BODY);
+    parents.resize(count, -1);
+    epochX.resize(count, 0.0);
+    epochY.resize(count, 0.0);
+    epochZ.resize(count, 0.0);
+    epochVx.resize(count, 0.0);
+    epochVy.resize(count, 0.0);
+    epochVz.resize(count, 0.0);
+    epochTime.resize(count, 0.0);
+    gravitationalParameter.resize(count, 0.0);
+}
+
+/**
+ * @brief Sets how a body moves. Takes effect at the next Initialise or sphere of influence check.
+ *
+ * @param index the body.
+ * @param motion how it should move.
+ */
+void KeplerRails::SetMotion(unsigned int index, MotionType motion) {
+    resize(index + 1);
+    motions[index] = motion;
+}
+
+/**
+ * @brief Puts a body on rails around a parent, starting from its current state.
+ *
+ * Bodies whose orbit has no mass behind it can't be put on rails, and are left as they are.
+ */
+void KeplerRails::anchor(const BodyStore& bodies, unsigned int index, int parent, double time, double gravitationalConstant) {
+    double mu = gravitationalConstant*(bodies.mass[parent] + bodies.mass[index]);
+    glm::dvec3 offset = bodies.Position(index) - bodies.Position(parent);
+    if (!(mu > 0.0) || glm::length(offset) == 0.0) {
+        parents[index] = -1;
+        return;
+    }
+    glm::dvec3 velocity = bodies.Velocity(index) - bodies.Velocity(parent);
+    parents[index] = parent;
+    epochX[index] = offset.x;
+    epochY[index] = offset.y;
+    epochZ[index] = offset.z;
+    epochVx[index] = velocity.x;
+    epochVy[index] = velocity.y;
+    epochVz[index] = velocity.z;
+    epochTime[index] = time;
+    gravitationalParameter[index] = mu;
+}
+
+/**
+ * @brief Sorts the bodies on rails so every parent is solved before its children.
+ *
+ * Parents are always heavier than their children, so there are no cycles.
+ */
+void KeplerRails::rebuildOrder() {
+    std::vector<int> depths(parents.size(), -1);
+    std::function<int(unsigned int)> depth = [&](unsigned int i) -> int {
+        if (parents[i] < 0) {
+            return 0;
+        }
+        if (depths[i] < 0) {
+            depths[i] = depth((unsigned int)parents[i]) + 1;
+        }
+        return depths[i];
+    };
+
+    railsOrder.clear();
+    freeBodies.clear();
+    for (unsigned int i = 0; i < parents.size(); i++) {
+        if (parents[i] >= 0) {
+            railsOrder.push_back(i);
+            depth(i);
+        }
+        else {
+            freeBodies.push_back(i);
+        }
+    }
+    std::stable_sort(railsOrder.begin(), railsOrder.end(), [&](unsigned int first, unsigned int second) {
+        return depths[first] < depths[second];
+    });
+
+    levelStarts.clear();
+    for (size_t r = 0; r < railsOrder.size(); r++) {
+        if (r == 0 || depths[railsOrder[r]] != depths[railsOrder[r - 1]]) {
+            levelStarts.push_back(r);
+        }
+    }
+    levelStarts.push_back(railsOrder.size());
+}
+
+/**
+ * @brief Finds every body's dominant body, and whether it is too near any sphere of influence's edge
+ * to stay on rails.
+ */
+void KeplerRails::findDominantBodies(const BodyStore& bodies, std::vector<bool>& isNearBoundary) {
+    size_t count = bodies.Size();
+    unsigned int heaviest = 0;
+    for (unsigned int i = 1; i < count; i++) {
+        if (bodies.mass[i] > bodies.mass[heaviest]) {
+            heaviest = i;
+        }
+    }
+
+    std::vector<unsigned int> attractors;
+    std::vector<double> influenceRadii;
+    for (unsigned int i = 0; i < count; i++) {
+        if (i != heaviest && bodies.mass[i] >= attractorMassRatio*bodies.mass[heaviest]) {
+            attractors.push_back(i);
+            double distance = glm::length(bodies.Position(i) - bodies.Position(heaviest));
+            influenceRadii.push_back(distance*std::pow(bodies.mass[i]/bodies.mass[heaviest], 0.4));
+        }
+    }
+
+    dominantBodies.assign(count, (int)heaviest);
+    std::vector<char> isNear(count, 0);
+    parallelFor(count, KEPLER_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (i == heaviest) {
+                dominantBodies[i] = -1;
+                isNear[i] = 1;
+                continue;
+            }
+            glm::dvec3 position = bodies.Position(i);
+            double smallestRadius = std::numeric_limits<double>::infinity();
+            for (size_t a = 0; a < attractors.size(); a++) {
+                unsigned int j = attractors[a];
+                if (j != i && bodies.mass[j] > bodies.mass[i] && influenceRadii[a] < smallestRadius &&
+                    glm::length(position - bodies.Position(j)) < influenceRadii[a]) {
+                    dominantBodies[i] = (int)j;
+                    smallestRadius = influenceRadii[a];
+                }
+            }
+
+            for (size_t a = 0; a < attractors.size(); a++) {
+                unsigned int j = attractors[a];
+                if ((int)j == dominantBodies[i] || j == i || bodies.mass[j] <= bodies.mass[i]) {
+                    continue;
+                }
+                if (glm::length(position - bodies.Position(j)) < influenceMargin*influenceRadii[a]) {
+                    isNear[i] = 1;
+                }
+            }
+            if (dominantBodies[i] != (int)heaviest && glm::length(position - bodies.Position(dominantBodies[i]))*influenceMargin > smallestRadius) {
+                isNear[i] = 1;
+            }
+        }
+    });
+    isNearBoundary.assign(isNear.begin(), isNear.end());
+}
+
+/**
+ * @brief Puts the bodies that should be on rails onto them, around their dominant bodies.
+ *
+ * Call once the bodies are set up, and again whenever they are replaced.
+ *
+ * @param bodies the bodies.
+ * @param time the current simulation time.
+ * @param gravitationalConstant the gravitational constant used by the simulation.
+ */
+void KeplerRails::Initialise(const BodyStore& bodies, double time, double gravitationalConstant) {
+    resize(bodies.Size());
+    std::fill(parents.begin(), parents.end(), -1);
+    stepsSinceCheck = 0;
+
+    std::vector<bool> isNearBoundary;
+    findDominantBodies(bodies, isNearBoundary);
+    for (unsigned int i = 0; i < bodies.Size(); i++) {
+        bool wantsRails = motions[i] == ON_RAILS || (motions[i] == AUTOMATIC_RAILS && !isNearBoundary[i]);
+        if (wantsRails && dominantBodies[i] >= 0) {
+            anchor(bodies, i, dominantBodies[i], time, gravitationalConstant);
+        }
+    }
+    rebuildOrder();
+}
+
+/**
+ * @brief Moves every body on rails to where its orbit puts it at the given time.
+ *
+ * Parents are moved before their children, and each level of the hierarchy is solved in parallel.
+ * Each body is also given its Kepler acceleration on top of its parent's.
+ *
+ * @param bodies the bodies.
+ * @param time the simulation time to move them to.
+ */
+void KeplerRails::Evaluate(BodyStore& bodies, double time) {
+    for (size_t level = 0; level + 1 < levelStarts.size(); level++) {
+        size_t levelStart = levelStarts[level];
+        parallelFor(levelStarts[level + 1] - levelStart, KEPLER_GRAIN_SIZE, [&](size_t begin, size_t end) {
+            alignas(64) double x[KEPLER_BLOCK_SIZE], y[KEPLER_BLOCK_SIZE], z[KEPLER_BLOCK_SIZE];
+            alignas(64) double vx[KEPLER_BLOCK_SIZE], vy[KEPLER_BLOCK_SIZE], vz[KEPLER_BLOCK_SIZE];
+            alignas(64) double mu[KEPLER_BLOCK_SIZE], deltaTime[KEPLER_BLOCK_SIZE];
+            alignas(64) double outX[KEPLER_BLOCK_SIZE], outY[KEPLER_BLOCK_SIZE], outZ[KEPLER_BLOCK_SIZE];
+            alignas(64) double outVx[KEPLER_BLOCK_SIZE], outVy[KEPLER_BLOCK_SIZE], outVz[KEPLER_BLOCK_SIZE];
+
+            for (size_t blockStart = begin; blockStart < end; blockStart += KEPLER_BLOCK_SIZE) {
+                size_t blockCount = std::min(KEPLER_BLOCK_SIZE, end - blockStart);
+                const unsigned int* block = railsOrder.data() + levelStart + blockStart;
+                for (size_t k = 0; k < blockCount; k++) {
+                    unsigned int i = block[k];
+                    x[k] = epochX[i];
+                    y[k] = epochY[i];
+                    z[k] = epochZ[i];
+                    vx[k] = epochVx[i];
+                    vy[k] = epochVy[i];
+                    vz[k] = epochVz[i];
+                    mu[k] = gravitationalParameter[i];
+                    deltaTime[k] = time - epochTime[i];
+                }
+                // The kernels work on whole lanes, so the last block is padded with circular orbits that don't move
+                size_t paddedCount = (blockCount + 7)/8*8;
+                for (size_t k = blockCount; k < paddedCount; k++) {
+                    x[k] = 1.0;
+                    y[k] = z[k] = 0.0;
+                    vx[k] = vz[k] = 0.0;
+                    vy[k] = 1.0;
+                    mu[k] = 1.0;
+                    deltaTime[k] = 0.0;
+                }
+
+                kernel(x, y, z, vx, vy, vz, mu, deltaTime, paddedCount, outX, outY, outZ, outVx, outVy, outVz);
+
+                for (size_t k = 0; k < blockCount; k++) {
+                    unsigned int i = block[k];
+                    unsigned int parent = (unsigned int)parents[i];
+                    double radius = std::sqrt(outX[k]*outX[k] + outY[k]*outY[k] + outZ[k]*outZ[k]);
+                    double pull = -mu[k]/(radius*radius*radius);
+                    bodies.x[i] = bodies.x[parent] + outX[k];
+                    bodies.y[i] = bodies.y[parent] + outY[k];
+                    bodies.z[i] = bodies.z[parent] + outZ[k];
+                    bodies.vx[i] = bodies.vx[parent] + outVx[k];
+                    bodies.vy[i] = bodies.vy[parent] + outVy[k];
+                    bodies.vz[i] = bodies.vz[parent] + outVz[k];
+                    bodies.ax[i] = bodies.ax[parent] + pull*outX[k];
+                    bodies.ay[i] = bodies.ay[parent] + pull*outY[k];
+                    bodies.az[i] = bodies.az[parent] + pull*outZ[k];
+                }
+            }
+        });
+    }
+}
+
+/**
+ * @brief Moves the bodies on rails to the end of a step, and every checkInterval steps switches bodies
+ * between rails and n-body as they move between spheres of influence.
+ *
+ * @param bodies the bodies, at the end of the step.
+ * @param time the simulation time at the end of the step.
+ * @param gravitationalConstant the gravitational constant used by the simulation.
+ * @return the bodies that have just left rails, whose accelerations must be computed before the next step.
+ */
+const std::vector<unsigned int>& KeplerRails::Update(BodyStore& bodies, double time, double gravitationalConstant) {
+    freedBodies.clear();
+    resize(bodies.Size());
+    Evaluate(bodies, time);
+    if (++stepsSinceCheck < checkInterval) {
+        return freedBodies;
+    }
+    stepsSinceCheck = 0;
+    if (std::all_of(motions.begin(), motions.end(), [](MotionType motion) { return motion == N_BODY; }) && railsOrder.empty()) {
+        return freedBodies;
+    }
+
+    std::vector<bool> isNearBoundary;
+    findDominantBodies(bodies, isNearBoundary);
+    bool hasChanged = false;
+    for (unsigned int i = 0; i < bodies.Size(); i++) {
+        bool wantsRails = (motions[i] == ON_RAILS && (IsOnRails(i) || dominantBodies[i] >= 0)) ||
+                          (motions[i] == AUTOMATIC_RAILS && !isNearBoundary[i] && dominantBodies[i] >= 0);
+        if (IsOnRails(i) && (!wantsRails || (motions[i] == AUTOMATIC_RAILS && parents[i] != dominantBodies[i]))) {
+            parents[i] = -1;
+            freedBodies.push_back(i);
+            hasChanged = true;
+        }
+        else if (!IsOnRails(i) && wantsRails) {
+            anchor(bodies, i, dominantBodies[i], time, gravitationalConstant);
+            hasChanged = hasChanged || IsOnRails(i);
+        }
+    }
+    if (hasChanged) {
+        rebuildOrder();
+        // Sets the accelerations of the bodies that have just gone on rails
+        Evaluate(bodies, time);
+    }
+    return freedBodies;
+}
+
+/**
+ * @brief Restarts every orbit from its body's current state.
+ *
+ * Needed after anything other than the rails moves a body on rails, such as a collision. Bodies
+ * whose orbit has lost all its mass leave rails.
+ *
+ * @param bodies the bodies.
+ * @param time the current simulation time.
+ * @param gravitationalConstant the gravitational constant used by the simulation.
+ * @return the bodies that have left rails.
+ */
+const std::vector<unsigned int>& KeplerRails::Anchor(const BodyStore& bodies, double time, double gravitationalConstant) {
+    freedBodies.clear();
+    for (unsigned int i : railsOrder) {
+        anchor(bodies, i, parents[i], time, gravitationalConstant);
+        if (!IsOnRails(i)) {
+            freedBodies.push_back(i);
+        }
+    }
+    rebuildOrder();
+    return freedBodies;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Rails/KeplerKernels.hpp>
+
+enum MotionType {
+    // Always integrated with full n-body forces
+    N_BODY,
+    // Always on a Kepler orbit around the body that was dominant when it was put on rails
+    ON_RAILS,
+    // On rails around its dominant body, but integrated while near the edge of any sphere of influence
+    AUTOMATIC_RAILS
+};
+
+/**
+ * @brief Moves bodies along analytic Kepler orbits around a parent body instead of integrating them.
+ *
+ * A body on rails keeps its position and velocity relative to its parent at the moment it was put on
+ * rails, and is moved to any later time by solving Kepler's equation in universal variables, which
+ * covers elliptic, parabolic and hyperbolic orbits alike. The orbits are kept as structure-of-arrays
+ * and solved in batches on the job system, by a SIMD kernel picked at runtime like the gravity kernels. Moving every body to an arbitrary time costs O(N), with no
+ * stepping, as long as the bodies' parents are on rails too.
+ *
+ * Bodies on rails still pull on everything else, but have no forces computed for themselves. Between
+ * updates they carry their Kepler acceleration, so integrators move them sensibly within a step; Update
+ * then puts them back on their orbits.
+ *
+ * Spheres of influence are worked out for the attractors, the bodies with at least attractorMassRatio
+ * of the heaviest body's mass, relative to the heaviest body. A body's dominant body is the heavier
+ * attractor whose sphere it is deepest inside, or the heaviest body. Bodies set to AUTOMATIC_RAILS ride
+ * rails around their dominant body, and drop back to n-body whenever they come within influenceMargin
+ * of another attractor's sphere, or of the edge of their dominant body's.
+ */
+class KeplerRails {
+    private:
+        JobSystem* jobSystem = nullptr;
+        SimdLevel simdLevel;
+        KeplerKernel kernel;
+        std::vector<MotionType> motions;
+        // -1 for bodies that aren't on rails
+        std::vector<int> parents;
+        // The orbit of each body on rails, as its state relative to its parent at the epoch
+        AlignedVector<double> epochX, epochY, epochZ;
+        AlignedVector<double> epochVx, epochVy, epochVz;
+        AlignedVector<double> epochTime, gravitationalParameter;
+
+        // Bodies on rails, parents before children, split into levels that can each be solved in parallel
+        std::vector<unsigned int> railsOrder;
+        std::vector<size_t> levelStarts;
+        std::vector<unsigned int> freeBodies;
+        std::vector<unsigned int> freedBodies;
+        std::vector<int> dominantBodies;
+        unsigned int stepsSinceCheck = 0;
+
+        void resize(size_t count);
+        void anchor(const BodyStore& bodies, unsigned int index, int parent, double time, double gravitationalConstant);
+        void rebuildOrder();
+        void findDominantBodies(const BodyStore& bodies, std::vector<bool>& isNearBoundary);
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    public:
+        // Bodies lighter than this fraction of the heaviest body's mass have no sphere of influence
+        double attractorMassRatio = 1e-5;
+        // How far, as a multiple of the sphere's radius, a body must be from any boundary to stay on rails
+        double influenceMargin = 1.5;
+        // Number of steps between checks of which sphere of influence each body is in
+        unsigned int checkInterval = 16;
+
+        KeplerRails();
+
+        void SetMotion(unsigned int index, MotionType motion);
+        MotionType GetMotion(unsigned int index) const { return index < motions.size() ? motions[index] : N_BODY; }
+        bool IsOnRails(unsigned int index) const { return index < parents.size() && parents[index] >= 0; }
+        int GetParent(unsigned int index) const { return index < parents.size() ? parents[index] : -1; }
+        bool Empty() const { return railsOrder.empty(); }
+
+        void Initialise(const BodyStore& bodies, double time, double gravitationalConstant);
+        const std::vector<unsigned int>& Update(BodyStore& bodies, double time, double gravitationalConstant);
+        void Evaluate(BodyStore& bodies, double time);
+        const std::vector<unsigned int>& Anchor(const BodyStore& bodies, double time, double gravitationalConstant);
+        const std::vector<unsigned int>& FreeBodies() const { return freeBodies; }
+
+        void SetJobSystem(JobSystem* jobSystem) { this->jobSystem = jobSystem; }
+        void SetSimdLevel(SimdLevel level);
+        SimdLevel GetSimdLevel() const { return simdLevel; }
+};
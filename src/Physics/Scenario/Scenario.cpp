@@ -0,0 +1,156 @@
+#include <Physics/Scenario/Scenario.hpp>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Computes the velocity for a circular, prograde orbit around a primary in the XZ plane.
+ *
+ * @param primary the body being orbited.
+ * @param position the position of the orbiting body.
+ * @param gravitationalConstant the gravitational constant used by the simulation.
+ * @return the velocity of the orbiting body.
+ */
+glm::dvec3 CircularOrbitVelocity(const Body& primary, glm::dvec3 position, double gravitationalConstant) {
+    glm::dvec3 offset = position - primary.position;
+    double distance = glm::length(offset);
+    double speed = std::sqrt(gravitationalConstant*primary.mass/distance);
+    glm::dvec3 direction = glm::normalize(glm::cross(glm::dvec3(0.0, 1.0, 0.0), offset));
+    return primary.velocity + speed*direction;
+}
+
+/**
+ * @brief Creates a toy solar system: a star with six planets on circular orbits.
+ *
+ * Units are arbitrary simulation units with G = 1, scaled so the system fits comfortably in view.
+ *
+ * @param bodies the store to add the system to; the star is added first.
+ */
+void CreateSolarSystem(BodyStore& bodies) {
+    std::vector<Body> system;
+    system.push_back(Body(glm::dvec3(0.0), glm::dvec3(0.0), 1000.0, 2.0));
+
+    const double orbitRadii[] = {6.0, 9.0, 13.0, 18.0, 27.0, 34.0};
+    const double masses[]     = {0.05, 0.4, 0.5, 0.1, 1.0, 0.3};
+    const double radii[]      = {0.3, 0.5, 0.55, 0.4, 1.2, 1.0};
+
+    for (int i = 0; i < 6; i++) {
+        // Spread the planets around their orbits rather than lining them up
+        double angle = 2.4*i;
+        glm::dvec3 position(orbitRadii[i]*std::cos(angle), 0.0, orbitRadii[i]*std::sin(angle));
+        system.push_back(Body(position, CircularOrbitVelocity(system[0], position), masses[i], radii[i]));
+    }
+
+    // Give the star the opposite momentum to the planets so the system as a whole doesn't drift away
+    glm::dvec3 momentum(0.0);
+    for (unsigned int i = 1; i < system.size(); i++) {
+        momentum += system[i].mass*system[i].velocity;
+    }
+    system[0].velocity = -momentum/system[0].mass;
+
+    for (const auto& body : system) {
+        bodies.Add(body);
+    }
+}
+
+/**
+ * @brief Adds a belt of small bodies on near-circular orbits around the first body.
+ *
+ * @param bodies the system to add the belt to; the first body is taken as the primary.
+ * @param count the number of asteroids to add.
+ * @param innerRadius the inner edge of the belt.
+ * @param outerRadius the outer edge of the belt.
+ * @param seed the seed for the random number generator, so belts are reproducible.
+ */
+void AddAsteroidBelt(BodyStore& bodies, int count, double innerRadius, double outerRadius, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> radiusDistribution(innerRadius, outerRadius);
+    std::uniform_real_distribution<double> angleDistribution(0.0, 2.0*M_PI);
+    std::normal_distribution<double> heightDistribution(0.0, 0.02*(outerRadius - innerRadius));
+    std::uniform_real_distribution<double> sizeDistribution(0.03, 0.1);
+
+    Body primary = bodies.Get(0);
+    bodies.Reserve(bodies.Size() + count);
+    for (int i = 0; i < count; i++) {
+        double orbitRadius = radiusDistribution(generator);
+        double angle = angleDistribution(generator);
+        glm::dvec3 position = primary.position + glm::dvec3(orbitRadius*std::cos(angle), heightDistribution(generator), orbitRadius*std::sin(angle));
+        double size = sizeDistribution(generator);
+        // Asteroids are tiny compared to the planets; their mass barely perturbs anything
+        bodies.Add(Body(position, CircularOrbitVelocity(primary, position), 1e-6*size*size*size, size));
+    }
+}
+
+/**
+ * @brief Adds a belt of massless test particles on near-circular orbits around a primary.
+ *
+ * The particles are spread like AddAsteroidBelt's asteroids, but only feel the gravity of the bodies,
+ * so belts of millions are affordable.
+ *
+ * @param particles the store to add the belt to.
+ * @param primary the body the belt orbits.
+ * @param count the number of particles to add.
+ * @param innerRadius the inner edge of the belt.
+ * @param outerRadius the outer edge of the belt.
+ * @param seed the seed for the random number generator, so belts are reproducible.
+ */
+void AddParticleBelt(ParticleStore& particles, const Body& primary, int count, double innerRadius, double outerRadius, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> radiusDistribution(innerRadius, outerRadius);
+    std::uniform_real_distribution<double> angleDistribution(0.0, 2.0*M_PI);
+    std::normal_distribution<double> heightDistribution(0.0, 0.02*(outerRadius - innerRadius));
+
+    particles.Reserve(particles.Size() + count);
+    for (int i = 0; i < count; i++) {
+        double orbitRadius = radiusDistribution(generator);
+        double angle = angleDistribution(generator);
+        glm::dvec3 position = primary.position + glm::dvec3(orbitRadius*std::cos(angle), heightDistribution(generator), orbitRadius*std::sin(angle));
+        particles.Add(position, CircularOrbitVelocity(primary, position));
+    }
+}
+
+/**
+ * @brief Fills a world with one of the named scenarios and picks the integrator that suits it.
+ *
+ * The bare solar system is a handful of bodies where accuracy is cheap, so it uses the fourth order
+ * integrator. The belt is dominated by force calculations over many bodies on gentle orbits, so it
+ * uses leapfrog, which needs a third of the force evaluations per step. The debris field is the same
+ * belt made of massless test particles, which is what lets it hold millions of them. The rails
+ * scenario is the belt again with the planets on fixed Kepler orbits, and the asteroids on rails
+ * except while they pass near a planet.
+ *
+ * @param name one of "solar", "belt", "debris" or "rails".
+ * @param world the world to set up; its bodies and particles should be empty.
+ * @param asteroidCount the number of asteroids in the belt and rails scenarios, or particles in the debris scenario.
+ * @throws std::runtime_error if the scenario name isn't recognised.
+ */
+void SetUpScenario(const std::string& name, PhysicsWorld& world, int asteroidCount) {
+    if (name == "solar") {
+        CreateSolarSystem(world.bodies);
+        world.SetIntegrator(YOSHIDA4);
+    }
+    else if (name == "belt") {
+        CreateSolarSystem(world.bodies);
+        AddAsteroidBelt(world.bodies, asteroidCount, 20.0, 23.0);
+        world.SetIntegrator(LEAPFROG);
+    }
+    else if (name == "debris") {
+        CreateSolarSystem(world.bodies);
+        AddParticleBelt(world.particles, world.bodies.Get(0), asteroidCount, 20.0, 23.0);
+        world.SetIntegrator(LEAPFROG);
+    }
+    else if (name == "rails") {
+        CreateSolarSystem(world.bodies);
+        unsigned int planetsEnd = (unsigned int)world.bodies.Size();
+        AddAsteroidBelt(world.bodies, asteroidCount, 20.0, 23.0);
+        for (unsigned int i = 1; i < world.bodies.Size(); i++) {
+            world.rails.SetMotion(i, i < planetsEnd ? ON_RAILS : AUTOMATIC_RAILS);
+        }
+        world.SetIntegrator(LEAPFROG);
+    }
+    else {
+        throw std::runtime_error("Unknown scenario '" + name + "'");
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+#include <Physics/Body/Body.hpp>
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/ParticleStore/ParticleStore.hpp>
+#include <Physics/PhysicsWorld/PhysicsWorld.hpp>
+
+void CreateSolarSystem(BodyStore& bodies);
+void AddAsteroidBelt(BodyStore& bodies, int count, double innerRadius, double outerRadius, unsigned int seed = 1);
+void AddParticleBelt(ParticleStore& particles, const Body& primary, int count, double innerRadius, double outerRadius, unsigned int seed = 1);
+glm::dvec3 CircularOrbitVelocity(const Body& primary, glm::dvec3 position, double gravitationalConstant = 1.0);
+void SetUpScenario(const std::string& name, PhysicsWorld& world, int asteroidCount);
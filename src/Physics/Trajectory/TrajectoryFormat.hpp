@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Trajectory files hold a recording of every body's position and velocity over a run.
+ *
+ * The file starts with a TrajectoryHeader, followed by each body's mass and radius, followed by the
+ * frames. Every frame is a TrajectoryFrameHeader followed by the x, y, z, vx, vy and vz arrays for all
+ * bodies, each padded to TRAJECTORY_ALIGNMENT. With TRAJECTORY_FRAME_BODIES set, every frame also ends
+ * with the mass and radius arrays, always as doubles, and the ones up front only hold their values when
+ * recording started. Frames are a fixed size (or, with delta compression, one of two fixed sizes in a
+ * fixed pattern), so any frame can be found without reading the ones before it, and a mapped file can
+ * be read directly with no parsing.
+ *
+ * All values are little-endian. Version 1 files are laid out the same, without any flags.
+ */
+
+static const char TRAJECTORY_MAGIC[8] = {'S', 'O', 'L', 'T', 'R', 'A', 'J', '\0'};
+static const uint32_t TRAJECTORY_VERSION = 2;
+static const size_t TRAJECTORY_ALIGNMENT = 64;
+// Arrays every frame holds, in the frame's compression
+static const int TRAJECTORY_ARRAY_COUNT = 6;
+
+// Every frame holds every body's mass and radius, for recordings in which they change, such as when
+// bodies merge
+static const uint32_t TRAJECTORY_FRAME_BODIES = 1;
+
+enum TrajectoryCompression : uint32_t {
+    // Full precision doubles
+    TRAJECTORY_FLOAT64 = 0,
+    // Floats; plenty for drawing, lossy for analysis
+    TRAJECTORY_FLOAT32 = 1,
+    // Every keyframeInterval-th frame is stored as doubles, the frames between as 16 bit offsets from it
+    TRAJECTORY_DELTA16 = 2
+};
+
+enum TrajectoryArray {
+    TRAJECTORY_X,
+    TRAJECTORY_Y,
+    TRAJECTORY_Z,
+    TRAJECTORY_VX,
+    TRAJECTORY_VY,
+    TRAJECTORY_VZ,
+    // Only in frames of files with TRAJECTORY_FRAME_BODIES
+    TRAJECTORY_MASS,
+    TRAJECTORY_RADIUS
+};
+
+struct TrajectoryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t compression;
+    uint64_t bodyCount;
+    // Frames completely written; only filled in when the writer is closed
+    uint64_t frameCount;
+    uint32_t keyframeInterval;
+    // TRAJECTORY_FRAME_BODIES, or 0
+    uint32_t flags;
+    // Offset of the mass array, which is followed by the radius array
+    uint64_t bodiesOffset;
+    uint64_t framesOffset;
+    uint64_t reserved1;
+};
+static_assert(sizeof(TrajectoryHeader) == 64, "Trajectory header layout must not change");
+
+struct TrajectoryFrameHeader {
+    uint64_t step;
+    double time;
+    // Size of one quantisation step of each array in a delta frame, unused otherwise
+    double scale[TRAJECTORY_ARRAY_COUNT];
+};
+static_assert(sizeof(TrajectoryFrameHeader) == 64, "Trajectory frame header layout must not change");
+
+/**
+ * @brief Works out where everything lives in a trajectory file from its header.
+ */
+class TrajectoryLayout {
+    private:
+        static size_t align(size_t size) { return (size + TRAJECTORY_ALIGNMENT - 1)/TRAJECTORY_ALIGNMENT*TRAJECTORY_ALIGNMENT; }
+
+        size_t arraySize(bool isKeyframe) const { return align(bodyCount*ElementSize(isKeyframe)); }
+        size_t bodyArraySize() const { return HasFrameBodies() ? align(bodyCount*sizeof(double)) : 0; }
+
+    public:
+        uint32_t compression = TRAJECTORY_FLOAT64;
+        size_t bodyCount = 0;
+        size_t keyframeInterval = 1;
+        uint32_t flags = 0;
+        size_t framesOffset = 0;
+
+        TrajectoryLayout() = default;
+        TrajectoryLayout(uint32_t compression, size_t bodyCount, size_t keyframeInterval, uint32_t flags = 0) :
+            compression(compression), bodyCount(bodyCount), keyframeInterval(compression == TRAJECTORY_DELTA16 ? keyframeInterval : 1),
+            flags(flags), framesOffset(align(sizeof(TrajectoryHeader)) + 2*align(bodyCount*sizeof(double))) {}
+
+        bool HasFrameBodies() const { return (flags & TRAJECTORY_FRAME_BODIES) != 0; }
+
+        size_t BodiesOffset() const { return align(sizeof(TrajectoryHeader)); }
+
+        bool IsKeyframe(size_t frame) const { return frame % keyframeInterval == 0; }
+
+        size_t ElementSize(bool isKeyframe) const {
+            switch (compression) {
+                case TRAJECTORY_FLOAT32: return sizeof(float);
+                case TRAJECTORY_DELTA16: return isKeyframe ? sizeof(double) : sizeof(int16_t);
+                default:                 return sizeof(double);
+            }
+        }
+
+        size_t FrameSize(bool isKeyframe) const {
+            return sizeof(TrajectoryFrameHeader) + TRAJECTORY_ARRAY_COUNT*arraySize(isKeyframe) + 2*bodyArraySize();
+        }
+
+        // Size of a keyframe and all the frames that depend on it
+        size_t BlockSize() const { return FrameSize(true) + (keyframeInterval - 1)*FrameSize(false); }
+
+        size_t FrameOffset(size_t frame) const {
+            size_t block = frame/keyframeInterval;
+            size_t inBlock = frame % keyframeInterval;
+            size_t offset = framesOffset + block*BlockSize();
+            if (inBlock > 0) {
+                offset += FrameSize(true) + (inBlock - 1)*FrameSize(false);
+            }
+            return offset;
+        }
+
+        size_t ArrayOffset(size_t frame, int array) const {
+            size_t offset = FrameOffset(frame) + sizeof(TrajectoryFrameHeader);
+            if (array < TRAJECTORY_ARRAY_COUNT) {
+                return offset + array*arraySize(IsKeyframe(frame));
+            }
+            return offset + TRAJECTORY_ARRAY_COUNT*arraySize(IsKeyframe(frame)) + (array - TRAJECTORY_ARRAY_COUNT)*bodyArraySize();
+        }
+
+        // Number of whole frames that fit in a file of the given size
+        size_t FramesInFile(size_t fileSize) const {
+            if (fileSize < framesOffset) {
+                return 0;
+            }
+            size_t bytes = fileSize - framesOffset;
+            size_t frames = bytes/BlockSize()*keyframeInterval;
+            size_t remainder = bytes % BlockSize();
+            if (remainder >= FrameSize(true)) {
+                frames += 1 + (remainder - FrameSize(true))/FrameSize(false);
+            }
+            return frames;
+        }
+};
@@ -0,0 +1,244 @@
+#include <Physics/Trajectory/TrajectoryReader.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief Maps a trajectory file and checks its header.
+ *
+ * @param path the path of the trajectory file.
+ * @throws std::runtime_error if the file can't be mapped, isn't a trajectory this version can read, or is
+ * shorter than its header says.
+ */
+TrajectoryReader::TrajectoryReader(const std::string& path) : file(path) {
+    if (file.Size() < sizeof(TrajectoryHeader)) {
+        throw std::runtime_error("'" + path + "' is too small to be a trajectory file");
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("'" + path + "' is not a trajectory file");
+    }
+    // Version 1 is version 2 without any flags
+    if (header.version != TRAJECTORY_VERSION && !(header.version == 1 && header.flags == 0)) {
+        throw std::runtime_error("'" + path + "' is trajectory version " + std::to_string(header.version) +
+                                 ", expected " + std::to_string(TRAJECTORY_VERSION));
+    }
+    // A body count too large for the file would overflow the layout's offsets, so it is checked first
+    if (header.compression > TRAJECTORY_DELTA16 || header.keyframeInterval == 0 || (header.flags & ~TRAJECTORY_FRAME_BODIES) != 0 ||
+        header.bodyCount > file.Size()/sizeof(double)) {
+        throw std::runtime_error("'" + path + "' has a corrupt header");
+    }
+
+    layout = TrajectoryLayout(header.compression, header.bodyCount, header.keyframeInterval, header.flags);
+    if (layout.framesOffset != header.framesOffset || layout.BodiesOffset() != header.bodiesOffset) {
+        throw std::runtime_error("'" + path + "' has a corrupt header");
+    }
+    if (header.framesOffset > file.Size()) {
+        throw std::runtime_error("'" + path + "' is truncated before the end of its body data");
+    }
+    // The header's count is only written on close, so the frames are counted from the file size, which
+    // only ever covers whole frames. A closed file with fewer frames than its header lists was cut short.
+    frameCount = layout.FramesInFile(file.Size());
+    if (header.frameCount > frameCount) {
+        throw std::runtime_error("'" + path + "' is truncated: its header lists " + std::to_string(header.frameCount) +
+                                 " frames, but only " + std::to_string(frameCount) + " are in the file");
+    }
+}
+
+/**
+ * @brief Gets the mass of every body in a frame.
+ *
+ * Files without TRAJECTORY_FRAME_BODIES only store the masses when recording started, which hold for
+ * every frame.
+ *
+ * @throws std::out_of_range if the frame doesn't exist.
+ */
+const double* TrajectoryReader::Masses(size_t frame) const {
+    frameHeader(frame);
+    if (layout.HasFrameBodies()) {
+        return (const double*)(file.Data() + layout.ArrayOffset(frame, TRAJECTORY_MASS));
+    }
+    return (const double*)(file.Data() + header.bodiesOffset);
+}
+
+/**
+ * @brief Gets the radius of every body in a frame.
+ *
+ * Files without TRAJECTORY_FRAME_BODIES only store the radii when recording started, which hold for
+ * every frame.
+ *
+ * @throws std::out_of_range if the frame doesn't exist.
+ */
+const double* TrajectoryReader::Radii(size_t frame) const {
+    frameHeader(frame);
+    if (layout.HasFrameBodies()) {
+        return (const double*)(file.Data() + layout.ArrayOffset(frame, TRAJECTORY_RADIUS));
+    }
+    return (const double*)(file.Data() + header.bodiesOffset + (header.framesOffset - header.bodiesOffset)/2);
+}
+
+const TrajectoryFrameHeader& TrajectoryReader::frameHeader(size_t frame) const {
+    if (frame >= frameCount) {
+        throw std::out_of_range("Trajectory frame " + std::to_string(frame) + " out of range");
+    }
+    return *(const TrajectoryFrameHeader*)(file.Data() + layout.FrameOffset(frame));
+}
+
+/**
+ * @brief Finds the last frame at or before a given simulation time.
+ *
+ * Frame times are increasing, so this is a binary search touching only O(log n) frame headers.
+ *
+ * @param time the simulation time to look for.
+ * @return the index of the frame, or 0 if the time is before the first frame.
+ */
+size_t TrajectoryReader::FrameAtTime(double time) const {
+    size_t low = 0;
+    size_t high = frameCount;
+    while (high - low > 1) {
+        size_t middle = low + (high - low)/2;
+        if (FrameTime(middle) <= time) {
+            low = middle;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Decodes one array of a frame, whatever the file's compression.
+ *
+ * A delta frame needs its keyframe as well, which is at most keyframeInterval - 1 frames earlier.
+ * Masses and radii are always doubles, wherever the file keeps them.
+ */
+template <typename T>
+void TrajectoryReader::readArray(size_t frame, int array, T* output) const {
+    if (array == TRAJECTORY_MASS || array == TRAJECTORY_RADIUS) {
+        const double* values = array == TRAJECTORY_MASS ? Masses(frame) : Radii(frame);
+        std::copy(values, values + layout.bodyCount, output);
+        return;
+    }
+
+    const TrajectoryFrameHeader& headerOfFrame = frameHeader(frame);
+    const uint8_t* data = file.Data() + layout.ArrayOffset(frame, array);
+    size_t bodyCount = layout.bodyCount;
+
+    if (layout.compression == TRAJECTORY_FLOAT32) {
+        const float* values = (const float*)data;
+        std::copy(values, values + bodyCount, output);
+    }
+    else if (layout.compression == TRAJECTORY_DELTA16 && !layout.IsKeyframe(frame)) {
+        size_t keyframeIndex = frame - frame % layout.keyframeInterval;
+        const double* keyframe = (const double*)(file.Data() + layout.ArrayOffset(keyframeIndex, array));
+        const int16_t* deltas = (const int16_t*)data;
+        double scale = headerOfFrame.scale[array];
+        for (size_t i = 0; i < bodyCount; i++) {
+            output[i] = (T)(keyframe[i] + scale*deltas[i]);
+        }
+    }
+    else {
+        const double* values = (const double*)data;
+        std::copy(values, values + bodyCount, output);
+    }
+}
+
+/**
+ * @brief Decodes one array of a frame into doubles.
+ *
+ * @param frame the index of the frame.
+ * @param array which array to read.
+ * @param output receives BodyCount() values.
+ * @throws std::out_of_range if the frame doesn't exist.
+ */
+void TrajectoryReader::ReadArray(size_t frame, TrajectoryArray array, double* output) const {
+    readArray(frame, array, output);
+}
+
+/**
+ * @brief Decodes one array of a frame into floats.
+ *
+ * @param frame the index of the frame.
+ * @param array which array to read.
+ * @param output receives BodyCount() values.
+ * @throws std::out_of_range if the frame doesn't exist.
+ */
+void TrajectoryReader::ReadArray(size_t frame, TrajectoryArray array, float* output) const {
+    readArray(frame, array, output);
+}
+
+/**
+ * @brief Decodes the positions of every body in a frame into floats, ready for drawing.
+ *
+ * @param frame the index of the frame.
+ * @param x, y, z receive BodyCount() values each.
+ * @throws std::out_of_range if the frame doesn't exist.
+ */
+void TrajectoryReader::ReadPositions(size_t frame, float* x, float* y, float* z) const {
+    readArray(frame, TRAJECTORY_X, x);
+    readArray(frame, TRAJECTORY_Y, y);
+    readArray(frame, TRAJECTORY_Z, z);
+}
+
+/**
+ * @brief Asks the OS to start reading a run of frames in from disk, without waiting for it.
+ *
+ * @param firstFrame the first frame to prefetch.
+ * @param count the number of frames to prefetch; clamped to the end of the file.
+ */
+void TrajectoryReader::Prefetch(size_t firstFrame, size_t count) const {
+    if (firstFrame >= frameCount) {
+        return;
+    }
+    size_t lastFrame = std::min(firstFrame + count, frameCount);
+    size_t begin = layout.FrameOffset(firstFrame);
+    size_t end = lastFrame < frameCount ? layout.FrameOffset(lastFrame) : file.Size();
+    file.Prefetch(begin, end - begin);
+    if (!layout.IsKeyframe(firstFrame)) {
+        // The first frames decode against an earlier keyframe, which needs to be resident too
+        size_t keyframeIndex = firstFrame - firstFrame % layout.keyframeInterval;
+        file.Prefetch(layout.FrameOffset(keyframeIndex), layout.FrameSize(true));
+    }
+}
+
+/**
+ * @brief Tells the OS a run of frames won't be needed soon, so their memory can be reused.
+ *
+ * @param firstFrame the first frame to evict.
+ * @param count the number of frames to evict; clamped to the end of the file.
+ */
+void TrajectoryReader::Evict(size_t firstFrame, size_t count) const {
+    if (firstFrame >= frameCount) {
+        return;
+    }
+    size_t lastFrame = std::min(firstFrame + count, frameCount);
+    size_t begin = layout.FrameOffset(firstFrame);
+    size_t end = lastFrame < frameCount ? layout.FrameOffset(lastFrame) : file.Size();
+    file.Evict(begin, end - begin);
+}
+
+/**
+ * @brief Checks whether a run of frames, and any keyframe they decode against, can be read without
+ * waiting on the disk.
+ *
+ * @param firstFrame the first frame to check.
+ * @param count the number of frames to check; clamped to the end of the file.
+ */
+bool TrajectoryReader::IsResident(size_t firstFrame, size_t count) const {
+    if (firstFrame >= frameCount) {
+        return true;
+    }
+    size_t lastFrame = std::min(firstFrame + count, frameCount);
+    size_t begin = layout.FrameOffset(firstFrame);
+    size_t end = lastFrame < frameCount ? layout.FrameOffset(lastFrame) : file.Size();
+    if (!file.IsResident(begin, end - begin)) {
+        return false;
+    }
+    if (!layout.IsKeyframe(firstFrame)) {
+        size_t keyframeIndex = firstFrame - firstFrame % layout.keyframeInterval;
+        return file.IsResident(layout.FrameOffset(keyframeIndex), layout.FrameSize(true));
+    }
+    return true;
+}
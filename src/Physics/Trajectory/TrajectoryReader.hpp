@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Physics/Trajectory/TrajectoryFormat.hpp>
+#include <Utilities/MappedFile.hpp>
+
+/**
+ * @brief Random access to the frames of a memory-mapped trajectory file.
+ *
+ * Opening a file only reads its header; frames are paged in from disk as they are read, so seeking
+ * anywhere in a recording of any size costs the same. Files that were never closed properly (for
+ * example because the simulation crashed) can still be read up to the last complete frame.
+ */
+class TrajectoryReader {
+    private:
+        MappedFile file;
+        TrajectoryHeader header;
+        TrajectoryLayout layout;
+        size_t frameCount = 0;
+
+        const TrajectoryFrameHeader& frameHeader(size_t frame) const;
+        template <typename T> void readArray(size_t frame, int array, T* output) const;
+
+    public:
+        explicit TrajectoryReader(const std::string& path);
+
+        size_t BodyCount() const { return layout.bodyCount; }
+        size_t FrameCount() const { return frameCount; }
+        TrajectoryCompression Compression() const { return (TrajectoryCompression)layout.compression; }
+        const TrajectoryLayout& Layout() const { return layout; }
+
+        const double* Masses(size_t frame) const;
+        const double* Radii(size_t frame) const;
+
+        uint64_t FrameStep(size_t frame) const { return frameHeader(frame).step; }
+        double FrameTime(size_t frame) const { return frameHeader(frame).time; }
+        size_t FrameAtTime(double time) const;
+
+        void ReadArray(size_t frame, TrajectoryArray array, double* output) const;
+        void ReadArray(size_t frame, TrajectoryArray array, float* output) const;
+        void ReadPositions(size_t frame, float* x, float* y, float* z) const;
+
+        void Prefetch(size_t firstFrame, size_t count) const;
+        void Evict(size_t firstFrame, size_t count) const;
+        bool IsResident(size_t firstFrame, size_t count) const;
+};
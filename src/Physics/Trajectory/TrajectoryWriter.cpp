@@ -0,0 +1,271 @@
+#include <Physics/Trajectory/TrajectoryWriter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+/**
+ * @brief Creates the trajectory file, writes its header and body data, and starts the writer thread.
+ *
+ * @param path the path of the file to create; an existing file is overwritten.
+ * @param bodies the bodies that will be recorded; their masses and radii are stored up front.
+ * @param compression how to store the frames.
+ * @param flags TRAJECTORY_FRAME_BODIES to also store the masses and radii in every frame, if they can
+ * change while recording; otherwise 0.
+ * @param keyframeInterval with delta compression, the number of frames from one keyframe to the next.
+ * @throws std::runtime_error if the file can't be created.
+ */
+TrajectoryWriter::TrajectoryWriter(const std::string& path, const BodyStore& bodies, TrajectoryCompression compression, uint32_t flags,
+                                   uint32_t keyframeInterval) :
+    file(path, std::ios::binary | std::ios::trunc) {
+    if (!file.good()) {
+        throw std::runtime_error("Could not create trajectory file '" + path + "'");
+    }
+    if (keyframeInterval == 0) {
+        throw std::runtime_error("Keyframe interval must be at least 1");
+    }
+
+    layout = TrajectoryLayout(compression, bodies.Size(), keyframeInterval, flags);
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version = TRAJECTORY_VERSION;
+    header.compression = compression;
+    header.bodyCount = bodies.Size();
+    header.keyframeInterval = (uint32_t)layout.keyframeInterval;
+    header.flags = flags;
+    header.bodiesOffset = layout.BodiesOffset();
+    header.framesOffset = layout.framesOffset;
+
+    // Everything up to the first frame is written in one go, zero padded between sections
+    std::vector<uint8_t> preamble(layout.framesOffset, 0);
+    std::memcpy(preamble.data(), &header, sizeof(header));
+    size_t massOffset = layout.BodiesOffset();
+    size_t radiusOffset = massOffset + (layout.framesOffset - massOffset)/2;
+    std::memcpy(preamble.data() + massOffset, bodies.mass.data(), bodies.Size()*sizeof(double));
+    std::memcpy(preamble.data() + radiusOffset, bodies.radius.data(), bodies.Size()*sizeof(double));
+    file.write((const char*)preamble.data(), preamble.size());
+    if (!layout.HasFrameBodies()) {
+        initialMasses.assign(bodies.mass.begin(), bodies.mass.begin() + bodies.Size());
+        initialRadii.assign(bodies.radius.begin(), bodies.radius.begin() + bodies.Size());
+    }
+
+    for (auto& array : keyframe) {
+        array.resize(bodies.Size());
+    }
+    thread = std::thread(&TrajectoryWriter::loop, this);
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    try {
+        Close();
+    }
+    catch (...) {
+        // Nothing sensible to do with an error while being destroyed
+    }
+}
+
+/**
+ * @brief Queues the current state of the bodies to be written.
+ *
+ * @param bodies the bodies to record; must be the same number as when the writer was created.
+ * @param step the simulation step the state is from.
+ * @param time the simulation time the state is from.
+ * @throws std::runtime_error if the number of bodies changed, if their masses or radii changed and the
+ * file has nowhere to store them, or if an earlier write failed.
+ */
+void TrajectoryWriter::WriteFrame(const BodyStore& bodies, uint64_t step, double time) {
+    if (bodies.Size() != header.bodyCount) {
+        throw std::runtime_error("Number of bodies changed while recording a trajectory");
+    }
+    if (!layout.HasFrameBodies() && (!std::equal(initialMasses.begin(), initialMasses.end(), bodies.mass.begin()) ||
+                                     !std::equal(initialRadii.begin(), initialRadii.end(), bodies.radius.begin()))) {
+        throw std::runtime_error("Masses or radii changed while recording a trajectory that only stores them once");
+    }
+
+    std::unique_ptr<FrameBuffer> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        rethrowError();
+        if (isClosing) {
+            throw std::runtime_error("Trajectory writer is closed");
+        }
+        if (!spareBuffers.empty()) {
+            buffer = std::move(spareBuffers.back());
+            spareBuffers.pop_back();
+        }
+    }
+    if (!buffer) {
+        buffer.reset(new FrameBuffer());
+        bufferCount++;
+    }
+
+    buffer->step = step;
+    buffer->time = time;
+    const AlignedVector<double>* sources[TRAJECTORY_ARRAY_COUNT] = {&bodies.x, &bodies.y, &bodies.z, &bodies.vx, &bodies.vy, &bodies.vz};
+    for (int a = 0; a < TRAJECTORY_ARRAY_COUNT; a++) {
+        buffer->arrays[a].assign(sources[a]->begin(), sources[a]->begin() + bodies.Size());
+    }
+    if (layout.HasFrameBodies()) {
+        buffer->masses.assign(bodies.mass.begin(), bodies.mass.begin() + bodies.Size());
+        buffer->radii.assign(bodies.radius.begin(), bodies.radius.begin() + bodies.Size());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(buffer));
+    }
+    queueChanged.notify_one();
+    framesQueued++;
+}
+
+/**
+ * @brief Writes out every queued frame, fills in the final frame count and closes the file.
+ *
+ * Safe to call more than once.
+ *
+ * @throws std::runtime_error if any write failed.
+ */
+void TrajectoryWriter::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isClosing = true;
+    }
+    queueChanged.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    if (file.is_open()) {
+        if (!error) {
+            header.frameCount = framesWritten;
+            file.seekp(0);
+            file.write((const char*)&header, sizeof(header));
+            file.flush();
+            if (!file.good()) {
+                error = std::make_exception_ptr(std::runtime_error("Could not finish writing trajectory file"));
+            }
+        }
+        file.close();
+    }
+    rethrowError();
+}
+
+/**
+ * @brief Rethrows the first error hit by the writer thread, if there was one.
+ */
+void TrajectoryWriter::rethrowError() {
+    if (error) {
+        std::exception_ptr thrown = error;
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+/**
+ * @brief The writer thread: takes frames off the queue and writes them until the writer is closed.
+ */
+void TrajectoryWriter::loop() {
+    while (true) {
+        std::unique_ptr<FrameBuffer> buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueChanged.wait(lock, [this]() { return !queue.empty() || isClosing; });
+            if (queue.empty()) {
+                return;
+            }
+            buffer = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        try {
+            writeFrame(*buffer);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+            queue.clear();
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        spareBuffers.push_back(std::move(buffer));
+    }
+}
+
+/**
+ * @brief Encodes a frame and appends it to the file.
+ *
+ * Delta frames store each value as a 16 bit multiple of a per-array scale, offset from the last
+ * keyframe rather than the previous frame, so any frame can be decoded from just itself and its
+ * keyframe. The scale is chosen per frame from the largest offset, so precision degrades gracefully
+ * for fast moving bodies instead of clipping.
+ */
+void TrajectoryWriter::writeFrame(const FrameBuffer& frame) {
+    bool isKeyframe = layout.IsKeyframe(framesWritten);
+    size_t bodyCount = header.bodyCount;
+    encoded.assign(layout.FrameSize(isKeyframe), 0);
+
+    TrajectoryFrameHeader* frameHeader = (TrajectoryFrameHeader*)encoded.data();
+    frameHeader->step = frame.step;
+    frameHeader->time = frame.time;
+
+    size_t frameOffset = layout.FrameOffset(framesWritten);
+    for (int a = 0; a < TRAJECTORY_ARRAY_COUNT; a++) {
+        uint8_t* destination = encoded.data() + layout.ArrayOffset(framesWritten, a) - frameOffset;
+        const double* values = frame.arrays[a].data();
+
+        if (layout.compression == TRAJECTORY_FLOAT32) {
+            float* output = (float*)destination;
+            for (size_t i = 0; i < bodyCount; i++) {
+                output[i] = (float)values[i];
+            }
+        }
+        else if (layout.compression == TRAJECTORY_DELTA16 && !isKeyframe) {
+            double largestDelta = 0.0;
+            for (size_t i = 0; i < bodyCount; i++) {
+                largestDelta = std::max(largestDelta, std::fabs(values[i] - keyframe[a][i]));
+            }
+            double scale = largestDelta/std::numeric_limits<int16_t>::max();
+            double inverseScale = scale > 0.0 ? 1.0/scale : 0.0;
+            frameHeader->scale[a] = scale;
+
+            int16_t* output = (int16_t*)destination;
+            for (size_t i = 0; i < bodyCount; i++) {
+                output[i] = (int16_t)std::lround((values[i] - keyframe[a][i])*inverseScale);
+            }
+        }
+        else {
+            std::memcpy(destination, values, bodyCount*sizeof(double));
+            if (layout.compression == TRAJECTORY_DELTA16) {
+                std::copy(values, values + bodyCount, keyframe[a].begin());
+            }
+        }
+    }
+
+    if (layout.HasFrameBodies()) {
+        std::memcpy(encoded.data() + layout.ArrayOffset(framesWritten, TRAJECTORY_MASS) - frameOffset, frame.masses.data(), bodyCount*sizeof(double));
+        std::memcpy(encoded.data() + layout.ArrayOffset(framesWritten, TRAJECTORY_RADIUS) - frameOffset, frame.radii.data(), bodyCount*sizeof(double));
+    }
+
+    file.write((const char*)encoded.data(), encoded.size());
+    if (!file.good()) {
+        throw std::runtime_error("Could not write to trajectory file");
+    }
+    framesWritten++;
+}
+
+/**
+ * @brief Parses the name of a compression mode, as used on the command line.
+ *
+ * @param name one of "float64", "float32" or "delta16".
+ * @return the matching compression mode.
+ * @throws std::runtime_error if the name isn't recognised.
+ */
+TrajectoryCompression TrajectoryCompressionFromString(const std::string& name) {
+    if (name == "float64") return TRAJECTORY_FLOAT64;
+    if (name == "float32") return TRAJECTORY_FLOAT32;
+    if (name == "delta16") return TRAJECTORY_DELTA16;
+    throw std::runtime_error("Unknown trajectory compression '" + name + "'");
+}
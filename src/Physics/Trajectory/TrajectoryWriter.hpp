@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Physics/BodyStore/BodyStore.hpp>
+#include <Physics/Trajectory/TrajectoryFormat.hpp>
+
+/**
+ * @brief Streams frames of a simulation to a trajectory file on a background thread.
+ *
+ * WriteFrame only copies the bodies' state into a spare buffer and queues it, so the simulation never
+ * waits on compression or the disk. If the disk falls behind, more buffers are allocated rather than
+ * making the simulation wait; they are kept and reused once the writer catches up.
+ *
+ * The set of bodies must not change size while recording. Their masses and radii may only change if
+ * the writer was created with TRAJECTORY_FRAME_BODIES, which stores them in every frame.
+ */
+class TrajectoryWriter {
+    private:
+        struct FrameBuffer {
+            uint64_t step;
+            double time;
+            std::vector<double> arrays[TRAJECTORY_ARRAY_COUNT];
+            // Only filled with TRAJECTORY_FRAME_BODIES
+            std::vector<double> masses, radii;
+        };
+
+        std::ofstream file;
+        TrajectoryHeader header;
+        TrajectoryLayout layout;
+        uint64_t framesQueued = 0;
+        // What was stored up front, to catch changes that the frames can't hold
+        std::vector<double> initialMasses, initialRadii;
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable queueChanged;
+        std::deque<std::unique_ptr<FrameBuffer>> queue;
+        std::vector<std::unique_ptr<FrameBuffer>> spareBuffers;
+        size_t bufferCount = 0;
+        bool isClosing = false;
+        std::exception_ptr error;
+
+        // Only touched by the writer thread
+        uint64_t framesWritten = 0;
+        std::vector<double> keyframe[TRAJECTORY_ARRAY_COUNT];
+        std::vector<uint8_t> encoded;
+
+        void loop();
+        void writeFrame(const FrameBuffer& frame);
+        void rethrowError();
+
+    public:
+        TrajectoryWriter(const std::string& path, const BodyStore& bodies, TrajectoryCompression compression, uint32_t flags = 0,
+                         uint32_t keyframeInterval = 32);
+        ~TrajectoryWriter();
+        TrajectoryWriter(const TrajectoryWriter&) = delete;
+        TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+        void WriteFrame(const BodyStore& bodies, uint64_t step, double time);
+        void Close();
+
+        uint64_t FramesQueued() const { return framesQueued; }
+        size_t BufferCount() const { return bufferCount; }
+};
+
+TrajectoryCompression TrajectoryCompressionFromString(const std::string& name);
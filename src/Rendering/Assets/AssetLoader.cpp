@@ -0,0 +1,135 @@
+#include <Rendering/Assets/AssetLoader.hpp>
+
+#include <chrono>
+#include <iterator>
+
+#include <stb_image.h>
+
+#include <Utilities/Utilities.hpp>
+
+/**
+ * @brief Starts the loading threads.
+ *
+ * @param materials the library that textures are added to and uploaded into.
+ * @param threadCount the number of threads to load on.
+ */
+AssetLoader::AssetLoader(MaterialLibrary& materials, unsigned int threadCount) :
+    materials(materials), loadingThreads(threadCount > 0 ? threadCount : 1) {}
+
+/**
+ * @brief Starts loading a model, unless it is loaded or loading already.
+ *
+ * @param path the path to the model file.
+ * @return the model, which stays owned by the loader. It draws nothing until it has loaded.
+ */
+Model* AssetLoader::LoadModel(const std::string& path) {
+    auto found = models.find(path);
+    if (found != models.end()) {
+        return found->second.get();
+    }
+
+    Model* model = models.emplace(path, std::unique_ptr<Model>(new Model())).first->second.get();
+    std::shared_ptr<Results> destination = results;
+    MeshCache cache = meshCache;
+    loadingThreads.Submit([destination, model, path, cache]() {
+        std::unique_ptr<CookedModel> cooked = cache.Load(path);
+        std::lock_guard<std::mutex> lock(destination->mutex);
+        destination->models.emplace_back(model, std::move(cooked));
+    });
+    pendingCount++;
+    return model;
+}
+
+/**
+ * @brief Adds a texture to the material library and starts decoding it, unless that has been done already.
+ *
+ * @param path the path to the image file.
+ * @return the texture's index in the material library.
+ */
+int AssetLoader::requestTexture(const std::string& path) {
+    auto found = textures.find(path);
+    if (found != textures.end()) {
+        return found->second;
+    }
+
+    int texture = materials.AddTexture();
+    textures.emplace(path, texture);
+    std::shared_ptr<Results> destination = results;
+    loadingThreads.Submit([destination, texture, path]() {
+        TextureImage image;
+        int width, height, numColourChannels;
+        // The flip is done by PrepareImage, as stb_image's flip setting is shared by every thread
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &numColourChannels, 4);
+        if (data) {
+            image = MaterialLibrary::PrepareImage(data, width, height);
+            stbi_image_free(data);
+        }
+        else {
+            outputError("Texture file could not be loaded: " + path);
+        }
+
+        std::lock_guard<std::mutex> lock(destination->mutex);
+        destination->textures.emplace_back(texture, std::move(image));
+    });
+    pendingCount++;
+    return texture;
+}
+
+/**
+ * @brief Uploads a model's meshes and starts loading their textures.
+ *
+ * Cached meshes are uploaded straight from the mapped cache file, which is unmapped once they are.
+ */
+void AssetLoader::uploadModel(Model& model, const CookedModel& cooked) {
+    std::vector<Mesh> uploaded;
+    uploaded.reserve(cooked.meshes.size());
+    for (const auto& mesh : cooked.meshes) {
+        int diffuse = mesh.diffusePath.empty() ? -1 : requestTexture(mesh.diffusePath);
+        int specular = mesh.specularPath.empty() ? -1 : requestTexture(mesh.specularPath);
+        uploaded.push_back(Mesh(mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount, materials.AddMaterial(diffuse, specular)));
+    }
+    model.SetMeshes(uploaded);
+}
+
+/**
+ * @brief Uploads assets that have finished loading, until the frame's budget is spent.
+ *
+ * Must be called on the thread that owns the GL context, once per frame before anything is drawn.
+ * Models go first, as they start their textures loading. Whatever doesn't fit waits for the next frame.
+ */
+void AssetLoader::Update() {
+    std::vector<std::pair<Model*, std::unique_ptr<CookedModel>>> completedModels;
+    std::vector<std::pair<int, TextureImage>> completedTextures;
+    {
+        std::lock_guard<std::mutex> lock(results->mutex);
+        completedModels.swap(results->models);
+        completedTextures.swap(results->textures);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool isFirst = true;
+    auto hasTime = [&]() {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        bool result = isFirst || elapsed.count() < uploadBudget;
+        isFirst = false;
+        return result;
+    };
+
+    size_t modelsUploaded = 0;
+    for (; modelsUploaded < completedModels.size() && hasTime(); modelsUploaded++) {
+        uploadModel(*completedModels[modelsUploaded].first, *completedModels[modelsUploaded].second);
+        completedModels[modelsUploaded].second.reset();
+        pendingCount--;
+    }
+    size_t texturesUploaded = 0;
+    for (; texturesUploaded < completedTextures.size() && hasTime(); texturesUploaded++) {
+        materials.UploadTexture(completedTextures[texturesUploaded].first, completedTextures[texturesUploaded].second);
+        pendingCount--;
+    }
+
+    if (modelsUploaded < completedModels.size() || texturesUploaded < completedTextures.size()) {
+        std::lock_guard<std::mutex> lock(results->mutex);
+        results->models.insert(results->models.begin(), std::make_move_iterator(completedModels.begin() + modelsUploaded), std::make_move_iterator(completedModels.end()));
+        results->textures.insert(results->textures.begin(), std::make_move_iterator(completedTextures.begin() + texturesUploaded), std::make_move_iterator(completedTextures.end()));
+    }
+}
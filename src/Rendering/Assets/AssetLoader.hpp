@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Rendering/Assets/MeshCache.hpp>
+#include <Rendering/Materials/MaterialLibrary.hpp>
+#include <Rendering/Window/Model/Model.hpp>
+
+/**
+ * @brief Loads models and their textures in the background, so nothing waits on the disk.
+ *
+ * File reads, model imports and image decodes run on a few threads of the loader's own, kept apart
+ * from the main job system so that a slow read can never hold up a physics step. Models come from the
+ * mesh cache where possible, and are only imported with Assimp when they aren't cached yet. Finished
+ * assets are uploaded on the GL thread by Update, a few at a time, until that frame's time budget is
+ * spent.
+ *
+ * Everything is usable as soon as it is requested: a model draws nothing until its meshes arrive,
+ * and a texture samples as plain white until its image does.
+ */
+class AssetLoader {
+    private:
+        // Filled by the loading threads and emptied by Update; shared so that jobs still running when
+        // the loader goes away have somewhere to put their results
+        struct Results {
+            std::mutex mutex;
+            std::vector<std::pair<Model*, std::unique_ptr<CookedModel>>> models;
+            std::vector<std::pair<int, TextureImage>> textures;
+        };
+
+        MaterialLibrary& materials;
+        MeshCache meshCache;
+        std::shared_ptr<Results> results = std::make_shared<Results>();
+        std::unordered_map<std::string, std::unique_ptr<Model>> models;
+        std::unordered_map<std::string, int> textures;
+        unsigned int pendingCount = 0;
+        JobSystem loadingThreads;
+
+        int requestTexture(const std::string& path);
+        void uploadModel(Model& model, const CookedModel& cooked);
+
+    public:
+        static constexpr unsigned int LOADING_THREAD_COUNT = 2;
+
+        // Longest to spend uploading finished assets each frame, in seconds. At least one asset is
+        // uploaded every frame, however long it takes
+        double uploadBudget = 0.002;
+
+        explicit AssetLoader(MaterialLibrary& materials, unsigned int threadCount = LOADING_THREAD_COUNT);
+
+        AssetLoader(const AssetLoader&) = delete;
+        AssetLoader& operator=(const AssetLoader&) = delete;
+
+        Model* LoadModel(const std::string& path);
+        void Update();
+        unsigned int PendingCount() const { return pendingCount; }
+};
@@ -0,0 +1,393 @@
+#include <Rendering/Assets/MeshCache.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include <Rendering/Assets/MeshCacheFormat.hpp>
+#include <Utilities/Utilities.hpp>
+
+static size_t align(size_t size) {
+    return (size + MESH_CACHE_ALIGNMENT - 1)/MESH_CACHE_ALIGNMENT*MESH_CACHE_ALIGNMENT;
+}
+
+/**
+ * @brief Folds bytes into a 64-bit FNV-1a hash.
+ */
+static uint64_t hashBytes(uint64_t hash, const uint8_t* bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static std::string modelDirectory(const std::string& modelPath) {
+    return modelPath.substr(0, modelPath.find_last_of('/'));
+}
+
+/**
+ * @brief Lists the files a model's meshes are imported from.
+ *
+ * That is the model file and, for glTF models, the binary buffers beside it, which hold the actual
+ * geometry, in a fixed order.
+ */
+static std::vector<std::string> sourceFiles(const std::string& modelPath) {
+    std::vector<std::string> sources = {modelPath};
+    std::filesystem::path path(modelPath);
+    if (path.extension() == ".gltf") {
+        std::vector<std::string> buffers;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(path.parent_path(), error)) {
+            if (entry.path().extension() == ".bin") {
+                buffers.push_back(entry.path().string());
+            }
+        }
+        std::sort(buffers.begin(), buffers.end());
+        sources.insert(sources.end(), buffers.begin(), buffers.end());
+    }
+    return sources;
+}
+
+/**
+ * @brief Gets the size and modification time of each source file.
+ *
+ * @throws std::runtime_error if any of the files can't be read.
+ */
+static std::vector<MeshStampSource> statSources(const std::vector<std::string>& sources) {
+    std::vector<MeshStampSource> stamps;
+    for (const auto& source : sources) {
+        stamps.push_back({(uint64_t)std::filesystem::file_size(source), (int64_t)std::filesystem::last_write_time(source).time_since_epoch().count()});
+    }
+    return stamps;
+}
+
+/**
+ * @brief Hashes everything a model's meshes are imported from: its source files and the import flags.
+ *
+ * @param modelPath the path to the model file.
+ * @throws std::runtime_error if any of the files can't be read.
+ */
+uint64_t MeshCache::HashSource(const std::string& modelPath) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = hashBytes(hash, (const uint8_t*)&Model::IMPORT_FLAGS, sizeof(Model::IMPORT_FLAGS));
+    for (const auto& source : sourceFiles(modelPath)) {
+        MappedFile file(source);
+        hash = hashBytes(hash, file.Data(), file.Size());
+    }
+    return hash;
+}
+
+/**
+ * @brief Gets the hash of a model's sources, from its stamp file if none of them have changed since.
+ *
+ * The sources are stat'ed before they are hashed, so a source changed while it is being hashed leaves
+ * a stamp that no longer matches, rather than one that hides the change.
+ *
+ * @param modelPath the path to the model file.
+ * @param isStampTrusted whether a matching stamp may be used, rather than always hashing the sources.
+ * @throws std::runtime_error if any of the sources can't be read.
+ */
+uint64_t MeshCache::lookUpSourceHash(const std::string& modelPath, bool isStampTrusted) const {
+    std::vector<MeshStampSource> sources = statSources(sourceFiles(modelPath));
+    std::string path = stampPath(modelPath);
+    uint64_t hash;
+    if (isStampTrusted && readStamp(path, sources, hash)) {
+        return hash;
+    }
+    hash = HashSource(modelPath);
+    writeStamp(path, sources, hash);
+    return hash;
+}
+
+std::string MeshCache::stampPath(const std::string& modelPath) const {
+    std::error_code error;
+    std::string absolutePath = std::filesystem::absolute(modelPath, error).string();
+    uint64_t pathHash = hashBytes(0xCBF29CE484222325ull, (const uint8_t*)absolutePath.data(), absolutePath.size());
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.stamp", (unsigned long long)pathHash);
+    return directory + '/' + name;
+}
+
+/**
+ * @brief Reads the source hash from a stamp file, if the file is there and matches the sources.
+ *
+ * @return whether the hash was found.
+ */
+bool MeshCache::readStamp(const std::string& path, const std::vector<MeshStampSource>& sources, uint64_t& sourceHash) const {
+    std::ifstream file(path, std::ios::binary);
+    MeshStampHeader header;
+    if (!file.read((char*)&header, sizeof(header))) {
+        return false;
+    }
+    if (std::memcmp(header.magic, MESH_STAMP_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION ||
+        header.importFlags != Model::IMPORT_FLAGS || header.sourceCount != sources.size()) {
+        return false;
+    }
+    std::vector<MeshStampSource> stamped(sources.size());
+    if (!file.read((char*)stamped.data(), stamped.size()*sizeof(MeshStampSource))) {
+        return false;
+    }
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (stamped[i].size != sources[i].size || stamped[i].modifiedTime != sources[i].modifiedTime) {
+            return false;
+        }
+    }
+    sourceHash = header.sourceHash;
+    return true;
+}
+
+/**
+ * @brief Records a model's source hash against the sizes and modification times of its sources.
+ *
+ * Written under a temporary name and renamed into place, like the cache files. Failing to write is
+ * harmless, as the sources are just hashed again next time.
+ */
+void MeshCache::writeStamp(const std::string& path, const std::vector<MeshStampSource>& sources, uint64_t sourceHash) const {
+    MeshStampHeader header = {};
+    std::memcpy(header.magic, MESH_STAMP_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.sourceCount = (uint32_t)sources.size();
+    header.sourceHash = sourceHash;
+    header.importFlags = Model::IMPORT_FLAGS;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string temporaryPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)sources.data(), sources.size()*sizeof(MeshStampSource));
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+std::string MeshCache::CachePath(uint64_t sourceHash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)sourceHash);
+    return directory + '/' + name;
+}
+
+/**
+ * @brief Gets a model's meshes, from the cache if it holds them and otherwise by importing the model
+ * and adding it to the cache. Safe to call from any thread.
+ *
+ * @param modelPath the path to the model file.
+ * @return the meshes, which are empty if the model couldn't be loaded.
+ */
+std::unique_ptr<CookedModel> MeshCache::Load(const std::string& modelPath) const {
+    std::unique_ptr<CookedModel> model(new CookedModel());
+    uint64_t sourceHash;
+    try {
+        sourceHash = lookUpSourceHash(modelPath, true);
+    }
+    catch (const std::runtime_error& e) {
+        outputError("Error loading model '" + modelPath + "': " + e.what());
+        return model;
+    }
+
+    std::string cachePath = CachePath(sourceHash);
+    std::string directory = modelDirectory(modelPath);
+    if (tryMap(cachePath, sourceHash, directory, *model)) {
+        return model;
+    }
+
+    model->imported = Model::Import(modelPath);
+    if (!model->imported.empty()) {
+        write(cachePath, sourceHash, directory, model->imported);
+    }
+    for (const auto& mesh : model->imported) {
+        model->meshes.push_back({mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), mesh.diffusePath, mesh.specularPath});
+    }
+    return model;
+}
+
+/**
+ * @brief Imports a model and writes it to the cache, whether or not it is cached already.
+ *
+ * @param modelPath the path to the model file.
+ * @return whether the cache file was written.
+ */
+bool MeshCache::Cook(const std::string& modelPath) const {
+    uint64_t sourceHash;
+    try {
+        sourceHash = lookUpSourceHash(modelPath, false);
+    }
+    catch (const std::runtime_error& e) {
+        outputError("Error cooking model '" + modelPath + "': " + e.what());
+        return false;
+    }
+
+    std::vector<MeshData> meshes = Model::Import(modelPath);
+    if (meshes.empty()) {
+        return false;
+    }
+    std::string cachePath = CachePath(sourceHash);
+    write(cachePath, sourceHash, modelDirectory(modelPath), meshes);
+    return std::filesystem::exists(cachePath);
+}
+
+/**
+ * @brief Maps a cache file and points the model's meshes into it, if the file is there and valid.
+ *
+ * @return whether the model's meshes were found.
+ */
+bool MeshCache::tryMap(const std::string& cachePath, uint64_t sourceHash, const std::string& modelDirectory, CookedModel& model) const {
+    std::error_code error;
+    if (!std::filesystem::exists(cachePath, error)) {
+        return false;
+    }
+
+    try {
+        MappedFile file(cachePath);
+        if (file.Size() < sizeof(MeshCacheHeader)) {
+            throw std::runtime_error("too small to be a mesh cache file");
+        }
+        MeshCacheHeader header;
+        std::memcpy(&header, file.Data(), sizeof(header));
+        if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("not a mesh cache file");
+        }
+        if (header.version != MESH_CACHE_VERSION || header.vertexSize != sizeof(Vertex) || header.importFlags != Model::IMPORT_FLAGS) {
+            throw std::runtime_error("written by a different version");
+        }
+        if (header.sourceHash != sourceHash) {
+            throw std::runtime_error("written for a different model");
+        }
+
+        auto isInFile = [&file](uint64_t offset, uint64_t length) {
+            return offset <= file.Size() && length <= file.Size() - offset;
+        };
+        if (!isInFile(header.meshesOffset, (uint64_t)header.meshCount*sizeof(MeshCacheEntry)) || !isInFile(header.pathsOffset, 0)) {
+            throw std::runtime_error("corrupt header");
+        }
+
+        const MeshCacheEntry* entries = (const MeshCacheEntry*)(file.Data() + header.meshesOffset);
+        const char* paths = (const char*)(file.Data() + header.pathsOffset);
+        auto texturePath = [&](uint32_t offset, uint32_t length) {
+            if (length == 0) {
+                return std::string();
+            }
+            if (!isInFile(header.pathsOffset + offset, length)) {
+                throw std::runtime_error("corrupt texture path");
+            }
+            return modelDirectory + '/' + std::string(paths + offset, length);
+        };
+
+        std::vector<MeshView> meshes;
+        for (uint32_t i = 0; i < header.meshCount; i++) {
+            const MeshCacheEntry& entry = entries[i];
+            if (!isInFile(entry.verticesOffset, (uint64_t)entry.vertexCount*sizeof(Vertex)) ||
+                !isInFile(entry.indicesOffset, (uint64_t)entry.indexCount*sizeof(unsigned int))) {
+                throw std::runtime_error("corrupt mesh " + std::to_string(i));
+            }
+            // An index past the end of the vertices would have the GPU read outside the vertex buffer
+            const unsigned int* indices = (const unsigned int*)(file.Data() + entry.indicesOffset);
+            if (entry.indexCount > 0 && *std::max_element(indices, indices + entry.indexCount) >= entry.vertexCount) {
+                throw std::runtime_error("mesh " + std::to_string(i) + " has indices past its vertices");
+            }
+            meshes.push_back({(const Vertex*)(file.Data() + entry.verticesOffset), entry.vertexCount,
+                              indices, entry.indexCount,
+                              texturePath(entry.diffusePathOffset, entry.diffusePathLength),
+                              texturePath(entry.specularPathOffset, entry.specularPathLength)});
+        }
+
+        model.file = std::move(file);
+        model.meshes = std::move(meshes);
+        return true;
+    }
+    catch (const std::runtime_error& e) {
+        outputError("Ignoring mesh cache file '" + cachePath + "': " + e.what());
+        return false;
+    }
+}
+
+/**
+ * @brief Writes a model's meshes to a cache file.
+ *
+ * The file is written under a temporary name and renamed into place once complete, so a cache file
+ * that exists is always whole, even if the program stopped part way through writing it. Failing to
+ * write is reported but otherwise harmless, as the model is just imported again next time.
+ */
+void MeshCache::write(const std::string& cachePath, uint64_t sourceHash, const std::string& modelDirectory, const std::vector<MeshData>& meshes) const {
+    // Texture paths are stored relative to the model, so that a model that is moved still finds them
+    std::string paths;
+    auto addPath = [&](const std::string& path, uint32_t& offset, uint32_t& length) {
+        std::string relativePath = path.compare(0, modelDirectory.size() + 1, modelDirectory + '/') == 0 ? path.substr(modelDirectory.size() + 1) : path;
+        offset = (uint32_t)paths.size();
+        length = (uint32_t)relativePath.size();
+        paths += relativePath;
+    };
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.sourceHash = sourceHash;
+    header.meshCount = (uint32_t)meshes.size();
+    header.importFlags = Model::IMPORT_FLAGS;
+    header.meshesOffset = align(sizeof(MeshCacheHeader));
+
+    std::vector<MeshCacheEntry> entries(meshes.size(), MeshCacheEntry{});
+    for (size_t i = 0; i < meshes.size(); i++) {
+        addPath(meshes[i].diffusePath, entries[i].diffusePathOffset, entries[i].diffusePathLength);
+        addPath(meshes[i].specularPath, entries[i].specularPathOffset, entries[i].specularPathLength);
+    }
+    header.pathsOffset = align(header.meshesOffset + entries.size()*sizeof(MeshCacheEntry));
+    size_t offset = align(header.pathsOffset + paths.size());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        entries[i].vertexCount = (uint32_t)meshes[i].vertices.size();
+        entries[i].indexCount = (uint32_t)meshes[i].indices.size();
+        entries[i].verticesOffset = offset;
+        offset = align(offset + meshes[i].vertices.size()*sizeof(Vertex));
+        entries[i].indicesOffset = offset;
+        offset = align(offset + meshes[i].indices.size()*sizeof(unsigned int));
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string temporaryPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        const char padding[MESH_CACHE_ALIGNMENT] = {};
+        size_t written = 0;
+        auto writeAt = [&](size_t position, const void* data, size_t length) {
+            file.write(padding, position - written);
+            file.write((const char*)data, length);
+            written = position + length;
+        };
+
+        writeAt(0, &header, sizeof(header));
+        writeAt(header.meshesOffset, entries.data(), entries.size()*sizeof(MeshCacheEntry));
+        writeAt(header.pathsOffset, paths.data(), paths.size());
+        for (size_t i = 0; i < meshes.size(); i++) {
+            writeAt(entries[i].verticesOffset, meshes[i].vertices.data(), meshes[i].vertices.size()*sizeof(Vertex));
+            writeAt(entries[i].indicesOffset, meshes[i].indices.data(), meshes[i].indices.size()*sizeof(unsigned int));
+        }
+        if (!file) {
+            outputError("Could not write mesh cache file '" + temporaryPath + "'");
+            file.close();
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error) {
+        outputError("Could not write mesh cache file '" + cachePath + "': " + error.message());
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Rendering/Assets/MeshCacheFormat.hpp>
+#include <Rendering/Window/Model/Model.hpp>
+#include <Utilities/MappedFile.hpp>
+
+/**
+ * @brief A mesh ready to upload, pointing into the CookedModel it belongs to.
+ */
+struct MeshView {
+    const Vertex* vertices;
+    size_t vertexCount;
+    const unsigned int* indices;
+    size_t indexCount;
+    // Paths to the mesh's diffuse and specular textures, or empty if it has none
+    std::string diffusePath;
+    std::string specularPath;
+};
+
+/**
+ * @brief A model's meshes, either mapped from the mesh cache or, failing that, imported with Assimp.
+ */
+struct CookedModel {
+    // Open when the meshes came from the cache
+    MappedFile file;
+    // Filled when the meshes were imported
+    std::vector<MeshData> imported;
+    // Point into whichever of the above holds the meshes
+    std::vector<MeshView> meshes;
+};
+
+/**
+ * @brief Keeps every model's meshes in a binary file of their own, so Assimp only runs once per model.
+ *
+ * Cache files are written the first time a model is loaded, or ahead of time with Cook, and are found
+ * again by the hash of the model's source files; see MeshCacheFormat.hpp for the layout. The hash is
+ * remembered in a stamp file alongside the sizes and modification times of the sources, and only
+ * worked out again when one of those changes. Any cache file that is missing, out of date or
+ * unreadable is ignored and the model imported again instead.
+ */
+class MeshCache {
+    private:
+        std::string directory;
+
+        uint64_t lookUpSourceHash(const std::string& modelPath, bool isStampTrusted) const;
+        std::string stampPath(const std::string& modelPath) const;
+        bool readStamp(const std::string& path, const std::vector<MeshStampSource>& sources, uint64_t& sourceHash) const;
+        void writeStamp(const std::string& path, const std::vector<MeshStampSource>& sources, uint64_t sourceHash) const;
+        bool tryMap(const std::string& cachePath, uint64_t sourceHash, const std::string& modelDirectory, CookedModel& model) const;
+        void write(const std::string& cachePath, uint64_t sourceHash, const std::string& modelDirectory, const std::vector<MeshData>& meshes) const;
+
+    public:
+        explicit MeshCache(const std::string& directory = "cache/meshes") : directory(directory) {}
+
+        std::unique_ptr<CookedModel> Load(const std::string& modelPath) const;
+        bool Cook(const std::string& modelPath) const;
+        std::string CachePath(uint64_t sourceHash) const;
+
+        static uint64_t HashSource(const std::string& modelPath);
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Mesh cache files hold a model's meshes already in the layout they are uploaded in, so that loading
+ * a model is a single mapping of the file, with no parsing and no copies.
+ *
+ * The file starts with a MeshCacheHeader, followed by a MeshCacheEntry per mesh, followed by the
+ * texture paths, followed by each mesh's vertex array (of Vertex) and index array (of unsigned int),
+ * every array padded to MESH_CACHE_ALIGNMENT. Texture paths are relative to the model's directory, and
+ * not null terminated.
+ *
+ * Files are named after the hash of the model's source files, which is also stored in the header, so
+ * editing a model makes its old cache file unreachable. All values are little-endian.
+ */
+
+static const char MESH_CACHE_MAGIC[8] = {'S', 'O', 'L', 'M', 'E', 'S', 'H', '\0'};
+static const uint32_t MESH_CACHE_VERSION = 1;
+static const size_t MESH_CACHE_ALIGNMENT = 64;
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    // sizeof(Vertex) when the file was written, so a change to the vertex layout invalidates it
+    uint32_t vertexSize;
+    uint64_t sourceHash;
+    uint32_t meshCount;
+    // The Assimp post processing flags the meshes were imported with
+    uint32_t importFlags;
+    uint64_t meshesOffset;
+    uint64_t pathsOffset;
+    uint64_t reserved[2];
+};
+static_assert(sizeof(MeshCacheHeader) == 64, "Mesh cache header layout must not change");
+
+struct MeshCacheEntry {
+    uint64_t verticesOffset;
+    uint64_t indicesOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    // Offsets are from pathsOffset; a length of 0 means the mesh has no such texture
+    uint32_t diffusePathOffset;
+    uint32_t diffusePathLength;
+    uint32_t specularPathOffset;
+    uint32_t specularPathLength;
+    uint64_t reserved;
+};
+static_assert(sizeof(MeshCacheEntry) == 48, "Mesh cache entry layout must not change");
+
+/**
+ * Stamp files sit beside the cache files, one per model path and named after its hash, so a model's
+ * cache file can be found without reading and hashing its sources. A stamp holds a MeshStampHeader
+ * followed by a MeshStampSource per source file, in the order they are hashed. While every source
+ * still has the recorded size and modification time, the recorded hash is taken as theirs.
+ */
+
+static const char MESH_STAMP_MAGIC[8] = {'S', 'O', 'L', 'S', 'T', 'A', 'M', 'P'};
+
+struct MeshStampHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sourceCount;
+    uint64_t sourceHash;
+    uint32_t importFlags;
+    uint32_t reserved;
+};
+static_assert(sizeof(MeshStampHeader) == 32, "Mesh stamp header layout must not change");
+
+struct MeshStampSource {
+    uint64_t size;
+    // In the filesystem's own clock ticks
+    int64_t modifiedTime;
+};
+static_assert(sizeof(MeshStampSource) == 16, "Mesh stamp source layout must not change");
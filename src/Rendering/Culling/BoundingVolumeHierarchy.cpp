@@ -0,0 +1,243 @@
+#include <Rendering/Culling/BoundingVolumeHierarchy.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    /**
+     * @brief The cone of space an occluder hides, as seen from the camera.
+     */
+    struct OcclusionCone {
+        glm::vec3 direction;
+        float distance;
+        float halfAngle;
+    };
+
+    /**
+     * @brief Checks whether a sphere is wholly hidden behind any of the occluders.
+     *
+     * A sphere is hidden if it lies entirely inside an occluder's cone and no part of it is nearer the
+     * camera than the occluder's centre; every point of the cone beyond that distance is behind the
+     * occluder's surface.
+     */
+    bool isOccluded(const std::vector<OcclusionCone>& cones, glm::vec3 eye, glm::vec3 centre, float radius) {
+        glm::vec3 toCentre = centre - eye;
+        float distance = glm::length(toCentre);
+        for (const auto& cone : cones) {
+            if (distance - radius < cone.distance) {
+                continue;
+            }
+            float cosAngle = glm::dot(toCentre, cone.direction)/distance;
+            float angle = std::acos(std::min(std::max(cosAngle, -1.0f), 1.0f));
+            if (angle + std::asin(radius/distance) <= cone.halfAngle) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    float surfaceArea(glm::vec3 boxMin, glm::vec3 boxMax) {
+        glm::vec3 size = boxMax - boxMin;
+        return 2.0f*(size.x*size.y + size.y*size.z + size.z*size.x);
+    }
+}
+
+/**
+ * @brief Builds the tree from scratch.
+ *
+ * @param instances the bodies, whose positions and radii give their bounding spheres.
+ * @param count the number of bodies.
+ */
+void BoundingVolumeHierarchy::Build(const InstanceData* instances, unsigned int count) {
+    nodes.clear();
+    bodyOrder.resize(count);
+    buildCentres.resize(count);
+    for (unsigned int i = 0; i < count; i++) {
+        bodyOrder[i] = i;
+        buildCentres[i] = instances[i].position;
+    }
+    if (count == 0) {
+        builtSurfaceArea = 0.0f;
+        return;
+    }
+
+    // A binary tree with at least one body in each leaf has fewer than 2*count nodes
+    nodes.reserve(2*((count + LEAF_SIZE - 1)/LEAF_SIZE));
+    buildNode(0, count);
+    builtSurfaceArea = refitBoxes(instances);
+}
+
+/**
+ * @brief Adds the node for a range of bodyOrder, and the nodes below it.
+ *
+ * The range is split in half at the median along the axis its centres are most spread out on.
+ *
+ * @return the index of the new node.
+ */
+unsigned int BoundingVolumeHierarchy::buildNode(unsigned int begin, unsigned int end) {
+    unsigned int index = (unsigned int)nodes.size();
+    nodes.push_back(Node());
+    if (end - begin <= LEAF_SIZE) {
+        nodes[index].firstOrRight = begin;
+        nodes[index].count = end - begin;
+        return index;
+    }
+
+    glm::vec3 centreMin = buildCentres[bodyOrder[begin]];
+    glm::vec3 centreMax = centreMin;
+    for (unsigned int i = begin + 1; i < end; i++) {
+        centreMin = glm::min(centreMin, buildCentres[bodyOrder[i]]);
+        centreMax = glm::max(centreMax, buildCentres[bodyOrder[i]]);
+    }
+    glm::vec3 spread = centreMax - centreMin;
+    int axis = 0;
+    if (spread.y > spread[axis]) {
+        axis = 1;
+    }
+    if (spread.z > spread[axis]) {
+        axis = 2;
+    }
+
+    unsigned int middle = begin + (end - begin)/2;
+    std::nth_element(bodyOrder.begin() + begin, bodyOrder.begin() + middle, bodyOrder.begin() + end,
+                     [&](unsigned int a, unsigned int b) { return buildCentres[a][axis] < buildCentres[b][axis]; });
+
+    buildNode(begin, middle);
+    unsigned int right = buildNode(middle, end);
+    nodes[index].firstOrRight = right;
+    nodes[index].count = 0;
+    return index;
+}
+
+/**
+ * @brief Recomputes every box to fit the bodies where they are now, keeping the tree's shape.
+ *
+ * Rebuilds the tree instead if the number of bodies has changed, or if the boxes have grown so loose
+ * that culling with them would no longer save much.
+ *
+ * @param instances the bodies, whose positions and radii give their bounding spheres.
+ * @param count the number of bodies.
+ */
+void BoundingVolumeHierarchy::Refit(const InstanceData* instances, unsigned int count) {
+    if (count != bodyOrder.size()) {
+        Build(instances, count);
+        return;
+    }
+    if (count == 0) {
+        return;
+    }
+    if (refitBoxes(instances) > rebuildGrowth*builtSurfaceArea) {
+        Build(instances, count);
+    }
+}
+
+/**
+ * @brief Fits every box to its bodies, from the leaves up.
+ *
+ * Children are always stored after their parent, so walking the nodes backwards reaches both
+ * children of a node before the node itself.
+ *
+ * @return the total surface area of the boxes, as a measure of how tight the tree is.
+ */
+float BoundingVolumeHierarchy::refitBoxes(const InstanceData* instances) {
+    float totalArea = 0.0f;
+    for (size_t i = nodes.size(); i-- > 0;) {
+        Node& node = nodes[i];
+        if (node.count > 0) {
+            const InstanceData& first = instances[bodyOrder[node.firstOrRight]];
+            node.boxMin = first.position - glm::vec3(first.radius);
+            node.boxMax = first.position + glm::vec3(first.radius);
+            for (unsigned int j = 1; j < node.count; j++) {
+                const InstanceData& body = instances[bodyOrder[node.firstOrRight + j]];
+                node.boxMin = glm::min(node.boxMin, body.position - glm::vec3(body.radius));
+                node.boxMax = glm::max(node.boxMax, body.position + glm::vec3(body.radius));
+            }
+        }
+        else {
+            const Node& left = nodes[i + 1];
+            const Node& right = nodes[node.firstOrRight];
+            node.boxMin = glm::min(left.boxMin, right.boxMin);
+            node.boxMax = glm::max(left.boxMax, right.boxMax);
+        }
+        totalArea += surfaceArea(node.boxMin, node.boxMax);
+    }
+    return totalArea;
+}
+
+/**
+ * @brief Finds the bodies that might be visible.
+ *
+ * Whole subtrees are skipped as soon as their box is outside the frustum or hidden behind an
+ * occluder, and subtrees wholly inside the frustum are not tested against its planes again. Both tests
+ * are conservative, so a body that is reported hidden is certainly hidden, but not the other way round.
+ *
+ * @param frustum the camera's frustum.
+ * @param occluders large spheres, such as nearby planets, that hide what is behind them.
+ * @param eye the position of the camera.
+ * @param instances the bodies, as last passed to Refit.
+ * @param visible filled with the indices of the bodies that might be visible, in no particular order.
+ */
+void BoundingVolumeHierarchy::Cull(const Frustum& frustum, const std::vector<OccluderSphere>& occluders, glm::vec3 eye,
+                                   const InstanceData* instances, std::vector<unsigned int>& visible) const {
+    visible.clear();
+    if (nodes.empty()) {
+        return;
+    }
+
+    std::vector<OcclusionCone> cones;
+    cones.reserve(occluders.size());
+    for (const auto& occluder : occluders) {
+        glm::vec3 toCentre = occluder.centre - eye;
+        float distance = glm::length(toCentre);
+        // An occluder the camera is inside would hide everything, which is never what is wanted
+        if (distance > occluder.radius) {
+            cones.push_back({toCentre/distance, distance, std::asin(occluder.radius/distance)});
+        }
+    }
+
+    // Each entry is a node index, with the top bit set once the node is known to be wholly in view
+    const unsigned int INSIDE_BIT = 1u << 31;
+    unsigned int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        unsigned int entry = stack[--stackSize];
+        bool isInside = (entry & INSIDE_BIT) != 0;
+        const Node& node = nodes[entry & ~INSIDE_BIT];
+
+        if (!isInside) {
+            Frustum::Containment containment = frustum.ClassifyBox(node.boxMin, node.boxMax);
+            if (containment == Frustum::OUTSIDE) {
+                continue;
+            }
+            isInside = containment == Frustum::INSIDE;
+        }
+        if (!cones.empty()) {
+            glm::vec3 boxCentre = 0.5f*(node.boxMin + node.boxMax);
+            float boxRadius = 0.5f*glm::length(node.boxMax - node.boxMin);
+            if (isOccluded(cones, eye, boxCentre, boxRadius)) {
+                continue;
+            }
+        }
+
+        if (node.count > 0) {
+            for (unsigned int j = 0; j < node.count; j++) {
+                unsigned int body = bodyOrder[node.firstOrRight + j];
+                const InstanceData& instance = instances[body];
+                if (!isInside && frustum.ClassifySphere(instance.position, instance.radius) == Frustum::OUTSIDE) {
+                    continue;
+                }
+                if (!cones.empty() && isOccluded(cones, eye, instance.position, instance.radius)) {
+                    continue;
+                }
+                visible.push_back(body);
+            }
+        }
+        else {
+            unsigned int insideBit = isInside ? INSIDE_BIT : 0u;
+            unsigned int index = (unsigned int)(&node - nodes.data());
+            stack[stackSize++] = node.firstOrRight | insideBit;
+            stack[stackSize++] = (index + 1) | insideBit;
+        }
+    }
+}
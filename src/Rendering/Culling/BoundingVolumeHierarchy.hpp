@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Rendering/Culling/Frustum.hpp>
+#include <Rendering/Window/InstancedMesh/InstancedMesh.hpp>
+
+/**
+ * @brief A large sphere that hides whatever is behind it from the camera.
+ */
+struct OccluderSphere {
+    glm::vec3 centre;
+    float radius;
+};
+
+/**
+ * @brief A tree of bounding boxes over the bodies, used to find which of them can be seen.
+ *
+ * The tree is built once by splitting the bodies at the median of their widest axis, and after that
+ * only its boxes are recomputed as the bodies move. Bodies that started near each other mostly stay
+ * near each other, so this is far cheaper than a rebuild and the boxes stay reasonably tight; the
+ * tree is rebuilt only once the boxes have grown too loose to be useful.
+ *
+ * Nodes are stored depth first, so a node's left child always directly follows it and its children
+ * always come after it.
+ */
+class BoundingVolumeHierarchy {
+    private:
+        struct Node {
+            glm::vec3 boxMin;
+            // For a leaf, the position in bodyOrder of its first body; otherwise the index of the right child
+            unsigned int firstOrRight;
+            glm::vec3 boxMax;
+            // The number of bodies in a leaf, or 0 for an internal node
+            unsigned int count;
+        };
+
+        std::vector<Node> nodes;
+        // Body indices, grouped so that each leaf's bodies are contiguous
+        std::vector<unsigned int> bodyOrder;
+        std::vector<glm::vec3> buildCentres;
+        float builtSurfaceArea = 0.0f;
+
+        unsigned int buildNode(unsigned int begin, unsigned int end);
+        float refitBoxes(const InstanceData* instances);
+
+    public:
+        static constexpr unsigned int LEAF_SIZE = 4;
+        // How much the total surface area of the boxes may grow, relative to when the tree was built,
+        // before it is rebuilt
+        float rebuildGrowth = 2.0f;
+
+        void Build(const InstanceData* instances, unsigned int count);
+        void Refit(const InstanceData* instances, unsigned int count);
+        void Cull(const Frustum& frustum, const std::vector<OccluderSphere>& occluders, glm::vec3 eye,
+                  const InstanceData* instances, std::vector<unsigned int>& visible) const;
+        unsigned int BodyCount() const { return (unsigned int)bodyOrder.size(); }
+};
@@ -0,0 +1,81 @@
+#include <Rendering/Culling/Frustum.hpp>
+
+/**
+ * @brief Extracts the frustum planes from a combined projection and view matrix.
+ *
+ * Every plane is a sum or difference of the matrix's last row with one of the others, as a point is in
+ * view exactly when its clip space x, y and z all lie between -w and w. The planes are normalised so
+ * that distances to them are in world units.
+ *
+ * @param cameraMatrix the camera's projection times view matrix.
+ * @return the frustum, in world space.
+ */
+Frustum Frustum::FromMatrix(const glm::mat4& cameraMatrix) {
+    // glm matrices are column-major, so row i is made of the i-th element of each column
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(cameraMatrix[0][i], cameraMatrix[1][i], cameraMatrix[2][i], cameraMatrix[3][i]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0]; // Left
+    frustum.planes[1] = rows[3] - rows[0]; // Right
+    frustum.planes[2] = rows[3] + rows[1]; // Bottom
+    frustum.planes[3] = rows[3] - rows[1]; // Top
+    frustum.planes[4] = rows[3] + rows[2]; // Near
+    frustum.planes[5] = rows[3] - rows[2]; // Far
+    for (auto& plane : frustum.planes) {
+        plane = plane*(1.0f/glm::length(glm::vec3(plane.x, plane.y, plane.z)));
+    }
+    return frustum;
+}
+
+/**
+ * @brief Works out whether a sphere is in view.
+ *
+ * @param centre the centre of the sphere, in world space.
+ * @param radius the radius of the sphere.
+ * @return whether the sphere is wholly outside, partly inside or wholly inside the frustum.
+ */
+Frustum::Containment Frustum::ClassifySphere(glm::vec3 centre, float radius) const {
+    Containment containment = INSIDE;
+    for (const auto& plane : planes) {
+        float distance = plane.x*centre.x + plane.y*centre.y + plane.z*centre.z + plane.w;
+        if (distance < -radius) {
+            return OUTSIDE;
+        }
+        if (distance < radius) {
+            containment = INTERSECTING;
+        }
+    }
+    return containment;
+}
+
+/**
+ * @brief Works out whether an axis-aligned box is in view.
+ *
+ * For each plane only the two corners furthest along and against its normal need testing. The test is
+ * conservative: a box near a corner of the frustum may be reported as intersecting when it is outside.
+ *
+ * @param boxMin the minimum corner of the box, in world space.
+ * @param boxMax the maximum corner of the box, in world space.
+ * @return whether the box is wholly outside, partly inside or wholly inside the frustum.
+ */
+Frustum::Containment Frustum::ClassifyBox(glm::vec3 boxMin, glm::vec3 boxMax) const {
+    Containment containment = INSIDE;
+    for (const auto& plane : planes) {
+        glm::vec3 furthest(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                           plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                           plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        glm::vec3 nearest(plane.x >= 0.0f ? boxMin.x : boxMax.x,
+                          plane.y >= 0.0f ? boxMin.y : boxMax.y,
+                          plane.z >= 0.0f ? boxMin.z : boxMax.z);
+        if (plane.x*furthest.x + plane.y*furthest.y + plane.z*furthest.z + plane.w < 0.0f) {
+            return OUTSIDE;
+        }
+        if (plane.x*nearest.x + plane.y*nearest.y + plane.z*nearest.z + plane.w < 0.0f) {
+            containment = INTERSECTING;
+        }
+    }
+    return containment;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief The six planes bounding what a camera can see.
+ *
+ * Each plane is stored as (normal, distance) with the normal pointing into the view, so a point p is
+ * on the visible side of a plane when dot(normal, p) + distance >= 0.
+ */
+struct Frustum {
+    enum Containment {
+        OUTSIDE,
+        INTERSECTING,
+        INSIDE
+    };
+
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& cameraMatrix);
+    Containment ClassifySphere(glm::vec3 centre, float radius) const;
+    Containment ClassifyBox(glm::vec3 boxMin, glm::vec3 boxMax) const;
+};
@@ -0,0 +1,105 @@
+#include <Rendering/GLState/GLState.hpp>
+
+namespace {
+    // Never a valid GL name, so nothing matches it until it has been bound through GLState
+    const GLuint UNKNOWN = ~0u;
+
+    // The texture targets that are tracked; each unit has a separate binding for each
+    const GLenum TARGETS[] = {GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY};
+    const int TARGET_COUNT = 2;
+
+    struct BoundState {
+        GLuint program = UNKNOWN;
+        GLuint vertexArray = UNKNOWN;
+        GLuint activeUnit = UNKNOWN;
+        GLuint textures[TARGET_COUNT][GLState::MAX_TEXTURE_UNITS];
+
+        BoundState() {
+            for (auto& targetTextures : textures) {
+                for (auto& texture : targetTextures) {
+                    texture = UNKNOWN;
+                }
+            }
+        }
+    };
+
+    // The index of a target in TARGETS, or -1 if it isn't tracked
+    int targetIndex(GLenum target) {
+        for (int i = 0; i < TARGET_COUNT; i++) {
+            if (TARGETS[i] == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    BoundState bound;
+}
+
+/**
+ * @brief Makes a program current, unless it already is.
+ */
+void GLState::UseProgram(GLuint program) {
+    if (bound.program != program) {
+        glUseProgram(program);
+        bound.program = program;
+    }
+}
+
+/**
+ * @brief Binds a vertex array, unless it already is.
+ */
+void GLState::BindVertexArray(GLuint vertexArray) {
+    if (bound.vertexArray != vertexArray) {
+        glBindVertexArray(vertexArray);
+        bound.vertexArray = vertexArray;
+    }
+}
+
+/**
+ * @brief Binds a texture to a texture unit, unless it already is.
+ *
+ * The active texture unit is only changed when a bind is actually needed. Units beyond
+ * MAX_TEXTURE_UNITS, and targets other than 2D textures and 2D texture arrays, are bound every time.
+ *
+ * @param unit the texture unit, counted from 0 rather than from GL_TEXTURE0.
+ * @param texture the texture, or 0 to unbind the unit.
+ * @param target the texture's target.
+ */
+void GLState::BindTexture(GLuint unit, GLuint texture, GLenum target) {
+    int index = targetIndex(target);
+    bool isTracked = index >= 0 && unit < MAX_TEXTURE_UNITS;
+    if (isTracked && bound.textures[index][unit] == texture) {
+        return;
+    }
+    if (bound.activeUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        bound.activeUnit = unit;
+    }
+    glBindTexture(target, texture);
+    if (isTracked) {
+        bound.textures[index][unit] = texture;
+    }
+}
+
+/**
+ * @brief Records that a texture has been deleted, which GL unbinds from every unit.
+ *
+ * Without this, a new texture reusing the name would be taken to be bound already.
+ */
+void GLState::ForgetTexture(GLuint texture) {
+    for (auto& targetTextures : bound.textures) {
+        for (auto& boundTexture : targetTextures) {
+            if (boundTexture == texture) {
+                boundTexture = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Forgets everything, so that the next bind of each kind always goes through.
+ */
+void GLState::Invalidate() {
+    bound = BoundState();
+}
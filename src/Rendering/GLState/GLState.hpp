@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/**
+ * @brief Remembers what is bound in the GL context, so that binds which would change nothing are skipped.
+ *
+ * Every bind costs a call into the driver, which validates it whether or not anything changes, and
+ * consecutive draws mostly share a program and often share a vertex array and textures. This only
+ * works if every program, vertex array and texture bind goes through here; after binding anything
+ * directly, call Invalidate.
+ *
+ * There is only one GL context, used only from the main thread, so the state is global.
+ */
+class GLState {
+    public:
+        static constexpr GLuint MAX_TEXTURE_UNITS = 16;
+
+        static void UseProgram(GLuint program);
+        static void BindVertexArray(GLuint vertexArray);
+        static void BindTexture(GLuint unit, GLuint texture, GLenum target = GL_TEXTURE_2D);
+        static void ForgetTexture(GLuint texture);
+        static void Invalidate();
+};
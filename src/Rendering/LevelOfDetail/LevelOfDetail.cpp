@@ -0,0 +1,39 @@
+#include <Rendering/LevelOfDetail/LevelOfDetail.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Angle subtended at the centre by an edge of an icosahedron; each subdivision halves it
+static const float ICOSAHEDRON_EDGE_ANGLE = 1.1071487f;
+
+/**
+ * @brief Works out the level at which a sphere's edges would be exactly the target size.
+ *
+ * @param projectedRadius the radius of the sphere on screen, in pixels.
+ * @return the ideal level, as a continuous value which may be outside the range of levels.
+ */
+float LevelOfDetail::IdealLevel(float projectedRadius) const {
+    if (projectedRadius <= 0.0f) {
+        return 0.0f;
+    }
+    return std::log2(projectedRadius*ICOSAHEDRON_EDGE_ANGLE/targetEdgePixels);
+}
+
+/**
+ * @brief Chooses the level to draw a sphere at this frame.
+ *
+ * A sphere moves up a level as soon as its edges grow past the target size, but only moves down
+ * once the level below would be finer than needed by the hysteresis margin.
+ *
+ * @param projectedRadius the radius of the sphere on screen, in pixels.
+ * @param currentLevel the level the sphere was drawn at last frame, or -1 if it hasn't been drawn yet.
+ * @return the level to draw the sphere at.
+ */
+int LevelOfDetail::SelectLevel(float projectedRadius, int currentLevel) const {
+    float ideal = IdealLevel(projectedRadius);
+    int level = (int)std::ceil(ideal);
+    if (currentLevel >= 0 && level < currentLevel && ideal > (float)(currentLevel - 1) - hysteresis) {
+        level = currentLevel;
+    }
+    return std::min(std::max(level, 0), maxLevel);
+}
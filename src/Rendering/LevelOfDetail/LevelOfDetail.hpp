@@ -0,0 +1,22 @@
+#pragma once
+
+/**
+ * @brief Picks the subdivision level of an icosphere from how large it appears on screen.
+ *
+ * The aim is to keep the triangles' edges roughly the same size on screen whatever the distance, so
+ * a sphere a few pixels across is drawn as the bare 20 triangle icosahedron. Levels only change once
+ * a sphere has moved a little way past a switching point, so bodies hovering around one don't flicker
+ * between levels.
+ */
+class LevelOfDetail {
+    public:
+        int maxLevel = 6;
+        // Screen length, in pixels, of the triangle edges to aim for
+        float targetEdgePixels = 6.0f;
+        // How far past a switching point, in levels, a sphere must go before it drops a level
+        float hysteresis = 0.3f;
+
+        float IdealLevel(float projectedRadius) const;
+        int SelectLevel(float projectedRadius, int currentLevel) const;
+        int LevelCount() const { return maxLevel + 1; }
+};
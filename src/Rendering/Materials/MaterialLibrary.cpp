@@ -0,0 +1,302 @@
+#include <Rendering/Materials/MaterialLibrary.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <Rendering/GLState/GLState.hpp>
+#include <Utilities/Utilities.hpp>
+
+/**
+ * @brief Resizes an RGBA image with bilinear filtering.
+ */
+static std::vector<unsigned char> resample(const unsigned char* pixels, int width, int height, int newWidth, int newHeight) {
+    std::vector<unsigned char> resampled((size_t)newWidth*newHeight*4);
+    for (int y = 0; y < newHeight; y++) {
+        float sourceY = std::min(std::max((y + 0.5f)*height/newHeight - 0.5f, 0.0f), (float)(height - 1));
+        int y0 = (int)sourceY;
+        int y1 = std::min(y0 + 1, height - 1);
+        float fy = sourceY - y0;
+        for (int x = 0; x < newWidth; x++) {
+            float sourceX = std::min(std::max((x + 0.5f)*width/newWidth - 0.5f, 0.0f), (float)(width - 1));
+            int x0 = (int)sourceX;
+            int x1 = std::min(x0 + 1, width - 1);
+            float fx = sourceX - x0;
+            for (int c = 0; c < 4; c++) {
+                float top = pixels[((size_t)y0*width + x0)*4 + c]*(1.0f - fx) + pixels[((size_t)y0*width + x1)*4 + c]*fx;
+                float bottom = pixels[((size_t)y1*width + x0)*4 + c]*(1.0f - fx) + pixels[((size_t)y1*width + x1)*4 + c]*fx;
+                resampled[((size_t)y*newWidth + x)*4 + c] = (unsigned char)(top*(1.0f - fy) + bottom*fy + 0.5f);
+            }
+        }
+    }
+    return resampled;
+}
+
+/**
+ * @brief Halves a square RGBA image, averaging each 2x2 block.
+ */
+static std::vector<unsigned char> halve(const std::vector<unsigned char>& pixels, int size) {
+    int newSize = size/2;
+    std::vector<unsigned char> halved((size_t)newSize*newSize*4);
+    for (int y = 0; y < newSize; y++) {
+        for (int x = 0; x < newSize; x++) {
+            for (int c = 0; c < 4; c++) {
+                int sum = pixels[((size_t)(2*y)*size + 2*x)*4 + c] + pixels[((size_t)(2*y)*size + 2*x + 1)*4 + c]
+                        + pixels[((size_t)(2*y + 1)*size + 2*x)*4 + c] + pixels[((size_t)(2*y + 1)*size + 2*x + 1)*4 + c];
+                halved[((size_t)y*newSize + x)*4 + c] = (unsigned char)((sum + 2)/4);
+            }
+        }
+    }
+    return halved;
+}
+
+/**
+ * @brief Number of mip levels of an array's layers, down to 1x1.
+ */
+static int levelCount(int array) {
+    int levels = 1;
+    for (int size = MaterialLibrary::ARRAY_SIZES[array]; size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+/**
+ * @brief Creates the material table, with only the plain material in it, and binds it to
+ * Shader::MATERIAL_DATA_BINDING for good.
+ *
+ * The whole table is allocated up front, as the shaders' block is declared at its full size.
+ */
+MaterialLibrary::MaterialLibrary() {
+    std::vector<MaterialData> table(MAX_MATERIALS, MaterialData{-1, -1, -1, -1});
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, table.size()*sizeof(MaterialData), table.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, Shader::MATERIAL_DATA_BINDING, UBO);
+
+    glGenBuffers(1, &PBO);
+    glGenFramebuffers(1, &copyFramebuffer);
+    glCheckError();
+
+    materials.push_back({-1, -1});
+}
+
+/**
+ * @brief Adds a texture, which samples as plain white until its image is uploaded.
+ *
+ * @return the texture's index, to pass to AddMaterial and UploadTexture.
+ */
+int MaterialLibrary::AddTexture() {
+    textures.push_back(TextureSlot());
+    return (int)textures.size() - 1;
+}
+
+/**
+ * @brief Adds a material, unless one with the same textures already exists.
+ *
+ * @param diffuseTexture the index of the diffuse texture, or -1 for none.
+ * @param specularTexture the index of the specular texture, or -1 for none.
+ * @return the material's index, for Mesh::material.
+ */
+unsigned int MaterialLibrary::AddMaterial(int diffuseTexture, int specularTexture) {
+    for (unsigned int i = 0; i < materials.size(); i++) {
+        if (materials[i].diffuseTexture == diffuseTexture && materials[i].specularTexture == specularTexture) {
+            return i;
+        }
+    }
+    if (materials.size() >= MAX_MATERIALS) {
+        outputError("Too many materials (at most " + std::to_string(MAX_MATERIALS) + "), using the plain material instead");
+        return PLAIN_MATERIAL;
+    }
+    materials.push_back({diffuseTexture, specularTexture});
+    writeMaterial((unsigned int)materials.size() - 1);
+    return (unsigned int)materials.size() - 1;
+}
+
+/**
+ * @brief Gets a decoded image ready to upload. Safe to call from any thread.
+ *
+ * The image is resized to the array size nearest its own, flipped so that its first row is the
+ * bottom, as GL expects, and given its full chain of mip levels, so the GL thread only has to copy it.
+ *
+ * @param pixels the image, RGBA, top row first.
+ * @param width the width of the image.
+ * @param height the height of the image.
+ */
+TextureImage MaterialLibrary::PrepareImage(const unsigned char* pixels, int width, int height) {
+    TextureImage image;
+    float logSize = 0.5f*std::log2((float)width*height);
+    float nearestDifference = INFINITY;
+    for (unsigned int i = 0; i < Shader::TEXTURE_ARRAY_COUNT; i++) {
+        float difference = std::fabs(std::log2((float)ARRAY_SIZES[i]) - logSize);
+        if (difference < nearestDifference) {
+            image.array = (int)i;
+            nearestDifference = difference;
+        }
+    }
+
+    int size = ARRAY_SIZES[image.array];
+    std::vector<unsigned char> level;
+    if (width == size && height == size) {
+        level.assign(pixels, pixels + (size_t)size*size*4);
+    }
+    else {
+        level = resample(pixels, width, height, size, size);
+    }
+    size_t rowBytes = (size_t)size*4;
+    for (int y = 0; y < size/2; y++) {
+        std::swap_ranges(level.begin() + y*rowBytes, level.begin() + (y + 1)*rowBytes, level.begin() + (size - 1 - y)*rowBytes);
+    }
+
+    image.levels.push_back(std::move(level));
+    for (; size > 1; size /= 2) {
+        image.levels.push_back(halve(image.levels.back(), size));
+    }
+    return image;
+}
+
+/**
+ * @brief Copies a prepared image into the next free layer of its array, and points every material
+ * that uses the texture at it.
+ *
+ * The pixels are staged in a freshly orphaned pixel unpack buffer, so the copy to the array happens on
+ * the GPU's time and the driver never waits on a previous upload.
+ *
+ * @param texture the texture's index, from AddTexture.
+ * @param image the texture's image, from PrepareImage.
+ */
+void MaterialLibrary::UploadTexture(int texture, const TextureImage& image) {
+    if (texture < 0 || texture >= (int)textures.size() || image.array < 0) {
+        return;
+    }
+
+    TextureArray& array = arrays[image.array];
+    if (array.layerCount == array.layerCapacity) {
+        growArray(image.array);
+    }
+    int layer = array.layerCount++;
+
+    size_t totalBytes = 0;
+    for (const auto& level : image.levels) {
+        totalBytes += level.size();
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+    unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    size_t offset = 0;
+    for (const auto& level : image.levels) {
+        std::memcpy(mapped + offset, level.data(), level.size());
+        offset += level.size();
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    GLState::BindTexture(image.array, array.id, GL_TEXTURE_2D_ARRAY);
+    offset = 0;
+    int size = ARRAY_SIZES[image.array];
+    for (unsigned int level = 0; level < image.levels.size(); level++) {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void*)offset);
+        offset += image.levels[level].size();
+        size = std::max(size/2, 1);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glCheckError();
+
+    textures[texture].array = image.array;
+    textures[texture].layer = layer;
+    for (unsigned int i = 0; i < materials.size(); i++) {
+        if (materials[i].diffuseTexture == texture || materials[i].specularTexture == texture) {
+            writeMaterial(i);
+        }
+    }
+}
+
+/**
+ * @brief Replaces an array with one of twice as many layers, copying the old layers across.
+ *
+ * GL 3.3 has no direct copy between textures, so each layer and level is attached to a framebuffer
+ * and copied from there.
+ */
+void MaterialLibrary::growArray(int array) {
+    TextureArray& old = arrays[array];
+    int size = ARRAY_SIZES[array];
+    int levels = levelCount(array);
+    int capacity = std::max(INITIAL_LAYER_CAPACITY, 2*old.layerCapacity);
+
+    GLuint id;
+    glGenTextures(1, &id);
+    GLState::BindTexture(array, id, GL_TEXTURE_2D_ARRAY);
+    for (int level = 0; level < levels; level++) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, std::max(size >> level, 1), std::max(size >> level, 1), capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    if (old.id != 0) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFramebuffer);
+        for (int layer = 0; layer < old.layerCount; layer++) {
+            for (int level = 0; level < levels; level++) {
+                glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, old.id, level, layer);
+                glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, 0, 0, std::max(size >> level, 1), std::max(size >> level, 1));
+            }
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glDeleteTextures(1, &old.id);
+        GLState::ForgetTexture(old.id);
+        // ForgetTexture cleared the unit, so bind the new array there again
+        GLState::BindTexture(array, id, GL_TEXTURE_2D_ARRAY);
+    }
+    glCheckError();
+
+    old.id = id;
+    old.layerCapacity = capacity;
+}
+
+/**
+ * @brief Copies one material's entry in the table to the GPU.
+ */
+void MaterialLibrary::writeMaterial(unsigned int material) {
+    MaterialData data = {-1, -1, -1, -1};
+    int diffuse = materials[material].diffuseTexture;
+    int specular = materials[material].specularTexture;
+    if (diffuse >= 0) {
+        data.diffuseArray = textures[diffuse].array;
+        data.diffuseLayer = textures[diffuse].layer;
+    }
+    if (specular >= 0) {
+        data.specularArray = textures[specular].array;
+        data.specularLayer = textures[specular].layer;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, material*sizeof(MaterialData), sizeof(MaterialData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/**
+ * @brief Binds every texture array to its unit. The material table stays bound from construction.
+ *
+ * Call once a frame before drawing; nothing else needs binding for any material.
+ */
+void MaterialLibrary::Bind() {
+    for (unsigned int i = 0; i < Shader::TEXTURE_ARRAY_COUNT; i++) {
+        if (arrays[i].id != 0) {
+            GLState::BindTexture(i, arrays[i].id, GL_TEXTURE_2D_ARRAY);
+        }
+    }
+}
+
+void MaterialLibrary::Delete() {
+    for (auto& array : arrays) {
+        if (array.id != 0) {
+            glDeleteTextures(1, &array.id);
+            GLState::ForgetTexture(array.id);
+        }
+    }
+    glDeleteBuffers(1, &UBO);
+    glDeleteBuffers(1, &PBO);
+    glDeleteFramebuffers(1, &copyFramebuffer);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <Shader/Shader.hpp>
+
+/**
+ * @brief Where a material's textures are, laid out to match the std140 MaterialData block in the shaders.
+ *
+ * Each texture is a layer of one of the texture arrays; -1 means the material has no such texture, or
+ * it hasn't been uploaded yet, and is sampled as plain white.
+ */
+struct MaterialData {
+    GLint diffuseArray;
+    GLint diffuseLayer;
+    GLint specularArray;
+    GLint specularLayer;
+};
+
+/**
+ * @brief A decoded texture, resized to fit its texture array, with every mip level.
+ *
+ * Made off the GL thread by MaterialLibrary::PrepareImage, then uploaded by UploadTexture.
+ */
+struct TextureImage {
+    // The array the image was sized for, or -1 if it couldn't be decoded
+    int array = -1;
+    // RGBA, level 0 first, each level half the size of the one before, down to 1x1
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+/**
+ * @brief Every texture and material in the scene, packed so that one bind serves every draw.
+ *
+ * Textures are gathered into a few 2D texture arrays, one per size in ARRAY_SIZES, and the materials
+ * into a uniform buffer table. Meshes only hold an index into the table, which the shaders look up to
+ * find the array and layer to sample, so nothing needs binding between draws.
+ *
+ * Textures are added as soon as something needs them and uploaded whenever their image is ready, so
+ * a material can be drawn before its textures have loaded; until then they sample as plain white.
+ */
+class MaterialLibrary {
+    private:
+        struct TextureSlot {
+            int array = -1;
+            int layer = -1;
+        };
+
+        struct Material {
+            int diffuseTexture;
+            int specularTexture;
+        };
+
+        struct TextureArray {
+            GLuint id = 0;
+            int layerCount = 0;
+            int layerCapacity = 0;
+        };
+
+        std::vector<TextureSlot> textures;
+        std::vector<Material> materials;
+        TextureArray arrays[Shader::TEXTURE_ARRAY_COUNT];
+        GLuint UBO = 0;
+        // Pixel unpack buffer that uploads are staged through
+        GLuint PBO = 0;
+        // Used to copy layers when an array grows
+        GLuint copyFramebuffer = 0;
+
+        void growArray(int array);
+        void writeMaterial(unsigned int material);
+
+    public:
+        static constexpr unsigned int MAX_MATERIALS = 256;
+        // Material 0 has no textures, for meshes that are coloured by their vertices alone
+        static constexpr unsigned int PLAIN_MATERIAL = 0;
+        // Width and height of each array's layers; textures are resized to the nearest
+        static constexpr int ARRAY_SIZES[Shader::TEXTURE_ARRAY_COUNT] = {256, 512, 1024, 2048};
+        // Layers an array is created with; it doubles whenever it fills up
+        static constexpr int INITIAL_LAYER_CAPACITY = 4;
+
+        MaterialLibrary();
+
+        MaterialLibrary(const MaterialLibrary&) = delete;
+        MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+
+        int AddTexture();
+        unsigned int AddMaterial(int diffuseTexture, int specularTexture);
+        void UploadTexture(int texture, const TextureImage& image);
+        void Bind();
+        void Delete();
+
+        static TextureImage PrepareImage(const unsigned char* pixels, int width, int height);
+
+        unsigned int MaterialCount() const { return (unsigned int)materials.size(); }
+};
@@ -0,0 +1,88 @@
+#include <Rendering/Particles/ParticleCloud.hpp>
+
+#include <cstdint>
+
+#include <Rendering/GLState/GLState.hpp>
+#include <Utilities/Utilities.hpp>
+
+ParticleCloud::ParticleCloud() {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glCheckError();
+}
+
+/**
+ * @brief Reallocates the buffer and points the attributes at its six arrays.
+ *
+ * Attributes 0 to 2 are the previous x, y and z, and 3 to 5 the current ones. Each array is capacity
+ * floats long, so the attributes move whenever the capacity changes.
+ *
+ * @param newCapacity the number of particles the buffer can hold.
+ */
+void ParticleCloud::resize(GLsizei newCapacity) {
+    capacity = newCapacity;
+    GLState::BindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, 6*(GLsizeiptr)capacity*sizeof(float), nullptr, GL_STREAM_DRAW);
+    for (GLuint attribute = 0; attribute < 6; attribute++) {
+        glVertexAttribPointer(attribute, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)((uintptr_t)attribute*capacity*sizeof(float)));
+        glEnableVertexAttribArray(attribute);
+    }
+    GLState::BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glCheckError();
+}
+
+/**
+ * @brief Replaces the positions to draw.
+ *
+ * The buffer is only reallocated when it needs to grow; otherwise it is orphaned and refilled, so the
+ * driver doesn't have to wait for the previous frame's draw to finish with it.
+ *
+ * @param previous the x, y and z arrays of where the particles were one step ago.
+ * @param current the x, y and z arrays of where the particles are now.
+ * @param count the number of particles.
+ */
+void ParticleCloud::SetPositions(const float* const previous[3], const float* const current[3], GLsizei count) {
+    particleCount = count;
+    if (count == 0) {
+        return;
+    }
+    if (count > capacity) {
+        resize(count);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, 6*(GLsizeiptr)capacity*sizeof(float), nullptr, GL_STREAM_DRAW);
+    GLsizeiptr arraySize = (GLsizeiptr)capacity*sizeof(float);
+    for (int i = 0; i < 3; i++) {
+        glBufferSubData(GL_ARRAY_BUFFER, i*arraySize, count*sizeof(float), previous[i]);
+        glBufferSubData(GL_ARRAY_BUFFER, (3 + i)*arraySize, count*sizeof(float), current[i]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glCheckError();
+}
+
+/**
+ * @brief Draws every particle as a point.
+ *
+ * @param shader the shader to draw with; must take the particle attributes.
+ * @param interpolation how far between the previous and current positions to draw, from 0 to 1.
+ */
+void ParticleCloud::Draw(Shader& shader, float interpolation) {
+    if (particleCount == 0) {
+        return;
+    }
+
+    shader.Activate();
+    glUniform1f(shader.GetUniformLocation("interpolation"), interpolation);
+    GLState::BindVertexArray(VAO);
+    glPointSize(pointSize);
+    glDrawArrays(GL_POINTS, 0, particleCount);
+    glCheckError();
+}
+
+void ParticleCloud::Delete() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+}
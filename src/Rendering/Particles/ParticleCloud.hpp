@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <Shader/Shader.hpp>
+
+/**
+ * @brief Draws a large number of test particles as points, in a single draw call.
+ *
+ * Particles are far too numerous to draw as spheres, and far too small to need to be. Their previous
+ * and current positions are streamed into one buffer as six float arrays, straight from the physics
+ * snapshot's layout, and the vertex shader interpolates between them (see shaders/particle.vert), so
+ * the CPU only copies memory.
+ */
+class ParticleCloud {
+    private:
+        GLuint VAO = 0;
+        GLuint VBO = 0;
+        GLsizei particleCount = 0;
+        GLsizei capacity = 0;
+
+        void resize(GLsizei newCapacity);
+
+    public:
+        float pointSize = 2.0f;
+
+        ParticleCloud();
+
+        void SetPositions(const float* const previous[3], const float* const current[3], GLsizei count);
+        void Draw(Shader& shader, float interpolation);
+        void Delete();
+};
@@ -0,0 +1,98 @@
+#include <Rendering/RenderQueue/RenderQueue.hpp>
+
+#include <algorithm>
+
+#include <Rendering/GLState/GLState.hpp>
+#include <Utilities/Utilities.hpp>
+
+/**
+ * @brief Builds a draw's sort key.
+ *
+ * Program names and material indices are truncated to fit their fields. Values that collide only
+ * cost some batching, as the draws still bind their own state.
+ *
+ * @param pass the pass the draw belongs to.
+ * @param program the shader program's name.
+ * @param material the draw's index into the MaterialLibrary's table.
+ * @param depth the draw's distance from the camera, as a fraction of the far plane distance.
+ * @return the key.
+ */
+uint64_t RenderQueue::MakeKey(Pass pass, GLuint program, GLuint material, float depth) {
+    const uint64_t DEPTH_STEPS = (1u << 24) - 1;
+    uint64_t quantisedDepth = (uint64_t)(std::min(std::max(depth, 0.0f), 1.0f)*DEPTH_STEPS);
+    return ((uint64_t)(pass & 0xF) << 60)
+         | ((uint64_t)(program & 0xFFF) << 48)
+         | ((uint64_t)(material & 0xFFFFFF) << 24)
+         | quantisedDepth;
+}
+
+void RenderQueue::Clear() {
+    commands.clear();
+    entries.clear();
+}
+
+void RenderQueue::Add(uint64_t key, const DrawCommand& command) {
+    entries.push_back({key, (unsigned int)commands.size()});
+    commands.push_back(command);
+}
+
+/**
+ * @brief Sorts the draws by key.
+ *
+ * A least significant digit radix sort, a byte at a time, which is stable and linear in the number of
+ * draws. Bytes that are the same in every key, such as the pass while there is only one, are skipped.
+ */
+void RenderQueue::Sort() {
+    scratch.resize(entries.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (const auto& entry : entries) {
+            counts[(entry.key >> shift) & 0xFF]++;
+        }
+        if (counts[(entries.empty() ? 0 : entries[0].key >> shift) & 0xFF] == entries.size()) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& count : counts) {
+            size_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+        for (const auto& entry : entries) {
+            scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+/**
+ * @brief Issues every draw, in sorted order.
+ *
+ * Programs and vertex arrays go through GLState, which skips binds that change nothing. The
+ * MaterialLibrary must already be bound.
+ *
+ * @param objects the frame's object data, already uploaded.
+ */
+void RenderQueue::Submit(ObjectUniformRing& objects) {
+    for (const auto& entry : entries) {
+        const DrawCommand& command = commands[entry.command];
+
+        command.shader->Activate();
+        GLState::BindVertexArray(command.vertexArray);
+        if (command.object != NO_OBJECT) {
+            objects.Bind(command.object);
+        }
+
+        if (command.instanceCount > 0) {
+            glDrawElementsInstanced(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, 0, command.instanceCount);
+        }
+        else if (command.baseVertex != 0) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, 0, command.baseVertex);
+        }
+        else {
+            glDrawElements(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, 0);
+        }
+    }
+    glCheckError();
+}
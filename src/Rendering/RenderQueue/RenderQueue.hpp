@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <Rendering/UniformBuffers/ObjectUniformRing.hpp>
+#include <Shader/Shader.hpp>
+
+/**
+ * @brief Everything needed to issue one draw call.
+ *
+ * Whatever is pointed to must stay alive until the queue has been submitted.
+ */
+struct DrawCommand {
+    Shader* shader;
+    GLuint vertexArray;
+    // The draw's ObjectData in the frame's ObjectUniformRing, or RenderQueue::NO_OBJECT if it doesn't use one
+    unsigned int object;
+    GLsizei indexCount;
+    GLint baseVertex;
+    // 0 for a draw that isn't instanced
+    GLsizei instanceCount;
+};
+
+/**
+ * @brief Collects a frame's draws, sorts them by the state they need and submits them in that order.
+ *
+ * Each draw carries a 64-bit sort key, most significant first:
+ *
+ *   | pass (4 bits) | program (12 bits) | material (24 bits) | depth (24 bits) |
+ *
+ * so draws are grouped by pass, then by program, then by material, and within a group run front to
+ * back so that the depth test can reject hidden fragments early. The order draws are added in makes
+ * no difference, and the fewest possible program changes are made. Materials need no binds of their
+ * own, as every texture is in the MaterialLibrary's arrays, but grouping by them keeps neighbouring
+ * draws sampling the same layers.
+ */
+class RenderQueue {
+    private:
+        struct SortEntry {
+            uint64_t key;
+            unsigned int command;
+        };
+
+        std::vector<DrawCommand> commands;
+        std::vector<SortEntry> entries;
+        std::vector<SortEntry> scratch;
+
+    public:
+        enum Pass : unsigned int {
+            OPAQUE_PASS = 0
+        };
+
+        static constexpr unsigned int NO_OBJECT = ~0u;
+
+        static uint64_t MakeKey(Pass pass, GLuint program, GLuint material, float depth);
+
+        void Clear();
+        void Add(uint64_t key, const DrawCommand& command);
+        void Sort();
+        void Submit(ObjectUniformRing& objects);
+        size_t Size() const { return commands.size(); }
+};
@@ -0,0 +1,372 @@
+#include <Rendering/Terrain/PlanetTerrain.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <Rendering/Materials/MaterialLibrary.hpp>
+#include <Utilities/Utilities.hpp>
+
+static const int FACE_COUNT = 6;
+static const int NOISE_OCTAVES = 10;
+static const size_t MAX_PENDING_PATCHES = 64;
+
+// Outward normal and the two in-plane axes of each cube face, chosen so that cross(u, v) = normal
+static const glm::vec3 FACE_NORMALS[FACE_COUNT] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+static const glm::vec3 FACE_U[FACE_COUNT] = {{0, 0, -1}, {0, 0, 1}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0}, {-1, 0, 0}};
+
+/**
+ * @brief Maps a point on a cube face to the unit sphere.
+ *
+ * Uses the spherified cube mapping rather than just normalising, which keeps patches much closer to
+ * the same size across each face.
+ *
+ * @param face the cube face.
+ * @param u, v the position on the face, each from -1 to 1.
+ * @return the direction from the centre of the sphere.
+ */
+static glm::vec3 cubeToSphere(int face, float u, float v) {
+    glm::vec3 normal = FACE_NORMALS[face];
+    glm::vec3 uAxis = FACE_U[face];
+    glm::vec3 p = normal + u*uAxis + v*glm::cross(normal, uAxis);
+    glm::vec3 squared = p*p;
+    return glm::vec3(p.x*std::sqrt(1.0f - 0.5f*squared.y - 0.5f*squared.z + squared.y*squared.z/3.0f),
+                     p.y*std::sqrt(1.0f - 0.5f*squared.z - 0.5f*squared.x + squared.z*squared.x/3.0f),
+                     p.z*std::sqrt(1.0f - 0.5f*squared.x - 0.5f*squared.y + squared.x*squared.y/3.0f));
+}
+
+/**
+ * @brief Hashes a lattice point to a value from -1 to 1.
+ */
+static float latticeValue(int x, int y, int z, unsigned int seed) {
+    uint32_t hash = seed*0x9E3779B9u;
+    hash ^= (uint32_t)x*0x85EBCA6Bu;
+    hash = (hash ^ (hash >> 15))*0xC2B2AE35u;
+    hash ^= (uint32_t)y*0x27D4EB2Fu;
+    hash = (hash ^ (hash >> 13))*0x165667B1u;
+    hash ^= (uint32_t)z*0xD3A2646Cu;
+    hash = (hash ^ (hash >> 16))*0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    return (float)(hash & 0xFFFFFF)/(float)0x7FFFFF - 1.0f;
+}
+
+/**
+ * @brief Smoothly interpolated value noise.
+ */
+static float valueNoise(glm::vec3 p, unsigned int seed) {
+    glm::vec3 floored(std::floor(p.x), std::floor(p.y), std::floor(p.z));
+    glm::vec3 f = p - floored;
+    glm::vec3 w = f*f*(3.0f - 2.0f*f);
+    int x = (int)floored.x, y = (int)floored.y, z = (int)floored.z;
+
+    float c000 = latticeValue(x, y, z, seed),         c100 = latticeValue(x + 1, y, z, seed);
+    float c010 = latticeValue(x, y + 1, z, seed),     c110 = latticeValue(x + 1, y + 1, z, seed);
+    float c001 = latticeValue(x, y, z + 1, seed),     c101 = latticeValue(x + 1, y, z + 1, seed);
+    float c011 = latticeValue(x, y + 1, z + 1, seed), c111 = latticeValue(x + 1, y + 1, z + 1, seed);
+
+    float c00 = c000 + w.x*(c100 - c000), c10 = c010 + w.x*(c110 - c010);
+    float c01 = c001 + w.x*(c101 - c001), c11 = c011 + w.x*(c111 - c011);
+    float c0 = c00 + w.y*(c10 - c00), c1 = c01 + w.y*(c11 - c01);
+    return c0 + w.z*(c1 - c0);
+}
+
+/**
+ * @brief Height of the terrain above the base radius, from -1 to 1, in a given direction.
+ *
+ * A fixed number of octaves is summed whatever the patch level, so neighbouring patches at different
+ * levels sample exactly the same surface.
+ */
+static float terrainHeight(glm::vec3 direction, unsigned int seed) {
+    float height = 0.0f;
+    float amplitude = 0.5f;
+    float frequency = 2.0f;
+    for (int octave = 0; octave < NOISE_OCTAVES; octave++) {
+        height += amplitude*valueNoise(direction*frequency, seed + octave);
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    return height;
+}
+
+static glm::vec3 terrainColour(float height) {
+    glm::vec3 lowland(0.28f, 0.42f, 0.22f);
+    glm::vec3 highland(0.52f, 0.46f, 0.40f);
+    glm::vec3 snow(0.95f, 0.95f, 0.97f);
+    float t = std::min(std::max(0.5f + height, 0.0f), 1.0f);
+    if (t < 0.75f) {
+        return glm::mix(lowland, highland, t/0.75f);
+    }
+    return glm::mix(highland, snow, (t - 0.75f)/0.25f);
+}
+
+/**
+ * @brief Creates the terrain for a planet and uploads the six root patches, which always stay resident.
+ *
+ * @param planetIndex the index of the planet, which must be unique among terrains sharing a pool.
+ * @param radius the radius of the planet.
+ * @param seed the seed for the planet's terrain.
+ * @param pool the pool to keep patch meshes in.
+ * @param jobSystem the job system to generate patches on, which should not be the one the physics runs on.
+ */
+PlanetTerrain::PlanetTerrain(unsigned int planetIndex, float radius, unsigned int seed, TerrainPatchPool& pool, JobSystem& jobSystem) :
+    planetIndex(planetIndex), radius(radius), seed(seed), pool(pool), jobSystem(jobSystem) {
+    for (int face = 0; face < FACE_COUNT; face++) {
+        uint64_t key = patchKey(face, 0, 0, 0);
+        int slot = pool.Allocate(key, true);
+        if (slot < 0) {
+            outputError("Terrain patch pool is too small for the root patches");
+            continue;
+        }
+        pool.Upload(slot, generatePatch(key, radius, elevation, seed));
+    }
+}
+
+/**
+ * @brief Packs a patch's planet, face, level and position in its face into a unique key.
+ */
+uint64_t PlanetTerrain::patchKey(int face, int level, uint32_t x, uint32_t y) const {
+    return ((uint64_t)(planetIndex & 0xFF) << 56) | ((uint64_t)face << 53) | ((uint64_t)level << 48) | ((uint64_t)x << 24) | (uint64_t)y;
+}
+
+/**
+ * @brief Gets the triangle indices of a patch, which are the same for every patch.
+ *
+ * The grid includes a ring of skirt vertices around the edge, so the skirt is just the outermost
+ * ring of quads.
+ */
+std::vector<unsigned int> PlanetTerrain::PatchIndices() {
+    const unsigned int size = PATCH_RESOLUTION + 2;
+    std::vector<unsigned int> indices;
+    indices.reserve((size - 1)*(size - 1)*6);
+    for (unsigned int j = 0; j + 1 < size; j++) {
+        for (unsigned int i = 0; i + 1 < size; i++) {
+            unsigned int corner = j*size + i;
+            indices.push_back(corner);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + size + 1);
+            indices.push_back(corner);
+            indices.push_back(corner + size + 1);
+            indices.push_back(corner + size);
+        }
+    }
+    return indices;
+}
+
+/**
+ * @brief Builds the mesh for a patch. Safe to call from any thread.
+ *
+ * Positions are sampled on a grid one vertex wider than the patch on every side. The extra ring is
+ * only used for the normals, so they are continuous across patch edges, and then becomes the skirt:
+ * a copy of the patch's edge pulled down towards the centre of the planet.
+ *
+ * @param key the patch's key.
+ * @param radius the base radius of the planet.
+ * @param elevation the height of the tallest mountains, as a fraction of the radius.
+ * @param seed the seed for the planet's terrain.
+ * @return the patch's vertices, relative to the centre of the planet.
+ */
+std::vector<Vertex> PlanetTerrain::generatePatch(uint64_t key, float radius, float elevation, unsigned int seed) {
+    int face = (int)((key >> 53) & 0x7);
+    int level = (int)((key >> 48) & 0x1F);
+    uint32_t x = (uint32_t)((key >> 24) & 0xFFFFFF);
+    uint32_t y = (uint32_t)(key & 0xFFFFFF);
+
+    const int size = PATCH_RESOLUTION + 2;
+    float patchSize = 2.0f/(float)(1u << level);
+    float step = patchSize/(float)(PATCH_RESOLUTION - 1);
+    float u0 = -1.0f + x*patchSize - step;
+    float v0 = -1.0f + y*patchSize - step;
+
+    std::vector<glm::vec3> positions(size*size);
+    std::vector<float> heights(size*size);
+    for (int j = 0; j < size; j++) {
+        for (int i = 0; i < size; i++) {
+            glm::vec3 direction = glm::normalize(cubeToSphere(face, u0 + i*step, v0 + j*step));
+            float height = terrainHeight(direction, seed);
+            heights[j*size + i] = height;
+            positions[j*size + i] = direction*radius*(1.0f + elevation*height);
+        }
+    }
+
+    // Deep enough to cover the largest height difference across a patch edge
+    float skirtDepth = radius*std::max(elevation, 0.5f*patchSize);
+
+    std::vector<Vertex> vertices(size*size);
+    for (int j = 0; j < size; j++) {
+        for (int i = 0; i < size; i++) {
+            int innerColumn = std::min(std::max(i, 1), size - 2);
+            int innerRow = std::min(std::max(j, 1), size - 2);
+            int inner = innerRow*size + innerColumn;
+
+            glm::vec3 tangentU = positions[inner + 1] - positions[inner - 1];
+            glm::vec3 tangentV = positions[inner + size] - positions[inner - size];
+
+            Vertex& vertex = vertices[j*size + i];
+            vertex.position = positions[inner];
+            if (inner != j*size + i) {
+                vertex.position -= glm::normalize(positions[inner])*skirtDepth;
+            }
+            vertex.normal = glm::normalize(glm::cross(tangentU, tangentV));
+            vertex.colour = terrainColour(heights[inner]);
+            vertex.textureCoords = glm::vec2(0.0f, 0.0f);
+        }
+    }
+    return vertices;
+}
+
+/**
+ * @brief Decides whether a patch is too coarse for how close the camera is.
+ */
+bool PlanetTerrain::shouldSplit(int face, int level, uint32_t x, uint32_t y, glm::vec3 cameraPosition) const {
+    float patchSize = 2.0f/(float)(1u << level);
+    glm::vec3 direction = glm::normalize(cubeToSphere(face, -1.0f + (x + 0.5f)*patchSize, -1.0f + (y + 0.5f)*patchSize));
+    glm::vec3 patchCentre = centre + direction*radius;
+    // A face spans a quarter of the way around the sphere
+    float width = radius*1.5707963f/(float)(1u << level);
+    return glm::length(cameraPosition - patchCentre) < splitDistance*width;
+}
+
+/**
+ * @brief Walks the quadtree under a resident patch, adding the patches to draw this frame.
+ *
+ * A patch is only replaced by its children once all four are resident, so the surface never has holes.
+ * Children that are wanted but missing are requested.
+ */
+void PlanetTerrain::selectPatches(int face, int level, uint32_t x, uint32_t y, int slot, glm::vec3 cameraPosition) {
+    if (level < maxLevel && shouldSplit(face, level, x, y, cameraPosition)) {
+        int childSlots[4];
+        bool areChildrenResident = true;
+        for (int c = 0; c < 4; c++) {
+            uint64_t childKey = patchKey(face, level + 1, 2*x + (c & 1), 2*y + (c >> 1));
+            childSlots[c] = pool.Find(childKey);
+            if (childSlots[c] < 0) {
+                request(childKey);
+                areChildrenResident = false;
+            }
+        }
+        if (areChildrenResident) {
+            for (int c = 0; c < 4; c++) {
+                selectPatches(face, level + 1, 2*x + (c & 1), 2*y + (c >> 1), childSlots[c], cameraPosition);
+            }
+            return;
+        }
+    }
+    drawList.push_back((unsigned int)slot);
+}
+
+/**
+ * @brief Queues a patch to be generated, unless it already is.
+ */
+void PlanetTerrain::request(uint64_t key) {
+    if (pending.size() >= MAX_PENDING_PATCHES || requests.size() >= maxRequestsPerFrame || pending.count(key) > 0) {
+        return;
+    }
+    pending.insert(key);
+    requests.push_back(key);
+}
+
+/**
+ * @brief Uploads patches that have finished generating, up to the per-frame limit.
+ *
+ * Must be called on the thread that owns the GL context, after every terrain sharing the pool has been
+ * updated for this frame, so that the patches any of them will draw are already marked as used and
+ * can't be evicted to make room. Patches that don't fit this frame wait for the next one, and are drawn
+ * from the next Update on.
+ */
+void PlanetTerrain::UploadCompleted() {
+    std::vector<std::pair<uint64_t, std::vector<Vertex>>> completed;
+    {
+        std::lock_guard<std::mutex> lock(results->mutex);
+        completed.swap(results->completed);
+    }
+
+    size_t uploaded = 0;
+    for (; uploaded < completed.size() && uploaded < maxUploadsPerFrame; uploaded++) {
+        int slot = pool.Allocate(completed[uploaded].first);
+        if (slot < 0) {
+            break;
+        }
+        pool.Upload(slot, completed[uploaded].second);
+        pending.erase(completed[uploaded].first);
+    }
+
+    if (uploaded < completed.size()) {
+        std::lock_guard<std::mutex> lock(results->mutex);
+        results->completed.insert(results->completed.begin(), std::make_move_iterator(completed.begin() + uploaded), std::make_move_iterator(completed.end()));
+    }
+}
+
+/**
+ * @brief Picks this frame's patches and starts generating any that are missing.
+ *
+ * Must be called on the thread that owns the GL context, once per frame before Enqueue, and after the
+ * pool's BeginFrame. Finished patches are uploaded separately, by UploadCompleted.
+ *
+ * @param centre the position of the planet this frame.
+ * @param camera the camera the terrain will be drawn from.
+ */
+void PlanetTerrain::Update(glm::vec3 centre, const Camera& camera) {
+    this->centre = centre;
+
+    requests.clear();
+    drawList.clear();
+    for (int face = 0; face < FACE_COUNT; face++) {
+        int slot = pool.Find(patchKey(face, 0, 0, 0));
+        if (slot >= 0) {
+            selectPatches(face, 0, 0, 0, slot, camera.position);
+        }
+    }
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        std::shared_ptr<PatchResults> destination = results;
+        uint64_t key = requests[i];
+        float patchRadius = radius;
+        float patchElevation = elevation;
+        unsigned int patchSeed = seed;
+        auto generate = [destination, key, patchRadius, patchElevation, patchSeed]() {
+            std::vector<Vertex> vertices = generatePatch(key, patchRadius, patchElevation, patchSeed);
+            std::lock_guard<std::mutex> lock(destination->mutex);
+            destination->completed.emplace_back(key, std::move(vertices));
+        };
+
+        if (jobSystem.WorkerCount() > 0) {
+            jobSystem.Submit(generate);
+        }
+        else if (i == 0) {
+            // With no workers nothing would ever pick the jobs up, so generate one patch a frame here instead
+            generate();
+        }
+        else {
+            pending.erase(key);
+        }
+    }
+}
+
+/**
+ * @brief Gets the transform to draw the terrain with; patches are built around the planet's centre.
+ */
+glm::mat4 PlanetTerrain::ModelMatrix() const {
+    return glm::translate(glm::mat4(1.0f), centre);
+}
+
+/**
+ * @brief Adds a draw of each patch picked by the last Update to a render queue.
+ *
+ * @param queue the queue to add to.
+ * @param shader the shader to draw with.
+ * @param object the terrain's ObjectData, from ModelMatrix and the plain material, in this frame's
+ * ObjectUniformRing.
+ * @param depth the planet's distance from the camera, as a fraction of the far plane distance.
+ */
+void PlanetTerrain::Enqueue(RenderQueue& queue, Shader& shader, unsigned int object, float depth) {
+    DrawCommand command;
+    command.shader = &shader;
+    command.vertexArray = pool.VAO;
+    command.object = object;
+    command.indexCount = (GLsizei)pool.IndexCount();
+    command.instanceCount = 0;
+    uint64_t key = RenderQueue::MakeKey(RenderQueue::OPAQUE_PASS, shader.programID, MaterialLibrary::PLAIN_MATERIAL, depth);
+    for (unsigned int slot : drawList) {
+        command.baseVertex = pool.BaseVertex(slot);
+        queue.Add(key, command);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <Camera/Camera.hpp>
+#include <JobSystem/JobSystem.hpp>
+#include <Rendering/RenderQueue/RenderQueue.hpp>
+#include <Rendering/Terrain/TerrainPatchPool.hpp>
+#include <Shader/Shader.hpp>
+
+/**
+ * @brief Streams detailed terrain for one planet as a cube-sphere quadtree of patches.
+ *
+ * Each of the six faces of a cube projected onto the sphere is the root of a quadtree. Patches are
+ * split while the camera is close relative to their size, so detail is concentrated under the camera.
+ * Patch meshes are generated on a job system kept apart from the physics, so a fly-by asking for many
+ * patches at once can never hold up a physics step. They are uploaded to a shared TerrainPatchPool a
+ * few per frame; until a patch's children are all resident, the patch itself is drawn in their place.
+ *
+ * Every terrain sharing a pool must pick its patches for the frame with Update before any of them
+ * uploads with UploadCompleted, since the pool only protects patches already marked as used that frame.
+ *
+ * Neighbouring patches may differ in level, so every patch has a skirt hanging down from its edges to
+ * hide any cracks between them.
+ */
+class PlanetTerrain {
+    public:
+        // Vertices along each edge of a patch, not counting the skirt
+        static const unsigned int PATCH_RESOLUTION = 33;
+        static const unsigned int VERTICES_PER_PATCH = (PATCH_RESOLUTION + 2)*(PATCH_RESOLUTION + 2);
+
+    private:
+        struct PatchResults {
+            std::mutex mutex;
+            std::vector<std::pair<uint64_t, std::vector<Vertex>>> completed;
+        };
+
+        unsigned int planetIndex;
+        float radius;
+        unsigned int seed;
+        TerrainPatchPool& pool;
+        JobSystem& jobSystem;
+
+        glm::vec3 centre = glm::vec3(0.0f);
+        std::unordered_set<uint64_t> pending;
+        std::vector<uint64_t> requests;
+        std::shared_ptr<PatchResults> results = std::make_shared<PatchResults>();
+        std::vector<unsigned int> drawList;
+
+        uint64_t patchKey(int face, int level, uint32_t x, uint32_t y) const;
+        bool shouldSplit(int face, int level, uint32_t x, uint32_t y, glm::vec3 cameraPosition) const;
+        void selectPatches(int face, int level, uint32_t x, uint32_t y, int slot, glm::vec3 cameraPosition);
+        void request(uint64_t key);
+
+        static std::vector<Vertex> generatePatch(uint64_t key, float radius, float elevation, unsigned int seed);
+
+    public:
+        int maxLevel = 14;
+        // A patch is split when the camera is closer than this many times the patch's width
+        float splitDistance = 2.5f;
+        // Most patches to start generating, and to upload, in a single frame
+        unsigned int maxRequestsPerFrame = 16;
+        unsigned int maxUploadsPerFrame = 8;
+        // Height of the tallest mountains, as a fraction of the radius
+        float elevation = 0.01f;
+
+        PlanetTerrain(unsigned int planetIndex, float radius, unsigned int seed, TerrainPatchPool& pool, JobSystem& jobSystem);
+
+        void Update(glm::vec3 centre, const Camera& camera);
+        void UploadCompleted();
+        void Enqueue(RenderQueue& queue, Shader& shader, unsigned int object, float depth);
+        glm::mat4 ModelMatrix() const;
+        const std::vector<unsigned int>& DrawList() const { return drawList; }
+
+        static std::vector<unsigned int> PatchIndices();
+};
@@ -0,0 +1,116 @@
+#include <Rendering/Terrain/TerrainPatchPool.hpp>
+
+#include <Rendering/GLState/GLState.hpp>
+#include <Utilities/Utilities.hpp>
+
+/**
+ * @brief Allocates the pool's buffers on the GPU.
+ *
+ * @param slotCount the number of patches the pool can hold at once.
+ * @param verticesPerPatch the number of vertices in every patch.
+ * @param indices the triangle indices of one patch, shared by every patch.
+ */
+TerrainPatchPool::TerrainPatchPool(unsigned int slotCount, unsigned int verticesPerPatch, const std::vector<unsigned int>& indices) {
+    this->verticesPerPatch = verticesPerPatch;
+    this->indexCount = (unsigned int)indices.size();
+
+    slots.resize(slotCount);
+    for (unsigned int i = slotCount; i > 0; i--) {
+        freeSlots.push_back(i - 1);
+    }
+
+    glGenVertexArrays(1, &VAO);
+    GLState::BindVertexArray(VAO);
+    glGenBuffers(1, &EBO);
+
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)slotCount*verticesPerPatch*sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);                 // Coordinates
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3*sizeof(float))); // Normals
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6*sizeof(float))); // Colours
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(9*sizeof(float))); // Texture coordinates
+    glEnableVertexAttribArray(3);
+
+    // Unbind all to prevent accidentally modifying them
+    GLState::BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    glCheckError();
+}
+
+/**
+ * @brief Looks up the slot holding a patch, marking it as used this frame.
+ *
+ * @param key the patch's key.
+ * @return the slot, or -1 if the patch isn't resident.
+ */
+int TerrainPatchPool::Find(uint64_t key) {
+    auto found = slotsByKey.find(key);
+    if (found == slotsByKey.end()) {
+        return -1;
+    }
+    Slot& slot = slots[found->second];
+    slot.lastUsedFrame = frame;
+    if (!slot.isPinned) {
+        lru.splice(lru.end(), lru, slot.lruPosition);
+    }
+    return (int)found->second;
+}
+
+/**
+ * @brief Claims a slot for a patch, evicting the least recently used patch if the pool is full.
+ *
+ * Patches used this frame are never evicted, since they may already be queued to draw.
+ *
+ * @param key the patch's key; must not already be resident.
+ * @param isPinned whether the patch should be kept for the life of the pool.
+ * @return the slot, or -1 if every slot is pinned or in use this frame.
+ */
+int TerrainPatchPool::Allocate(uint64_t key, bool isPinned) {
+    unsigned int index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        if (lru.empty() || slots[lru.front()].lastUsedFrame == frame) {
+            return -1;
+        }
+        index = lru.front();
+        lru.pop_front();
+        slotsByKey.erase(slots[index].key);
+    }
+
+    Slot& slot = slots[index];
+    slot.key = key;
+    slot.lastUsedFrame = frame;
+    slot.isPinned = isPinned;
+    if (!isPinned) {
+        slot.lruPosition = lru.insert(lru.end(), index);
+    }
+    slotsByKey[key] = index;
+    return (int)index;
+}
+
+/**
+ * @brief Copies a patch's vertices into its slot.
+ *
+ * @param slot the slot to fill.
+ * @param vertices exactly verticesPerPatch vertices.
+ */
+void TerrainPatchPool::Upload(unsigned int slot, const std::vector<Vertex>& vertices) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (size_t)slot*verticesPerPatch*sizeof(Vertex), verticesPerPatch*sizeof(Vertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glCheckError();
+}
+
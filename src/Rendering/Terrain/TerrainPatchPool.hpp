@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <Rendering/Window/Mesh/Mesh.hpp>
+
+/**
+ * @brief A fixed-size pool of GPU slots for terrain patch meshes, recycled least recently used first.
+ *
+ * Every patch has the same vertex count and topology, so the pool is one vertex buffer split into
+ * equal slots plus one index buffer shared by all of them; a patch is drawn by offsetting the base
+ * vertex to its slot. GPU memory is fixed when the pool is created, however much terrain is visited.
+ */
+class TerrainPatchPool {
+    private:
+        struct Slot {
+            uint64_t key;
+            uint64_t lastUsedFrame;
+            bool isPinned;
+            std::list<unsigned int>::iterator lruPosition;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<unsigned int> freeSlots;
+        std::unordered_map<uint64_t, unsigned int> slotsByKey;
+        // Occupied, unpinned slots, least recently used at the front
+        std::list<unsigned int> lru;
+        uint64_t frame = 0;
+
+        unsigned int verticesPerPatch;
+        unsigned int indexCount;
+
+    public:
+        unsigned int VAO;
+        unsigned int VBO;
+        unsigned int EBO;
+
+        TerrainPatchPool(unsigned int slotCount, unsigned int verticesPerPatch, const std::vector<unsigned int>& indices);
+
+        void BeginFrame() { frame++; }
+        int Find(uint64_t key);
+        int Allocate(uint64_t key, bool isPinned = false);
+        void Upload(unsigned int slot, const std::vector<Vertex>& vertices);
+        unsigned int IndexCount() const { return indexCount; }
+        // The first vertex of a slot, to offset the shared indices by
+        GLint BaseVertex(unsigned int slot) const { return (GLint)(slot*verticesPerPatch); }
+
+        unsigned int SlotCount() const { return (unsigned int)slots.size(); }
+        unsigned int FreeSlotCount() const { return (unsigned int)freeSlots.size(); }
+};
@@ -0,0 +1,33 @@
+#include <Rendering/UniformBuffers/FrameUniformBuffer.hpp>
+
+#include <Shader/Shader.hpp>
+#include <Utilities/Utilities.hpp>
+
+/**
+ * @brief Creates the buffer and binds it to Shader::FRAME_DATA_BINDING for good.
+ */
+FrameUniformBuffer::FrameUniformBuffer() {
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, Shader::FRAME_DATA_BINDING, UBO);
+    glCheckError();
+}
+
+/**
+ * @brief Replaces the frame's data. Call once a frame, before drawing anything.
+ *
+ * The old contents are orphaned first, so the driver doesn't have to wait for the last frame's draws
+ * to finish reading them.
+ */
+void FrameUniformBuffer::Update(const FrameData& data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniformBuffer::Delete() {
+    glDeleteBuffers(1, &UBO);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Everything shaders need that is the same for every draw in a frame.
+ *
+ * Laid out to match the std140 FrameData block in the shaders: every member is a vec4 or mat4, so
+ * there is no padding to get wrong. Only the xyz of the positions are used.
+ */
+struct FrameData {
+    glm::mat4 camMatrix;
+    glm::vec4 camPos;
+    glm::vec4 lightColour;
+    glm::vec4 lightPos;
+};
+
+/**
+ * @brief The uniform buffer holding the FrameData, bound once and shared by every program.
+ */
+class FrameUniformBuffer {
+    private:
+        GLuint UBO = 0;
+
+    public:
+        FrameUniformBuffer();
+
+        FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+        FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+        void Update(const FrameData& data);
+        void Delete();
+};
@@ -0,0 +1,124 @@
+#include <Rendering/UniformBuffers/ObjectUniformRing.hpp>
+
+#include <cstring>
+
+#include <Shader/Shader.hpp>
+#include <Utilities/Utilities.hpp>
+
+// How long to wait for the GPU to finish with a section, in nanoseconds, before giving up and overwriting it
+static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+/**
+ * @brief Creates the buffer.
+ *
+ * @param initialCapacity the number of objects each frame has room for; this grows as needed.
+ */
+ObjectUniformRing::ObjectUniformRing(unsigned int initialCapacity) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride = (sizeof(ObjectData) + alignment - 1)/alignment*alignment;
+
+    glGenBuffers(1, &UBO);
+    allocate(initialCapacity);
+}
+
+/**
+ * @brief Gives the buffer new storage, with room for a number of objects in every section.
+ *
+ * The old storage is orphaned rather than freed, so draws still reading it are unaffected and there is
+ * nothing to wait for.
+ */
+void ObjectUniformRing::allocate(unsigned int objects) {
+    capacity = objects;
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, FRAMES_IN_FLIGHT*capacity*stride, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    for (auto& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    glCheckError();
+}
+
+/**
+ * @brief Moves on to the next section, waiting for the GPU to finish with it if it hasn't already.
+ *
+ * With FRAMES_IN_FLIGHT sections, the wait is normally already over.
+ */
+void ObjectUniformRing::BeginFrame() {
+    section = (section + 1) % FRAMES_IN_FLIGHT;
+    if (fences[section]) {
+        glClientWaitSync(fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        glDeleteSync(fences[section]);
+        fences[section] = nullptr;
+    }
+    staging.clear();
+    objectCount = 0;
+    boundObject = -1;
+}
+
+/**
+ * @brief Adds an object's data to this frame.
+ *
+ * @return the object's index, to pass to Bind once the frame has been uploaded.
+ */
+unsigned int ObjectUniformRing::Push(const ObjectData& data) {
+    staging.resize((size_t)(objectCount + 1)*stride);
+    std::memcpy(staging.data() + (size_t)objectCount*stride, &data, sizeof(ObjectData));
+    return objectCount++;
+}
+
+/**
+ * @brief Copies everything pushed this frame into the buffer. Call once, after the last Push and
+ * before the first Bind.
+ */
+void ObjectUniformRing::Upload() {
+    if (objectCount == 0) {
+        return;
+    }
+    if (objectCount > capacity) {
+        allocate(2*objectCount);
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    void* mapped = glMapBufferRange(GL_UNIFORM_BUFFER, (GLintptr)(section*capacity*stride), (GLsizeiptr)staging.size(),
+                                    GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (mapped) {
+        std::memcpy(mapped, staging.data(), staging.size());
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glCheckError();
+}
+
+/**
+ * @brief Points the shaders' ObjectData block at an object's data, unless it already is.
+ *
+ * @param object the index returned by Push this frame.
+ */
+void ObjectUniformRing::Bind(unsigned int object) {
+    if (boundObject == (int)object) {
+        return;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, Shader::OBJECT_DATA_BINDING, UBO, (GLintptr)((section*capacity + object)*stride), sizeof(ObjectData));
+    boundObject = (int)object;
+}
+
+/**
+ * @brief Marks the end of the frame's draws, so the section isn't written again until they are done.
+ */
+void ObjectUniformRing::EndFrame() {
+    fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void ObjectUniformRing::Delete() {
+    for (auto& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    glDeleteBuffers(1, &UBO);
+}
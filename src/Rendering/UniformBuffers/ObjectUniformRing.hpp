@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Everything shaders need that differs between the objects drawn in a frame.
+ *
+ * Laid out to match the std140 ObjectData block in the shaders.
+ */
+struct ObjectData {
+    glm::mat4 model;
+    // Index into the MaterialLibrary's table
+    GLint material;
+    GLint padding[3];
+};
+
+/**
+ * @brief Streams each frame's ObjectData to the GPU, with a single copy into a mapped buffer.
+ *
+ * During a frame, object data is pushed into a CPU-side array, then uploaded all at once before the
+ * draws; each draw binds its own object's range of the buffer. The buffer is split into one section
+ * per frame in flight and the sections are used in turn. A section is mapped unsynchronised, so the
+ * driver never stalls or copies, and a fence makes sure the GPU has finished with a section before it
+ * is written again.
+ */
+class ObjectUniformRing {
+    private:
+        static constexpr unsigned int FRAMES_IN_FLIGHT = 3;
+
+        GLuint UBO = 0;
+        // Bytes between objects, rounded up to the alignment GL requires of uniform buffer offsets
+        size_t stride = 0;
+        // Objects each section has room for
+        unsigned int capacity = 0;
+        unsigned int section = 0;
+        GLsync fences[FRAMES_IN_FLIGHT] = {};
+        std::vector<unsigned char> staging;
+        unsigned int objectCount = 0;
+        // The object whose range is bound, or -1 if none is
+        int boundObject = -1;
+
+        void allocate(unsigned int objects);
+
+    public:
+        ObjectUniformRing(unsigned int initialCapacity = 256);
+
+        ObjectUniformRing(const ObjectUniformRing&) = delete;
+        ObjectUniformRing& operator=(const ObjectUniformRing&) = delete;
+
+        void BeginFrame();
+        unsigned int Push(const ObjectData& data);
+        void Upload();
+        void Bind(unsigned int object);
+        void EndFrame();
+        void Delete();
+};
@@ -0,0 +1,116 @@
+#include <Rendering/Window/InstancedMesh/InstancedMesh.hpp>
+
+#include <cstddef>
+
+#include <Rendering/GLState/GLState.hpp>
+#include <Utilities/Utilities.hpp>
+
+/**
+ * @brief Creates an instanced version of a mesh.
+ *
+ * The mesh's own buffers are reused rather than copied; only a new vertex array and the instance
+ * buffer are created.
+ *
+ * @param mesh the mesh to draw copies of.
+ */
+InstancedMesh::InstancedMesh(const Mesh& mesh) {
+    this->mesh = mesh;
+
+    glGenVertexArrays(1, &VAO);
+    GLState::BindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);                 // Coordinates
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3*sizeof(float))); // Normals
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6*sizeof(float))); // Colours
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(9*sizeof(float))); // Texture coordinates
+    glEnableVertexAttribArray(3);
+
+    // Instance attributes advance once per instance rather than once per vertex
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, position)); // Instance positions
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, radius));   // Instance radii
+    glEnableVertexAttribArray(5);
+    glVertexAttribDivisor(5, 1);
+    glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, colour));   // Instance colours
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+
+    // Unbind all to prevent accidentally modifying them
+    GLState::BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    glCheckError();
+}
+
+/**
+ * @brief Replaces the instances to draw.
+ *
+ * The buffer is only reallocated when it needs to grow; otherwise it is orphaned and refilled, so the
+ * driver doesn't have to wait for the previous frame's draw to finish with it.
+ *
+ * @param instances the instances to draw.
+ * @param count the number of instances.
+ */
+void InstancedMesh::SetInstances(const InstanceData* instances, unsigned int count) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (count > instanceCapacity) {
+        instanceCapacity = count;
+    }
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity*sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count*sizeof(InstanceData), instances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceCount = count;
+
+    glCheckError();
+}
+
+/**
+ * @brief Draws every instance with one draw call.
+ *
+ * @param shader the shader to draw with; must take the instance attributes.
+ */
+void InstancedMesh::Draw(Shader& shader) {
+    if (instanceCount == 0) {
+        return;
+    }
+
+    shader.Activate();
+    GLState::BindVertexArray(VAO);
+
+    glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0, instanceCount);
+    glCheckError();
+}
+
+/**
+ * @brief Adds a draw of every instance to a render queue.
+ *
+ * The instances are drawn as they are when the queue is submitted, so SetInstances must not be called
+ * again before then.
+ *
+ * @param queue the queue to add to.
+ * @param shader the shader to draw with; must take the instance attributes.
+ */
+void InstancedMesh::Enqueue(RenderQueue& queue, Shader& shader) {
+    if (instanceCount == 0) {
+        return;
+    }
+
+    DrawCommand command;
+    command.shader = &shader;
+    command.vertexArray = VAO;
+    command.object = RenderQueue::NO_OBJECT;
+    command.indexCount = mesh.indexCount;
+    command.baseVertex = 0;
+    command.instanceCount = (GLsizei)instanceCount;
+    // Instances are spread all over, so there is no one depth to sort them by
+    queue.Add(RenderQueue::MakeKey(RenderQueue::OPAQUE_PASS, shader.programID, mesh.material, 0.0f), command);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include <Rendering/Window/Mesh/Mesh.hpp>
+#include <Camera/Camera.hpp>
+#include <Shader/Shader.hpp>
+
+/**
+ * @brief Per-instance data for drawing many copies of a unit sphere.
+ *
+ * Bodies are spheres, so a position and a radius are their whole transform.
+ */
+struct InstanceData {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 colour;
+};
+
+/**
+ * @brief Draws many copies of one mesh in a single draw call.
+ *
+ * Shares the vertex and index buffers of an existing Mesh, and adds a buffer of InstanceData that
+ * the vertex shader reads once per instance (attribute locations 4 to 6, see shaders/instanced.vert).
+ */
+class InstancedMesh {
+    private:
+        unsigned int instanceCapacity = 0;
+
+    public:
+        Mesh mesh;
+        unsigned int VAO;
+        unsigned int instanceVBO;
+        unsigned int instanceCount = 0;
+
+        InstancedMesh() {};
+        InstancedMesh(const Mesh& mesh);
+
+        void SetInstances(const InstanceData* instances, unsigned int count);
+        void Draw(Shader& shader);
+        void Enqueue(RenderQueue& queue, Shader& shader);
+};
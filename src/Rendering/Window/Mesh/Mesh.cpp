@@ -1,22 +1,30 @@
 #include <Rendering/Window/Mesh/Mesh.hpp>
 
+#include <Rendering/GLState/GLState.hpp>
 #include <Utilities/Utilities.hpp>
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures) {
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
+Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int material) :
+    Mesh(vertices.data(), vertices.size(), indices.data(), indices.size(), material) {}
+
+/**
+ * @brief Uploads a mesh straight from wherever its vertices and indices are, such as a mapped file.
+ *
+ * Nothing is kept on the CPU, so the arrays can be freed as soon as this returns.
+ */
+Mesh::Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, unsigned int material) {
+    this->indexCount = (GLsizei)indexCount;
+    this->material = material;
 
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    GLState::BindVertexArray(VAO);
     glGenBuffers(1, &EBO);
 
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount*sizeof(Vertex), vertices, GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount*sizeof(unsigned int), indices, GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);                 // Coordinates
     glEnableVertexAttribArray(0);
@@ -28,51 +36,58 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std:
     glEnableVertexAttribArray(3);
 
     // Unbind all to prevent accidentally modifying them
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     glCheckError();
 }
 
-void Mesh::Draw(Shader& shader, Camera& camera, glm::mat4 matrix, glm::vec3 translation, glm::quat rotation, glm::vec3 scale) {
+/**
+ * @brief Draws the mesh.
+ *
+ * The camera and lights come from the frame's uniform buffer, and the mesh's transform and material from
+ * whichever ObjectData range the caller has bound. The program and vertex array are only bound if they
+ * aren't already, so drawing many meshes with one shader costs little more than the draw calls.
+ *
+ * @param shader the shader to draw with.
+ */
+void Mesh::Draw(Shader& shader) {
     shader.Activate();
-    glBindVertexArray(VAO);
-    glCheckError();
-    unsigned int numOfDiffuseTextures = 0;
-    unsigned int numOfSpecularTextures = 0;
-    for (unsigned int i = 0; i < textures.size(); i++) {
-        std::string num = std::to_string(i);
-        TextureType type = textures[i].type;
-        if (type == TextureType::DIFFUSE) {
-            num = std::to_string(numOfDiffuseTextures++);
-        } else if (type == TextureType::SPECULAR) {
-            num = std::to_string(numOfSpecularTextures++);
-        }
-        else {
-            outputError("Unknown texture type '" + std::to_string(type) + "'");
-        }
-
-        textures[i].SetTextureUnit(shader.programID, (textures[i].GetTextureTypeAsString() + num).c_str(), i);
-        textures[i].Bind();
-    }
-    // Pass in the camera's position into the shader
-    glUniform3f(glGetUniformLocation(shader.programID, "camPos"), camera.position.x, camera.position.y, camera.position.z);
-
-    camera.SendMatrixToShader(shader.programID, "camMatrix");
+    GLState::BindVertexArray(VAO);
 
-    glm::mat4 trans = glm::mat4(1.0f);
-    glm::mat4 rot = glm::mat4(1.0f);
-    glm::mat4 sca = glm::mat4(1.0f);
-
-    trans = glm::translate(trans, translation);
-    rot = glm::mat4_cast(rotation);
-    sca = glm::scale(sca, scale);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    glCheckError();
+}
 
-    glUniformMatrix4fv(glGetUniformLocation(shader.programID, "translation"), 1, GL_FALSE, glm::value_ptr(trans));
-    glUniformMatrix4fv(glGetUniformLocation(shader.programID, "rotation"), 1, GL_FALSE, glm::value_ptr(rot));
-    glUniformMatrix4fv(glGetUniformLocation(shader.programID, "scale"), 1, GL_FALSE, glm::value_ptr(sca));
-    glUniformMatrix4fv(glGetUniformLocation(shader.programID, "model"), 1, GL_FALSE, glm::value_ptr(matrix));
+/**
+ * @brief Adds a draw of the mesh to a render queue.
+ *
+ * @param queue the queue to add to.
+ * @param shader the shader to draw with.
+ * @param objects this frame's ObjectUniformRing, which the mesh's transform and material are pushed to.
+ * @param model the mesh's model matrix.
+ * @param depth the mesh's distance from the camera, as a fraction of the far plane distance.
+ */
+void Mesh::Enqueue(RenderQueue& queue, Shader& shader, ObjectUniformRing& objects, glm::mat4 model, float depth) {
+    DrawCommand command;
+    command.shader = &shader;
+    command.vertexArray = VAO;
+    command.object = objects.Push({model, (GLint)material});
+    command.indexCount = indexCount;
+    command.baseVertex = 0;
+    command.instanceCount = 0;
+    queue.Add(RenderQueue::MakeKey(RenderQueue::OPAQUE_PASS, shader.programID, material, depth), command);
+}
 
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+/**
+ * @brief Combines a transform into the single model matrix the shaders take.
+ *
+ * @return matrix*translation*rotation*scale.
+ */
+glm::mat4 Mesh::ModelMatrix(glm::mat4 matrix, glm::vec3 translation, glm::quat rotation, glm::vec3 scale) {
+    glm::mat4 trans = glm::translate(glm::mat4(1.0f), translation);
+    glm::mat4 rot = glm::mat4_cast(rotation);
+    glm::mat4 sca = glm::scale(glm::mat4(1.0f), scale);
+    return matrix*trans*rot*sca;
 }
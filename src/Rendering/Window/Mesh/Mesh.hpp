@@ -3,8 +3,9 @@
 #include <string>
 #include <vector>
 #include <iostream>
-#include <Rendering/Window/Texture/Texture.hpp>
 #include <Camera/Camera.hpp>
+#include <Rendering/RenderQueue/RenderQueue.hpp>
+#include <Rendering/UniformBuffers/ObjectUniformRing.hpp>
 
 struct Vertex {
     glm::vec3 position;
@@ -15,16 +16,21 @@ struct Vertex {
 
 class Mesh {
     public:
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
+        // The vertices and indices only live on the GPU
+        GLsizei indexCount = 0;
+        // Index into the MaterialLibrary's table
+        unsigned int material = 0;
 
         unsigned int VAO;
         unsigned int VBO;
         unsigned int EBO;
 
         Mesh() {};
-        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
+        Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int material = 0);
+        Mesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, unsigned int material = 0);
 
-        void Draw(Shader& shader, Camera& camera, glm::mat4 matrix = glm::mat4(1.0f), glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f), glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f));
+        void Draw(Shader& shader);
+        void Enqueue(RenderQueue& queue, Shader& shader, ObjectUniformRing& objects, glm::mat4 model, float depth);
+
+        static glm::mat4 ModelMatrix(glm::mat4 matrix = glm::mat4(1.0f), glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f), glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f));
 };
\ No newline at end of file
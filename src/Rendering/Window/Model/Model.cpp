@@ -1,48 +1,69 @@
 #include "Model.hpp"
 
-#include "../Mesh/Mesh.hpp"
 #include <Camera/Camera.hpp>
 #include <Utilities/Utilities.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-void Model::Draw(Shader& shader, Camera& camera) {
+// See http://assimp.sourceforge.net/lib_html/postprocess_8h.html for a list of available post processing flags
+const unsigned int Model::IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
+
+void Model::Draw(Shader& shader) {
     for (unsigned int im = 0; im < meshes.size(); im++) {
-        meshes[im].Draw(shader, camera);
+        meshes[im].Draw(shader);
     }
 }
 
-void Model::loadModel(string filepath) {
+void Model::Enqueue(RenderQueue& queue, Shader& shader, ObjectUniformRing& objects, glm::mat4 model, float depth) {
+    for (unsigned int im = 0; im < meshes.size(); im++) {
+        meshes[im].Enqueue(queue, shader, objects, model, depth);
+    }
+}
+
+/**
+ * @brief Sets the model's meshes, once they have been uploaded. Must be called on the GL thread.
+ */
+void Model::SetMeshes(vector<Mesh> meshes) {
+    this->meshes = meshes;
+    isLoaded = true;
+}
+
+/**
+ * @brief Reads a model file into meshes, without touching GL. Safe to call from any thread.
+ *
+ * @param filepath the path to the model file.
+ * @return the meshes, or none if the file couldn't be read.
+ */
+vector<MeshData> Model::Import(const string& filepath) {
+    vector<MeshData> meshes;
     Assimp::Importer importer;
-    const aiScene *scene = importer.ReadFile(filepath, aiProcess_Triangulate | aiProcess_FlipUVs); // See http://assimp.sourceforge.net/lib_html/postprocess_8h.html for a list of available post processing flags
+    const aiScene *scene = importer.ReadFile(filepath, IMPORT_FLAGS);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         outputError("Error loading model '" + filepath + "'");
-        return;
+        return meshes;
     }
-    directory = filepath.substr(0, filepath.find_last_of('/'));
+    string directory = filepath.substr(0, filepath.find_last_of('/'));
 
-    processNode(scene->mRootNode, scene);
+    processNode(scene->mRootNode, scene, directory, meshes);
+    return meshes;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene) {
+void Model::processNode(aiNode* node, const aiScene* scene, const string& directory, vector<MeshData>& meshes) {
     // process all the node's meshes (if any)
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         aiMesh *mesh = scene->mMeshes[node->mMeshes[i]]; 
-        meshes.push_back(toMesh(mesh, scene));
+        meshes.push_back(toMeshData(mesh, scene, directory));
     }
     // then do the same for each of its children
     for(unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, directory, meshes);
     }
 }
 
-Mesh Model::toMesh(aiMesh* mesh, const aiScene* scene) {
-    vector<Vertex> vertices;
-    vector<unsigned int> indices;
-    vector<Texture> textures;
-
+MeshData Model::toMeshData(aiMesh* mesh, const aiScene* scene, const string& directory) {
+    MeshData data;
     for (unsigned int iv = 0; iv < mesh->mNumVertices; iv++) {
         Vertex vertex;
         glm::vec3 vector;
@@ -74,52 +95,39 @@ Mesh Model::toMesh(aiMesh* mesh, const aiScene* scene) {
             vertex.textureCoords = glm::vec2(0.0f, 0.0f);
         }
 
-        vertices.push_back(vertex);
+        data.vertices.push_back(vertex);
     }
 
     for (unsigned int iface = 0; iface < mesh->mNumFaces; iface++) {
         aiFace face = mesh->mFaces[iface];
         for (unsigned int ii = 0; ii < face.mNumIndices; ii++) {
-            indices.push_back(face.mIndices[ii]);
+            data.indices.push_back(face.mIndices[ii]);
         }
     }
 
     if(mesh->mMaterialIndex >= 0) {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, TextureType::DIFFUSE);
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        vector<Texture> specularMaps = loadMaterialTextures(material, TextureType::SPECULAR);
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        data.diffusePath = texturePath(material, false, directory);
+        data.specularPath = texturePath(material, true, directory);
     }
 
-    return Mesh(vertices, indices, textures);
+    return data;
 }
 
-vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, TextureType type) {
-    vector<Texture> textures;
-
-    aiTextureType assimpType = type == TextureType::DIFFUSE  ? aiTextureType_DIFFUSE : aiTextureType_SPECULAR;
-
-    for (unsigned int it = 0; it < mat->GetTextureCount(assimpType); it++) {
-        aiString str;
-        mat->GetTexture(assimpType, it, &str);
-
-        string textureFullPath = directory + '/' + str.C_Str();
-
-        bool skip = false;
-        for (unsigned int il = 0; il < loadedTextures.size(); il++) {
-            if (strcmp(loadedTextures[il].path.c_str(),textureFullPath.c_str()) == 0) {
-                textures.push_back(loadedTextures[il]);
-                skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                break;
-            }
-        }
-        if (!skip) { // if texture hasn't been loaded already, load it
-            Texture texture(textureFullPath.c_str(), type, it);
-            textures.push_back(texture);
-            loadedTextures.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-        }
+/**
+ * @brief Gets the path to a material's first diffuse or specular texture.
+ *
+ * Only the first texture of each type is used, as that is all the shaders sample.
+ *
+ * @return the path, or an empty string if the material has none.
+ */
+string Model::texturePath(aiMaterial* mat, bool isSpecular, const string& directory) {
+    aiTextureType assimpType = isSpecular ? aiTextureType_SPECULAR : aiTextureType_DIFFUSE;
+    if (mat->GetTextureCount(assimpType) == 0) {
+        return "";
     }
 
-    return textures;
+    aiString str;
+    mat->GetTexture(assimpType, 0, &str);
+    return directory + '/' + str.C_Str();
 }
\ No newline at end of file
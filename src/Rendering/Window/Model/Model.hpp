@@ -4,7 +4,9 @@
 #include <string>
 #include <iostream>
 
-#include "../Texture/Texture.hpp"
+#include <glm/glm.hpp>
+
+#include "../Mesh/Mesh.hpp"
 
 using namespace std;
 
@@ -12,21 +14,44 @@ class aiNode;
 class aiScene;
 class aiMesh;
 class aiMaterial;
-class Mesh;
 class Camera;
 class Shader;
+class RenderQueue;
+class ObjectUniformRing;
+
+/**
+ * @brief A mesh as imported from a model file, before anything has been uploaded.
+ */
+struct MeshData {
+    vector<Vertex> vertices;
+    vector<unsigned int> indices;
+    // Paths to the mesh's first diffuse and specular textures, or empty if it has none
+    string diffusePath;
+    string specularPath;
+};
 
+/**
+ * @brief A model made of meshes, imported from any file Assimp can read.
+ *
+ * Importing is kept apart from uploading, so that models can be imported on other threads (see
+ * AssetLoader). A model has no meshes, and draws nothing, until SetMeshes is called.
+ */
 class Model {
 private:
     vector<Mesh> meshes;
-    vector<Texture> loadedTextures;
-    string directory;
+    bool isLoaded = false;
 
-    void loadModel(string filepath);
-    void processNode(aiNode* node, const aiScene* scene);
-    Mesh toMesh(aiMesh* mesh, const aiScene* scene);
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, TextureType type);
+    static void processNode(aiNode* node, const aiScene* scene, const string& directory, vector<MeshData>& meshes);
+    static MeshData toMeshData(aiMesh* mesh, const aiScene* scene, const string& directory);
+    static string texturePath(aiMaterial* mat, bool isSpecular, const string& directory);
 public:
-    Model(const char* filepath) {loadModel(filepath); };
-    void Draw(Shader& shader, Camera& camera);
+    // The Assimp post processing every model is imported with
+    static const unsigned int IMPORT_FLAGS;
+
+    static vector<MeshData> Import(const string& filepath);
+
+    void SetMeshes(vector<Mesh> meshes);
+    bool IsLoaded() const {return isLoaded;};
+    void Draw(Shader& shader);
+    void Enqueue(RenderQueue& queue, Shader& shader, ObjectUniformRing& objects, glm::mat4 model, float depth);
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <Rendering/GLState/GLState.hpp>
 #include <Utilities/Utilities.hpp>
 #include <fstream>
 #include <iostream>
@@ -35,9 +36,8 @@ Texture::Texture(const char* image, TextureType textureType, GLuint unit) {
     }
 
     glGenTextures(1, &id);
-    glActiveTexture(GL_TEXTURE0 + unit);
     this->unit = unit;
-    glBindTexture(GL_TEXTURE_2D, id); // Bind the texture so we can adjust its parameters
+    GLState::BindTexture(unit, id); // Bind the texture so we can adjust its parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Uses the texel nearest to the specified texture x coordinate
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Uses the texel nearest to the specified texture y coordinate
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // Set texture wrapping to GL_REPEAT along the X axis
@@ -63,7 +63,7 @@ Texture::Texture(const char* image, TextureType textureType, GLuint unit) {
     glCheckError();
 
     stbi_image_free(data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(unit, 0);
     glCheckError();
 }
 
@@ -78,7 +78,7 @@ Texture::Texture(const char* image, TextureType textureType, GLuint unit) {
  */
 void Texture::SetTextureUnit(unsigned int shaderID, const char* uniform, GLuint unit) {
     GLuint textureUniformID = glGetUniformLocation(shaderID, uniform);
-    glUseProgram(shaderID);
+    GLState::UseProgram(shaderID);
     glUniform1i(textureUniformID, unit);
     glCheckError();
 }
@@ -86,21 +86,31 @@ void Texture::SetTextureUnit(unsigned int shaderID, const char* uniform, GLuint
 /**
  * Binds the texture to the specified texture unit.
  *
- * This function will use glActiveTexture to set the active texture unit to the unit specified in the constructor, and then use glBindTexture to bind the texture to that unit.
+ * This function will bind the texture to the unit specified in the constructor, skipping the bind if it is already bound there.
  */
 void Texture::Bind() {
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_2D, id);
+    GLState::BindTexture(unit, id);
 }
 
 /**
- * Unbinds the texture from the active texture unit.
+ * Binds the texture to a given texture unit, rather than the one specified in the constructor.
  *
- * This function will reset the active texture unit to 0 (i.e. the default texture unit).
+ * \param unit The texture unit to bind to.
+ *
+ * Skips the bind if the texture is already bound to that unit.
+ */
+void Texture::Bind(GLuint unit) {
+    GLState::BindTexture(unit, id);
+}
+
+/**
+ * Unbinds the texture from its texture unit.
+ *
+ * This function will bind texture 0 (i.e. no texture) to the unit specified in the constructor.
  * It is useful for unbinding a texture after it has been used for rendering.
  */
 void Texture::Unbind() {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(unit, 0);
 }
 
 /**
@@ -111,4 +121,5 @@ void Texture::Unbind() {
  */
 void Texture::Delete() {
     glDeleteTextures(1, &id);
+    GLState::ForgetTexture(id);
 }
\ No newline at end of file
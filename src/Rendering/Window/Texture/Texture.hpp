@@ -7,7 +7,7 @@ using namespace std;
 #include <glad/glad.h>
 #include <Shader/Shader.hpp>
 
-enum TextureType {
+enum TextureType : unsigned int {
     DIFFUSE,
     SPECULAR
 };
@@ -25,6 +25,7 @@ class Texture {
 
         void SetTextureUnit(unsigned int shaderID, const char* uniform, GLuint unit);
         void Bind();
+        void Bind(GLuint unit);
         void Unbind();
         void Delete();
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <iostream>
 
+#include <Rendering/GLState/GLState.hpp>
 #include <Utilities/Utilities.hpp>
 
 Shader::Shader(const char* vertexFilePath, const char* fragmentFilePath) {
@@ -44,10 +45,53 @@ Shader::Shader(const char* vertexFilePath, const char* fragmentFilePath) {
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    bindBlocksAndSamplers();
+
     // Do a final check to see if everything went well
     glCheckError();
 }
 
+/**
+ * @brief Connects the uniform blocks to their binding points and the samplers to their units, once, after linking.
+ *
+ * GLSL 3.30 can't give a block its binding or a sampler its unit in the shader itself, so it is done
+ * here. Blocks and samplers the program doesn't use are skipped.
+ */
+void Shader::bindBlocksAndSamplers() {
+    GLuint frameBlock = glGetUniformBlockIndex(programID, "FrameData");
+    if (frameBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(programID, frameBlock, FRAME_DATA_BINDING);
+    }
+    GLuint objectBlock = glGetUniformBlockIndex(programID, "ObjectData");
+    if (objectBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(programID, objectBlock, OBJECT_DATA_BINDING);
+    }
+    GLuint materialBlock = glGetUniformBlockIndex(programID, "MaterialData");
+    if (materialBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(programID, materialBlock, MATERIAL_DATA_BINDING);
+    }
+
+    Activate();
+    for (unsigned int i = 0; i < TEXTURE_ARRAY_COUNT; i++) {
+        std::string name = "textureArrays[" + std::to_string(i) + "]";
+        glUniform1i(glGetUniformLocation(programID, name.c_str()), (GLint)i);
+    }
+}
+
+/**
+ * @brief Gets the location of any uniform by name, only asking GL the first time.
+ *
+ * @param name the name of the uniform.
+ * @return the location, or -1 if the program has no such uniform.
+ */
+GLint Shader::GetUniformLocation(const std::string& name) {
+    auto found = uniformLocations.find(name);
+    if (found == uniformLocations.end()) {
+        found = uniformLocations.emplace(name, glGetUniformLocation(programID, name.c_str())).first;
+    }
+    return found->second;
+}
+
 void Shader::CheckForCompilationErrors(GLuint shader, const char* type) {
     int success;
     char infoLog[512]; 
@@ -68,9 +112,11 @@ void Shader::CheckForCompilationErrors(GLuint shader, const char* type) {
 }
 
 void Shader::Activate() {
-    glUseProgram(programID);
+    GLState::UseProgram(programID);
 }
 
 void Shader::Delete() {
     glDeleteProgram(programID);
+    // A deleted program stays current until another is used, but its name may be reused by a new one
+    GLState::Invalidate();
 }
\ No newline at end of file
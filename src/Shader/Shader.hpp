@@ -1,13 +1,30 @@
 #pragma once
 
+#include <string>
+#include <unordered_map>
 #include <glad/glad.h>
 
 class Shader { 
     public:
+        // Uniform buffer binding points, the same in every program, for the FrameData, ObjectData and
+        // MaterialData blocks
+        static constexpr GLuint FRAME_DATA_BINDING = 0;
+        static constexpr GLuint OBJECT_DATA_BINDING = 1;
+        static constexpr GLuint MATERIAL_DATA_BINDING = 2;
+        // Size of the textureArrays sampler array; sampler i always reads texture unit i
+        static constexpr unsigned int TEXTURE_ARRAY_COUNT = 4;
+
         GLuint programID;
 
         Shader(const char* vertexFilePath, const char* fragmentFilePath);
         void Activate();
         void Delete();
         void CheckForCompilationErrors(GLuint shader, const char* type);
-};
\ No newline at end of file
+
+        GLint GetUniformLocation(const std::string& name);
+
+    private:
+        std::unordered_map<std::string, GLint> uniformLocations;
+
+        void bindBlocksAndSamplers();
+};
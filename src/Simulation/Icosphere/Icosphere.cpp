@@ -1,14 +1,98 @@
 #include <Simulation/Icosphere/Icosphere.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+
+/**
+ * @brief Maps an edge, as an unordered pair of vertex indices, to the index of its midpoint vertex.
+ *
+ * A flat open-addressing table with linear probing: every edge is looked up twice, once from each
+ * triangle that shares it, so this sits on the hot path of generation.
+ */
+struct Icosphere::MidpointCache {
+    static constexpr uint64_t EMPTY = ~0ull;
+
+    std::vector<uint64_t> keys;
+    // -1 until the midpoint for the key has been created
+    std::vector<int> values;
+    size_t mask = 0;
+
+    /**
+     * @brief Empties the table and sizes it for the given number of edges, at most half full.
+     */
+    void Reset(size_t edgeCount) {
+        size_t capacity = 16;
+        while (capacity < 2*edgeCount) {
+            capacity *= 2;
+        }
+        keys.assign(capacity, EMPTY);
+        values.assign(capacity, -1);
+        mask = capacity - 1;
+    }
+
+    /**
+     * @brief Finds the midpoint index stored for an edge, adding the edge with no midpoint if it is new.
+     */
+    int& Find(int index1, int index2) {
+        uint64_t low = (uint64_t)std::min(index1, index2);
+        uint64_t high = (uint64_t)std::max(index1, index2);
+        uint64_t key = (low << 32) | high;
+        size_t slot = (size_t)((key*0x9E3779B97F4A7C15ull) >> 32) & mask;
+        while (keys[slot] != EMPTY && keys[slot] != key) {
+            slot = (slot + 1) & mask;
+        }
+        keys[slot] = key;
+        return values[slot];
+    }
+};
+
 Icosphere::Icosphere(glm::vec3 position, float radius, int resolution) {
     this->position = position;
     this->radius = radius;
     this->resolution = resolution;
 
-    generateIcosphere();
+    mesh = &GetUnitMesh(resolution);
+}
+
+/**
+ * @brief Gets the shared unit sphere mesh for a resolution, generating it the first time it is asked for.
+ *
+ * Meshes are never freed, and references to them stay valid for the life of the process.
+ * Must be called on the thread that owns the GL context.
+ *
+ * @param resolution the number of times the icosahedron is subdivided.
+ * @return the unit sphere mesh.
+ */
+Mesh& Icosphere::GetUnitMesh(int resolution) {
+    static std::map<int, Mesh> unitMeshes;
+
+    auto cached = unitMeshes.find(resolution);
+    if (cached == unitMeshes.end()) {
+        cached = unitMeshes.emplace(resolution, generateUnitMesh(resolution)).first;
+    }
+    return cached->second;
 }
 
-void Icosphere::generateIcosphere() {
+/**
+ * @brief Generates a unit sphere of the given resolution and uploads it.
+ *
+ * Each subdivision splits every triangle into four, sharing the new midpoint vertices between the
+ * triangles either side of each edge. A sphere of resolution n therefore has exactly 20*4^n triangles,
+ * 30*4^n edges and 10*4^n + 2 vertices, so everything is allocated up front.
+ *
+ * @param resolution the number of times the icosahedron is subdivided.
+ * @return the new mesh.
+ */
+Mesh Icosphere::generateUnitMesh(int resolution) {
+    const size_t finalTriangleCount = (size_t)20 << (2*resolution);
+    const size_t finalVertexCount = ((size_t)10 << (2*resolution)) + 2;
+
+    std::vector<vec3> vertices;
+    std::vector<TriIndex> triangles;
+    std::vector<TriIndex> newTriangles;
+    MidpointCache midpoints;
+
     // Create the icosphere, very nicely sourced from http://blog.andreaskahler.com/2009/06/creating-icosphere-mesh-in-code.html
     const float t = (1.0f + sqrt(5.0f)) / 2.0f; // Golden ratio
     vertices = {
@@ -53,62 +137,41 @@ void Icosphere::generateIcosphere() {
         {8, 6, 7},
         {9, 8, 1}
     };
+    vertices.reserve(finalVertexCount);
+    triangles.reserve(finalTriangleCount);
+    newTriangles.reserve(finalTriangleCount);
 
     int i1, i2, i3, i12, i13, i23;
     for (int i = 0; i < resolution; i++) {
-        std::vector<TriIndex> newTriangles;
+        // Every edge of this level is shared by two triangles, and no edge carries over to the next level
+        midpoints.Reset(triangles.size()*3/2);
+        newTriangles.clear();
         for (const auto& tri : triangles) {
             i1 = tri.index0;
             i2 = tri.index1;
             i3 = tri.index2;
-            i12 = createNewMidpoint(i1, i2);
-            i13 = createNewMidpoint(i1, i3);
-            i23 = createNewMidpoint(i2, i3);
+            i12 = createNewMidpoint(vertices, midpoints, i1, i2);
+            i13 = createNewMidpoint(vertices, midpoints, i1, i3);
+            i23 = createNewMidpoint(vertices, midpoints, i2, i3);
 
             newTriangles.push_back({i1,  i12, i13});
             newTriangles.push_back({i13, i12, i23});
             newTriangles.push_back({i12,  i2, i23});
             newTriangles.push_back({i13, i23,  i3});
         }
-        triangles = newTriangles;
-    }
-
-    // Calculate normals
-    normals.assign(vertices.size(), vec3(0.0f, 0.0f, 0.0f));
-    for (const auto& tri : triangles) {
-        vec3 v1 = vertices[tri.index0];
-        vec3 v2 = vertices[tri.index1];
-        vec3 v3 = vertices[tri.index2];
-        vec3 normal = glm::normalize(glm::cross(v2 - v1, v3 - v1));
-        normals[tri.index0] += normal;
-        normals[tri.index1] += normal;
-        normals[tri.index2] += normal;
+        triangles.swap(newTriangles);
     }
 
-    updateMesh();
-}
-
-int Icosphere::createNewMidpoint(int i1, int i2) {
-    vec3 v1 = vertices[i1];
-    vec3 v2 = vertices[i2];
-    vec3 midpoint = (v1 + v2) / 2.0f;
-    midpoint = glm::normalize(midpoint);
-    // Get index before adding new vertex
-    // E.g. if we add the 13th vertex (the first new one), we want to return 12
-    int index = vertices.size();
-    vertices.push_back(midpoint);
-    return index;
-}
-
-void Icosphere::updateMesh() {
     std::vector<Vertex> meshVertices;
     std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
+    meshVertices.reserve(vertices.size());
+    indices.reserve(3*triangles.size());
 
     for (unsigned int iv = 0; iv < vertices.size(); iv++) {
         Vertex vertex;
         vertex.position = vertices[iv];
-        vertex.normal = normals[iv];
+        // On a unit sphere the exact normal is just the position, with no seams between faces
+        vertex.normal = vertices[iv];
 
         // TODO: Update with actual colour, but for the moment keep as white
         vertex.colour = glm::vec3(1.0f, 0.5f, 0.31f);
@@ -125,8 +188,31 @@ void Icosphere::updateMesh() {
         indices.push_back(tri.index2);
     }
 
-    Texture texture("resources/textures/blank.png", TextureType::DIFFUSE, 0);
-    textures.push_back(texture);
+    return Mesh(meshVertices, indices, MaterialLibrary::PLAIN_MATERIAL);
+}
 
-    mesh = Mesh(meshVertices, indices, textures);
+/**
+ * @brief Gets the midpoint vertex of an edge, creating it if neither triangle sharing the edge has yet.
+ *
+ * @param vertices the vertices so far; a new midpoint is appended, pushed out onto the unit sphere.
+ * @param midpoints the midpoints already created for this subdivision level.
+ * @param i1 the index of one end of the edge.
+ * @param i2 the index of the other end of the edge.
+ * @return the index of the midpoint vertex.
+ */
+int Icosphere::createNewMidpoint(std::vector<vec3>& vertices, MidpointCache& midpoints, int i1, int i2) {
+    int& midpointIndex = midpoints.Find(i1, i2);
+    if (midpointIndex >= 0) {
+        return midpointIndex;
+    }
+
+    vec3 v1 = vertices[i1];
+    vec3 v2 = vertices[i2];
+    vec3 midpoint = (v1 + v2) / 2.0f;
+    midpoint = glm::normalize(midpoint);
+    // Get index before adding new vertex
+    // E.g. if we add the 13th vertex (the first new one), we want to return 12
+    midpointIndex = vertices.size();
+    vertices.push_back(midpoint);
+    return midpointIndex;
 }
\ No newline at end of file
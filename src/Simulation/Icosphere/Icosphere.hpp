@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Rendering/Window/Mesh/Mesh.hpp>
+#include <Rendering/Materials/MaterialLibrary.hpp>
 #include <Shader/Shader.hpp>
 #include <Camera/Camera.hpp>
 
@@ -8,6 +9,13 @@
 
 using namespace glm;
 
+/**
+ * @brief A sphere made by subdividing an icosahedron.
+ *
+ * The geometry only depends on the resolution, so it is generated once per resolution as a unit
+ * sphere and shared by every Icosphere in the process, along with its GPU buffers. Each Icosphere
+ * only holds its own position and radius, which are applied when it is drawn.
+ */
 class Icosphere {
 private:
     struct TriIndex {
@@ -21,27 +29,29 @@ private:
             this->index2 = index2;
         }
     };
-    std::vector<vec3> vertices;
-    std::vector<vec3> normals;
-    std::vector<TriIndex> triangles;
+
+    struct MidpointCache;
 
     int shaderID;
+    Mesh* mesh;
 
-    void generateIcosphere();
-    void updateMesh();
-    int createNewMidpoint(int index1, int index2);
+    static Mesh generateUnitMesh(int resolution);
+    static int createNewMidpoint(std::vector<vec3>& vertices, MidpointCache& midpoints, int index1, int index2);
 
 public:
     glm::vec3 position;
     float radius;
     int resolution;
-    Mesh mesh;
 
     Icosphere(vec3 position, float radius, int resolution);
     ~Icosphere() {};
 
     void SetShader(int shaderID) {this->shaderID =shaderID;};
     int GetShader() {return shaderID;};
-    void Draw(Shader& shader, Camera& camera) {mesh.Draw(shader, camera);};
+    Mesh& GetMesh() {return *mesh;};
+    glm::mat4 ModelMatrix() const {return Mesh::ModelMatrix(glm::mat4(1.0f), position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(radius));};
+    // The ObjectData for ModelMatrix must already be bound
+    void Draw(Shader& shader) {mesh->Draw(shader);};
 
-};
\ No newline at end of file
+    static Mesh& GetUnitMesh(int resolution);
+};
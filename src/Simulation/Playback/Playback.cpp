@@ -0,0 +1,283 @@
+#include <Simulation/Playback/Playback.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+// How far ahead of the playhead to keep prefetched
+static const size_t PREFETCH_BYTES = 256*1024*1024;
+static const size_t MIN_PREFETCH_FRAMES = 16;
+// How much of the window to ask for per update, so the frames a seek lands on never queue behind a whole window
+static const size_t PREFETCH_STEP_BYTES = 16*1024*1024;
+// After a jump, how many updates to keep showing the old frames while the new ones are read in
+static const size_t MAX_DEFERRED_DECODES = 30;
+
+/**
+ * @brief Opens a trajectory for playback, with the playhead on the first frame.
+ *
+ * @param path the path of the trajectory file.
+ * @throws std::runtime_error if the file can't be read or holds no frames.
+ */
+Playback::Playback(const std::string& path) : reader(path) {
+    if (reader.FrameCount() == 0) {
+        throw std::runtime_error("Trajectory '" + path + "' holds no frames");
+    }
+    size_t bodyCount = reader.BodyCount();
+    currentX.resize(bodyCount);
+    currentY.resize(bodyCount);
+    currentZ.resize(bodyCount);
+    nextX.resize(bodyCount);
+    nextY.resize(bodyCount);
+    nextZ.resize(bodyCount);
+    radii.resize(bodyCount);
+
+    const TrajectoryLayout& layout = reader.Layout();
+    size_t averageFrameSize = layout.BlockSize()/layout.keyframeInterval;
+    prefetchFrames = std::max(MIN_PREFETCH_FRAMES, PREFETCH_BYTES/averageFrameSize);
+    prefetchStepFrames = std::max((size_t)1, PREFETCH_STEP_BYTES/averageFrameSize);
+    // Read once here, as the last frame's page may well have been evicted by the time it's next needed
+    firstTime = reader.FrameTime(0);
+    lastTime = reader.FrameTime(reader.FrameCount() - 1);
+
+    Seek(0);
+}
+
+/**
+ * @brief Moves the playhead on by the given amount of real time, unless paused.
+ *
+ * Playback stops at either end of the recording. While a seek is waiting on the disk, the playhead
+ * stays where it was.
+ *
+ * @param deltaTime the real time since the last update.
+ */
+void Playback::Update(double deltaTime) {
+    if (!isPaused && !isSeeking) {
+        size_t lastFrame = reader.FrameCount() - 1;
+        playheadTime += speed*deltaTime;
+
+        // The playhead moves a few frames at most between updates, so walking is cheaper than searching
+        while (frame < lastFrame && reader.FrameTime(frame + 1) <= playheadTime) {
+            frame++;
+        }
+        while (frame > 0 && reader.FrameTime(frame) > playheadTime) {
+            frame--;
+        }
+
+        if (playheadTime <= firstTime || playheadTime >= lastTime) {
+            playheadTime = std::min(std::max(playheadTime, firstTime), lastTime);
+            isPaused = true;
+        }
+    }
+    prefetch();
+}
+
+/**
+ * @brief Pauses or resumes playback.
+ *
+ * Resuming at the end of the recording, in the direction of play, starts again from the other end.
+ */
+void Playback::TogglePause() {
+    isPaused = !isPaused;
+    if (!isPaused) {
+        if (speed >= 0.0 && playheadTime >= lastTime) {
+            Seek(0);
+        }
+        else if (speed < 0.0 && playheadTime <= firstTime) {
+            Seek(reader.FrameCount() - 1);
+        }
+    }
+}
+
+/**
+ * @brief Moves the playhead straight to a frame.
+ *
+ * The prefetch window is moved to the target, and nothing is read from a frame that isn't in memory
+ * yet: its time, like its positions, is only read once decode finds it has arrived. Until then the
+ * playhead keeps its old time.
+ *
+ * @param frame the frame to move to; clamped to the recording.
+ */
+void Playback::Seek(size_t frame) {
+    this->frame = std::min(frame, reader.FrameCount() - 1);
+    prefetch();
+    isSeeking = true;
+    if (reader.IsResident(this->frame, 1)) {
+        finishSeek();
+    }
+}
+
+/**
+ * @brief Moves the playhead's time to the frame it was last sent to, now the frame is in memory.
+ */
+void Playback::finishSeek() {
+    if (isSeeking) {
+        playheadTime = reader.FrameTime(frame);
+        isSeeking = false;
+    }
+}
+
+/**
+ * @brief Moves the playhead by a number of frames, forwards or backwards.
+ *
+ * @param frames the number of frames to move by; the playhead stops at either end.
+ */
+void Playback::SeekRelative(long long frames) {
+    long long target = (long long)frame + frames;
+    Seek((size_t)std::max(target, 0LL));
+}
+
+/**
+ * @brief Keeps the frames ahead of the playhead, in the direction of play, prefetched.
+ *
+ * The window is only moved once the playhead is half way through it, so the OS gets large,
+ * sequential requests rather than one per frame. The window is asked for a step at a time, over the
+ * following updates, in the direction of play. When the playhead has jumped out of the window, the
+ * frames it landed on are asked for first, and the new window also reaches a little way behind them,
+ * so scrubbing back from a seek stays resident. Frames left behind are evicted so a long recording
+ * doesn't fill memory with pages that were only needed once.
+ */
+void Playback::prefetch() {
+    bool isForwards = speed >= 0.0;
+    size_t halfWindow = prefetchFrames/2;
+    bool isInWindow = frame >= prefetchBegin && frame < prefetchEnd;
+    bool needsMoving = !isInWindow
+                    || (isForwards && frame >= prefetchBegin + halfWindow && prefetchEnd < reader.FrameCount())
+                    || (!isForwards && frame < prefetchEnd - halfWindow && prefetchBegin > 0);
+    if (needsMoving) {
+        moveWindow(isForwards, isInWindow);
+    }
+
+    if (requestBegin < requestEnd) {
+        size_t count = std::min(prefetchStepFrames, requestEnd - requestBegin);
+        if (isForwards) {
+            requestFrames(requestBegin, count);
+            requestBegin += count;
+        }
+        else {
+            requestFrames(requestEnd - count, count);
+            requestEnd -= count;
+        }
+    }
+}
+
+/**
+ * @brief Moves the prefetch window to the playhead, evicting whatever part of the old one it leaves.
+ *
+ * @param isForwards whether the window should lie ahead of the playhead or behind it.
+ * @param isInWindow whether the playhead is still in the old window, rather than having jumped.
+ */
+void Playback::moveWindow(bool isForwards, bool isInWindow) {
+    size_t frameCount = reader.FrameCount();
+    size_t behind = isInWindow ? 0 : prefetchFrames/8;
+    size_t begin, end;
+    if (isForwards) {
+        begin = frame - std::min(frame, behind);
+        end = std::min(begin + prefetchFrames, frameCount);
+    }
+    else {
+        end = std::min(frame + 1 + behind, frameCount);
+        begin = end > prefetchFrames ? end - prefetchFrames : 0;
+    }
+    if (prefetchEnd > prefetchBegin) {
+        // Evict whatever part of the old window the new one doesn't cover
+        if (prefetchBegin < begin) {
+            evictFrames(prefetchBegin, std::min(prefetchEnd, begin) - prefetchBegin);
+        }
+        if (prefetchEnd > end) {
+            size_t evictBegin = std::max(prefetchBegin, end);
+            evictFrames(evictBegin, prefetchEnd - evictBegin);
+        }
+    }
+    if (isInWindow) {
+        // The part of the new window the old one covered has been asked for already, or is next
+        requestBegin = isForwards ? std::max(begin, requestBegin) : begin;
+        requestEnd = isForwards ? end : std::min(end, requestEnd);
+    }
+    else {
+        requestFrames(frame, 2);
+        requestBegin = begin;
+        requestEnd = end;
+    }
+    prefetchBegin = begin;
+    prefetchEnd = end;
+}
+
+/**
+ * @brief Asks the OS to read in a run of frames, on the prefetch thread.
+ *
+ * Asking allocates the pages and submits the reads there and then, which takes milliseconds for a
+ * few megabytes and blocks outright once the disk's queue is full, so it is kept off the render thread.
+ */
+void Playback::requestFrames(size_t firstFrame, size_t count) {
+    prefetchThread.Submit([this, firstFrame, count]() { reader.Prefetch(firstFrame, count); });
+}
+
+/**
+ * @brief Lets the OS reuse a run of frames' memory, on the prefetch thread, behind any earlier requests.
+ */
+void Playback::evictFrames(size_t firstFrame, size_t count) {
+    prefetchThread.Submit([this, firstFrame, count]() { reader.Evict(firstFrame, count); });
+}
+
+/**
+ * @brief Decodes the frames either side of the playhead, if they aren't already.
+ *
+ * Radii are taken from the current frame, and only read once if the file doesn't store them per frame.
+ * When the playhead has only moved on by one frame, the old next frame becomes the current one. After
+ * a jump, decoding waits until the frames are in memory, so the render thread never stalls on the
+ * disk; the frames decoded before the jump are shown meanwhile. It stops waiting after
+ * MAX_DEFERRED_DECODES updates, in case the OS ignored the prefetch.
+ */
+void Playback::decode() {
+    if (decodedFrame == frame) {
+        finishSeek();
+        return;
+    }
+    size_t nextFrame = std::min(frame + 1, reader.FrameCount() - 1);
+    bool isStep = decodedFrame != (size_t)-1 && decodedFrame + 1 == frame;
+    if (decodedFrame != (size_t)-1 && !isStep && deferredDecodes < MAX_DEFERRED_DECODES &&
+        !reader.IsResident(frame, nextFrame + 1 - frame)) {
+        deferredDecodes++;
+        return;
+    }
+    deferredDecodes = 0;
+    if (isStep) {
+        std::swap(currentX, nextX);
+        std::swap(currentY, nextY);
+        std::swap(currentZ, nextZ);
+    }
+    else {
+        reader.ReadPositions(frame, currentX.data(), currentY.data(), currentZ.data());
+    }
+    reader.ReadPositions(nextFrame, nextX.data(), nextY.data(), nextZ.data());
+    if (decodedFrame == (size_t)-1 || reader.Layout().HasFrameBodies()) {
+        reader.ReadArray(frame, TRAJECTORY_RADIUS, radii.data());
+    }
+    decodedFrame = frame;
+    finishSeek();
+}
+
+/**
+ * @brief Gets every body's position at the playhead, interpolated between the frames either side.
+ *
+ * @param positions receives one position per body.
+ */
+void Playback::InterpolatedPositions(std::vector<glm::vec3>& positions) {
+    decode();
+
+    // Normally the playhead's frame, unless decoding it is still waiting on the disk
+    float alpha = 0.0f;
+    if (decodedFrame + 1 < reader.FrameCount()) {
+        double currentTime = reader.FrameTime(decodedFrame);
+        double frameLength = reader.FrameTime(decodedFrame + 1) - currentTime;
+        if (frameLength > 0.0) {
+            alpha = (float)std::min(std::max((playheadTime - currentTime)/frameLength, 0.0), 1.0);
+        }
+    }
+
+    positions.resize(reader.BodyCount());
+    for (size_t i = 0; i < positions.size(); i++) {
+        glm::vec3 current(currentX[i], currentY[i], currentZ[i]);
+        glm::vec3 next(nextX[i], nextY[i], nextZ[i]);
+        positions[i] = glm::mix(current, next, alpha);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <JobSystem/JobSystem.hpp>
+#include <Physics/Trajectory/TrajectoryReader.hpp>
+
+/**
+ * @brief Plays back a recorded trajectory in place of running the physics.
+ *
+ * The playhead moves through simulation time at a controllable speed, possibly backwards, and can be
+ * moved to any frame instantly. Body positions are interpolated between the two frames either side of
+ * the playhead. Frames are read straight out of the mapped file; a window of frames ahead of the
+ * playhead is prefetched, from a thread of its own, so the disk reads happen before the frames are
+ * needed. After a seek, the old positions and time stay until the new frames have been read in, so a
+ * seek never waits on the disk.
+ */
+class Playback {
+    private:
+        TrajectoryReader reader;
+        size_t frame = 0;
+        double playheadTime = 0.0;
+        double firstTime = 0.0;
+        double lastTime = 0.0;
+        // Set while the playhead has jumped to a frame that hasn't been read in, so its time isn't known
+        bool isSeeking = false;
+        double speed = 1.0;
+        bool isPaused = false;
+
+        // Frames either side of the playhead, decoded
+        size_t decodedFrame = (size_t)-1;
+        size_t deferredDecodes = 0;
+        std::vector<float> currentX, currentY, currentZ;
+        std::vector<float> nextX, nextY, nextZ;
+        // Of the current frame; bodies can change size between frames when they merge
+        std::vector<float> radii;
+
+        size_t prefetchFrames;
+        size_t prefetchBegin = 0;
+        size_t prefetchEnd = 0;
+        // The part of the window not yet asked for
+        size_t prefetchStepFrames;
+        size_t requestBegin = 0;
+        size_t requestEnd = 0;
+        // Declared after the reader, so it stops before the file is unmapped
+        JobSystem prefetchThread{1};
+
+        void decode();
+        void finishSeek();
+        void prefetch();
+        void moveWindow(bool isForwards, bool isInWindow);
+        void requestFrames(size_t firstFrame, size_t count);
+        void evictFrames(size_t firstFrame, size_t count);
+
+    public:
+        explicit Playback(const std::string& path);
+
+        void Update(double deltaTime);
+        void Seek(size_t frame);
+        void SeekRelative(long long frames);
+
+        void TogglePause();
+        bool IsPaused() const { return isPaused; }
+        void SetSpeed(double speed) { this->speed = speed; }
+        double GetSpeed() const { return speed; }
+
+        size_t CurrentFrame() const { return frame; }
+        size_t FrameCount() const { return reader.FrameCount(); }
+        double Time() const { return playheadTime; }
+        const TrajectoryReader& Reader() const { return reader; }
+
+        void InterpolatedPositions(std::vector<glm::vec3>& positions);
+        // Every body's radius in the frame InterpolatedPositions last decoded
+        const std::vector<float>& Radii() const { return radii; }
+};
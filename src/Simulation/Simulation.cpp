@@ -5,10 +5,27 @@
 #include <vector>
 #include <algorithm>
 
-#include <Rendering/Window/Texture/Texture.hpp>
 #include <Simulation/Icosphere/Icosphere.hpp>
+#include <Physics/Scenario/Scenario.hpp>
 #include <Utilities/Utilities.hpp>
 
+/**
+ * @brief Creates the simulation, its window and its physics worker threads.
+ *
+ * @param workerCount the number of physics worker threads; 0 uses every hardware thread.
+ * @param playbackPath a trajectory file to play back instead of simulating, or empty to simulate.
+ * @param ephemerisPath an ephemeris file to drive the major bodies from, or empty to integrate them.
+ */
+Simulation::Simulation(unsigned int workerCount, const std::string& playbackPath, const std::string& ephemerisPath) : jobSystem(workerCount) {
+    world.SetJobSystem(&jobSystem);
+    if (!playbackPath.empty()) {
+        playback.reset(new Playback(playbackPath));
+    }
+    if (!ephemerisPath.empty()) {
+        ephemeris.reset(new Ephemeris(ephemerisPath));
+    }
+}
+
 /**
  * @brief Runs the main loop for the simulation.
  *
@@ -17,19 +34,39 @@
  */
 void Simulation::Run() {
     int shaderProgram = loadShader("shaders/default.vert", "shaders/default.frag");
-    Icosphere icosphere(glm::vec3(0.0f, 0.0f, 0.0f), 1.0f, 5);
-    icosphere.SetShader(shaderProgram);
-    addDrawable(icosphere);
+    defaultShader = shaderProgram;
+    instancedShader = loadShader("shaders/instanced.vert", "shaders/default.frag");
+    particleShader = loadShader("shaders/particle.vert", "shaders/particle.frag");
+    for (int level = 0; level < levelOfDetail.LevelCount(); level++) {
+        levelSpheres.push_back(InstancedMesh(Icosphere::GetUnitMesh(level)));
+    }
+    levelInstances.resize(levelOfDetail.LevelCount());
+    terrainPool.reset(new TerrainPatchPool(TERRAIN_POOL_SLOTS, PlanetTerrain::VERTICES_PER_PATCH, PlanetTerrain::PatchIndices()));
 
-    glm::vec4 lightColour = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-    glm::vec3 lightPos = glm::vec3(2.0f, 2.0f, 2.0f);
-    glm::mat4 lightModel = glm::mat4(1.0f);
-    lightModel = glm::translate(lightModel, lightPos);
+    addModel("resources/models/sword/scene.gltf", glm::vec3(-8.0f, 10.0f, 40.0f), 0.1f);
+    addModel("resources/models/grindstone/scene.gltf", glm::vec3(0.0f, 10.0f, 40.0f), 1.0f);
+    addModel("resources/models/bunny/scene.gltf", glm::vec3(8.0f, 10.0f, 40.0f), 10.0f);
 
-    Shader shader = shaders.at(shaderProgram);
-    shader.Activate();
-    glUniform4f(glGetUniformLocation(shaderProgram, "lightColour"), lightColour.x, lightColour.y, lightColour.z, lightColour.w);
-    glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+    if (playback) {
+        playback->InterpolatedPositions(playbackPositions);
+        const std::vector<float>& radii = playback->Radii();
+        for (unsigned int i = 0; i < playbackPositions.size(); i++) {
+            addBody(playbackPositions[i], radii[i]);
+        }
+    }
+    else {
+        SetUpScenario("belt", world, 300);
+        AddParticleBelt(world.particles, world.bodies.Get(0), DEBRIS_PARTICLE_COUNT, 40.0, 48.0);
+        world.collisions.response = MERGE;
+        world.SetEphemeris(ephemeris.get());
+        world.Initialise();
+        const BodyStore& bodies = world.bodies;
+        for (unsigned int i = 0; i < bodies.Size(); i++) {
+            addBody(glm::vec3(bodies.x[i], bodies.y[i], bodies.z[i]), (float)bodies.radius[i]);
+        }
+        physicsThread.Start();
+    }
+    bodyHierarchy.Build(bodyInstances.data(), (unsigned int)bodyInstances.size());
 
     // Main loop
     while (!window.ShouldClose()) {
@@ -39,14 +76,28 @@ void Simulation::Run() {
         render();
     }
 
-    shader.Delete();
+    if (!playback) {
+        physicsThread.Stop();
+    }
+    shaders.at(shaderProgram).Delete();
+    shaders.at(instancedShader).Delete();
+    shaders.at(particleShader).Delete();
+    particleCloud.Delete();
+    frameUniforms.Delete();
+    objectUniforms.Delete();
+    materials.Delete();
 }
 
 /**
  * @brief Updates the simulation state based on the elapsed time since the last frame.
  *
- * This handles any user input to the window, updates the camera's position and orientation based on input, and
- * checks if the window has changed size.
+ * This handles any user input to the window, updates the camera's position and orientation based on input,
+ * picks up the latest state from the physics thread, and checks if the window has changed size.
+ *
+ * The physics runs on its own thread at a fixed timestep, so the bodies are drawn interpolated between
+ * the last two states it published rather than being stepped by the frame time. Bodies driven by an
+ * ephemeris are evaluated from it directly. When playing back a recording, the bodies are instead
+ * taken from the recording at the playhead.
  *
  * @param deltaTime the time since the last frame.
  */
@@ -55,6 +106,10 @@ void Simulation::update(float deltaTime) {
     if (timeSinceFPSUpdate >= 1.0f) {
         int FPS = (int)(1.0f/deltaTime);
         std::string title = "Solar System Simulation | " + std::to_string(window.width) + " x " + std::to_string(window.height) + " | FPS: " + std::to_string(FPS);
+        if (playback) {
+            title += " | Frame " + std::to_string(playback->CurrentFrame() + 1) + "/" + std::to_string(playback->FrameCount())
+                   + " | Speed " + std::to_string(playback->GetSpeed()) + (playback->IsPaused() ? " | Paused" : "");
+        }
         glfwSetWindowTitle(window.window, title.c_str());
         timeSinceFPSUpdate = 0.0f;
     }
@@ -62,16 +117,133 @@ void Simulation::update(float deltaTime) {
 
     camera.HandleInputs(window.window, deltaTime);
 
+    if (playback) {
+        handlePlaybackInputs(deltaTime);
+        playback->Update(deltaTime);
+        playback->InterpolatedPositions(playbackPositions);
+        const std::vector<float>& radii = playback->Radii();
+        for (unsigned int i = 0; i < playbackPositions.size() && i < bodyInstances.size(); i++) {
+            bodyInstances[i].position = playbackPositions[i];
+            // Recordings of merging bodies store their radii per frame
+            bodyInstances[i].radius = radii[i];
+        }
+    }
+    else {
+        bool isNewSnapshot = physicsThread.AcquireSnapshot();
+        const PhysicsSnapshot& snapshot = physicsThread.Snapshot();
+        float alpha = snapshot.InterpolationFactor(std::chrono::steady_clock::now());
+        for (unsigned int i = 0; i < snapshot.Size() && i < bodyInstances.size(); i++) {
+            glm::vec3 previous(snapshot.previousX[i], snapshot.previousY[i], snapshot.previousZ[i]);
+            glm::vec3 current(snapshot.x[i], snapshot.y[i], snapshot.z[i]);
+            bodyInstances[i].position = glm::mix(previous, current, alpha);
+            // Bodies grow as they merge, and those they swallow shrink to nothing
+            bodyInstances[i].radius = snapshot.radius[i];
+        }
+
+        // Bodies driven by the ephemeris are placed exactly at the time being drawn, instead of interpolated
+        double drawTime = snapshot.previousTime + alpha*(snapshot.time - snapshot.previousTime);
+        if (ephemeris && ephemeris->Covers(drawTime)) {
+            const uint64_t* indices = ephemeris->BodyIndices();
+            for (size_t body = 0; body < ephemeris->BodyCount(); body++) {
+                if (indices[body] < bodyInstances.size()) {
+                    glm::dvec3 position, velocity;
+                    ephemeris->Evaluate(body, drawTime, position, velocity);
+                    bodyInstances[indices[body]].position = glm::vec3(position);
+                }
+            }
+        }
+
+        // The particles are interpolated on the GPU, so they are only uploaded when they have moved
+        if (isNewSnapshot) {
+            const float* previous[3] = {snapshot.previousParticleX.data(), snapshot.previousParticleY.data(), snapshot.previousParticleZ.data()};
+            const float* current[3] = {snapshot.particleX.data(), snapshot.particleY.data(), snapshot.particleZ.data()};
+            particleCloud.SetPositions(previous, current, (GLsizei)snapshot.ParticleCount());
+        }
+        particleInterpolation = alpha;
+    }
+
     // Check if the window has changed size
     glfwGetFramebufferSize(window.window, &window.width, &window.height);
     glfwGetFramebufferSize(window.window, &camera.width, &camera.height);
-    camera.UpdateMatrix(45.0f, 0.1f, 100.0f);
+    camera.UpdateMatrix(45.0f, 0.1f, FAR_PLANE);
+}
+
+/**
+ * @brief Handles the keys that control playback of a recording.
+ *
+ * P pauses and resumes, R reverses, the up and down arrows double and halve the speed, comma and
+ * full stop step a single frame, the left and right arrows scrub while held, and Home and End jump
+ * to either end of the recording.
+ *
+ * @param deltaTime the time since the last frame.
+ */
+void Simulation::handlePlaybackInputs(float deltaTime) {
+    if (wasKeyPressed(GLFW_KEY_P)) {
+        playback->TogglePause();
+    }
+    if (wasKeyPressed(GLFW_KEY_R)) {
+        playback->SetSpeed(-playback->GetSpeed());
+    }
+    if (wasKeyPressed(GLFW_KEY_UP)) {
+        playback->SetSpeed(playback->GetSpeed()*2.0);
+    }
+    if (wasKeyPressed(GLFW_KEY_DOWN)) {
+        playback->SetSpeed(playback->GetSpeed()*0.5);
+    }
+    if (wasKeyPressed(GLFW_KEY_PERIOD)) {
+        playback->SeekRelative(1);
+    }
+    if (wasKeyPressed(GLFW_KEY_COMMA)) {
+        playback->SeekRelative(-1);
+    }
+    if (wasKeyPressed(GLFW_KEY_HOME)) {
+        playback->Seek(0);
+    }
+    if (wasKeyPressed(GLFW_KEY_END)) {
+        playback->Seek(playback->FrameCount() - 1);
+    }
+
+    // Scrubbing covers the whole recording in ten seconds, whatever its length
+    int scrubDirection = (glfwGetKey(window.window, GLFW_KEY_RIGHT) == GLFW_PRESS) - (glfwGetKey(window.window, GLFW_KEY_LEFT) == GLFW_PRESS);
+    if (scrubDirection != 0) {
+        scrubFrames += scrubDirection*0.1*playback->FrameCount()*deltaTime;
+        long long wholeFrames = (long long)scrubFrames;
+        if (wholeFrames != 0) {
+            playback->SeekRelative(wholeFrames);
+            scrubFrames -= (double)wholeFrames;
+        }
+    }
+    else {
+        scrubFrames = 0.0;
+    }
+}
+
+/**
+ * @brief Checks whether a key has gone down since the last time this was called for it.
+ *
+ * @param key the GLFW key code.
+ * @return true only on the first frame the key is held.
+ */
+bool Simulation::wasKeyPressed(int key) {
+    bool isPressed = glfwGetKey(window.window, key) == GLFW_PRESS;
+    bool wasPressed = previousKeyStates[key];
+    previousKeyStates[key] = isPressed;
+    return isPressed && !wasPressed;
 }
 
 /**
  * @brief Renders the scene.
  *
  * This sets the clear color and clears the color and depth buffers, updates the camera's matrix, and renders each mesh in the scene.
+ * Only the bodies that might be visible are drawn, with one instanced draw call per level of detail,
+ * however many of them there are.
+ * The camera and lights are uploaded once for the whole frame, and the transforms of everything else
+ * drawn are gathered first and uploaded together before any of it is drawn.
+ * Every draw goes through the render queue, which sorts them to change program as rarely as possible
+ * and otherwise draws front to back. Every texture is bound once, up front, as part of the material library.
+ * Assets that have finished loading in the background are uploaded first, within a small time budget,
+ * and models still loading are drawn as placeholder spheres.
+ * The test particles are drawn last, as points, in a single draw call of their own.
  * Finally, it swaps the front and back buffers and processes any pending events.
  */
 void Simulation::render() {
@@ -79,25 +251,125 @@ void Simulation::render() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glCheckError();
 
-    camera.UpdateMatrix(45.0f, 0.1f, 100.0f);
-
-    for (auto& mesh : drawableObjects) {
-        int shaderID = mesh.first;
-        std::vector<Mesh>* meshVector = &mesh.second;
+    camera.UpdateMatrix(45.0f, 0.1f, FAR_PLANE);
+    FrameData frame;
+    frame.camMatrix = camera.cameraMatrix;
+    frame.camPos = glm::vec4(camera.position, 1.0f);
+    frame.lightColour = lightColour;
+    frame.lightPos = glm::vec4(lightPos, 1.0f);
+    frameUniforms.Update(frame);
+    objectUniforms.BeginFrame();
+    assets.Update();
 
-        for (auto& mesh : *meshVector) {
-            mesh.Draw(shaders.at(shaderID), camera);
+    terrainPool->BeginFrame();
+    for (auto& instances : levelInstances) {
+        instances.clear();
+    }
+    renderQueue.Clear();
+    cullBodies();
+    for (unsigned int i : visibleBodies) {
+        if (PlanetTerrain* terrain = updateTerrain(i)) {
+            unsigned int object = objectUniforms.Push({terrain->ModelMatrix(), MaterialLibrary::PLAIN_MATERIAL});
+            terrain->Enqueue(renderQueue, shaders.at(defaultShader), object, sortDepth(bodyInstances[i].position));
+            continue;
         }
+        float projectedRadius = camera.ProjectedRadius(bodyInstances[i].position, bodyInstances[i].radius);
+        bodyLevels[i] = levelOfDetail.SelectLevel(projectedRadius, bodyLevels[i]);
+        levelInstances[bodyLevels[i]].push_back(bodyInstances[i]);
+    }
+    // Only once every terrain has marked the patches it draws this frame, so none of them can be evicted
+    for (auto& terrain : terrains) {
+        terrain.second->UploadCompleted();
+    }
+    for (unsigned int level = 0; level < levelSpheres.size(); level++) {
+        levelSpheres[level].SetInstances(levelInstances[level].data(), levelInstances[level].size());
+        levelSpheres[level].Enqueue(renderQueue, shaders.at(instancedShader));
+    }
 
-        backpack.Draw(shaders.at(shaderID), camera);
+    for (auto& drawable : drawableObjects) {
+        glm::vec3 position = glm::vec3(drawable.model[3].x, drawable.model[3].y, drawable.model[3].z);
+        drawable.mesh->Enqueue(renderQueue, shaders.at(drawable.shaderID), objectUniforms, drawable.model, sortDepth(position));
+    }
+    for (auto& placed : models) {
+        glm::vec3 position = glm::vec3(placed.transform[3].x, placed.transform[3].y, placed.transform[3].z);
+        if (placed.model->IsLoaded()) {
+            placed.model->Enqueue(renderQueue, shaders.at(defaultShader), objectUniforms, placed.transform, sortDepth(position));
+        }
+        else {
+            glm::mat4 placeholder = Mesh::ModelMatrix(glm::mat4(1.0f), position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(PLACEHOLDER_RADIUS));
+            Icosphere::GetUnitMesh(1).Enqueue(renderQueue, shaders.at(defaultShader), objectUniforms, placeholder, sortDepth(position));
+        }
     }
 
+    objectUniforms.Upload();
+    renderQueue.Sort();
+    materials.Bind();
+    renderQueue.Submit(objectUniforms);
+    objectUniforms.EndFrame();
+    particleCloud.Draw(shaders.at(particleShader), particleInterpolation);
+
     glfwSwapBuffers(window.window);
     glCheckError();
 
     glfwPollEvents();
 }
 
+/**
+ * @brief Finds the bodies that might be visible this frame.
+ *
+ * The bounding volume hierarchy is refitted to where the bodies are drawn this frame, then culled
+ * against the camera's frustum. The star and any planets large enough on screen hide the bodies
+ * behind them.
+ */
+void Simulation::cullBodies() {
+    bodyHierarchy.Refit(bodyInstances.data(), (unsigned int)bodyInstances.size());
+
+    occluders.clear();
+    for (unsigned int i = 0; i < PLANET_COUNT && i < bodyInstances.size(); i++) {
+        const InstanceData& body = bodyInstances[i];
+        if (camera.ProjectedRadius(body.position, body.radius) >= OCCLUDER_MIN_PIXELS) {
+            occluders.push_back({body.position, body.radius});
+        }
+    }
+
+    bodyHierarchy.Cull(Frustum::FromMatrix(camera.cameraMatrix), occluders, camera.position, bodyInstances.data(), visibleBodies);
+}
+
+/**
+ * @brief Gets the depth to sort a draw at, as a fraction of the far plane distance.
+ */
+float Simulation::sortDepth(glm::vec3 position) const {
+    return glm::length(position - camera.position)/FAR_PLANE;
+}
+
+/**
+ * @brief Updates a planet's streamed terrain if the camera is close enough to need it.
+ *
+ * Each planet's terrain is created the first time it is needed and kept afterwards; its patches are
+ * only kept while the shared pool has room for them.
+ *
+ * @param index the index of the body.
+ * @return the terrain to draw the body as, or nullptr if it should be drawn as a sphere.
+ */
+PlanetTerrain* Simulation::updateTerrain(unsigned int index) {
+    // The star has no surface to fly over, and the asteroids are far too small to need one
+    if (index == 0 || index >= PLANET_COUNT) {
+        return nullptr;
+    }
+    const InstanceData& body = bodyInstances[index];
+    if (camera.ProjectedRadius(body.position, body.radius) < TERRAIN_SCREEN_FRACTION*camera.height) {
+        return nullptr;
+    }
+
+    auto found = terrains.find(index);
+    if (found == terrains.end()) {
+        found = terrains.emplace(index, std::unique_ptr<PlanetTerrain>(new PlanetTerrain(index, body.radius, index, *terrainPool, terrainThreads))).first;
+    }
+    PlanetTerrain* terrain = found->second.get();
+    terrain->Update(body.position, camera);
+    return terrain;
+}
+
 /**
  * @brief Loads a shader from file and adds it to the shaders map.
  *
@@ -119,21 +391,49 @@ int Simulation::loadShader(const char* vertexFilePath, const char* fragmentFileP
 /**
  * @brief Adds an Icosphere to the simulation's drawable meshes.
  *
- * This function retrieves the shader ID from the given Icosphere
- * and checks if the shader ID is already a key in the meshes map.
- * If not, it initializes an empty vector of Meshes for that shader ID.
- * The Icosphere's mesh is then added to the vector associated with the shader ID.
+ * The Icosphere's shared unit mesh is drawn with the Icosphere's shader, scaled and moved to where
+ * the Icosphere is. Draws are sorted by the render queue, so the order they are added in doesn't matter.
  *
  * @param icosphere The Icosphere object to be added to the drawable meshes.
  */
 void Simulation::addDrawable(Icosphere icosphere) {
-    int id = icosphere.GetShader();
-    // if shader ID not in keys, add it
-    if (drawableObjects.find(id) == drawableObjects.end()) {
-        drawableObjects.insert(std::pair<int, std::vector<Mesh>>(id, std::vector<Mesh>()));
-    }
+    drawableObjects.push_back({icosphere.GetShader(), &icosphere.GetMesh(), icosphere.ModelMatrix()});
+}
 
-    std::vector<Mesh> meshVector = drawableObjects[id];
-    meshVector.push_back(icosphere.mesh);
-    drawableObjects[id] = meshVector;
+/**
+ * @brief Starts loading a model into the scene. It is drawn as a placeholder sphere until it has loaded.
+ *
+ * @param filepath the path to the model file.
+ * @param position where to place the model.
+ * @param scale how much to scale the model by.
+ */
+void Simulation::addModel(const char* filepath, glm::vec3 position, float scale) {
+    glm::mat4 transform = Mesh::ModelMatrix(glm::mat4(1.0f), position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(scale));
+    models.push_back({assets.LoadModel(filepath), transform});
+}
+
+/**
+ * @brief Adds the instance used to draw a body.
+ *
+ * Bodies must be added in order; the first PLANET_COUNT are coloured as the star and planets, the
+ * rest as asteroids.
+ *
+ * @param position the starting position of the body.
+ * @param radius the radius of the body.
+ */
+void Simulation::addBody(glm::vec3 position, float radius) {
+    InstanceData instance;
+    instance.position = position;
+    instance.radius = radius;
+    if (bodyInstances.empty()) {
+        instance.colour = glm::vec3(1.0f, 0.85f, 0.4f);
+    }
+    else if (bodyInstances.size() < PLANET_COUNT) {
+        instance.colour = glm::vec3(1.0f, 0.5f, 0.31f);
+    }
+    else {
+        instance.colour = glm::vec3(0.6f, 0.58f, 0.55f);
+    }
+    bodyInstances.push_back(instance);
+    bodyLevels.push_back(-1);
 }
\ No newline at end of file
@@ -3,32 +3,134 @@
 #include <Rendering/Window/Window.hpp>
 #include <Camera/Camera.hpp>
 #include <Simulation/Icosphere/Icosphere.hpp>
+#include <Rendering/Window/InstancedMesh/InstancedMesh.hpp>
+#include <Rendering/LevelOfDetail/LevelOfDetail.hpp>
+#include <Rendering/Culling/BoundingVolumeHierarchy.hpp>
+#include <Rendering/Terrain/PlanetTerrain.hpp>
+#include <Rendering/Terrain/TerrainPatchPool.hpp>
 #include <Rendering/Window/Model/Model.hpp>
+#include <Rendering/Materials/MaterialLibrary.hpp>
+#include <Rendering/Assets/AssetLoader.hpp>
+#include <Rendering/UniformBuffers/FrameUniformBuffer.hpp>
+#include <Rendering/UniformBuffers/ObjectUniformRing.hpp>
+#include <Rendering/RenderQueue/RenderQueue.hpp>
+#include <Rendering/Particles/ParticleCloud.hpp>
+#include <Physics/PhysicsWorld/PhysicsWorld.hpp>
+#include <Physics/PhysicsThread/PhysicsThread.hpp>
+#include <Physics/Ephemeris/Ephemeris.hpp>
+#include <JobSystem/JobSystem.hpp>
+#include <Simulation/Playback/Playback.hpp>
 
 #include <glm/glm.hpp>
 #include <map>
+#include <memory>
+#include <string>
 
 using namespace glm;
 
 class Simulation {
     private:
+        // A mesh to draw every frame, with its own transform
+        struct Drawable {
+            int shaderID;
+            Mesh* mesh;
+            glm::mat4 model;
+        };
+
+        // A model and where it is placed
+        struct PlacedModel {
+            Model* model;
+            glm::mat4 transform;
+        };
+
+        static constexpr float FAR_PLANE = 500.0f;
+        // Models are drawn as a sphere this size until they have loaded
+        static constexpr float PLACEHOLDER_RADIUS = 1.0f;
+
         Window window{WIDTH, HEIGHT, "Solar System Simulation"};
-        Camera camera{WIDTH, HEIGHT, vec3(0.0f, 0.0f, 2.0f)};
+        Camera camera{WIDTH, HEIGHT, vec3(0.0f, 10.0f, 60.0f)};
         double previousTime = 0.0f;
         double currentTime = 0.0f;
         double timeSinceFPSUpdate = 0.0f;
 
         std::map<int, Shader> shaders;
-        std::map<int, std::vector<Mesh>> drawableObjects;
-        Model backpack = Model("resources/models/sword/scene.gltf");
+        std::vector<Drawable> drawableObjects;
+        // Every model's textures, packed into a few arrays bound once for the whole frame, and loaded
+        // in the background along with the models
+        MaterialLibrary materials;
+        AssetLoader assets{materials};
+        std::vector<PlacedModel> models;
+
+        // Camera and lights are uploaded once a frame and shared by every program; the few objects with
+        // their own transforms get them from a ring of per-frame buffers
+        FrameUniformBuffer frameUniforms;
+        ObjectUniformRing objectUniforms;
+        // Every draw goes through here, to be sorted by the state it needs
+        RenderQueue renderQueue;
+        glm::vec4 lightColour = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        glm::vec3 lightPos = glm::vec3(2.0f, 2.0f, 2.0f);
+
+        // Declared in this order so the physics thread stops before the world and workers go away
+        std::unique_ptr<Ephemeris> ephemeris;
+        JobSystem jobSystem;
+        PhysicsWorld world;
+        PhysicsThread physicsThread{world};
+
+        // Every body is an instance of a shared unit sphere, at a level of detail picked each frame from
+        // how large it appears on screen
+        static constexpr unsigned int PLANET_COUNT = 7;
+        LevelOfDetail levelOfDetail;
+        std::vector<InstancedMesh> levelSpheres;
+        std::vector<std::vector<InstanceData>> levelInstances;
+        std::vector<InstanceData> bodyInstances;
+        std::vector<int> bodyLevels;
+
+        // Only bodies in view and not hidden behind a nearby planet or the star are drawn
+        static constexpr float OCCLUDER_MIN_PIXELS = 50.0f;
+        BoundingVolumeHierarchy bodyHierarchy;
+        std::vector<OccluderSphere> occluders;
+        std::vector<unsigned int> visibleBodies;
+
+        // A ring of massless test particles beyond the planets, drawn as points as there are far too many
+        // for spheres
+        static constexpr int DEBRIS_PARTICLE_COUNT = 200000;
+        ParticleCloud particleCloud;
+        float particleInterpolation = 1.0f;
+        int particleShader;
+
+        // Planets close enough to fill much of the screen are drawn as streamed terrain instead
+        static constexpr float TERRAIN_SCREEN_FRACTION = 0.25f;
+        static constexpr unsigned int TERRAIN_POOL_SLOTS = 512;
+        static constexpr unsigned int TERRAIN_THREAD_COUNT = 2;
+        // Patches are generated on threads of their own, so that a fly-by can never hold up a physics step
+        JobSystem terrainThreads{TERRAIN_THREAD_COUNT};
+        std::unique_ptr<TerrainPatchPool> terrainPool;
+        std::map<unsigned int, std::unique_ptr<PlanetTerrain>> terrains;
+        int defaultShader;
+        int instancedShader;
+
+        // Set when replaying a recording, in which case the physics never runs
+        std::unique_ptr<Playback> playback;
+        std::vector<glm::vec3> playbackPositions;
+        std::map<int, bool> previousKeyStates;
+        double scrubFrames = 0.0;
 
         void update(float deltaTime);
+        void handlePlaybackInputs(float deltaTime);
+        bool wasKeyPressed(int key);
         void render();
+        void cullBodies();
+        float sortDepth(glm::vec3 position) const;
         int loadShader(const char* vertexFilePath, const char* fragmentFilePath);
         void addDrawable(Icosphere icosphere);
+        void addModel(const char* filepath, glm::vec3 position, float scale);
+        void addBody(glm::vec3 position, float radius);
+        PlanetTerrain* updateTerrain(unsigned int index);
     public:
         static const int WIDTH = 1920;
         static const int HEIGHT = 1000;
 
+        explicit Simulation(unsigned int workerCount = 0, const std::string& playbackPath = "", const std::string& ephemerisPath = "");
+
         void Run();
 };
\ No newline at end of file
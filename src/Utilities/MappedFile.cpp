@@ -0,0 +1,210 @@
+#include <Utilities/MappedFile.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/**
+ * @brief Maps a file into memory for reading.
+ *
+ * @param path the path of the file to map.
+ * @throws std::runtime_error if the file can't be opened or mapped.
+ */
+MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(fileHandle, &fileSize);
+    size = (size_t)fileSize.QuadPart;
+    if (size == 0) {
+        close();
+        throw std::runtime_error("File '" + path + "' is empty");
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle != nullptr) {
+        data = (const uint8_t*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        throw std::runtime_error("Could not open file '" + path + "'");
+    }
+    struct stat status;
+    fstat(fileDescriptor, &status);
+    size = (size_t)status.st_size;
+    if (size == 0) {
+        close();
+        throw std::runtime_error("File '" + path + "' is empty");
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (mapping != MAP_FAILED) {
+        data = (const uint8_t*)mapping;
+    }
+#endif
+    if (data == nullptr) {
+        close();
+        throw std::runtime_error("Could not map file '" + path + "'");
+    }
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+#ifdef _WIN32
+        std::swap(fileHandle, other.fileHandle);
+        std::swap(mappingHandle, other.mappingHandle);
+#else
+        std::swap(fileDescriptor, other.fileDescriptor);
+#endif
+    }
+    return *this;
+}
+
+/**
+ * @brief Unmaps the file and closes it, if it is open.
+ */
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data != nullptr) {
+        munmap((void*)data, size);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+    fileDescriptor = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+/**
+ * @brief Hints to the OS that a range of the file will be read soon, so it can start reading it in.
+ *
+ * Returns immediately; the pages are read in the background. Out of range parts are ignored.
+ *
+ * @param offset the start of the range, in bytes.
+ * @param length the length of the range, in bytes.
+ */
+void MappedFile::Prefetch(size_t offset, size_t length) const {
+    if (data == nullptr || offset >= size) {
+        return;
+    }
+    if (length > size - offset) {
+        length = size - offset;
+    }
+#ifdef _WIN32
+    #if _WIN32_WINNT >= 0x0602
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = (void*)(data + offset);
+        range.NumberOfBytes = length;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    #endif
+#else
+    // madvise needs a page aligned address
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t alignedOffset = offset - offset % pageSize;
+    size_t end = offset + length;
+    // Linux only reads ahead a device's readahead limit per call, often a few megabytes, and silently
+    // drops the rest, so large ranges are asked for a piece at a time
+    const size_t chunkSize = 1024*1024;
+    for (size_t chunk = alignedOffset; chunk < end; chunk += chunkSize) {
+        madvise((void*)(data + chunk), std::min(chunkSize, end - chunk), MADV_WILLNEED);
+    }
+#endif
+}
+
+/**
+ * @brief Hints to the OS that a range of the file won't be needed again soon, so its pages can be dropped.
+ *
+ * @param offset the start of the range, in bytes.
+ * @param length the length of the range, in bytes.
+ */
+void MappedFile::Evict(size_t offset, size_t length) const {
+    if (data == nullptr || offset >= size) {
+        return;
+    }
+    if (length > size - offset) {
+        length = size - offset;
+    }
+#ifndef _WIN32
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t alignedOffset = offset - offset % pageSize;
+    madvise((void*)(data + alignedOffset), length + (offset - alignedOffset), MADV_DONTNEED);
+#endif
+}
+
+/**
+ * @brief Checks whether a range of the file is already in memory, so reading it won't wait on the disk.
+ *
+ * Windows has no cheap way to ask, so there every range is reported as resident.
+ *
+ * @param offset the start of the range, in bytes.
+ * @param length the length of the range, in bytes.
+ */
+bool MappedFile::IsResident(size_t offset, size_t length) const {
+    if (data == nullptr || offset >= size) {
+        return true;
+    }
+    if (length > size - offset) {
+        length = size - offset;
+    }
+#ifdef _WIN32
+    return true;
+#else
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t alignedOffset = offset - offset % pageSize;
+    size_t alignedLength = length + (offset - alignedOffset);
+    std::vector<unsigned char> pages((alignedLength + pageSize - 1)/pageSize);
+#ifdef __APPLE__
+    int result = mincore((void*)(data + alignedOffset), alignedLength, (char*)pages.data());
+#else
+    int result = mincore((void*)(data + alignedOffset), alignedLength, pages.data());
+#endif
+    if (result != 0) {
+        return true;
+    }
+    for (unsigned char page : pages) {
+        if ((page & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
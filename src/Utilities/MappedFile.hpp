@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A read-only view of a whole file mapped into memory.
+ *
+ * Pages are only read from disk as they are touched, so a file far larger than memory can be opened
+ * and accessed at random without loading it. Not copyable; the mapping lives as long as the object.
+ */
+class MappedFile {
+    private:
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#else
+        int fileDescriptor = -1;
+#endif
+
+        void close();
+
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        const uint8_t* Data() const { return data; }
+        size_t Size() const { return size; }
+        bool IsOpen() const { return data != nullptr; }
+
+        void Prefetch(size_t offset, size_t length) const;
+        void Evict(size_t offset, size_t length) const;
+        bool IsResident(size_t offset, size_t length) const;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free single-producer, single-consumer triple buffer.
+ *
+ * The producer always has a buffer to write into and the consumer always has a buffer to read from,
+ * so neither ever waits on the other. The third buffer sits in the middle holding the most recently
+ * published data; publishing and acquiring just swap a buffer with it. Intermediate states the
+ * consumer never picked up are silently overwritten.
+ */
+template <typename T>
+class TripleBuffer {
+    private:
+        // Bits 0-1 hold the index of the middle buffer, bit 2 is set when it holds unread data
+        static const uint8_t INDEX_MASK = 0x3;
+        static const uint8_t NEW_DATA = 0x4;
+
+        T buffers[3];
+        std::atomic<uint8_t> middle{1};
+        uint8_t writeIndex = 0;
+        uint8_t readIndex = 2;
+
+    public:
+        /**
+         * @brief Gets the buffer owned by the producer. Only the producer thread may call this.
+         */
+        T& WriteBuffer() { return buffers[writeIndex]; }
+
+        /**
+         * @brief Hands the write buffer to the consumer and takes the middle buffer to write into next.
+         */
+        void Publish() {
+            uint8_t previous = middle.exchange(writeIndex | NEW_DATA, std::memory_order_acq_rel);
+            writeIndex = previous & INDEX_MASK;
+        }
+
+        /**
+         * @brief Takes the most recently published buffer, if there is one the consumer hasn't seen.
+         *
+         * @return true if ReadBuffer() now returns newer data.
+         */
+        bool Acquire() {
+            if ((middle.load(std::memory_order_relaxed) & NEW_DATA) == 0) {
+                return false;
+            }
+            uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+            readIndex = previous & INDEX_MASK;
+            return true;
+        }
+
+        /**
+         * @brief Gets the buffer owned by the consumer. Only the consumer thread may call this.
+         */
+        const T& ReadBuffer() const { return buffers[readIndex]; }
+};
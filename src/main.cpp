@@ -1,21 +1,72 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
+#include <vector>
+
+#include <Rendering/Assets/MeshCache.hpp>
 #include <Simulation/Simulation.hpp>
 
+static const char* USAGE = "Usage: SolarSystem [--playback <trajectory file>] [--ephemeris <ephemeris file>] [--cook <model file>...]\n";
+
 /**
  * @brief Entry point of the program.
  * 
  * Initializes the OpenGL context and GLFW, sets up the window and
  * rendering loop, and handles input and window resizing.
+ *
+ * Passing --playback <file> plays back a recorded trajectory instead of simulating.
+ * Passing --ephemeris <file> drives the bodies in an ephemeris file from it, leaving the rest to the physics.
+ * Passing --cook <model file>... writes the models to the mesh cache, then exits without opening a window.
  * 
  * @return int Exit status of the program.
  */
-int main() {
-    Simulation simulation;
+int main(int argc, char** argv) {
+    std::string playbackPath;
+    std::string ephemerisPath;
+    std::vector<std::string> modelsToCook;
+    bool isCooking = false;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--playback" && i + 1 < argc) {
+            playbackPath = argv[++i];
+        }
+        else if (argument == "--ephemeris" && i + 1 < argc) {
+            ephemerisPath = argv[++i];
+        }
+        else if (argument == "--cook") {
+            isCooking = true;
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                modelsToCook.push_back(argv[++i]);
+            }
+        }
+        else {
+            std::cerr << USAGE;
+            return EXIT_FAILURE;
+        }
+    }
+    if (isCooking && modelsToCook.empty()) {
+        std::cerr << USAGE;
+        return EXIT_FAILURE;
+    }
 
     try {
+        if (isCooking) {
+            MeshCache cache;
+            bool isCooked = true;
+            for (const auto& model : modelsToCook) {
+                if (cache.Cook(model)) {
+                    std::cout << "Cooked '" << model << "' to '" << cache.CachePath(MeshCache::HashSource(model)) << "'\n";
+                }
+                else {
+                    isCooked = false;
+                }
+            }
+            return isCooked ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        Simulation simulation(0, playbackPath, ephemerisPath);
         simulation.Run();
     }
     catch(const std::exception& e) {
@@ -24,4 +75,4 @@ int main() {
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include <Camera/Camera.hpp>
+#include <JobSystem/JobSystem.hpp>
+#include <Rendering/Terrain/PlanetTerrain.hpp>
+#include <Rendering/Terrain/TerrainPatchPool.hpp>
+
+// Slots written by glBufferSubData since they were last cleared, to catch uploads over patches on screen
+static std::vector<unsigned int> uploadedSlots;
+static const size_t PATCH_BYTES = PlanetTerrain::VERTICES_PER_PATCH*sizeof(Vertex);
+
+/**
+ * @brief Points glad at functions that do nothing, so the terrain can run without a GL context.
+ *
+ * Only the calls the pool and terrain make are stubbed; uploads are recorded by slot.
+ */
+static void stubGL() {
+    glad_glGenVertexArrays = [](GLsizei count, GLuint* arrays) { for (GLsizei i = 0; i < count; i++) arrays[i] = 1; };
+    glad_glBindVertexArray = [](GLuint) {};
+    glad_glGenBuffers = [](GLsizei count, GLuint* buffers) { for (GLsizei i = 0; i < count; i++) buffers[i] = 1; };
+    glad_glBindBuffer = [](GLenum, GLuint) {};
+    glad_glBufferData = [](GLenum, GLsizeiptr, const void*, GLenum) {};
+    glad_glBufferSubData = [](GLenum, GLintptr offset, GLsizeiptr, const void*) {
+        uploadedSlots.push_back((unsigned int)((size_t)offset/PATCH_BYTES));
+    };
+    glad_glVertexAttribPointer = [](GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {};
+    glad_glEnableVertexAttribArray = [](GLuint) {};
+    glad_glGetError = []() -> GLenum { return GL_NO_ERROR; };
+}
+
+static int fail(const char* message) {
+    std::cerr << "FAILED: " << message << std::endl;
+    return EXIT_FAILURE;
+}
+
+/**
+ * @brief Two planets share a pool too small for all the patches the camera wants from both of them.
+ *
+ * The camera hangs still between the planets, close to both surfaces. Every patch drawn in one frame is
+ * wanted again in the next, so no upload may ever go into a slot that either planet drew the frame
+ * before, however hard the two planets compete for the pool.
+ */
+int main() {
+    stubGL();
+
+    const unsigned int rootSlots = 12;
+    TerrainPatchPool pool(rootSlots + 40, PlanetTerrain::VERTICES_PER_PATCH, PlanetTerrain::PatchIndices());
+    // With no workers, each terrain generates one patch a frame on this thread, so the test is deterministic
+    JobSystem jobSystem(0);
+    PlanetTerrain first(1, 1.0f, 1, pool, jobSystem);
+    PlanetTerrain second(2, 1.0f, 2, pool, jobSystem);
+    first.maxLevel = 5;
+    second.maxLevel = 5;
+
+    glm::vec3 firstCentre(0.0f, 0.0f, 0.0f);
+    glm::vec3 secondCentre(2.4f, 0.0f, 0.0f);
+    Camera camera(800, 600, glm::vec3(1.2f, 0.0f, 0.0f));
+
+    std::set<unsigned int> previouslyDrawn;
+    size_t mostDrawn[2] = {0, 0};
+    for (int frame = 0; frame < 400; frame++) {
+        pool.BeginFrame();
+        uploadedSlots.clear();
+        first.Update(firstCentre, camera);
+        second.Update(secondCentre, camera);
+        first.UploadCompleted();
+        second.UploadCompleted();
+
+        for (unsigned int slot : uploadedSlots) {
+            if (previouslyDrawn.count(slot) > 0) {
+                return fail("a patch drawn last frame was evicted while it was still on screen");
+            }
+        }
+
+        std::set<unsigned int> drawn;
+        for (const PlanetTerrain* terrain : {&first, &second}) {
+            for (unsigned int slot : terrain->DrawList()) {
+                if (!drawn.insert(slot).second) {
+                    return fail("two patches were drawn from the same slot");
+                }
+            }
+        }
+        mostDrawn[0] = std::max(mostDrawn[0], first.DrawList().size());
+        mostDrawn[1] = std::max(mostDrawn[1], second.DrawList().size());
+        previouslyDrawn.swap(drawn);
+    }
+
+    if (pool.FreeSlotCount() > 0) {
+        return fail("the pool never filled up, so the planets never competed for it");
+    }
+    if (mostDrawn[0] <= 6 || mostDrawn[1] <= 6) {
+        return fail("a planet never got any patches beyond its roots");
+    }
+    std::cout << "Terrain kept every visible patch resident with " << pool.SlotCount() << " slots shared by two planets" << std::endl;
+    return EXIT_SUCCESS;
+}